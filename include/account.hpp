@@ -340,8 +340,9 @@ wxString account_concepts_phrase
 /**
  * @returns a map which indicates, for each AccountSuperType,
  * the Account of that AccountSuperType which has the largest number of
- * ActualOrdinaryEntries (however, the budget balancing Account is
- * never included, nor are any pure_envelope Accounts).
+ * recent ActualOrdinaryEntries, as per
+ * LedgerSnapshot::recent_usage_counts() (however, the budget balancing
+ * Account is never included, nor are any pure_envelope Accounts).
  */
 std::map<AccountSuperType, sqloxx::Id>
 favourite_accounts(DcmDatabaseConnection& p_database_connection);
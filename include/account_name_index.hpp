@@ -0,0 +1,107 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_account_name_index_hpp_8352960174126843
+#define GUARD_account_name_index_hpp_8352960174126843
+
+#include <boost/optional.hpp>
+#include <sqloxx/id.hpp>
+#include <wx/string.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class DcmDatabaseConnection;
+
+// End forward declarations
+
+// What triggers staleness: only Account operations, as nothing else
+// affects Account names.
+// Account::do_save_existing() - marks that Account as stale, as it may
+// have been renamed; its name is re-read from the database on the next
+// lookup.
+// Account::do_remove() - marks that Account as stale; on re-reading, it
+// is found to be gone, and dropped from the index.
+// Account::do_save_new() - marks the whole index as stale, as the Account
+// is not given its id until it has been saved.
+
+/**
+ * Provides an in-memory index of the names of all the Accounts in the
+ * database, folded to lower case in the same (locale-aware) way as by
+ * wxString::Lower(), so that an Account can be looked up by name, case
+ * insensitively, with just a hash lookup. The index is built lazily on the
+ * first lookup, and thereafter maintained incrementally.
+ */
+class AccountNameIndex
+{
+public:
+
+    explicit AccountNameIndex(DcmDatabaseConnection& p_database_connection);
+
+    AccountNameIndex(AccountNameIndex const&) = delete;
+    AccountNameIndex(AccountNameIndex&&) = delete;
+    AccountNameIndex& operator=(AccountNameIndex const&) = delete;
+    AccountNameIndex& operator=(AccountNameIndex&&) = delete;
+    ~AccountNameIndex();
+
+    /**
+     * @returns an optional initialized with the id of the Account named
+     * \e p_name, matched case insensitively, or an uninitialized optional
+     * if there is no such Account. If there are several such Accounts, it
+     * is undefined which of their ids is returned.
+     */
+    boost::optional<sqloxx::Id> find(wxString const& p_name);
+
+    /**
+     * Mark the index as a whole as stale.
+     */
+    void mark_as_stale();
+
+    /**
+     * Mark as stale the name of the Account with id \e p_account_id.
+     */
+    void mark_account_as_stale(sqloxx::Id p_account_id);
+
+private:
+
+    // Keys are names as folded by folded_name(...).
+    typedef std::unordered_map<std::string, sqloxx::Id> IdMap;
+    typedef std::unordered_map<sqloxx::Id, std::string> NameMap;
+
+    static std::string folded_name(wxString const& p_name);
+
+    void refresh();
+    void refresh_all();
+    void refresh_account(sqloxx::Id p_account_id);
+    void insert(sqloxx::Id p_account_id, std::string const& p_folded_name);
+    void erase(sqloxx::Id p_account_id);
+
+    DcmDatabaseConnection& m_database_connection;
+    IdMap m_ids;
+    NameMap m_names;
+    std::unordered_set<sqloxx::Id> m_stale_account_ids;
+    bool m_is_stale;
+
+};  // class AccountNameIndex
+
+}  // namespace dcm
+
+#endif  // GUARD_account_name_index_hpp_8352960174126843
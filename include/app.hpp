@@ -20,11 +20,14 @@
 #include "dcm_database_connection.hpp"
 #include "gui/error_reporter.hpp"
 #include "gui/frame.hpp"
+#include "task_scheduler.hpp"
+#include "warm_start_cache.hpp"
 #include <boost/filesystem.hpp>
 #include <boost/optional.hpp>
 #include <jewel/version_fwd.hpp>
 #include <wx/app.h>
 #include <wx/config.h>
+#include <wx/event.h>
 #include <wx/intl.h>
 #include <wx/snglinst.h>
 #include <wx/string.h>
@@ -101,8 +104,17 @@ public:
 
     DcmDatabaseConnection& database_connection();
 
+    /**
+     * @returns the TaskScheduler on which long-running work can be done
+     * in the background. See gui/task_bridge.hpp for getting results back
+     * to the GUI thread.
+     */
+    TaskScheduler& task_scheduler();
+
 private:
 
+    void on_gui_callback(wxThreadEvent& event);
+
     /**
      * @returns the filepath of the application file last opened by the
      * user, stored in a boost::optional. The returned optional
@@ -121,19 +133,39 @@ private:
 
     void configure_logging();
     
-    void make_backup(boost::filesystem::path const& p_original_filepath);
+    /**
+     * Start the parts of startup that the user need not wait for
+     * before the main window is shown: loading the ledger (from which
+     * the balances and favourite Accounts are drawn), and backing up the
+     * database file. These run on the TaskScheduler. When both are done,
+     * the Repeaters are updated, and the results reported to the Frame.
+     */
+    void start_deferred_startup();
+
+    void on_deferred_startup_stage_done();
+
+    /**
+     * @returns the main Frame, or nullptr if the event loop is not
+     * running or the Frame is being destroyed.
+     */
+    gui::Frame* main_frame();
 
     static wxConfig& config();
 
     boost::filesystem::path elicit_existing_filepath();
 
     bool m_exiting_cleanly;
+    int m_num_pending_startup_stages;
     wxSingleInstanceChecker* m_single_instance_checker;
     std::unique_ptr<DcmDatabaseConnection> m_database_connection;
+    std::unique_ptr<TaskScheduler> m_task_scheduler;  // created on demand
+    std::unique_ptr<WarmStartCache> m_warm_start_cache;
     boost::optional<boost::filesystem::path> m_database_filepath;
     boost::optional<boost::filesystem::path> m_backup_filepath;
     gui::ErrorReporter m_error_reporter;
     wxLocale m_locale;
+
+    DECLARE_EVENT_TABLE()
 };
 
 /// @cond
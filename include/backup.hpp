@@ -52,6 +52,9 @@ namespace dcm
  * Preconditions: it is the caller's resonsibility to ensure that
  * p_directory and p_original exist. Also, both p_original and p_directory
  * should be absolute filepaths.
+ *
+ * This touches only the filesystem, and so may be called on any thread
+ * (e.g. within a task run on a TaskScheduler).
  */
 boost::filesystem::path make_backup
 (   boost::filesystem::path const& p_original,
@@ -52,6 +52,15 @@ class DcmDatabaseConnection;
 // as such do not need to trigger BalanceCache staleness.
 // Repeater. These contain only draft Entries so do not need to trigger
 // staleness.
+//
+// Opening balances are cached separately, and are only affected by the
+// OrdinaryJournals dated opening_balance_journal_date(). So the opening
+// balances as a whole are marked as stale when such an OrdinaryJournal is
+// saved or removed (or an existing one is moved to or from that date), when
+// an existing Account is saved or removed (as its Commodity may have
+// changed), when the entity creation date (and so
+// opening_balance_journal_date()) is changed, and whenever the whole cache
+// is marked as stale; but not merely because an Entry is operated on.
 
 
 /**
@@ -97,6 +106,12 @@ public:
      */
     void mark_as_stale(sqloxx::Id p_account_id); 
 
+    /**
+     * Mark the cached opening balances of all Accounts as stale, without
+     * affecting the cached technical balances.
+     */
+    void mark_opening_balances_as_stale();
+
 private:
 
     typedef
@@ -105,14 +120,24 @@ private:
             boost::optional<jewel::Decimal>
         >
         Map;
+
+    typedef
+        std::unordered_map<sqloxx::Id, jewel::Decimal>
+        OpeningBalanceMap;
         
     void refresh();
     void refresh_all();
     void refresh_targetted(std::vector<sqloxx::Id> const& p_targets);
 
+    // Reads the opening balances of all Accounts with a single grouped
+    // query.
+    void refresh_opening_balances();
+
     DcmDatabaseConnection& m_database_connection;
     std::unique_ptr<Map> m_map;
     bool m_map_is_stale;
+    std::unique_ptr<OpeningBalanceMap> m_opening_balance_map;
+    bool m_opening_balance_map_is_stale;
 
 };
 
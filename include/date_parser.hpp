@@ -17,15 +17,91 @@
 #ifndef GUARD_date_parser_hpp_5151682568318994
 #define GUARD_date_parser_hpp_5151682568318994
 
+#include "date.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <wx/datetime.h>
 #include <wx/intl.h>
 #include <wx/string.h>
+#include <unordered_map>
+#include <vector>
 
 namespace dcm
 {
 
+/**
+ * A strftime-like date format string, "compiled" once into a short
+ * sequence of steps, so that dates can then be parsed and formatted
+ * according to it without going through wxDateTime.
+ *
+ * Only "simple" formats can be compiled, being those made up of exactly
+ * one day-of-month ("%d"), one month ("%m") and one year ("%y" or "%Y")
+ * field, together with any other characters (including "%%"). Anything
+ * else (e.g. "%A, %d %B %Y") leaves the CompiledDateFormat invalid, and
+ * the caller should fall back on wxDateTime.
+ */
+class CompiledDateFormat
+{
+public:
+
+    explicit CompiledDateFormat(wxString const& p_format);
+
+    CompiledDateFormat(CompiledDateFormat const&) = default;
+    CompiledDateFormat(CompiledDateFormat&&) = default;
+    CompiledDateFormat& operator=(CompiledDateFormat const&) = default;
+    CompiledDateFormat& operator=(CompiledDateFormat&&) = default;
+    ~CompiledDateFormat() = default;
+
+    /**
+     * @returns \e true if and only if the format string could be compiled.
+     * The other member functions should not be called unless this returns
+     * \e true.
+     */
+    bool is_valid() const;
+
+    /**
+     * Parses \e p_string, accepting just what wxDateTime::ParseFormat
+     * would accept if passed the same format string (with the whole of
+     * \e p_string to be consumed), except that a year given with "%Y" that
+     * is less than 100 is taken to be in the 2000s, and that the date must
+     * be one that can be represented by a boost::gregorian::date.
+     *
+     * @returns \e true, and sets \e p_date_rep to the date parsed, if
+     * parsing is successful; otherwise returns \e false, leaving \e
+     * p_date_rep unchanged.
+     */
+    bool parse(wxString const& p_string, DateRep& p_date_rep) const;
+
+    /**
+     * @returns \e p_date_rep formatted as std::strftime would format it
+     * with the same format string. \e p_date_rep must be a valid date
+     * (see is_valid_date(...)).
+     */
+    wxString format(DateRep p_date_rep) const;
+
+private:
+
+    enum class StepType: unsigned char
+    {
+        literal,     // matches the character itself
+        space,       // matches any amount of whitespace, including none
+        day,         // "%d"
+        month,       // "%m"
+        short_year,  // "%y"
+        year         // "%Y"
+    };
+
+    struct Step
+    {
+        StepType type;
+        wxUniChar character;
+    };
+
+    std::vector<Step> m_steps;
+
+};  // class CompiledDateFormat
+
+
 class DateParser
 {
 public:
@@ -63,8 +139,22 @@ public:
         bool p_be_tolerant = false
     ) const;
 
+    /**
+     * As for parse(p_string, false), but returning the date as a DateRep.
+     * Where the formats are simple enough to be compiled (see
+     * CompiledDateFormat), this does not go through wxDateTime or
+     * boost::gregorian::date at all, and so is the one to use where many
+     * dates are to be parsed.
+     */
+    boost::optional<DateRep> parse_date_rep(wxString const& p_string) const;
+
 private:
 
+    boost::optional<DateRep> wx_parse
+    (   wxString const& p_string,
+        wxString const& p_format
+    ) const;
+
     boost::optional<boost::gregorian::date> tolerant_parse
     (   wxString const& p_string
     ) const;
@@ -77,8 +167,50 @@ private:
     // tolerant than this.
     wxString const m_secondary_format;
 
+    CompiledDateFormat const m_compiled_primary_format;
+    CompiledDateFormat const m_compiled_secondary_format;
+
 };  // class DateParser
 
+
+/**
+ * Formats dates according to a date format string, remembering the
+ * string for each date it has formatted, so that formatting a date the
+ * second time round costs only a hash table lookup. This suits a list
+ * in which many rows share a handful of dates.
+ *
+ * Where the format string is too complex to be compiled (see
+ * CompiledDateFormat), dates are formatted with wxDateTime::Format.
+ */
+class DateFormatter
+{
+public:
+
+    explicit DateFormatter
+    (   wxString const& p_format = wxLocale::GetInfo(wxLOCALE_SHORT_DATE_FMT)
+    );
+
+    DateFormatter(DateFormatter const&) = default;
+    DateFormatter(DateFormatter&&) = default;
+    DateFormatter& operator=(DateFormatter const&) = default;
+    DateFormatter& operator=(DateFormatter&&) = default;
+    ~DateFormatter() = default;
+
+    /**
+     * @returns the string representation of \e p_date_rep, which must be
+     * a valid date (see is_valid_date(...)). The reference remains valid
+     * for the lifetime of the DateFormatter.
+     */
+    wxString const& format(DateRep p_date_rep) const;
+
+private:
+
+    wxString m_format;
+    CompiledDateFormat m_compiled_format;
+    mutable std::unordered_map<DateRep, wxString> m_cache;
+
+};  // class DateFormatter
+
 }  // namespace dcm
 
 #endif  // GUARD_date_parser_hpp_5151682568318994
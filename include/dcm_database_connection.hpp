@@ -22,11 +22,14 @@
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/optional.hpp>
 #include <sqloxx/database_connection.hpp>
 #include <sqloxx/handle_fwd.hpp>
 #include <sqloxx/id.hpp>
 #include <sqloxx/identity_map_fwd.hpp>
 #include <jewel/decimal.hpp>
+#include <wx/string.h>
+#include <cstddef>
 #include <list>
 #include <string>
 
@@ -38,11 +41,18 @@ namespace dcm
 class AmalgamatedBudget;
 class AmalgamatedBudgetSignature;
 class Account;
+class AccountNameIndex;
 class BalanceCache;
 class BudgetItem;
 class Commodity;
 class DraftJournal;
 class Entry;
+class EntryFingerprint;
+class EntryFingerprintIndex;
+template <typename T> class HandleCache;
+class LedgerImporter;
+class LedgerSnapshot;
+class OrdinaryJournal;
 class PersistentJournal;
 class Repeater;
 
@@ -113,6 +123,9 @@ public:
      * that are not cached under the new level, that were cached under the old
      * level, that are cached at the time the level changes, are emptied from
      * the cache.
+     *
+     * For a bounded degree of caching of Entries and journals, see
+     * handle_cache().
      */
     void set_caching_level(unsigned int level);
 
@@ -161,6 +174,10 @@ public:
      * the entity creation date that was set here will be automatically saved
      * to the database at that time.
      *
+     * The cached opening balances of the Accounts are marked as stale, as
+     * the opening balance journals are those dated the day before the
+     * entity creation date.
+     *
      * Exception safety: <em>strong guarantee</em>.
      */
     void set_entity_creation_date
@@ -179,6 +196,13 @@ public:
      * by AmalgamatedBudget.
      */
     sqloxx::Handle<DraftJournal> budget_instrument() const;
+
+    /**
+     * @returns the in-memory, column-wise snapshot of the ordinary Entries
+     * in the database, through which reports and Entry lists can be
+     * populated without querying the database for each row.
+     */
+    LedgerSnapshot& ledger_snapshot() const;
     
     /**
      * Class to provide restricted access to cache holding Account balances.
@@ -189,6 +213,9 @@ public:
         friend class Account;
         friend class Commodity;
         friend class Entry;
+        friend class LedgerImporter;
+        friend class OrdinaryJournal;
+        friend class PersistentJournal;
         BalanceCacheAttorney() = delete;
         ~BalanceCacheAttorney() = delete;
     private:
@@ -200,6 +227,10 @@ public:
         (   DcmDatabaseConnection const& p_database_connection,
             sqloxx::Id p_account_id
         );
+        // Mark the opening balances of all Accounts as stale.
+        static void mark_opening_balances_as_stale
+        (   DcmDatabaseConnection const& p_database_connection
+        );
         // Retrieve the technical_balance of an Account
         static jewel::Decimal technical_balance
         (   DcmDatabaseConnection const& p_database_connection,
@@ -213,6 +244,75 @@ public:
     };
     friend class BalanceCacheAttorney;
 
+    /**
+     * Class to provide restricted access to the index by means of which
+     * duplicate Entries can be detected.
+     */
+    class EntryFingerprintAttorney
+    {
+    public:
+        friend class Entry;
+        friend class LedgerImporter;
+        friend class OrdinaryJournal;
+        friend class PersistentJournal;
+        EntryFingerprintAttorney() = delete;
+        ~EntryFingerprintAttorney() = delete;
+    private:
+        // Mark whole index as stale.
+        static void mark_as_stale
+        (   DcmDatabaseConnection const& p_database_connection
+        );
+        static void mark_journal_as_stale
+        (   DcmDatabaseConnection const& p_database_connection,
+            sqloxx::Id p_journal_id
+        );
+        static void mark_entry_as_stale
+        (   DcmDatabaseConnection const& p_database_connection,
+            sqloxx::Id p_entry_id
+        );
+        // Record a newly inserted ordinary Entry, bypassing Entry.
+        static void add_entry
+        (   DcmDatabaseConnection const& p_database_connection,
+            sqloxx::Id p_entry_id,
+            EntryFingerprint const& p_fingerprint
+        );
+        // Retrieve the number of ordinary Entries in the database having
+        // a given EntryFingerprint.
+        static std::size_t count
+        (   DcmDatabaseConnection const& p_database_connection,
+            EntryFingerprint const& p_fingerprint
+        );
+    };
+    friend class EntryFingerprintAttorney;
+
+    /**
+     * Class to provide restricted access to the index by means of which
+     * Accounts are looked up by name.
+     */
+    class AccountNameAttorney
+    {
+    public:
+        friend class Account;
+        AccountNameAttorney() = delete;
+        ~AccountNameAttorney() = delete;
+    private:
+        // Mark whole index as stale.
+        static void mark_as_stale
+        (   DcmDatabaseConnection const& p_database_connection
+        );
+        static void mark_account_as_stale
+        (   DcmDatabaseConnection const& p_database_connection,
+            sqloxx::Id p_account_id
+        );
+        // Retrieve the id of the Account with a given name, matched case
+        // insensitively, if there is one.
+        static boost::optional<sqloxx::Id> find
+        (   DcmDatabaseConnection const& p_database_connection,
+            wxString const& p_name
+        );
+    };
+    friend class AccountNameAttorney;
+
     Frequency budget_frequency() const;
 
     bool supports_budget_frequency(Frequency const& p_frequency) const;
@@ -249,6 +349,16 @@ public:
     template<typename T>
     sqloxx::IdentityMap<T>& identity_map();
 
+    /**
+     * @returns the HandleCache through which the most recently used
+     * objects of type T can be kept in memory, within a bounded number,
+     * when caching is disabled in the IdentityMap for T (see
+     * set_caching_level(...)). Provided for Entry and PersistentJournal.
+     * Each retains nothing until given a capacity.
+     */
+    template<typename T>
+    HandleCache<T>& handle_cache();
+
 private:
 
     /**
@@ -326,6 +436,9 @@ private:
     // order of deletion of pointer members.
     PermanentEntityData* m_permanent_entity_data;
     BalanceCache* m_balance_cache;
+    EntryFingerprintIndex* m_entry_fingerprint_index;
+    AccountNameIndex* m_account_name_index;
+    LedgerSnapshot* m_ledger_snapshot;
     AmalgamatedBudget* m_budget;
     sqloxx::IdentityMap<Account>* m_account_map;
     sqloxx::IdentityMap<BudgetItem>* m_budget_item_map;
@@ -333,6 +446,8 @@ private:
     sqloxx::IdentityMap<Entry>* m_entry_map;
     sqloxx::IdentityMap<PersistentJournal>* m_journal_map;
     sqloxx::IdentityMap<Repeater>* m_repeater_map;
+    HandleCache<Entry>* m_entry_cache;
+    HandleCache<PersistentJournal>* m_journal_cache;
 
     void perform_integrity_checks();
 
@@ -228,6 +228,40 @@ JEWEL_DERIVED_EXCEPTION(InvalidTransactionTypeException, DcmException);
  */
 JEWEL_DERIVED_EXCEPTION(UniqueNameException, DcmException);
 
+/*
+ * Exception to be thrown when a file of transactions being imported from an
+ * external source (e.g. a bank statement) cannot be parsed, or contains
+ * a record that cannot validly be posted.
+ */
+JEWEL_DERIVED_EXCEPTION(LedgerImportException, DcmException);
+
+/**
+ * Exception to be thrown when a ledger export cannot be written, or when
+ * a file being read as a ledger export is not one, or is corrupt.
+ */
+JEWEL_DERIVED_EXCEPTION(LedgerExportException, DcmException);
+
+/*
+ * Exception to be thrown when an accounting period cannot be closed.
+ */
+JEWEL_DERIVED_EXCEPTION(PeriodCloseException, DcmException);
+
+/*
+ * Exception to be thrown by a task run on a TaskScheduler that stops
+ * early because it has been cancelled.
+ */
+JEWEL_DERIVED_EXCEPTION(TaskCancelledException, DcmException);
+
+/*
+ * Exception to be thrown when a ReadOnlyConnection cannot be opened.
+ */
+JEWEL_DERIVED_EXCEPTION(ReadOnlyConnectionException, DcmException);
+
+/**
+ * Exception to be thrown when a WarmStartCache cannot be saved.
+ */
+JEWEL_DERIVED_EXCEPTION(WarmStartCacheException, DcmException);
+
 }  // namespace dcm
 
 /// @endcond
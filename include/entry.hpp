@@ -31,6 +31,7 @@
 #include <wx/string.h>
 #include <memory>
 #include <string>
+#include <vector>
 
 
 namespace dcm
@@ -98,6 +99,14 @@ public:
      */
     void set_journal_id(sqloxx::Id p_journal_id);
 
+    /**
+     * Records the date of the OrdinaryJournal to which the Entry belongs,
+     * so that date() can be answered without loading the journal. Note
+     * this should \e not normally be called; it is called by
+     * OrdinaryJournal when the journal is saved.
+     */
+    void set_journal_date(boost::gregorian::date const& p_date);
+
     void set_account(sqloxx::Handle<Account> const& p_account);
 
     void set_comment(wxString const& p_comment);
@@ -177,9 +186,31 @@ public:
      * @returns the posting date of the Entry, assuming it is associated
      * with an OrdinaryJournal. If it is associated with another kind of
      * Journal, then behaviour is undefined.
+     *
+     * Once the Entry has been saved or loaded, this is the date as last
+     * saved for the OrdinaryJournal, and the journal is not loaded.
      */
     boost::gregorian::date date();
 
+    /**
+     * @returns \e true if the Entry has never been saved, or if any of its
+     * attributes has been set to a different value since it was last
+     * loaded or saved. Saving an existing Entry for which this returns
+     * \e false does not touch the database.
+     *
+     * Does not cause the Entry to be loaded.
+     */
+    bool has_unsaved_changes();
+
+    /**
+     * @returns \e true if the Entry has never been saved, or if its
+     * Account or amount has been changed since it was last loaded or
+     * saved, i.e. if saving it could change the balance of an Account.
+     *
+     * Does not cause the Entry to be loaded.
+     */
+    bool has_unsaved_balance_changes();
+
 private:
 
     void swap(Entry& rhs);
@@ -204,22 +235,22 @@ private:
 
 
 /**
- * @returns a unique_ptr to a heap-allocated SQLStatement from which
- * entry_id may be selected from the first result column. Contains
- * only Entries that belong to actual (i.e. non-budget)
- * Journals that are OrdinaryJournals (i.e. not DraftJournals).
- * Filtering may optionally be performed by Account and/or date.
- * Within the result set, Entries are ordered by date.
+ * Set whether each of \e p_entries is reconciled to \e p_is_reconciled,
+ * saving those whose status changes, all within a single
+ * sqloxx::DatabaseTransaction, so that reconciling many Entries at once
+ * costs only one commit.
+ *
+ * @returns the ids of the Entries whose status changed, in the order in
+ * which they appear in \e p_entries.
+ *
+ * Exception safety: <em>strong guarantee</em> as regards the database. If
+ * an exception is thrown, the Entries that had been changed are
+ * ghostified, so that they are reloaded as they are in the database.
  */
-std::unique_ptr<sqloxx::SQLStatement>
-create_date_ordered_actual_ordinary_entry_selector
+std::vector<sqloxx::Id> set_whether_reconciled
 (   DcmDatabaseConnection& p_database_connection,
-    boost::optional<boost::gregorian::date> const& p_maybe_min_date =
-        boost::optional<boost::gregorian::date>(),
-    boost::optional<boost::gregorian::date> const& p_maybe_max_date =
-        boost::optional<boost::gregorian::date>(),
-    boost::optional<sqloxx::Handle<Account> > const& p_maybe_account =
-        boost::optional<sqloxx::Handle<Account> >()
+    std::vector<sqloxx::Handle<Entry> > const& p_entries,
+    bool p_is_reconciled
 );
 
 }  // namespace dcm
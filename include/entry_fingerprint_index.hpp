@@ -0,0 +1,188 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_entry_fingerprint_index_hpp_2970418836651047
+#define GUARD_entry_fingerprint_index_hpp_2970418836651047
+
+#include "date.hpp"
+#include <jewel/decimal.hpp>
+#include <sqloxx/id.hpp>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class DcmDatabaseConnection;
+
+// End forward declarations
+
+/**
+ * Identifies an ordinary Entry for the purpose of detecting duplicate
+ * transactions, e.g. when the same bank statement is imported twice. Two
+ * Entries with the same Account, date, amount and "normalized" comment
+ * have the same EntryFingerprint.
+ *
+ * The comment is normalized by converting ASCII letters to lower case,
+ * collapsing each run of whitespace to a single space, and trimming
+ * leading and trailing whitespace.
+ */
+class EntryFingerprint
+{
+public:
+
+    /**
+     * @param p_amount_intval should be the amount of the Entry, expressed
+     * in terms of the precision of the Commodity of the Account
+     * (i.e. as it is stored in the database).
+     *
+     * @param p_comment should be UTF-8 encoded.
+     */
+    EntryFingerprint
+    (   sqloxx::Id p_account_id,
+        DateRep p_date,
+        jewel::Decimal::int_type p_amount_intval,
+        std::string const& p_comment
+    );
+
+    EntryFingerprint(EntryFingerprint const&) = default;
+    EntryFingerprint(EntryFingerprint&&) = default;
+    EntryFingerprint& operator=(EntryFingerprint const&) = default;
+    EntryFingerprint& operator=(EntryFingerprint&&) = default;
+    ~EntryFingerprint() = default;
+
+    bool operator==(EntryFingerprint const& rhs) const;
+
+    /**
+     * Function object for hashing an EntryFingerprint, for use with
+     * unordered containers.
+     */
+    struct Hasher
+    {
+        std::size_t operator()(EntryFingerprint const& p_fingerprint) const;
+    };
+
+private:
+
+    sqloxx::Id m_account_id;
+    DateRep m_date;
+    jewel::Decimal::int_type m_amount_intval;
+    std::string m_comment;
+
+};  // class EntryFingerprint
+
+
+// Summary of what triggers staleness - along the same lines as for
+// BalanceCache:
+// Entry - saving an Entry marks its Journal as stale, so that
+// the fingerprints of all that Journal's Entries are re-read from the
+// database on the next lookup. (We can't just compute the fingerprint
+// of the Entry as it is saved, as the date is a property of the Journal,
+// which may not yet have been saved at that point; and re-reading also
+// means we don't have to worry about the database being rolled back
+// after we have been notified.) Removing an Entry marks that Entry as
+// stale.
+// LedgerImporter - this bypasses Entry, but knows the fingerprint of each
+// Entry it inserts, so it adds these to the index directly, once its
+// transaction has been committed.
+
+/**
+ * Provides an in-memory index, keyed by EntryFingerprint, of all the
+ * ordinary (i.e. non-draft) Entries in the database. The index is built
+ * lazily on the first lookup, and thereafter maintained incrementally,
+ * so that each lookup is just a hash lookup.
+ */
+class EntryFingerprintIndex
+{
+public:
+
+    explicit EntryFingerprintIndex
+    (   DcmDatabaseConnection& p_database_connection
+    );
+
+    EntryFingerprintIndex(EntryFingerprintIndex const&) = delete;
+    EntryFingerprintIndex(EntryFingerprintIndex&&) = delete;
+    EntryFingerprintIndex& operator=(EntryFingerprintIndex const&) = delete;
+    EntryFingerprintIndex& operator=(EntryFingerprintIndex&&) = delete;
+    ~EntryFingerprintIndex();
+
+    /**
+     * @returns the number of ordinary Entries in the database with the
+     * fingerprint \e p_fingerprint.
+     */
+    std::size_t count(EntryFingerprint const& p_fingerprint);
+
+    /**
+     * Record that an ordinary Entry with id \e p_entry_id and fingerprint
+     * \e p_fingerprint has been inserted into the database, and that the
+     * insertion has been committed. If the index as a whole is stale, this
+     * does nothing, as the Entry will be read along with all the others.
+     */
+    void add_entry
+    (   sqloxx::Id p_entry_id,
+        EntryFingerprint const& p_fingerprint
+    );
+
+    /**
+     * Mark the index as a whole as stale.
+     */
+    void mark_as_stale();
+
+    /**
+     * Mark as stale the fingerprints of the Entries in the Journal with
+     * id \e p_journal_id.
+     */
+    void mark_journal_as_stale(sqloxx::Id p_journal_id);
+
+    /**
+     * Mark as stale the fingerprint of the Entry with id \e p_entry_id.
+     */
+    void mark_entry_as_stale(sqloxx::Id p_entry_id);
+
+private:
+
+    typedef
+        std::unordered_map
+        <   EntryFingerprint,
+            std::size_t,
+            EntryFingerprint::Hasher
+        >
+        CountMap;
+
+    typedef std::unordered_map<sqloxx::Id, EntryFingerprint> EntryMap;
+
+    void refresh();
+    void refresh_all();
+    void refresh_journal(sqloxx::Id p_journal_id);
+    void insert(sqloxx::Id p_entry_id, EntryFingerprint const& p_fingerprint);
+    void erase(sqloxx::Id p_entry_id);
+
+    DcmDatabaseConnection& m_database_connection;
+    CountMap m_counts;
+    EntryMap m_entries;
+    std::unordered_set<sqloxx::Id> m_stale_journal_ids;
+    std::unordered_set<sqloxx::Id> m_stale_entry_ids;
+    bool m_is_stale;
+
+};  // class EntryFingerprintIndex
+
+}  // namespace dcm
+
+#endif  // GUARD_entry_fingerprint_index_hpp_2970418836651047
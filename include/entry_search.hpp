@@ -0,0 +1,97 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_entry_search_hpp_4620981735502718
+#define GUARD_entry_search_hpp_4620981735502718
+
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/optional.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/id.hpp>
+#include <wx/string.h>
+#include <cstddef>
+#include <vector>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class DcmDatabaseConnection;
+
+// End forward declarations
+
+/**
+ * What to search for with search_entries(...). Each of the optional
+ * fields, if uninitialized, places no restriction on the results.
+ */
+struct EntrySearchQuery
+{
+    EntrySearchQuery(): max_results(500)
+    {
+    }
+
+    // The words to look for in the comment of the Entry or of its
+    // journal. An Entry matches only if every word is found, either
+    // as a whole word or as the beginning of one, ignoring case.
+    wxString text;
+
+    // Inclusive.
+    boost::optional<boost::gregorian::date> min_date;
+    boost::optional<boost::gregorian::date> max_date;
+
+    // Inclusive, and compared with the absolute value of Entry::amount().
+    boost::optional<jewel::Decimal> min_amount;
+    boost::optional<jewel::Decimal> max_amount;
+
+    std::size_t max_results;
+};
+
+/**
+ * Set up the full-text index of the comments of the Entries and of their
+ * journals, if the database does not have it already (including if the
+ * database was created before there was such an index, in which case the
+ * index is built from the existing Entries). Thereafter the index is kept
+ * up to date by triggers in the database, however the Entries and
+ * journals are saved or removed.
+ *
+ * If the SQLite library does not support FTS5, then no index is set up,
+ * and search_entries(...) falls back on a (much slower) scan of the
+ * comments.
+ */
+void setup_entry_search(DcmDatabaseConnection& p_database_connection);
+
+/**
+ * @returns the ids of the Entries of OrdinaryJournals, in all Accounts,
+ * that match \e p_query, with the best matches first. For an Entry, a
+ * match in its own comment counts for more than a match in the comment of
+ * its journal. If the text of \e p_query contains no words, then no
+ * Entries are returned.
+ *
+ * The amounts in \e p_query are taken to be in the precision of the
+ * default Commodity.
+ *
+ * @todo LOW PRIORITY If we can ever have multiple Commodities, then the
+ * amount filters will need to take this into account.
+ */
+std::vector<sqloxx::Id> search_entries
+(   DcmDatabaseConnection& p_database_connection,
+    EntrySearchQuery const& p_query
+);
+
+}  // namespace dcm
+
+#endif  // GUARD_entry_search_hpp_4620981735502718
@@ -24,10 +24,11 @@
 #define GUARD_finformat_hpp_5275738907640678
 
 #include "string_flags.hpp"
-#include <jewel/decimal_fwd.hpp>
+#include <jewel/decimal.hpp>
 #include <jewel/flag_set.hpp>
 #include <wx/intl.h>
 #include <wx/string.h>
+#include <cstddef>
 #include <string>
 
 /**
@@ -60,6 +61,64 @@ typedef
     >
     DecimalParsingFlags;
 
+/**
+ * Formats jewel::Decimal as does finformat_wx(...), but reads the
+ * decimal point and thousands separator from the wxLocale just once, on
+ * construction. Where many numbers are to be formatted with the same
+ * wxLocale and DecimalFormatFlags, construct one DecimalFormatter and
+ * reuse it.
+ *
+ * The wxLocale is not retained; a DecimalFormatter constructed before
+ * the settings of the wxLocale change goes on using the old settings.
+ */
+class DecimalFormatter
+{
+public:
+
+    explicit DecimalFormatter
+    (   wxLocale const& p_locale,
+        DecimalFormatFlags p_flags = DecimalFormatFlags()
+    );
+
+    DecimalFormatter(DecimalFormatter const&) = default;
+    DecimalFormatter(DecimalFormatter&&) = default;
+    DecimalFormatter& operator=(DecimalFormatter const&) = default;
+    DecimalFormatter& operator=(DecimalFormatter&&) = default;
+    ~DecimalFormatter() = default;
+
+    /**
+     * @returns \e p_decimal formatted as finformat_wx(...) would format
+     * it, given the wxLocale and flags passed to the constructor.
+     */
+    wxString format(jewel::Decimal const& p_decimal) const;
+
+private:
+
+    /**
+     * @returns the most characters that write_backwards(...) might write
+     * for a number with \e p_places decimal places.
+     */
+    std::size_t max_length(jewel::Decimal::places_type p_places) const;
+
+    /**
+     * Write the formatted number backwards, so that its last character is
+     * at p_end - 1.
+     *
+     * @returns the number of characters written.
+     */
+    std::size_t write_backwards
+    (   jewel::Decimal::int_type p_intval,
+        jewel::Decimal::places_type p_places,
+        wxChar* p_end
+    ) const;
+
+    bool m_dash_for_zero;
+    bool m_pad;
+    wxString m_decimal_point;
+    wxString m_thousands_sep;
+
+};  // class DecimalFormatter
+
 /**
  * @returns decimal formatted as a wxString, with parentheses
  * to indicate negative, and with thousands separator and
@@ -81,6 +140,9 @@ typedef
  * If DCM_DISALLOW_DASH_FOR_ZERO is defined, then
  * dash is never used for zero, regardless of the contents
  * of \e p_flags.
+ *
+ * This reads the wxLocale afresh on each call; see DecimalFormatter for
+ * formatting many numbers.
  */
 wxString finformat_wx
 (   jewel::Decimal const& decimal,
@@ -88,6 +150,119 @@ wxString finformat_wx
     DecimalFormatFlags p_flags = DecimalFormatFlags()
 );
 
+/**
+ * Reads numbers as do wx_to_decimal(...) and wx_to_simple_sum(...), but
+ * reads the decimal point and thousands separator from the wxLocale just
+ * once, on construction; and reads each string in a single pass over its
+ * characters, without copying it or throwing if it is not a number.
+ *
+ * The wxLocale is not retained; a DecimalParser constructed before the
+ * settings of the wxLocale change goes on using the old settings.
+ */
+class DecimalParser
+{
+public:
+
+    explicit DecimalParser
+    (   wxLocale const& p_locale,
+        DecimalParsingFlags p_flags = DecimalParsingFlags()
+    );
+
+    /**
+     * Read numbers with the decimal point \e p_decimal_point and the
+     * thousands separator \e p_thousands_sep, whatever the locale - as
+     * when reading a file in a fixed format. \e p_thousands_sep may be
+     * empty, in which case no thousands separator is accepted.
+     *
+     * Precondition: \e p_decimal_point must not be empty, and must differ
+     * from \e p_thousands_sep.
+     */
+    DecimalParser
+    (   wxString const& p_decimal_point,
+        wxString const& p_thousands_sep,
+        DecimalParsingFlags p_flags = DecimalParsingFlags()
+    );
+
+    DecimalParser(DecimalParser const&) = default;
+    DecimalParser(DecimalParser&&) = default;
+    DecimalParser& operator=(DecimalParser const&) = default;
+    DecimalParser& operator=(DecimalParser&&) = default;
+    ~DecimalParser() = default;
+
+    /**
+     * Read \e p_string as wx_to_decimal(...) would, given the wxLocale
+     * and flags passed to the constructor.
+     *
+     * @returns \e true, setting \e p_decimal to the number read, if
+     * \e p_string is a number; otherwise \e false, setting
+     * \e p_error_position to the (0-based) position in \e p_string of
+     * the first character that cannot be read as part of a number, or to
+     * the length of \e p_string if it ends too soon.
+     *
+     * @throws jewel::DecimalException or some derivative thereof, if
+     * \e p_string is a number, but has too many digits to be held in a
+     * jewel::Decimal.
+     */
+    bool parse
+    (   wxString const& p_string,
+        jewel::Decimal& p_decimal,
+        std::size_t& p_error_position
+    ) const;
+
+    /**
+     * As for parse(...), but reads \e p_string as wx_to_simple_sum(...)
+     * would. Parentheses are not accepted, whatever the flags passed to the
+     * constructor.
+     *
+     * @throws jewel::DecimalException or some derivative thereof, if
+     * any term, or the sum, cannot be held in a jewel::Decimal.
+     */
+    bool parse_simple_sum
+    (   wxString const& p_string,
+        jewel::Decimal& p_decimal,
+        std::size_t& p_error_position
+    ) const;
+
+private:
+
+    /**
+     * Read a single term, running from \e p_begin to \e p_end and
+     * starting at \e p_position in the string, with an optional
+     * leading sign. If \e p_is_negated, the term is negated, and may not
+     * have a leading sign of its own.
+     */
+    bool parse_term
+    (   wxString::const_iterator p_begin,
+        wxString::const_iterator p_end,
+        std::size_t p_position,
+        bool p_is_negated,
+        bool p_ignore_spaces,
+        jewel::Decimal& p_decimal,
+        std::size_t& p_error_position
+    ) const;
+
+    /**
+     * Read, through the jewel::Decimal constructor from std::string, a
+     * term already known to be well formed, that is too large to be
+     * read directly.
+     */
+    jewel::Decimal parse_large_term
+    (   wxString::const_iterator p_begin,
+        wxString::const_iterator p_end,
+        bool p_is_negative,
+        bool p_ignore_spaces
+    ) const;
+
+    bool m_allow_parens;
+    wxString m_decimal_point;
+    wxString m_thousands_sep;
+
+    // The decimal point expected by the jewel::Decimal constructor from
+    // std::string, which is that of the global std::locale.
+    char m_std_decimal_point;
+
+};  // class DecimalParser
+
 /**
  * Assuming a locale of loc, convert a wxString to a jewel::Decimal.
  *
@@ -105,6 +280,11 @@ wxString finformat_wx
  * If DCM_DISALLOW_DASH_FOR_ZERO is defined, then
  * dash is never used for zero, regardless of the contents
  * of \e p_flags.
+ *
+ * @throws jewel::DecimalFromStringException if \e wxs is not a number.
+ *
+ * This reads the wxLocale afresh on each call; see DecimalParser for
+ * reading many numbers, or for reading without exceptions.
  */
 jewel::Decimal wx_to_decimal
 (   wxString wxs,
@@ -19,12 +19,16 @@
 
 #include "account_table_iterator.hpp"
 #include "account_type.hpp"
+#include "warm_start_cache.hpp"
+#include <jewel/decimal.hpp>
 #include <sqloxx/handle_fwd.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/event.h>
 #include <wx/listctrl.h>
 #include <wx/string.h>
 #include <wx/wx.h>
 #include <set>
+#include <vector>
 
 namespace dcm
 {
@@ -61,11 +65,18 @@ public:
      * AccountType and then by name. The widget displays, in two
      * columns, the name and the balance (i.e. \e friendly_balance())
      * of each Account.
+     *
+     * If \e p_show_balances is false, the balance and budget columns are
+     * left blank (or show the figures passed to
+     * show_provisional_figures(...)), and no balances or budgets are
+     * calculated, until show_balances() is called. This allows the list
+     * to be shown before the ledger has been loaded.
      */
     AccountListCtrl
     (   wxWindow* p_parent,
         DcmDatabaseConnection& p_database_connection,
-        AccountSuperType p_account_super_type
+        AccountSuperType p_account_super_type,
+        bool p_show_balances = true
     );
 
     AccountListCtrl(AccountListCtrl const&) = delete;
@@ -85,9 +96,30 @@ public:
      * Redraw AccountListCtrl on the basis of what is currently in the
      * database, showing whichever AccountSuperType is currently being
      * shown.
+     *
+     * If the same Accounts are to be shown, in the same order, as
+     * were shown already, then only those cells whose contents have
+     * changed are redrawn, and selection and scrolled position are
+     * left alone. Otherwise the whole list is rebuilt.
      */
     void update();
 
+    /**
+     * Start showing balances, if they are not being shown already (see
+     * constructor).
+     */
+    void show_balances();
+
+    /**
+     * Until show_balances() is called, show the figures in \e p_figures
+     * (typically from a WarmStartCache) in place of blanks, for those
+     * Accounts that appear in \e p_figures. Has no effect if balances are
+     * already being shown.
+     */
+    void show_provisional_figures
+    (   WarmStartCache::AccountFiguresMap const& p_figures
+    );
+
     /**
      * @returns a Handle to what may be
      * considered the default Account in the AccountListCtrl; except that, if
@@ -117,10 +149,61 @@ private:
 
     bool showing_daily_budget() const;
 
+    /**
+     * What is shown in a single row of the AccountListCtrl.
+     */
+    struct AccountRow
+    {
+        sqloxx::Id account_id;
+        wxString name;
+        jewel::Decimal balance;
+        jewel::Decimal budget;
+        bool has_figures;  // if false, balance and budget are left blank
+    };
+
+    /**
+     * @returns \e true if and only if \e p_rows are for the same Accounts,
+     * in the same order, as m_rows.
+     */
+    bool has_same_accounts(std::vector<AccountRow> const& p_rows) const;
+
+    /**
+     * Redraw the cells of those rows in m_rows that differ from the
+     * corresponding row in \e p_rows.
+     *
+     * Precondition: has_same_accounts(p_rows).
+     */
+    void update_cells(std::vector<AccountRow> const& p_rows);
+
+    /**
+     * Clear the AccountListCtrl and redraw it from scratch to show
+     * \e p_rows, preserving (so far as possible) the selection and
+     * scrolled position.
+     */
+    void rebuild(std::vector<AccountRow> const& p_rows);
+
+    /**
+     * @returns the text to show in a cell in \e p_row for \e p_figure,
+     * which is either its balance or its budget.
+     */
+    static wxString figure_text
+    (   AccountRow const& p_row,
+        jewel::Decimal const& p_figure
+    );
+
+    void configure_column_widths();
+
     bool m_show_hidden;
+    bool m_show_balances;
+    WarmStartCache::AccountFiguresMap m_provisional_figures;
     AccountSuperType const m_account_super_type;
     DcmDatabaseConnection& m_database_connection;
 
+    /**
+     * Rows currently shown, in the order in which they are shown.
+     */
+    std::vector<AccountRow> m_rows;
+
     static int const s_name_col = 0;
     static int const s_balance_col = s_name_col + 1;
     static int const s_budget_col = s_name_col + 2;
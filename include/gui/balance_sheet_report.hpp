@@ -18,6 +18,7 @@
 #define GUARD_balance_sheet_report_hpp_8005432485605326
 
 #include "report.hpp"
+#include "report_totals.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <jewel/decimal.hpp>
@@ -25,6 +26,7 @@
 #include <wx/gdicmn.h>
 #include <wx/string.h>
 #include <unordered_map>
+#include <vector>
 
 namespace dcm
 {
@@ -59,9 +61,21 @@ public:
     virtual ~BalanceSheetReport();
 
 private:
-    virtual void do_generate() override;
-
-    void refresh_map();
+    virtual std::vector<ReportQuery> do_get_totals_queries()
+        override;
+    virtual void do_generate
+    (   std::vector<ReportTotals> const& p_totals
+    ) override;
+
+    /**
+     * @returns true if the Report covers the entire period since the
+     * opening balance date, in which case the opening and current
+     * balances of the Accounts can be used directly, and no totals
+     * need be accumulated.
+     */
+    bool covers_all_dates();
+
+    void refresh_map(std::vector<ReportTotals> const& p_totals);
 
     void display_body();
 
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_change_set_hpp_4418027593361208
+#define GUARD_change_set_hpp_4418027593361208
+
+#include <sqloxx/id.hpp>
+#include <cstddef>
+#include <unordered_set>
+#include <vector>
+
+namespace dcm
+{
+namespace gui
+{
+
+/**
+ * Kinds of change to PersistentObjects of which the GUI needs to be
+ * notified. These correspond to the PersistentObjectEvent types that
+ * notify of a completed change (as opposed to a request to create or
+ * edit something).
+ */
+enum class ChangeKind: unsigned char
+{
+    account_created = 0,
+    account_edited,
+    journal_created,
+    journal_edited,
+    draft_journal_deleted,
+    ordinary_journal_deleted,
+    draft_entry_deleted,
+    ordinary_entry_deleted,
+    budget_edited,  // the id is that of the Account
+    reconciliation_status,  // the id is that of the Entry
+    num_change_kinds  // Do not insert kinds below here.
+};
+
+/**
+ * Accumulates notifications of changes to PersistentObjects, so that the
+ * GUI can be brought up to date for all of them at once, rather than
+ * once per object.
+ *
+ * Within each ChangeKind, ids are kept in the order in which they were
+ * first recorded, and recording the same id twice has no further
+ * effect. Notifications that have been superseded are dropped: e.g. once
+ * a journal has been deleted, it is of no interest that it was created
+ * or edited; and once a journal has been recorded as created, it is of no
+ * interest that it was then edited.
+ */
+class ChangeSet
+{
+public:
+
+    ChangeSet();
+
+    ChangeSet(ChangeSet const&) = delete;
+    ChangeSet(ChangeSet&&) = default;
+    ChangeSet& operator=(ChangeSet const&) = delete;
+    ChangeSet& operator=(ChangeSet&&) = default;
+    ~ChangeSet() = default;
+
+    void record(ChangeKind p_kind, sqloxx::Id p_id);
+
+    /**
+     * @returns the ids recorded for \e p_kind, in the order in which they
+     * were first recorded.
+     */
+    std::vector<sqloxx::Id> const& ids(ChangeKind p_kind) const;
+
+    bool contains(ChangeKind p_kind, sqloxx::Id p_id) const;
+
+    bool is_empty() const;
+
+    void clear();
+
+private:
+
+    void erase(ChangeKind p_kind, sqloxx::Id p_id);
+
+    static std::size_t const s_num_kinds =
+        static_cast<std::size_t>(ChangeKind::num_change_kinds);
+
+    std::vector<std::vector<sqloxx::Id> > m_ids;
+    std::vector<std::unordered_set<sqloxx::Id> > m_id_sets;
+
+};  // class ChangeSet
+
+}  // namespace gui
+}  // namespace dcm
+
+#endif  // GUARD_change_set_hpp_4418027593361208
@@ -82,6 +82,13 @@ public:
      */
     boost::optional<boost::gregorian::date> date();
 
+    /**
+     * Show \e p_date in the control, or leave it blank if \e p_date is
+     * uninitialized (which should only be done if the control allows
+     * blanks).
+     */
+    void set_date(boost::optional<boost::gregorian::date> const& p_date);
+
 private:
     void on_kill_focus(wxFocusEvent& event);
     void on_set_focus(wxFocusEvent& event);
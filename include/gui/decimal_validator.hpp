@@ -17,6 +17,7 @@
 #ifndef GUARD_decimal_validator_hpp_503944817233805
 #define GUARD_decimal_validator_hpp_503944817233805
 
+#include "finformat.hpp"
 #include <jewel/decimal.hpp>
 #include <wx/intl.h>
 #include <wx/valtext.h>
@@ -61,6 +62,7 @@ private:
     bool m_print_dash_for_zero;
     jewel::Decimal::places_type m_precision;
     jewel::Decimal m_decimal;
+    DecimalParser m_parser;
 
 };  // class DecimalValidator
 
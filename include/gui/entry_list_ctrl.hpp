@@ -17,13 +17,16 @@
 #ifndef GUARD_entry_list_ctrl_hpp_03525603377970682
 #define GUARD_entry_list_ctrl_hpp_03525603377970682
 
+#include "date.hpp"
+#include "date_parser.hpp"
 #include "entry_table_iterator.hpp"
+#include "finformat.hpp"
 #include "reconciliation_list_panel.hpp"
 #include "summary_datum.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <sqloxx/handle_fwd.hpp>
-#include <sqloxx/sql_statement_fwd.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/event.h>
 #include <wx/gdicmn.h>
 #include <wx/listctrl.h>
@@ -38,7 +41,6 @@ namespace dcm
 
 class Account;
 class Entry;
-class DateParser;
 class OrdinaryJournal;
 class DcmDatabaseConnection;
 
@@ -101,6 +103,20 @@ public:
         boost::gregorian::date const& p_max_date
     );
 
+    /**
+     * @returns a pointer to a heap-allocated EntryListCtrl, listing the
+     * Entries whose ids are in \e p_entry_ids (e.g. as returned by
+     * search_entries(...)), in that order, whatever their Account.
+     *
+     * Caller has responsibility for managing the pointed-to memory.
+     */
+    static EntryListCtrl* create_search_entry_list
+    (   wxWindow* p_parent,
+        wxSize const& p_size,
+        DcmDatabaseConnection& p_database_connection,
+        std::vector<sqloxx::Id> const& p_entry_ids
+    );
+
     EntryListCtrl(EntryListCtrl const&) = delete;
     EntryListCtrl(EntryListCtrl&&) = delete;
     EntryListCtrl& operator=(EntryListCtrl const&) = delete;
@@ -188,13 +204,9 @@ protected:
     void adjust_comment_column_to_fit();
 
     /**
-     * @returns the date displayed in the row indexed by \e p_row, using \e
-     * p_parser to parse the text of the date.
+     * @returns the date displayed in the row indexed by \e p_row.
      */
-    boost::gregorian::date date_displayed
-    (   long p_row,
-        DateParser const& p_parser
-    ) const;
+    DateRep date_displayed(long p_row) const;
 
     /**
      * \e Assuming the displayed Entries are already ordered in increasing order
@@ -209,6 +221,11 @@ protected:
 
     DcmDatabaseConnection const& database_connection() const;
 
+    /**
+     * @returns the DecimalFormatter with which to display amounts.
+     */
+    DecimalFormatter const& amount_formatter() const;
+
 private:
 
     /**
@@ -261,13 +278,12 @@ private:
     virtual int do_get_comment_col_num() const = 0;
 
     /**
-     * Inheriting class should implement this so as to return a std::unique_ptr
-     * to a heap-allocated sqloxx::SQLStatement which is a "SELECT" SQL
-     * statement that selects just the primary key column from the database
-     * table in which Entry instances are stored.
+     * Inheriting class should implement this so as to return the ids of
+     * the Entries that are candidates for display, in the order in which
+     * they should be displayed. (This would normally be obtained from
+     * DcmDatabaseConnection::ledger_snapshot().)
      */
-    virtual std::unique_ptr<sqloxx::SQLStatement>
-        do_create_entry_selector() = 0;
+    virtual std::vector<sqloxx::Id> do_select_entry_ids() = 0;
 
     /**
      * This is called to update the displayed list to reflect that the Account
@@ -351,6 +367,14 @@ private:
 
     DcmDatabaseConnection& m_database_connection;
 
+    DecimalFormatter const m_amount_formatter;
+
+    // For the date column. These are kept for the life of the
+    // EntryListCtrl, as the DateFormatter remembers the dates it has
+    // formatted, and row_for_date(...) parses many dates.
+    DateParser const m_date_parser;
+    DateFormatter const m_date_formatter;
+
     DECLARE_EVENT_TABLE()
 
 };  // class EntryListCtrl
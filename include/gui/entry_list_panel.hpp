@@ -17,6 +17,7 @@
 #ifndef GUARD_entry_list_panel_hpp_3556466034407013
 #define GUARD_entry_list_panel_hpp_3556466034407013
 
+#include "warm_start_cache.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <sqloxx/handle_fwd.hpp>
@@ -78,8 +79,28 @@ public:
     void update_for_amended(sqloxx::Handle<Account> const& p_account);
     void update_for_deleted(std::vector<sqloxx::Id> const& p_doomed_ids);
 
+    /**
+     * Update the display after an unspecified (and possibly large) number
+     * of OrdinaryJournals have been posted or removed in bulk, e.g. by
+     * LedgerImporter or close_period(...).
+     */
+    void update_for_bulk_changes();
+
     std::vector<sqloxx::Handle<Entry> > selected_entries();
 
+    /**
+     * @returns the Account and date range currently chosen by the user.
+     */
+    EntryListFilter filter();
+
+    /**
+     * Set the Account and date range shown in the controls at the top,
+     * ready for the user to run. Fields of \e p_filter that are
+     * uninitialized leave the corresponding control as it is, except
+     * that the date controls are blanked where they allow it.
+     */
+    void set_filter(EntryListFilter const& p_filter);
+
     // TODO LOW PRIORITY This should really be private, but we need to call it
     // from TopPanel to ensure EntryListCtrl is properly sized, AFTER the
     // EntryListPanel has been constructed. Make this nicer.
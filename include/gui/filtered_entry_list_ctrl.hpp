@@ -22,9 +22,10 @@
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <sqloxx/handle.hpp>
-#include <sqloxx/sql_statement_fwd.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/window.h>
 #include <memory>
+#include <vector>
 
 namespace dcm
 {
@@ -81,8 +82,7 @@ private:
 
     virtual int do_get_comment_col_num() const = 0;
 
-    virtual std::unique_ptr<sqloxx::SQLStatement>
-        do_create_entry_selector() override;
+    virtual std::vector<sqloxx::Id> do_select_entry_ids() override;
 
     sqloxx::Handle<Account> const m_account;
     boost::gregorian::date m_min_date;
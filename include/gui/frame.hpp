@@ -17,10 +17,13 @@
 #ifndef GUARD_frame_hpp_873675392881816
 #define GUARD_frame_hpp_873675392881816
 
+#include "change_set.hpp"
 #include "repeater.hpp"
 #include "top_panel.hpp"
+#include "warm_start_cache.hpp"
 #include <jewel/assert.hpp>
 #include <sqloxx/handle_fwd.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/menu.h>
 #include <wx/wx.h>
 #include <wx/string.h>
@@ -52,9 +55,15 @@ class Frame: public wxFrame
 {
 public:
 
+    /**
+     * \e p_warm_start_cache supplies figures to show while the real ones
+     * are calculated (see TopPanel), and is updated with the user's
+     * choices when the Frame is closed. It must outlive the Frame.
+     */
     Frame
     (   wxString const& title,
-        DcmDatabaseConnection& p_database_connection
+        DcmDatabaseConnection& p_database_connection,
+        WarmStartCache& p_warm_start_cache
     );
 
     Frame(Frame const&) = delete;
@@ -91,6 +100,12 @@ public:
     std::vector<sqloxx::Handle<DraftJournal> >
     selected_draft_journals() const;
 
+    /**
+     * Fill in those parts of the main window that were left out when it
+     * was first shown (see TopPanel::complete_startup()).
+     */
+    void complete_startup();
+
     /**
      * Inform the Frame regarding the results of attempting
      * to fire Repeaters. The Frame then takes responsibility
@@ -107,6 +122,9 @@ private:
 
     // Event handlers - menu selections
     void on_menu_quit(wxCommandEvent& event);
+    void on_menu_import(wxCommandEvent& event);
+    void on_menu_export(wxCommandEvent& event);
+    void on_menu_close_period(wxCommandEvent& event);
     void on_menu_new_bs_account(wxCommandEvent& event); 
     void on_menu_new_pl_account(wxCommandEvent& event);
     void on_menu_new_transaction(wxCommandEvent& event);
@@ -126,7 +144,10 @@ private:
     void on_journal_editing_requested(PersistentObjectEvent& event);
 
     // Event handlers - other - handle notifications re. edited,
-    // created or deleted PersistentObjects.
+    // created or deleted PersistentObjects. These merely record the
+    // change in m_pending_changes; the display is brought up to date for
+    // all the changes recorded, once only, when the application next
+    // becomes idle.
     void on_account_created_event(PersistentObjectEvent& event);
     void on_account_edited_event(PersistentObjectEvent& event);
     void on_journal_created_event(PersistentObjectEvent& event);
@@ -138,6 +159,16 @@ private:
     void on_budget_edited_event(PersistentObjectEvent& event);
     void on_reconciliation_status_event(PersistentObjectEvent& event);
 
+    void on_idle(wxIdleEvent& event);
+
+    void on_close(wxCloseEvent& event);
+
+    void record_change(ChangeKind p_kind, sqloxx::Id p_id);
+
+    // Update the display to reflect the changes in m_pending_changes, if
+    // any, and clear m_pending_changes.
+    void dispatch_pending_changes();
+
     // The actual function which conducts Account editing.
     void edit_account(sqloxx::Handle<Account> const& p_account);
 
@@ -164,6 +195,9 @@ private:
         s_edit_draft_journal_id + 1;
     static int const s_toggle_pl_account_show_hidden_id =
         s_toggle_bs_account_show_hidden_id + 1;
+    static int const s_import_id = s_toggle_pl_account_show_hidden_id + 1;
+    static int const s_export_id = s_import_id + 1;
+    static int const s_close_period_id = s_export_id + 1;
 
     DcmDatabaseConnection& m_database_connection;
 
@@ -174,6 +208,7 @@ private:
     wxMenu* m_view_menu;
     wxMenu* m_help_menu;
     TopPanel* m_top_panel;
+    ChangeSet m_pending_changes;
 
     DECLARE_EVENT_TABLE()
 };
@@ -118,6 +118,17 @@ public:
         std::vector<sqloxx::Id> const& p_doomed_ids
     );
 
+    /**
+     * Convenience function to fire a DCM_RECONCILIATION_STATUS_EVENT for
+     * each of the Entries with ids \e p_entry_ids, e.g. after their
+     * reconciliation status has been changed in bulk. (The Frame gathers
+     * these up and updates the display for all of them at once.)
+     */
+    static void notify_reconciliation_statuses
+    (   wxWindow* p_originator,
+        std::vector<sqloxx::Id> const& p_entry_ids
+    );
+
 private:
 
     static void notify_many
@@ -18,11 +18,13 @@
 #define GUARD_pl_report_hpp_03798236466850264
 
 #include "report.hpp"
+#include "report_totals.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <jewel/decimal.hpp>
 #include <wx/gdicmn.h>
 #include <unordered_map>
+#include <vector>
 
 namespace dcm
 {
@@ -56,7 +58,11 @@ public:
     virtual ~PLReport();
 
 private:
-    virtual void do_generate() override;
+    virtual std::vector<ReportQuery> do_get_totals_queries()
+        override;
+    virtual void do_generate
+    (   std::vector<ReportTotals> const& p_totals
+    ) override;
 
     /**
      * @returns an initialized optional only if there is a max_date().
@@ -73,7 +79,7 @@ private:
         int p_count = 0
     );
 
-    void refresh_map();
+    void refresh_map(ReportTotals const& p_totals);
 
     void display_body();
 
@@ -18,18 +18,20 @@
 #define GUARD_reconciliation_entry_list_ctrl_hpp_7164053319564114
 
 #include "filtered_entry_list_ctrl.hpp"
+#include "finformat.hpp"
 #include "reconciliation_list_panel.hpp"
 #include "summary_datum.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <jewel/decimal.hpp>
 #include <sqloxx/handle_fwd.hpp>
-#include <sqloxx/sql_statement_fwd.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/gdicmn.h>
 #include <wx/imaglist.h>
 #include <wx/listctrl.h>
 #include <wx/window.h>
 #include <memory>
+#include <vector>
 
 
 namespace dcm
@@ -94,11 +96,23 @@ private:
 
     virtual void do_process_removal_for_summary(long p_row) override;
 
-    virtual std::unique_ptr<sqloxx::SQLStatement>
-        do_create_entry_selector() override;
+    virtual std::vector<sqloxx::Id> do_select_entry_ids() override;
 
+    /**
+     * Right-clicking an item toggles whether it is reconciled. If the item
+     * is among several selected items, or if the shift key is down, the
+     * user is instead offered a menu for marking the selected items, or
+     * all the items up to the item's date, in one go.
+     */
     void on_item_right_click(wxListEvent& event);
 
+    /**
+     * Set whether the Entries shown in \e p_rows are reconciled, saving
+     * them in a single DatabaseTransaction, then update the display and
+     * notify of the changes.
+     */
+    void reconcile_rows(std::vector<long> const& p_rows, bool p_is_reconciled);
+
     jewel::Decimal amount_for_row(long p_row) const;
 
     // This duplicates FilteredEntryListCtrl, but is done for convenience and
@@ -110,6 +124,9 @@ private:
     jewel::Decimal m_closing_balance;
     jewel::Decimal m_reconciled_closing_balance;
 
+    // For reading back the amounts displayed, as in amount_for_row(...).
+    DecimalParser const m_amount_parser;
+
     DECLARE_EVENT_TABLE()
 
 };  // class ReconciliationEntryListCtrl
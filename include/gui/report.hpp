@@ -18,7 +18,8 @@
 #define GUARD_report_hpp_0032136221431259167
 
 #include "account_type.hpp"
-#include "gridded_scrolled_panel.hpp"
+#include "report_grid.hpp"
+#include "report_totals.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <sqloxx/handle_fwd.hpp>
@@ -56,7 +57,7 @@ class ReportPanel;
  * @todo MEDIUM PRIORITY The report is rather plain looking. Make it look
  * nicer.
  */
-class Report: public GriddedScrolledPanel
+class Report: public ReportGrid
 {
 public:
 
@@ -91,7 +92,21 @@ public:
     void update_for_amended_budget(sqloxx::Handle<Account> const& p_account);
     void update_for_deleted(std::vector<sqloxx::Id> const& p_doomed_ids);
 
-    void generate();
+    /**
+     * @returns the Account totals that must be accumulated (see
+     * accumulate_report_totals(...)) before the Report can be generated.
+     * This may be empty, in which case generate() should be passed an
+     * empty vector.
+     */
+    std::vector<ReportQuery> totals_queries();
+
+    /**
+     * Populate the Report.
+     *
+     * @param p_totals the results of running the ReportQueries returned by
+     * totals_queries(), in the same order.
+     */
+    void generate(std::vector<ReportTotals> const& p_totals);
 
 protected:
     Report
@@ -105,8 +120,15 @@ protected:
     boost::gregorian::date min_date() const;
     boost::optional<boost::gregorian::date> maybe_max_date() const;
 
+    DcmDatabaseConnection& database_connection();
+    DcmDatabaseConnection const& database_connection() const;
+
 private:
-    virtual void do_generate() = 0;
+    virtual std::vector<ReportQuery> do_get_totals_queries() = 0;
+    virtual void do_generate
+    (   std::vector<ReportTotals> const& p_totals
+    ) = 0;
+    DcmDatabaseConnection& m_database_connection;
     boost::gregorian::date m_min_date;
     boost::optional<boost::gregorian::date> m_maybe_max_date;
 
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_report_grid_hpp_6203918475520381
+#define GUARD_report_grid_hpp_6203918475520381
+
+#include "finformat.hpp"
+#include <jewel/decimal_fwd.hpp>
+#include <wx/event.h>
+#include <wx/gdicmn.h>
+#include <wx/scrolwin.h>
+#include <wx/string.h>
+#include <wx/window.h>
+#include <vector>
+
+namespace dcm
+{
+namespace gui
+{
+
+/**
+ * A vertically scrolling window displaying a grid of read-only text
+ * cells.
+ *
+ * Unlike GriddedScrolledPanel, ReportGrid does not create a widget for
+ * each cell. The cell strings are stored in a flat array, and only the
+ * rows currently visible are drawn, in the paint event handler. The time
+ * and memory taken to display the grid are thus proportional to the
+ * number of cells, and are not subject to any limit the platform places
+ * on the number of native widgets.
+ *
+ * Cells are positioned using a "current row", in the same way as in
+ * GriddedScrolledPanel. All rows are of the same height. Once the cells
+ * have been populated, lay_out_cells() must be called for the grid to be
+ * sized and drawn correctly.
+ */
+class ReportGrid: public wxScrolledWindow
+{
+public:
+
+    ReportGrid(wxWindow* p_parent, wxSize const& p_size);
+
+    ReportGrid(ReportGrid const&) = delete;
+    ReportGrid(ReportGrid&&) = delete;
+    ReportGrid& operator=(ReportGrid const&) = delete;
+    ReportGrid& operator=(ReportGrid&&) = delete;
+    virtual ~ReportGrid();
+
+protected:
+
+    int current_row() const;
+    void increment_row(int p_inc = 1);
+    void decrement_row();
+    void set_row(int p_row);
+
+    /**
+     * Display \e p_text in the cell at current_row() and \e p_column.
+     * \e p_alignment_flags should be either wxALIGN_LEFT or
+     * wxALIGN_RIGHT.
+     */
+    void display_text
+    (   wxString const& p_text,
+        int p_column,
+        int p_alignment_flags = wxALIGN_LEFT
+    );
+
+    /**
+     * Display \e p_decimal, right-aligned, in the cell at current_row()
+     * and \e p_column.
+     */
+    void display_decimal
+    (   jewel::Decimal const& p_decimal,
+        int p_column,
+        bool p_dash_for_zero = true
+    );
+
+    /**
+     * Remove all cells, and set current_row() back to 0.
+     */
+    void clear_cells();
+
+    /**
+     * Calculate the widths of the columns and the virtual size of the
+     * grid from the cells currently populated, and redraw.
+     */
+    void lay_out_cells();
+
+private:
+
+    void on_paint(wxPaintEvent& event);
+
+    struct Cell
+    {
+        Cell();
+        wxString text;
+        int alignment_flags;
+        int width;  // in pixels; calculated in lay_out_cells()
+    };
+
+    /**
+     * @returns the Cell at \e p_row and \e p_column, growing the grid
+     * if required for it to exist.
+     */
+    Cell& cell_at(int p_row, int p_column);
+
+    int m_current_row;
+    int m_num_rows;
+    int m_num_columns;
+    int m_row_height;
+
+    // Row-major; of size m_num_rows * m_num_columns.
+    std::vector<Cell> m_cells;
+
+    // Of size m_num_columns + 1. Element i is the x-coordinate at which
+    // column i starts; and the last element is the width of the grid.
+    std::vector<int> m_column_positions;
+
+    // Used by display_decimal(...), according to p_dash_for_zero.
+    DecimalFormatter const m_formatter;
+    DecimalFormatter const m_dash_for_zero_formatter;
+
+    DECLARE_EVENT_TABLE()
+
+};  // class ReportGrid
+
+}  // namespace gui
+}  // namespace dcm
+
+#endif  // GUARD_report_grid_hpp_6203918475520381
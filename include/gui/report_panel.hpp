@@ -18,12 +18,17 @@
 #define GUARD_report_panel_hpp_8629163596140763
 
 #include "account_type.hpp"
+#include "task_scheduler.hpp"
+#include "gui/report_totals.hpp"
 #include <sqloxx/handle_fwd.hpp>
 #include <sqloxx/id.hpp>
 #include <wx/event.h>
+#include <wx/gauge.h>
 #include <wx/gbsizer.h>
 #include <wx/panel.h>
 #include <wx/window.h>
+#include <exception>
+#include <memory>
 #include <vector>
 
 namespace dcm
@@ -48,6 +53,11 @@ class Report;
 /**
  * Panel for holding date-filtered balance sheet and profit-and-loss
  * reports.
+ *
+ * The Account totals on which a Report is based are accumulated as a
+ * TaskScheduler task (see accumulate_report_totals(...)), while a gauge
+ * shows progress. Changing the date range while this is under way
+ * cancels it.
  */
 class ReportPanel: public wxPanel
 {
@@ -72,10 +82,38 @@ public:
 
 private:
     void on_run_button_click(wxCommandEvent& event);
+    void on_date_text_changed(wxCommandEvent& event);
+
+    /**
+     * Called on the GUI thread as the task started by start_generation()
+     * makes progress, and when it finishes. Calls for a \e p_job_id other
+     * than m_job_id, or when not generating, are from a task since
+     * cancelled, and are ignored.
+     */
+    void on_report_progress(long p_job_id, int p_percentage);
+    void on_report_finished
+    (   long p_job_id,
+        std::exception_ptr const& p_error,
+        std::vector<ReportTotals> const& p_totals
+    );
 
     void configure_top();
     void configure_bottom();
 
+    /**
+     * Start accumulating the totals required by m_report, on the
+     * TaskScheduler, cancelling any such task already under way.
+     * m_report is generated once the task finishes. If no totals are
+     * required, m_report is generated immediately.
+     */
+    void start_generation();
+
+    /**
+     * Cancel the task started by start_generation(), if it is still
+     * under way, without generating m_report.
+     */
+    void cancel_generation();
+
     AccountSuperType selected_account_super_type() const;
 
     static int const s_min_date_ctrl_id = wxID_HIGHEST + 1;
@@ -92,7 +130,20 @@ private:
     DateCtrl* m_min_date_ctrl;
     DateCtrl* m_max_date_ctrl;
     Button* m_run_button;
+    wxGauge* m_progress_gauge;
     Report* m_report;
+    bool m_is_generating;
+    CancellationToken m_cancellation_token;
+
+    // Incremented each time a task is started, so that callbacks still
+    // queued from a cancelled task can be recognized and ignored.
+    long m_job_id;
+
+    // Callbacks posted to the GUI thread hold only a weak_ptr to this, so
+    // that those arriving after the ReportPanel has been destroyed can be
+    // recognized and ignored.
+    std::shared_ptr<char> const m_lifeline;
+
     DcmDatabaseConnection& m_database_connection;
 
     DECLARE_EVENT_TABLE()
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_report_totals_hpp_6093714258830162
+#define GUARD_report_totals_hpp_6093714258830162
+
+#include "ledger_snapshot.hpp"
+#include "task_scheduler.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/optional.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/id.hpp>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace dcm
+{
+namespace gui
+{
+
+/**
+ * Requests the totals, for each Account, of the amounts of the Entries
+ * in actual (i.e. non-budget) OrdinaryJournals dated between
+ * \e maybe_min_date and \e maybe_max_date inclusive. An uninitialized
+ * bound means the range is unbounded in that direction.
+ */
+struct ReportQuery
+{
+    boost::optional<boost::gregorian::date> maybe_min_date;
+    boost::optional<boost::gregorian::date> maybe_max_date;
+};
+
+/**
+ * Totals, by Account id, in terms of jewel::Decimal::intval().
+ */
+typedef
+    std::unordered_map<sqloxx::Id, jewel::Decimal::int_type>
+    ReportTotals;
+
+/**
+ * @returns the results of \e p_queries against \e p_columns, in the same
+ * order as the queries.
+ *
+ * This reads only \e p_columns, and not the DcmDatabaseConnection, and
+ * so may be run as a TaskScheduler task, provided \e p_columns are not
+ * modified meanwhile (as is the case for LedgerColumns obtained from
+ * LedgerSnapshot::shared_columns()). The rows are scanned in chunks,
+ * between which \e p_token is polled, and \e p_on_progress (if not
+ * empty) is called, on the calling thread, with the percentage complete
+ * whenever that changes.
+ *
+ * @throws TaskCancelledException if \e p_token is cancelled.
+ *
+ * @throws UnsafeArithmeticException if a total could not be safely
+ * accumulated.
+ */
+std::vector<ReportTotals> accumulate_report_totals
+(   LedgerColumns const& p_columns,
+    std::vector<ReportQuery> const& p_queries,
+    CancellationToken const& p_token = CancellationToken(),
+    std::function<void(int)> const& p_on_progress = std::function<void(int)>()
+);
+
+}  // namespace gui
+}  // namespace dcm
+
+#endif  // GUARD_report_totals_hpp_6093714258830162
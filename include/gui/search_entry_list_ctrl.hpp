@@ -0,0 +1,101 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_search_entry_list_ctrl_hpp_5518036274190463
+#define GUARD_search_entry_list_ctrl_hpp_5518036274190463
+
+#include "entry_list_ctrl.hpp"
+#include <sqloxx/handle_fwd.hpp>
+#include <sqloxx/id.hpp>
+#include <wx/gdicmn.h>
+#include <wx/window.h>
+#include <unordered_set>
+#include <vector>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class Account;
+class DcmDatabaseConnection;
+class Entry;
+
+// End forward declarations
+
+namespace gui
+{
+
+/**
+ * An EntryListCtrl showing the results of a search (see
+ * search_entries(...)), in the order in which they were found, from
+ * any Account.
+ *
+ * Entries that were not among the results are never added to the list;
+ * to see any new matches, the search must be run again.
+ */
+class SearchEntryListCtrl: public EntryListCtrl
+{
+public:
+    SearchEntryListCtrl
+    (   wxWindow* p_parent,
+        wxSize const& p_size,
+        DcmDatabaseConnection& p_database_connection,
+        std::vector<sqloxx::Id> const& p_entry_ids
+    );
+
+    SearchEntryListCtrl(SearchEntryListCtrl const&) = delete;
+    SearchEntryListCtrl(SearchEntryListCtrl&&) = delete;
+    SearchEntryListCtrl& operator=(SearchEntryListCtrl const&) = delete;
+    SearchEntryListCtrl& operator=(SearchEntryListCtrl&&) = delete;
+    virtual ~SearchEntryListCtrl();
+
+private:
+
+    virtual bool do_require_progress_log() const override;
+
+    virtual void do_insert_non_date_columns() override;
+
+    virtual bool do_approve_entry
+    (   sqloxx::Handle<Entry> const& p_entry
+    ) const override;
+
+    virtual void do_set_non_date_columns
+    (   long p_row,
+        sqloxx::Handle<Entry> const& p_entry
+    ) override;
+
+    virtual void do_set_column_widths() override;
+
+    virtual int do_get_num_columns() const override;
+
+    virtual int do_get_comment_col_num() const override;
+
+    virtual std::vector<sqloxx::Id> do_select_entry_ids() override;
+
+    virtual void do_update_for_amended
+    (   sqloxx::Handle<Account> const& p_account
+    ) override;
+
+    std::vector<sqloxx::Id> const m_entry_ids;
+    std::unordered_set<sqloxx::Id> const m_entry_id_set;
+
+};  // class SearchEntryListCtrl
+
+}  // namespace gui
+}  // namespace dcm
+
+#endif  // GUARD_search_entry_list_ctrl_hpp_5518036274190463
@@ -0,0 +1,131 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_search_panel_hpp_0831746259013384
+#define GUARD_search_panel_hpp_0831746259013384
+
+#include "entry_search.hpp"
+#include <boost/optional.hpp>
+#include <sqloxx/handle_fwd.hpp>
+#include <wx/event.h>
+#include <wx/gbsizer.h>
+#include <wx/panel.h>
+#include <wx/stattext.h>
+#include <wx/window.h>
+#include <vector>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class DcmDatabaseConnection;
+class Entry;
+
+namespace gui
+{
+
+class Button;
+class DateCtrl;
+class DecimalTextCtrl;
+class EntryListCtrl;
+class TextCtrl;
+
+// End forward declarations
+
+/**
+ * A panel in which the user can search the comments of the Entries, and
+ * of their journals, across all Accounts (see search_entries(...)),
+ * optionally restricting the results to a date range and/or a range of
+ * amounts. The results are shown, best match first, in an EntryListCtrl.
+ *
+ * The results are those of the search as last run, except that, when
+ * update_for_changes() is called, the search is run again, so that they
+ * reflect the current state of the database. (This is cheap enough to do
+ * on every change, and is the only way of keeping the results in order of
+ * relevance.)
+ */
+class SearchPanel: public wxPanel
+{
+public:
+    SearchPanel
+    (   wxWindow* p_parent,
+        DcmDatabaseConnection& p_database_connection
+    );
+
+    SearchPanel(SearchPanel const&) = delete;
+    SearchPanel(SearchPanel&&) = delete;
+    SearchPanel& operator=(SearchPanel const&) = delete;
+    SearchPanel& operator=(SearchPanel&&) = delete;
+    virtual ~SearchPanel();
+
+    /**
+     * Update the results to reflect that OrdinaryJournals, Entries or
+     * Accounts have been changed, in any number and in any way.
+     */
+    void update_for_changes();
+
+    std::vector<sqloxx::Handle<Entry> > selected_entries();
+
+private:
+    void on_search_button_click(wxCommandEvent& event);
+
+    /**
+     * Run \e p_query, and show its results in place of any shown
+     * already.
+     */
+    void run(EntrySearchQuery const& p_query);
+
+    /**
+     * @returns an EntrySearchQuery reflecting what the user has entered
+     * in the controls at the top. Amounts of zero are taken to mean no
+     * restriction.
+     */
+    EntrySearchQuery query_from_controls();
+
+    static int const s_text_ctrl_id = wxID_HIGHEST + 1;
+    static int const s_min_date_ctrl_id = s_text_ctrl_id + 1;
+    static int const s_max_date_ctrl_id = s_min_date_ctrl_id + 1;
+    static int const s_min_amount_ctrl_id = s_max_date_ctrl_id + 1;
+    static int const s_max_amount_ctrl_id = s_min_amount_ctrl_id + 1;
+    static int const s_search_button_id = s_max_amount_ctrl_id + 1;
+
+    int m_next_row;
+    int m_client_size_aux;
+
+    wxGridBagSizer* m_top_sizer;
+    TextCtrl* m_text_ctrl;
+    DateCtrl* m_min_date_ctrl;
+    DateCtrl* m_max_date_ctrl;
+    DecimalTextCtrl* m_min_amount_ctrl;
+    DecimalTextCtrl* m_max_amount_ctrl;
+    Button* m_search_button;
+    wxStaticText* m_result_count_text;
+    EntryListCtrl* m_entry_list_ctrl;
+
+    // The search whose results are shown, if any.
+    boost::optional<EntrySearchQuery> m_maybe_query;
+
+    DcmDatabaseConnection& m_database_connection;
+
+    DECLARE_EVENT_TABLE()
+
+};  // class SearchPanel
+
+}  // namespace gui
+}  // namespace dcm
+
+#endif  // GUARD_search_panel_hpp_0831746259013384
@@ -24,6 +24,7 @@
  */
 
 #include <wx/gdicmn.h>
+#include <wx/window.h>
 
 namespace dcm
 {
@@ -75,6 +76,24 @@ wxSize screen_size();
  */
 int scrollbar_width_allowance();
 
+/**
+ * @returns the height to give a list that is to fill the rest of
+ * \e p_window, below \e p_num_rows rows of controls each \e p_row_height
+ * high, allowing for standard gaps and border.
+ *
+ * The client height of \e p_window is read into \e p_client_height the
+ * first time, and reused thereafter, so that the list keeps its height
+ * when it is replaced by another; unless it was then implausibly small
+ * (as before \e p_window has been laid out), in which case it is read
+ * again next time.
+ */
+int list_height_below_rows
+(   wxWindow const& p_window,
+    int& p_client_height,
+    int p_num_rows,
+    int p_row_height
+);
+
 }  // namespace gui
 }  // namespace dcm
 
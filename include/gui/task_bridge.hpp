@@ -0,0 +1,68 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_task_bridge_hpp_0861723540912286
+#define GUARD_task_bridge_hpp_0861723540912286
+
+/** @file
+ *
+ * @brief Functions for handing work from TaskScheduler threads back to
+ * the GUI thread.
+ *
+ * Callbacks are queued, and a wxThreadEvent of type wxEVT_COMMAND_THREAD,
+ * with id gui_callback_event_id, is queued on wxTheApp. The App handles
+ * that event by calling run_gui_callbacks().
+ */
+
+#include "task_scheduler.hpp"
+#include <wx/defs.h>
+#include <functional>
+
+namespace dcm
+{
+namespace gui
+{
+
+int const gui_callback_event_id = wxID_HIGHEST + 1;
+
+/**
+ * Arrange for \e p_callback to be called on the GUI thread, from the
+ * event loop. Safe to call from any thread. Callbacks are called in the
+ * order in which they were posted. If the application is shutting down,
+ * \e p_callback may never be called.
+ */
+void post_to_gui_thread(std::function<void()> const& p_callback);
+
+/**
+ * @returns a TaskScheduler::Completion which, wherever it is called,
+ * posts a call to \e p_completion, with the same argument, to the GUI
+ * thread.
+ */
+TaskScheduler::Completion on_gui_thread
+(   TaskScheduler::Completion const& p_completion
+);
+
+/**
+ * Call, in order, the callbacks posted by post_to_gui_thread() that
+ * have not yet been called. Should only be called on the GUI thread.
+ * Exceptions thrown by the callbacks are propagated.
+ */
+void run_gui_callbacks();
+
+}  // namespace gui
+}  // namespace dcm
+
+#endif  // GUARD_task_bridge_hpp_0861723540912286
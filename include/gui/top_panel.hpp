@@ -21,12 +21,16 @@
 #include "reconciliation_list_panel.hpp"
 #include "sizing.hpp"
 #include "transaction_ctrl.hpp"
+#include "warm_start_cache.hpp"
 #include <jewel/assert.hpp>
 #include <sqloxx/handle_fwd.hpp>
 #include <sqloxx/id.hpp>
+#include <wx/bookctrl.h>
+#include <wx/event.h>
 #include <wx/notebook.h>
 #include <wx/panel.h>
 #include <wx/sizer.h>
+#include <map>
 #include <type_traits>
 #include <vector>
 
@@ -46,10 +50,12 @@ namespace gui
 {
 
 class AccountListCtrl;
+class ChangeSet;
 class DraftJournalListCtrl;
 class EntryListPanel;
 class Frame;
 class ReportPanel;
+class SearchPanel;
 class TransactionCtrl;
 
 // End forward declarations
@@ -57,7 +63,20 @@ class TransactionCtrl;
 /**
  * Top level panel intended as immediate child of Frame.
  *
- * @todo LOW PRIORITY The various "update_for_..." functions each contain calls
+ * The notebook pages other than the first (the Account lists) are
+ * populated only when first shown. A page that is not currently shown is
+ * not updated as changes are notified, but is marked as stale, and
+ * brought up to date when next shown.
+ *
+ * When first constructed, the TopPanel shows the Account lists without
+ * balances, and no TransactionCtrl; these follow when complete_startup()
+ * is called, which should be once the ledger has been loaded (see
+ * LedgerSnapshot::adopt_columns(...)), so that they are cheap to produce.
+ * If the WarmStartCache is loaded, though, its figures and favourite
+ * Accounts are shown in the meantime, and the TransactionCtrl is
+ * configured for them straight away.
+ *
+ * @todo LOW PRIORITY update_for_changes(...) contains calls
  * to analogous "update_for_..." functions for each of the sub-widgets
  * in TopPanel. This makes for repetitive code. We could maybe streamline
  * this and make it more maintainable either by using wxWidgets' event
@@ -77,7 +96,8 @@ public:
 
     TopPanel
     (   Frame* parent,
-        DcmDatabaseConnection& p_database_connection
+        DcmDatabaseConnection& p_database_connection,
+        WarmStartCache& p_warm_start_cache
     );
 
     TopPanel(TopPanel const&) = delete;
@@ -86,6 +106,19 @@ public:
     TopPanel& operator=(TopPanel&&) = delete;
     ~TopPanel() = default;
 
+    /**
+     * Show the balances in the Account lists, select the user's
+     * favourite Accounts, and configure the TransactionCtrl for them
+     * (unless the user has already caused it to be configured).
+     */
+    void complete_startup();
+
+    /**
+     * Record in the WarmStartCache those of the user's choices in the
+     * TopPanel that it keeps (see EntryListFilter).
+     */
+    void record_warm_start_state();
+
     /**
      * @returns a vector populated with handles to all the balance sheet
      * Accounts currently selected by the user in the main window.
@@ -116,77 +149,30 @@ public:
 
     /**
      * Update the display to reflect current state of database, after
-     * saving of p_saved_object, where p_saved_object is a newly saved
-     * object that was not already in the database.
-     */
-    void update_for_new
-    (   sqloxx::Handle<DraftJournal> const& p_saved_object
-    );
-    void update_for_new
-    (   sqloxx::Handle<OrdinaryJournal> const& p_saved_object
-    );
-    void update_for_new(sqloxx::Handle<Account> const& p_saved_object);
-
-    /**
-     * Update the display to reflect current state of database, after
-     * saving of p_saved_object, where p_saved_object already existed
-     * in the database, but has just been amended and the amendments
-     * saved.
+     * the changes recorded in \e p_changes have been saved. Each
+     * sub-widget is refreshed at most once for each kind of change,
+     * however many objects were affected. Deletions are processed before
+     * creations, and creations before amendments.
      *
-     * NOTE these do not provide any information to TopPanel about any
-     * Entries that have been deleted from a DraftJournal or
-     * OrdinaryJournal represented by \e p_saved_object. Information
-     * about deleted Entries should be provided to TopPanel separately
-     * via update_for_deleted_ordinary_entries(...) or
-     * update_for_deleted_draft_entries(...) (as appropriate) (which
-     * may in turn be done via appropriate PersistentObjectEvent(s) rather
-     * than by calling these functions directly). It is better to notify
-     * re. the deleted Entries prior to notifying re. the (other) Journal
-     * edits.
-     */
-    void update_for_amended(sqloxx::Handle<DraftJournal> const& p_saved_object);
-    void update_for_amended
-    (   sqloxx::Handle<OrdinaryJournal> const& p_saved_object
-    );
-    void update_for_amended(sqloxx::Handle<Account> const& p_saved_object);
-
-    /**
-     * Update the display to reflect that the object with
-     * p_doomed_id (or the objects with p_doomed_ids) have just
-     * been removed from the database.
+     * NOTE This intentionally does \e not update the
+     * ReconciliationListPanel / ReconciliationEntryListCtrl for changes
+     * of ChangeKind::reconciliation_status, as it is assumed these are
+     * the \e source of the change - we don't update these \e again, on
+     * pain of circularity.
+     *
+     * @todo LOW PRIORITY Make this less messy and "coupled" (see note
+     * above).
      */
-    void update_for_deleted_ordinary_journal(sqloxx::Id p_doomed_id);
-    void update_for_deleted_draft_journal(sqloxx::Id p_doomed_id);
-    void update_for_deleted_ordinary_entries
-    (   std::vector<sqloxx::Id> const& p_doomed_ids
-    );
-    void update_for_deleted_draft_entries
-    (   std::vector<sqloxx::Id> const& p_doomed_ids
-    );
+    void update_for_changes(ChangeSet const& p_changes);
 
     /**
      * Update the display to reflect current state of database, after
-     * BudgetItems pertaining to p_account have been added, deleted
-     * and/or amended.
-     * 
-     * Precondition: p_account should be of AccountSuperType::pl.
+     * a batch of OrdinaryJournals has been imported (see LedgerImporter)
+     * or archived (see close_period(...)). This does the work of
+     * refreshing each sub-widget once only, however many OrdinaryJournals
+     * were affected.
      */
-    void update_for_amended_budget(sqloxx::Handle<Account> const& p_account);
-
-    /**
-     * Update the display to reflect the current state of \e p_entry
-     * with respect just to whether it is reconciled.
-     *
-     * NOTE This is messy and "coupled", but: this intentionally does
-     * \e not update the
-     * ReconciliationListPanel / ReconciliationEntryListCtrl, as it
-     * is assumed these are the \e source of the change - we don't update
-     * these \e again, on pain of circularity.
-     *
-     * @todo LOW PRIORITY Make this less messy and "coupled" (see note
-     * above).
-     */
-    void update_for_reconciliation_status(sqloxx::Handle<Entry> const& p_entry);
+    void update_for_bulk_changes();
 
     /**
      * @returns a ProtoJournal containing two Entries, with blank
@@ -232,26 +218,42 @@ public:
 
 private:
 
+    void on_notebook_page_changed(wxBookCtrlEvent& event);
+
+    bool is_current_page(wxWindow* p_page) const;
+
     void configure_account_lists();
+    void select_accounts
+    (   std::map<AccountSuperType, sqloxx::Id> const& p_account_ids
+    );
     void configure_entry_list();
     void configure_reconciliation_page();
     void configure_report_page();
+    void configure_search_page();
 
     DcmDatabaseConnection& m_database_connection;
+    WarmStartCache& m_warm_start_cache;
     wxBoxSizer* m_top_sizer;
     wxNotebook* m_notebook;
     wxPanel* m_notebook_page_accounts;
     wxPanel* m_notebook_page_transactions;
     wxPanel* m_notebook_page_reconciliations;
     wxPanel* m_notebook_page_reports;
+    wxPanel* m_notebook_page_search;
     wxBoxSizer* m_right_column_sizer;
     AccountListCtrl* m_bs_account_list;
     AccountListCtrl* m_pl_account_list;
     EntryListPanel* m_entry_list_panel;
     ReconciliationListPanel* m_reconciliation_panel;
     ReportPanel* m_report_panel;
+    SearchPanel* m_search_panel;
     TransactionCtrl* m_transaction_ctrl;
     DraftJournalListCtrl* m_draft_journal_list;
+    bool m_entry_list_page_stale;
+    bool m_reconciliation_page_stale;
+    bool m_search_page_stale;
+
+    DECLARE_EVENT_TABLE()
 };
 
 
@@ -30,6 +30,7 @@
 #include <wx/gdicmn.h>
 #include <wx/stattext.h>
 #include <memory>
+#include <vector>
 
 namespace dcm
 {
@@ -190,9 +191,22 @@ private:
 
     /**
      * @returns true if and only if existing journal was successfully saved.
+     * If it was not, any changes made to *m_journal and its Entries along
+     * the way are discarded.
      */
     bool save_existing_journal();
 
+    bool save_existing_journal_core();
+
+    /**
+     * Ghostify *m_journal, and each of \e p_old_entries (the Entries it
+     * had before it was edited), so that they are reloaded from the
+     * database next time they are used.
+     */
+    void discard_journal_changes
+    (   std::vector<sqloxx::Handle<Entry> > const& p_old_entries
+    );
+
     bool is_balanced() const;
 
     TransactionTypeCtrl* m_transaction_type_ctrl;
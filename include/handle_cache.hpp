@@ -0,0 +1,270 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_handle_cache_hpp_6093817524460318
+#define GUARD_handle_cache_hpp_6093817524460318
+
+#include "dcm_database_connection.hpp"
+#include <jewel/assert.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace dcm
+{
+
+/**
+ * Counts of the lookups made through a HandleCache.
+ */
+struct HandleCacheStatistics
+{
+    HandleCacheStatistics(): hits(0), misses(0), evictions(0)
+    {
+    }
+
+    // Lookups for which the object was already retained.
+    std::size_t hits;
+
+    // Lookups for which it was not, so that a Handle had to be obtained
+    // from the IdentityMap (which will load the object from the database
+    // when it is first accessed, unless something else is still holding
+    // on to it).
+    std::size_t misses;
+
+    // Objects let go of to keep within the capacity.
+    std::size_t evictions;
+};
+
+/**
+ * Keeps alive the objects of type T (a class managed by a
+ * sqloxx::IdentityMap of the DcmDatabaseConnection) that were most
+ * recently looked up through it, up to a set number of them, by holding
+ * a sqloxx::Handle to each.
+ *
+ * This sits between the two settings of the IdentityMap itself. With
+ * caching disabled in the IdentityMap, an object is deleted once the last
+ * Handle to it goes, so that it is loaded afresh each time it is needed;
+ * with caching enabled, every object ever loaded stays in memory. With
+ * a HandleCache, the recently used objects stay in memory, and the least
+ * recently used are let go of as others come in.
+ *
+ * Note that this means an object may be kept alive after code that has
+ * changed it, but not saved it, has let go of its own Handle to it.
+ * Code abandoning such changes must ghostify() the object (see for
+ * example gui::TransactionCtrl::save_existing_journal()), or the changes
+ * will be seen by whatever looks the object up next.
+ *
+ * The capacity is 0 (so that nothing is retained) until set otherwise
+ * with set_capacity(...).
+ *
+ * T is the class for which the IdentityMap is kept (e.g.
+ * PersistentJournal); lookups may be made for a class derived from it
+ * (e.g. OrdinaryJournal).
+ */
+template <typename T>
+class HandleCache
+{
+public:
+
+    explicit HandleCache(DcmDatabaseConnection& p_database_connection);
+
+    HandleCache(HandleCache const&) = delete;
+    HandleCache(HandleCache&&) = delete;
+    HandleCache& operator=(HandleCache const&) = delete;
+    HandleCache& operator=(HandleCache&&) = delete;
+    ~HandleCache() = default;
+
+    /**
+     * @returns a Handle to the object with id \e p_id, as would
+     * sqloxx::Handle<U>(database_connection, p_id), and marks it as the
+     * most recently used.
+     *
+     * Exception safety: as for that constructor; if it throws, the
+     * HandleCache is unchanged apart from its statistics().
+     */
+    template <typename U = T>
+    sqloxx::Handle<U> provide(sqloxx::Id p_id);
+
+    std::size_t capacity() const;
+
+    /**
+     * Set the maximum number of objects retained, letting go of the least
+     * recently used if there are more than \e p_capacity already.
+     */
+    void set_capacity(std::size_t p_capacity);
+
+    /**
+     * @returns the number of objects currently retained.
+     */
+    std::size_t size() const;
+
+    HandleCacheStatistics const& statistics() const;
+
+    /**
+     * Let go of the object with id \e p_id, if it is retained - as when
+     * its row has been deleted from the database other than through its
+     * own remove(), so that it still has the id. This does not count
+     * towards the evictions in the statistics().
+     */
+    void evict(sqloxx::Id p_id);
+
+    /**
+     * Let go of all the objects retained. The statistics() are kept.
+     */
+    void clear();
+
+private:
+
+    typedef std::list<std::pair<sqloxx::Id, sqloxx::Handle<T> > > List;
+
+    void evict_surplus();
+
+    DcmDatabaseConnection& m_database_connection;
+    std::size_t m_capacity;
+
+    // Most recently used at the front.
+    List m_list;
+    std::unordered_map<sqloxx::Id, typename List::iterator> m_index;
+
+    HandleCacheStatistics m_statistics;
+
+};  // class HandleCache
+
+
+template <typename T>
+inline
+HandleCache<T>::HandleCache(DcmDatabaseConnection& p_database_connection):
+    m_database_connection(p_database_connection),
+    m_capacity(0)
+{
+}
+
+template <typename T>
+template <typename U>
+inline
+sqloxx::Handle<U>
+HandleCache<T>::provide(sqloxx::Id p_id)
+{
+    auto const it = m_index.find(p_id);
+    if (it != m_index.end())
+    {
+        typename List::iterator const pos = it->second;
+        sqloxx::Handle<T> const& retained = pos->second;
+
+        // An object that has since been removed from the database no
+        // longer has the id under which it was retained.
+        if (retained->has_id() && (retained->id() == p_id))
+        {
+            ++m_statistics.hits;
+            m_list.splice(m_list.begin(), m_list, pos);
+            return sqloxx::handle_cast<U>(retained);
+        }
+        m_list.erase(pos);
+        m_index.erase(it);
+    }
+    ++m_statistics.misses;
+    sqloxx::Handle<U> const ret(m_database_connection, p_id);
+    if (m_capacity != 0)
+    {
+        m_list.push_front(std::make_pair(p_id, sqloxx::handle_cast<T>(ret)));
+        m_index[p_id] = m_list.begin();
+        evict_surplus();
+    }
+    return ret;
+}
+
+template <typename T>
+inline
+std::size_t
+HandleCache<T>::capacity() const
+{
+    return m_capacity;
+}
+
+template <typename T>
+inline
+void
+HandleCache<T>::set_capacity(std::size_t p_capacity)
+{
+    m_capacity = p_capacity;
+    evict_surplus();
+    return;
+}
+
+template <typename T>
+inline
+std::size_t
+HandleCache<T>::size() const
+{
+    JEWEL_ASSERT (m_list.size() == m_index.size());
+    return m_index.size();
+}
+
+template <typename T>
+inline
+HandleCacheStatistics const&
+HandleCache<T>::statistics() const
+{
+    return m_statistics;
+}
+
+template <typename T>
+inline
+void
+HandleCache<T>::evict(sqloxx::Id p_id)
+{
+    auto const it = m_index.find(p_id);
+    if (it != m_index.end())
+    {
+        m_list.erase(it->second);
+        m_index.erase(it);
+    }
+    return;
+}
+
+template <typename T>
+inline
+void
+HandleCache<T>::clear()
+{
+    m_index.clear();
+    m_list.clear();
+    return;
+}
+
+template <typename T>
+inline
+void
+HandleCache<T>::evict_surplus()
+{
+    while (m_list.size() > m_capacity)
+    {
+        m_index.erase(m_list.back().first);
+
+        // If nothing else holds a Handle to the object, this is where the
+        // IdentityMap lets go of it.
+        m_list.pop_back();
+        ++m_statistics.evictions;
+    }
+    return;
+}
+
+}  // namespace dcm
+
+#endif  // GUARD_handle_cache_hpp_6093817524460318
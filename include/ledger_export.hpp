@@ -0,0 +1,245 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_ledger_export_hpp_4415920837162603
+#define GUARD_ledger_export_hpp_4415920837162603
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class DcmDatabaseConnection;
+
+// End forward declarations
+
+/**
+ * Represents the ways in which a column of a ledger export file may be
+ * encoded. All integers are written as variable-length "varints" (7 bits
+ * per byte, least significant group first), with signed values first being
+ * "zigzag" encoded, so that numbers of small magnitude take few bytes
+ * whether positive or negative.
+ */
+enum class ExportEncoding: unsigned char
+{
+    // Each integer is written in full.
+    integer_plain = 0,
+
+    // Each integer is written as the difference from the previous one in
+    // the same block. Suits ids and dates, which mostly ascend in small
+    // steps.
+    integer_delta,
+
+    // As for integer_delta, but the integers are dates, represented as
+    // in the database (see julian_int(...)). When converted to CSV, these
+    // are shown in ISO format.
+    date_delta,
+
+    // The distinct integers in the block are written once; each row is
+    // then written as an index into these. Suits foreign keys such as
+    // account ids, that recur often.
+    integer_dictionary,
+
+    // As for integer_dictionary, but for UTF-8 text.
+    text_dictionary,
+
+    num_export_encodings  // Do not add encodings below this line.
+};
+
+/**
+ * @returns \e true if and only if columns encoded with \e p_encoding
+ * contain text (rather than integers).
+ */
+bool is_text(ExportEncoding p_encoding);
+
+/**
+ * Describes a column of a table in a ledger export file.
+ */
+struct ExportColumn
+{
+    std::string name;
+    ExportEncoding encoding;
+};
+
+/**
+ * Describes where to find a block of a table in a ledger export file.
+ */
+struct ExportBlockInfo
+{
+    // In bytes, from the start of the file
+    unsigned long long offset;
+    unsigned long long size;
+
+    std::size_t num_rows;
+};
+
+/**
+ * Describes a table in a ledger export file, and where to find its blocks.
+ */
+struct ExportTableInfo
+{
+    std::string name;
+    std::vector<ExportColumn> columns;
+    std::size_t num_rows;
+    std::vector<ExportBlockInfo> blocks;
+};
+
+/**
+ * Holds the decoded contents of a single block of a table. For each column
+ * \e c, exactly one of \e integers[c] and \e texts[c] is populated,
+ * depending on whether the column contains text, and it contains one
+ * element per row.
+ */
+struct ExportBlock
+{
+    std::size_t num_rows;
+    std::vector<std::vector<long long> > integers;
+    std::vector<std::vector<std::string> > texts;
+};
+
+
+/**
+ * Writes the contents of the database - Accounts, OrdinaryJournals,
+ * DraftJournals, Entries, Repeaters and BudgetItems - to a compact,
+ * columnar binary "ledger export" file, for consumption by other tools.
+ *
+ * Each table is written as a sequence of blocks of at most
+ * \e block_size() rows. Within a block, the values of each column are
+ * stored contiguously, and encoded as per its ExportEncoding; each block
+ * can be decoded independently of the others. The rows are streamed from
+ * the database, and each block is written as soon as it is full, so the
+ * memory used is bounded by the block size, however large the ledger.
+ *
+ * The file ends with a footer describing each table and giving the offset
+ * and size of each of its blocks, followed by the offset of the footer
+ * itself. A reader can thus locate any block directly - whether by
+ * seeking, or within a memory-mapped view of the file - without decoding
+ * those before it. See LedgerExportReader.
+ *
+ * Layout:
+ * <pre>
+ *   magic (8 bytes) | version (varint) | blocks... | footer |
+ *   footer offset (8 bytes, little-endian) | magic (8 bytes)
+ * </pre>
+ * A block is: number of rows (varint), then for each column: the number of
+ * bytes of encoded data (varint), followed by that data.
+ */
+class LedgerExporter
+{
+public:
+
+    explicit LedgerExporter(DcmDatabaseConnection& p_database_connection);
+
+    LedgerExporter(LedgerExporter const&) = delete;
+    LedgerExporter(LedgerExporter&&) = delete;
+    LedgerExporter& operator=(LedgerExporter const&) = delete;
+    LedgerExporter& operator=(LedgerExporter&&) = delete;
+    ~LedgerExporter();
+
+    /**
+     * Write the export to \e p_stream, which should be open in binary
+     * mode.
+     *
+     * @returns the total number of rows written, across all tables.
+     *
+     * @throws LedgerExportException if \e p_stream fails.
+     */
+    std::size_t write(std::ostream& p_stream);
+
+    /**
+     * @returns the maximum number of rows written per block.
+     */
+    static std::size_t block_size();
+
+private:
+
+    DcmDatabaseConnection& m_database_connection;
+
+};  // class LedgerExporter
+
+
+/**
+ * Reads a file written by LedgerExporter, one block at a time.
+ */
+class LedgerExportReader
+{
+public:
+
+    /**
+     * Reads the footer of the export in \e p_stream, which should be open
+     * in binary mode, and must outlive the reader.
+     *
+     * @throws LedgerExportException if \e p_stream does not contain a
+     * valid ledger export.
+     */
+    explicit LedgerExportReader(std::istream& p_stream);
+
+    LedgerExportReader(LedgerExportReader const&) = delete;
+    LedgerExportReader(LedgerExportReader&&) = delete;
+    LedgerExportReader& operator=(LedgerExportReader const&) = delete;
+    LedgerExportReader& operator=(LedgerExportReader&&) = delete;
+    ~LedgerExportReader();
+
+    std::vector<ExportTableInfo> const& tables() const;
+
+    /**
+     * @throws LedgerExportException if there is no table named
+     * \e p_table_name.
+     */
+    ExportTableInfo const& table(std::string const& p_table_name) const;
+
+    /**
+     * Decode block number \e p_block_index of \e p_table into
+     * \e p_block. Passing the same ExportBlock for successive calls
+     * allows its memory to be reused.
+     *
+     * @throws LedgerExportException if the block is corrupt.
+     */
+    void read_block
+    (   ExportTableInfo const& p_table,
+        std::size_t p_block_index,
+        ExportBlock& p_block
+    );
+
+    /**
+     * Write the table named \e p_table_name to \e p_stream as CSV (with a
+     * header row), decoding one block at a time.
+     *
+     * @throws LedgerExportException if there is no such table, or if the
+     * export is corrupt.
+     */
+    void write_csv(std::string const& p_table_name, std::ostream& p_stream);
+
+private:
+
+    // Read \e p_size bytes, starting at \e p_offset, into m_buffer.
+    void read_range(unsigned long long p_offset, std::size_t p_size);
+
+    std::istream& m_stream;
+    std::vector<ExportTableInfo> m_tables;
+    std::vector<char> m_buffer;
+
+};  // class LedgerExportReader
+
+}  // namespace dcm
+
+#endif  // GUARD_ledger_export_hpp_4415920837162603
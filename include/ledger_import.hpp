@@ -0,0 +1,307 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_ledger_import_hpp_6038291745516082
+#define GUARD_ledger_import_hpp_6038291745516082
+
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include "finformat.hpp"
+#include <boost/filesystem.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/handle.hpp>
+#include <wx/string.h>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class Account;
+class DateParser;
+class DcmDatabaseConnection;
+
+// End forward declarations
+
+/**
+ * Represents the external file formats from which transactions can be
+ * imported.
+ */
+enum class ImportFormat: unsigned char
+{
+    csv = 0,
+    ofx,
+    qif
+};
+
+/**
+ * @returns the ImportFormat suggested by the extension of \e p_filepath
+ * (".csv", ".ofx" or ".qif", ignoring case).
+ *
+ * @throws LedgerImportException if the extension does not correspond
+ * to any ImportFormat.
+ */
+ImportFormat import_format_from_filepath
+(   boost::filesystem::path const& p_filepath
+);
+
+/**
+ * Represents a single transaction as read from an external statement
+ * file. \e amount is expressed from the point of view of the Account to
+ * which the statement relates: positive amounts are funds coming in, and
+ * negative amounts are funds going out.
+ */
+struct ImportRecord
+{
+    boost::gregorian::date date;
+    wxString description;
+    jewel::Decimal amount;
+};
+
+/**
+ * Reads ImportRecords one at a time from a std::istream, without ever
+ * holding more than the current record in memory. Obtain an instance via
+ * create(...).
+ *
+ * CSV input should have either three columns (date, description, amount)
+ * or four columns (date, description, withdrawal, deposit). A leading header
+ * row is skipped automatically. Fields may be quoted as per RFC 4180.
+ *
+ * OFX input is read tolerantly as a stream of tags, whether in the older
+ * SGML form or the newer XML form; only the STMTTRN aggregates are examined.
+ *
+ * QIF input is read line by line; only the D, T (or U), P, M and ^ line
+ * types are examined.
+ *
+ * Dates are accepted in ISO form ("YYYY-MM-DD" or "YYYYMMDD") or, failing
+ * that, in the short or long date format of the current locale.
+ *
+ * Amounts are read with the DecimalParser passed to create(...), so with
+ * whatever decimal point and thousands separator it was constructed with.
+ * Whatever these are, a minus sign or parentheses mark an amount as
+ * negative; and "+" signs, spaces, "$" and any non-ASCII characters (such
+ * as other currency symbols, or a non-breaking space used as a thousands
+ * separator) are ignored.
+ */
+class ImportRecordReader
+{
+public:
+
+    /**
+     * @returns a reader that will read records of format \e p_format
+     * from \e p_stream, reading amounts with \e p_amount_parser (see
+     * class documentation). \e p_stream must outlive the reader.
+     */
+    static std::unique_ptr<ImportRecordReader> create
+    (   std::istream& p_stream,
+        ImportFormat p_format,
+        DecimalParser const& p_amount_parser
+    );
+
+    ImportRecordReader(ImportRecordReader const&) = delete;
+    ImportRecordReader(ImportRecordReader&&) = delete;
+    ImportRecordReader& operator=(ImportRecordReader const&) = delete;
+    ImportRecordReader& operator=(ImportRecordReader&&) = delete;
+    virtual ~ImportRecordReader();
+
+    /**
+     * Read the next record from the stream into \e p_record.
+     *
+     * @returns \e true if a record was read, or \e false if the end of the
+     * stream was reached (in which case \e p_record is unchanged).
+     *
+     * @throws LedgerImportException if the stream contains a record that
+     * cannot be parsed. The message identifies the offending line.
+     */
+    bool read(ImportRecord& p_record);
+
+protected:
+
+    explicit ImportRecordReader(std::istream& p_stream);
+
+    /**
+     * Read the next line of the stream into \e p_line, stripping any
+     * trailing carriage return.
+     *
+     * @returns \e false at end of stream.
+     */
+    bool next_line(std::string& p_line);
+
+    std::istream& stream();
+
+    std::size_t line_number() const;
+
+    /**
+     * @throws LedgerImportException if \e p_string cannot be parsed as a
+     * date.
+     */
+    boost::gregorian::date parse_date(std::string const& p_string);
+
+    /**
+     * Parse an amount, as described in the class documentation.
+     *
+     * @throws LedgerImportException if \e p_string cannot be parsed as an
+     * amount.
+     */
+    jewel::Decimal parse_amount(std::string const& p_string);
+
+    /**
+     * @returns a message for a LedgerImportException, identifying the
+     * current line and incorporating \e p_detail.
+     */
+    std::string parsing_error_message(std::string const& p_detail) const;
+
+private:
+
+    virtual bool do_read(ImportRecord& p_record) = 0;
+
+    std::istream& m_stream;
+    std::size_t m_line_number;
+
+    // Only constructed if a date is encountered that is not in ISO format.
+    std::unique_ptr<DateParser> m_date_parser;
+
+    DecimalParser m_amount_parser;
+
+};  // class ImportRecordReader
+
+
+/**
+ * Posts the records read from an external statement file, as
+ * OrdinaryJournals, to the database.
+ *
+ * Each record becomes an OrdinaryJournal with two Entries: one to the
+ * "statement Account" (the Account to which the statement file relates),
+ * and one to a "counterparty" Account. The counterparty is the Account of
+ * the first mapping rule (see add_mapping_rule(...)) whose keyword appears
+ * in the record's description, or the default counterparty if no rule
+ * matches.
+ *
+ * By default, a record is skipped if it duplicates a transaction already in
+ * the database - i.e. if there is an existing ordinary Entry with the same
+ * Account, date, amount and (normalized) comment as the statement Account
+ * Entry the record would give rise to (see EntryFingerprint). This makes it
+ * safe to import statements with overlapping date ranges. Where a statement
+ * legitimately contains \e n identical records, only as many of these are
+ * skipped as there are duplicates already in the database.
+ *
+ * For speed, the journals are written directly to the database with
+ * prepared statements that are reused for every record, all within a single
+ * transaction, rather than via OrdinaryJournal::save(). The balance cache is
+ * then marked as stale just once, at the end. The effect on the database is
+ * otherwise the same as if each journal had been saved individually.
+ */
+class LedgerImporter
+{
+public:
+
+    /**
+     * Precondition: \e p_statement_account and \e p_default_counterparty
+     * must both already be saved, and must differ from each other.
+     */
+    LedgerImporter
+    (   DcmDatabaseConnection& p_database_connection,
+        sqloxx::Handle<Account> const& p_statement_account,
+        sqloxx::Handle<Account> const& p_default_counterparty
+    );
+
+    LedgerImporter(LedgerImporter const&) = delete;
+    LedgerImporter(LedgerImporter&&) = delete;
+    LedgerImporter& operator=(LedgerImporter const&) = delete;
+    LedgerImporter& operator=(LedgerImporter&&) = delete;
+    ~LedgerImporter();
+
+    /**
+     * Cause records whose description contains \e p_keyword (ignoring
+     * case) to be posted against \e p_account rather than the default
+     * counterparty. Rules are tried in the order in which they were added.
+     */
+    void add_mapping_rule
+    (   wxString const& p_keyword,
+        sqloxx::Handle<Account> const& p_account
+    );
+
+    /**
+     * Determine whether records duplicating existing transactions will be
+     * skipped (see class documentation). The default is \e true.
+     */
+    void set_skipping_duplicates(bool p_skipping_duplicates);
+
+    /**
+     * Determine how amounts are read (see ImportRecordReader). By default
+     * they are read with "." as the decimal point and "," as the thousands
+     * separator, as in most statement files whatever the locale. To read
+     * amounts in the user's own format, pass DecimalParser(p_locale), where
+     * \e p_locale is the user's wxLocale.
+     */
+    void set_amount_parser(DecimalParser const& p_amount_parser);
+
+    /**
+     * @returns the number of records skipped as duplicates during the most
+     * recent call to import(...).
+     */
+    std::size_t num_duplicates_skipped() const;
+
+    /**
+     * Read all records from \e p_stream, and post them to the database.
+     * Records with a zero amount, and (see set_skipping_duplicates(...))
+     * records duplicating existing transactions, are skipped.
+     *
+     * @returns the number of OrdinaryJournals posted.
+     *
+     * @throws LedgerImportException if a record cannot be parsed, or has
+     * more decimal places than the relevant Commodity supports.
+     *
+     * @throws InvalidJournalDateException if a record is dated earlier than
+     * the entity creation date.
+     *
+     * @throws JournalOverflowException if posting the records would cause
+     * overflow in an Account balance.
+     *
+     * Exception safety: <em>strong guarantee</em> as regards the database;
+     * if an exception is thrown, no records will have been posted. The
+     * position of \e p_stream is unspecified in that case.
+     */
+    std::size_t import(std::istream& p_stream, ImportFormat p_format);
+
+private:
+
+    sqloxx::Handle<Account> const& counterparty_for
+    (   wxString const& p_description
+    ) const;
+
+    DcmDatabaseConnection& m_database_connection;
+    sqloxx::Handle<Account> const m_statement_account;
+    sqloxx::Handle<Account> const m_default_counterparty;
+
+    bool m_skipping_duplicates;
+    std::size_t m_num_duplicates_skipped;
+    DecimalParser m_amount_parser;
+
+    // Keywords are stored lower-cased.
+    std::vector<std::pair<wxString, sqloxx::Handle<Account> > >
+        m_mapping_rules;
+
+};  // class LedgerImporter
+
+}  // namespace dcm
+
+#endif  // GUARD_ledger_import_hpp_6038291745516082
@@ -0,0 +1,314 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_ledger_snapshot_hpp_5730186249150372
+#define GUARD_ledger_snapshot_hpp_5730186249150372
+
+#include "date.hpp"
+#include "transaction_type.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/optional.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/database_connection.hpp>
+#include <sqloxx/id.hpp>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class DcmDatabaseConnection;
+
+// End forward declarations
+
+/**
+ * The ordinary (i.e. non-draft) Entries in the database, stored
+ * column-wise. Element \e i of each vector describes the same Entry. Rows
+ * are ordered by date, and then by entry_id.
+ */
+struct LedgerColumns
+{
+    typedef std::vector<sqloxx::Id>::size_type size_type;
+
+    size_type size() const;
+    void clear();
+    void reserve(size_type p_capacity);
+
+    std::vector<sqloxx::Id> entry_ids;
+    std::vector<sqloxx::Id> journal_ids;
+    std::vector<sqloxx::Id> account_ids;
+    std::vector<DateRep> dates;
+
+    // Expressed in terms of the precision of the Commodity of the Account
+    // (i.e. as stored in the database).
+    std::vector<jewel::Decimal::int_type> amounts;
+
+    std::vector<TransactionType> transaction_types;
+
+    // Each element is 1 if the Entry is reconciled, 0 if not. (We avoid
+    // std::vector<bool> so that this can be scanned like the other
+    // columns.)
+    std::vector<unsigned char> reconciled_flags;
+
+};  // struct LedgerColumns
+
+/**
+ * @returns the half-open range [first, second) of positions in
+ * \e p_columns of the Entries dated between \e p_maybe_min_date and
+ * \e p_maybe_max_date, inclusive. If either bound is uninitialized, the
+ * range is unbounded in that direction.
+ */
+std::pair<LedgerColumns::size_type, LedgerColumns::size_type> rows_between
+(   LedgerColumns const& p_columns,
+    boost::optional<boost::gregorian::date> const& p_maybe_min_date,
+    boost::optional<boost::gregorian::date> const& p_maybe_max_date
+);
+
+/**
+ * Add to \e p_totals, for each Account, the sum of the amounts of the
+ * Entries at positions [p_begin, p_end) in \e p_columns. If
+ * \e p_actual_only is true, only Entries belonging to actual Journals
+ * are included.
+ *
+ * This does not touch the database, and so may be called on a thread
+ * other than the one that owns the DcmDatabaseConnection, provided
+ * \e p_columns is not being modified (see
+ * LedgerSnapshot::shared_columns()).
+ *
+ * @throws UnsafeArithmeticException if any addition would overflow.
+ * In this case \e p_totals is left in a valid but unspecified state.
+ */
+void accumulate_totals
+(   LedgerColumns const& p_columns,
+    LedgerColumns::size_type p_begin,
+    LedgerColumns::size_type p_end,
+    std::unordered_map<sqloxx::Id, jewel::Decimal::int_type>& p_totals,
+    bool p_actual_only
+);
+
+/**
+ * Read all the ordinary Entries in the database into \e p_columns,
+ * replacing anything already there.
+ *
+ * Only SQLStatements are used, so \e p_database_connection may be a
+ * ReadOnlyConnection on a thread other than the GUI thread. For the
+ * result to be consistent, the reads should be done under a single
+ * transaction (e.g. a ReadOnlyConnection::Snapshot).
+ */
+void load_ledger_columns
+(   sqloxx::DatabaseConnection& p_database_connection,
+    LedgerColumns& p_columns
+);
+
+
+// Staleness is triggered in the same way as for EntryFingerprintIndex:
+// Entry - saving an Entry marks its Journal as stale; removing an Entry
+// marks that Entry as stale.
+// OrdinaryJournal - saving an existing OrdinaryJournal marks it as stale,
+// as its date or TransactionType may have changed.
+// LedgerImporter - this bypasses Entry, and marks each Journal it posts as
+// stale.
+
+/**
+ * Provides an in-memory, column-wise copy of all the ordinary Entries in
+ * the database, together with the date and TransactionType of their
+ * Journals, so that reports and Entry lists can be produced by scanning
+ * contiguous arrays rather than by querying the database and loading an
+ * Entry and OrdinaryJournal for every row.
+ *
+ * The snapshot is built by a single scan of the database on the first
+ * query, and thereafter brought up to date lazily, on the next query
+ * following a change, by re-reading only the Journals that have changed.
+ */
+class LedgerSnapshot
+{
+public:
+
+    typedef LedgerColumns::size_type size_type;
+
+    explicit LedgerSnapshot(DcmDatabaseConnection& p_database_connection);
+
+    LedgerSnapshot(LedgerSnapshot const&) = delete;
+    LedgerSnapshot(LedgerSnapshot&&) = delete;
+    LedgerSnapshot& operator=(LedgerSnapshot const&) = delete;
+    LedgerSnapshot& operator=(LedgerSnapshot&&) = delete;
+    ~LedgerSnapshot();
+
+    /**
+     * @returns the columns, after first bringing them up to date. The
+     * reference is valid only until the next call to any non-const member
+     * function of LedgerSnapshot.
+     */
+    LedgerColumns const& columns();
+
+    /**
+     * @returns the columns, after first bringing them up to date, in a
+     * form that is never modified thereafter: updates to the
+     * LedgerSnapshot replace its columns rather than modifying them in
+     * place. The returned columns may thus be read on another thread,
+     * while the LedgerSnapshot continues to be used on this one.
+     */
+    std::shared_ptr<LedgerColumns const> shared_columns();
+
+    /**
+     * @returns the half-open range [first, second) of positions in
+     * columns() of the Entries dated between \e p_maybe_min_date and
+     * \e p_maybe_max_date, inclusive. If either bound is uninitialized, the
+     * range is unbounded in that direction.
+     */
+    std::pair<size_type, size_type> rows_between
+    (   boost::optional<boost::gregorian::date> const& p_maybe_min_date =
+            boost::optional<boost::gregorian::date>(),
+        boost::optional<boost::gregorian::date> const& p_maybe_max_date =
+            boost::optional<boost::gregorian::date>()
+    );
+
+    /**
+     * @returns the ids of the Entries that belong to actual (i.e.
+     * non-budget) OrdinaryJournals, ordered by date. Filtering may
+     * optionally be performed by Account and/or date (with the date range
+     * being inclusive).
+     */
+    std::vector<sqloxx::Id> actual_entry_ids
+    (   boost::optional<boost::gregorian::date> const& p_maybe_min_date =
+            boost::optional<boost::gregorian::date>(),
+        boost::optional<boost::gregorian::date> const& p_maybe_max_date =
+            boost::optional<boost::gregorian::date>(),
+        boost::optional<sqloxx::Id> const& p_maybe_account_id =
+            boost::optional<sqloxx::Id>()
+    );
+
+    /**
+     * Add to \e p_totals, for each Account, the sum of the amounts
+     * (as per LedgerColumns::amounts) of the Entries dated between
+     * \e p_maybe_min_date and \e p_maybe_max_date inclusive. If
+     * \e p_actual_only is true, only Entries belonging to actual
+     * Journals are included.
+     *
+     * @throws UnsafeArithmeticException if any addition would overflow.
+     * In this case \e p_totals is left in a valid but unspecified state.
+     */
+    void accumulate_totals
+    (   std::unordered_map<sqloxx::Id, jewel::Decimal::int_type>& p_totals,
+        bool p_actual_only,
+        boost::optional<boost::gregorian::date> const& p_maybe_min_date =
+            boost::optional<boost::gregorian::date>(),
+        boost::optional<boost::gregorian::date> const& p_maybe_max_date =
+            boost::optional<boost::gregorian::date>()
+    );
+
+    /**
+     * @returns, for each Account having at least one actual Entry dated
+     * no earlier than recent_usage_days() days before today, the number
+     * of such Entries. (Entries dated after today are included.) Accounts
+     * with no such Entries do not appear.
+     *
+     * The counts are kept bucketed by day, and are adjusted as the
+     * snapshot is brought up to date, so that, after the first call,
+     * this is just a matter of dropping the days that have since fallen
+     * out of the window. The reference is valid only until the next call
+     * to any non-const member function of LedgerSnapshot.
+     */
+    std::unordered_map<sqloxx::Id, std::size_t> const& recent_usage_counts();
+
+    /**
+     * @returns the length, in days, of the window covered by
+     * recent_usage_counts().
+     */
+    static int recent_usage_days();
+
+    /**
+     * Mark the snapshot as a whole as stale.
+     */
+    void mark_as_stale();
+
+    /**
+     * Mark as stale the Entries in the Journal with id \e p_journal_id.
+     */
+    void mark_journal_as_stale(sqloxx::Id p_journal_id);
+
+    /**
+     * Mark as stale the Entry with id \e p_entry_id.
+     */
+    void mark_entry_as_stale(sqloxx::Id p_entry_id);
+
+    /**
+     * @returns the number of times the snapshot has been marked as stale
+     * (in whole or in part) since it was constructed.
+     */
+    std::size_t num_changes() const;
+
+    /**
+     * Take \e p_columns, loaded elsewhere (typically by
+     * load_ledger_columns(...) on a ReadOnlyConnection, on another
+     * thread), as the up-to-date columns - but only if nothing has been
+     * marked as stale since num_changes() returned \e p_num_changes, and
+     * so only if \e p_columns reflects a state of the database no older
+     * than the one at that point.
+     *
+     * @returns \e true if \e p_columns was adopted; otherwise \e false,
+     * in which case the LedgerSnapshot is unchanged.
+     */
+    bool adopt_columns
+    (   std::shared_ptr<LedgerColumns const> const& p_columns,
+        std::size_t p_num_changes
+    );
+
+private:
+
+    void refresh();
+    void refresh_all();
+    void refresh_stale_journals();
+
+    // Rebuild the usage counts from m_columns, for the window as at today.
+    void rebuild_usage();
+
+    // Count (or, if p_increment is false, uncount) the usage represented
+    // by row p_index of p_columns, if it lies within the window.
+    void count_usage
+    (   LedgerColumns const& p_columns,
+        size_type p_index,
+        bool p_increment
+    );
+
+    DcmDatabaseConnection& m_database_connection;
+    // Never modified once populated (see shared_columns()).
+    std::shared_ptr<LedgerColumns const> m_columns;
+    std::unordered_set<sqloxx::Id> m_stale_journal_ids;
+    std::unordered_set<sqloxx::Id> m_stale_entry_ids;
+    bool m_is_stale;
+    std::size_t m_num_changes;
+
+    // See recent_usage_counts(). The buckets are keyed by date, and hold
+    // the counts for that date, which sum to m_usage_counts. Nothing
+    // dated before m_usage_window_start is counted.
+    DateRep m_usage_window_start;
+    std::map<DateRep, std::unordered_map<sqloxx::Id, std::size_t> >
+        m_usage_buckets;
+    std::unordered_map<sqloxx::Id, std::size_t> m_usage_counts;
+
+};  // class LedgerSnapshot
+
+}  // namespace dcm
+
+#endif  // GUARD_ledger_snapshot_hpp_5730186249150372
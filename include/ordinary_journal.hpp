@@ -144,6 +144,10 @@ private:
     void do_ghostify() override;
     void do_remove() override;
 
+    // Passes the date to each of the Entries, which are then able to
+    // answer Entry::date() without loading this OrdinaryJournal.
+    void update_entry_dates();
+
     // Sole non-inherited data member. Note this is of a type where copying
     // does not throw. If we ever add more data members here and/or change
     // this one's type, it MAY be necessary to wrap this with pimpl to
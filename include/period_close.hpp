@@ -0,0 +1,97 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_period_close_hpp_8316620459917243
+#define GUARD_period_close_hpp_8316620459917243
+
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/filesystem.hpp>
+#include <cstddef>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class DcmDatabaseConnection;
+
+// End forward declarations
+
+/**
+ * "Close" the period before \e p_cutoff_date, so that the history prior
+ * to that date no longer has to be traversed when calculating balances,
+ * populating entry lists and generating reports.
+ *
+ * All the OrdinaryJournals dated earlier than \e p_cutoff_date (including
+ * the opening balance journals) are copied, with their Entries, to the
+ * archive database at \e p_archive_filepath, and then removed from the
+ * main database. The archive is created if it does not already exist; if it
+ * does, the journals are added to those already in it, so successive
+ * periods can be closed into the same archive. The archive also receives
+ * a copy of the commodities and accounts tables, so that the archived data
+ * can be reported on independently of the main database; and a row in its
+ * \e period_closures table recording \e p_cutoff_date.
+ *
+ * In place of the removed journals, the main database receives, for each
+ * Account (other than the balancing account) that had a non-zero balance
+ * as at the end of the closed period, a single "balance carried forward"
+ * OrdinaryJournal. This is posted in the same way as an opening balance
+ * journal (see create_opening_balance_journal(...)), and indeed the entity
+ * creation date is moved to \e p_cutoff_date so that these journals
+ * <em>are</em> the opening balance journals from then on. (The balancing
+ * account's balance is carried forward automatically, as the other side of
+ * each of these journals.) Where the closed period contained both
+ * reconciled and unreconciled Entries for an Account, these are carried
+ * forward as separate Entries, so that reconciled balances are unaffected.
+ *
+ * After closing, every Account has the same balance as before, and every
+ * Account other than the balancing account has the same reconciled balance
+ * as before. The balancing account's side of each carried-forward journal
+ * is unreconciled, so any reconciled balance it had as at the end of the
+ * closed period is not carried forward as such. The closed period can no
+ * longer be posted to or edited.
+ *
+ * @returns the number of OrdinaryJournals archived.
+ *
+ * @throws PeriodCloseException if \e p_cutoff_date is not later than the
+ * entity creation date, or is later than today; or if any Repeater is due
+ * to fire before \e p_cutoff_date (as the resulting journals could not then
+ * be posted).
+ *
+ * Exception safety: <em>strong guarantee</em> as regards the main database;
+ * <em>basic guarantee</em> as regards the archive and objects in memory.
+ * (As the database is in WAL mode, the archive and the main database
+ * cannot be committed in a single transaction. The archive is committed
+ * first. If the main database then cannot be, the journals just copied to
+ * the archive are discarded from it again; and should even that fail, or
+ * the application be interrupted between the two commits, they and their
+ * \e period_closures row are discarded by the next call to
+ * close_period(...) with the same archive. Also, any
+ * OrdinaryJournal that was to be archived may have been marked as removed,
+ * even though it remains in the database.)
+ *
+ * Precondition: the database must not be within an uncommitted
+ * transaction (as SQLite cannot attach the archive database within one).
+ */
+std::size_t close_period
+(   DcmDatabaseConnection& p_database_connection,
+    boost::gregorian::date const& p_cutoff_date,
+    boost::filesystem::path const& p_archive_filepath
+);
+
+}  // namespace dcm
+
+#endif  // GUARD_period_close_hpp_8316620459917243
@@ -22,6 +22,8 @@
 #include <sqloxx/id.hpp>
 #include <sqloxx/persistent_object.hpp>
 #include <ostream>
+#include <unordered_set>
+#include <vector>
 
 namespace dcm
 {
@@ -116,9 +118,33 @@ private:
 
     /**
      * @returns true if and only if posting the Journal would cause arithmetic
-     * overflow in Account balances.
+     * overflow in Account balances. Only the Entries for which
+     * Entry::has_unsaved_balance_changes() is true are considered.
      */
     bool would_cause_overflow();
+
+    /**
+     * Delete from the database the Entries with ids \e p_entry_ids, which
+     * have been removed from the PersistentJournal, in a single statement;
+     * and mark as stale the cached balances of \e p_account_ids (the
+     * Accounts of those Entries), and whatever else is cached about those
+     * Entries.
+     */
+    void remove_entries
+    (   std::vector<sqloxx::Id> const& p_entry_ids,
+        std::unordered_set<sqloxx::Id> const& p_account_ids
+    );
+
+    void clear_dirty_flags();
+
+    // Whether the comment or TransactionType has been set to a different
+    // value since the PersistentJournal was last loaded or saved.
+    bool m_core_is_dirty;
+
+    // Whether any Entries have been removed from (or cleared from) the
+    // PersistentJournal since it was last loaded or saved. Unless they
+    // have, saving need not look for Entries to delete.
+    bool m_entries_may_be_removed;
 };
 
 
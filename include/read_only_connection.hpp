@@ -0,0 +1,99 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_read_only_connection_hpp_6620985137402754
+#define GUARD_read_only_connection_hpp_6620985137402754
+
+#include <boost/filesystem.hpp>
+#include <sqloxx/database_connection.hpp>
+#include <sqloxx/database_transaction.hpp>
+
+namespace dcm
+{
+
+/**
+ * A lightweight connection, which can only read, to a database file
+ * that is already set up for DCM (and typically already open in a
+ * DcmDatabaseConnection on the GUI thread).
+ *
+ * A ReadOnlyConnection has its own SQLite connection, and hence its own
+ * cache of SQLStatements; but it has no IdentityMaps, BalanceCache or
+ * other entity-level state, so it cannot be used with Handles or
+ * PersistentObjects - only with SQLStatements. That makes it cheap to open
+ * and safe to use away from the GUI thread, for example within a task run
+ * on a TaskScheduler. A given ReadOnlyConnection must only be used by
+ * one thread at a time.
+ *
+ * Any attempt to write through a ReadOnlyConnection fails with a
+ * SQLiteException. Because DcmDatabaseConnection puts the database in
+ * WAL mode, a ReadOnlyConnection and the DcmDatabaseConnection do not
+ * block each other. To see a consistent state of the database across
+ * several statements, hold a ReadOnlyConnection::Snapshot.
+ */
+class ReadOnlyConnection: public sqloxx::DatabaseConnection
+{
+public:
+
+    /**
+     * Opens a ReadOnlyConnection to the database at \e p_filepath.
+     *
+     * @throws ReadOnlyConnectionException if there is no file at
+     * \e p_filepath. (A ReadOnlyConnection never creates a database.)
+     *
+     * @throws SQLiteException or some derivative thereof, if the file
+     * cannot be opened.
+     */
+    explicit ReadOnlyConnection(boost::filesystem::path const& p_filepath);
+
+    ReadOnlyConnection(ReadOnlyConnection const&) = delete;
+    ReadOnlyConnection(ReadOnlyConnection&&) = delete;
+    ReadOnlyConnection& operator=(ReadOnlyConnection const&) = delete;
+    ReadOnlyConnection& operator=(ReadOnlyConnection&&) = delete;
+    ~ReadOnlyConnection();
+
+    /**
+     * While a Snapshot exists, all reads through the ReadOnlyConnection
+     * see the database as it was when the Snapshot was constructed,
+     * regardless of what is written through other connections in the
+     * meantime.
+     */
+    class Snapshot
+    {
+    public:
+        explicit Snapshot(ReadOnlyConnection& p_connection);
+        Snapshot(Snapshot const&) = delete;
+        Snapshot(Snapshot&&) = delete;
+        Snapshot& operator=(Snapshot const&) = delete;
+        Snapshot& operator=(Snapshot&&) = delete;
+        ~Snapshot();
+    private:
+        sqloxx::DatabaseTransaction m_transaction;
+    };
+
+private:
+
+    /**
+     * Overrides sqloxx::DatabaseConnection::do_setup(). Unlike
+     * DcmDatabaseConnection::do_setup(), this creates nothing;
+     * it just makes the connection read-only.
+     */
+    void do_setup() override;
+
+};  // class ReadOnlyConnection
+
+}  // namespace dcm
+
+#endif  // GUARD_read_only_connection_hpp_6620985137402754
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_task_scheduler_hpp_4417093268815520
+#define GUARD_task_scheduler_hpp_4417093268815520
+
+#include "dcm_exceptions.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dcm
+{
+
+/**
+ * Shared flag by which a running task may be asked to stop. Copies of a
+ * CancellationToken refer to the same flag. A task is expected to poll
+ * the token at convenient points and, if it has been cancelled, to stop
+ * (which it may do by calling throw_if_cancelled()).
+ */
+class CancellationToken
+{
+public:
+
+    /**
+     * Constructs a token that has not been cancelled, and which does not
+     * share its flag with any other token.
+     */
+    CancellationToken();
+
+    CancellationToken(CancellationToken const&) = default;
+    CancellationToken(CancellationToken&&) = default;
+    CancellationToken& operator=(CancellationToken const&) = default;
+    CancellationToken& operator=(CancellationToken&&) = default;
+    ~CancellationToken() = default;
+
+    /**
+     * Safe to call from any thread.
+     */
+    void cancel();
+
+    bool is_cancelled() const;
+
+    /**
+     * @throws TaskCancelledException if is_cancelled().
+     */
+    void throw_if_cancelled() const;
+
+private:
+    std::shared_ptr<std::atomic<bool> > m_flag;
+
+};  // class CancellationToken
+
+/**
+ * The order in which a TaskScheduler starts the tasks queued on it.
+ * Tasks of the same priority are started in the order in which they
+ * were submitted (subject to work stealing; see TaskScheduler).
+ */
+enum class TaskPriority: unsigned char
+{
+    high = 0,
+    normal,
+    low,
+    num_task_priorities  // Not a priority. Must be last.
+};
+
+/**
+ * A fixed pool of threads on which tasks can be run in the background.
+ *
+ * Each thread has its own queue (one per TaskPriority). Submitted tasks
+ * are distributed across the queues in turn; a thread takes work from the
+ * front of its own queue, and when that is empty "steals" from the back
+ * of the others', so that no thread sits idle while work is waiting.
+ *
+ * A task must not touch the DcmDatabaseConnection, the identity maps,
+ * or any wxWidgets object, all of which may only be used on the GUI
+ * thread. It should work on data handed to it when it was submitted
+ * (for example LedgerColumns obtained from
+ * LedgerSnapshot::shared_columns()). To get results back to the GUI
+ * thread, use a completion callback wrapped by gui::on_gui_thread().
+ */
+class TaskScheduler
+{
+public:
+
+    typedef std::function<void(CancellationToken const&)> Task;
+
+    /**
+     * Called, on the thread that ran the task, once a task has finished
+     * or has been abandoned. The exception_ptr is null if the task
+     * returned normally; otherwise it points to the exception thrown by
+     * the task, or to a TaskCancelledException if the task was cancelled
+     * before it started.
+     *
+     * Must not throw. There is nothing to pass an exception on to, and it
+     * cannot be logged, as it is not thrown on the GUI thread; so an
+     * exception thrown by a Completion is discarded. (A Completion wrapped
+     * by gui::on_gui_thread() only posts a callback, which is run on the
+     * GUI thread, where exceptions propagate in the usual way.)
+     */
+    typedef std::function<void(std::exception_ptr const&)> Completion;
+
+    /**
+     * Starts \e p_num_threads threads, or default_num_threads() threads
+     * if \e p_num_threads is 0.
+     */
+    explicit TaskScheduler(std::size_t p_num_threads = 0);
+
+    TaskScheduler(TaskScheduler const&) = delete;
+    TaskScheduler(TaskScheduler&&) = delete;
+    TaskScheduler& operator=(TaskScheduler const&) = delete;
+    TaskScheduler& operator=(TaskScheduler&&) = delete;
+
+    /**
+     * Cancels all tasks that have not yet finished, and waits for the
+     * threads to stop. The Completion of every task is called before
+     * the destructor returns.
+     */
+    ~TaskScheduler();
+
+    /**
+     * Queue \e p_task to be run on one of the threads.
+     *
+     * @returns a token that may be used to cancel the task. If the task
+     * has not started when it is cancelled, it will not be run.
+     */
+    CancellationToken submit
+    (   Task const& p_task,
+        TaskPriority p_priority = TaskPriority::normal,
+        Completion const& p_completion = Completion()
+    );
+
+    /**
+     * Block until every task submitted so far has finished (or been
+     * abandoned), and its Completion called.
+     */
+    void wait_until_idle();
+
+    std::size_t num_threads() const;
+
+    /**
+     * @returns the number of threads to use if none is specified: one
+     * fewer than the number of hardware threads (leaving one for the
+     * GUI), but at least one.
+     */
+    static std::size_t default_num_threads();
+
+private:
+
+    static std::size_t const s_num_priorities =
+        static_cast<std::size_t>(TaskPriority::num_task_priorities);
+
+    struct Job
+    {
+        Task task;
+        Completion completion;
+        CancellationToken token;
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs[s_num_priorities];
+
+        // Token of the Job being run by the thread that owns this queue,
+        // if any; so that it can be cancelled on destruction.
+        std::unique_ptr<CancellationToken> current_token;
+    };
+
+    void run_worker(std::size_t p_index);
+
+    /**
+     * Take the highest priority Job from the thread's own queue or,
+     * failing that, steal one from another queue.
+     *
+     * @returns true if a Job was found.
+     */
+    bool pop_job(std::size_t p_index, Job& p_job);
+
+    void run_job(std::size_t p_index, Job& p_job);
+
+    std::vector<std::unique_ptr<WorkerQueue> > m_queues;
+    std::vector<std::thread> m_threads;
+
+    // Number of Jobs in the queues. Only incremented with m_mutex held,
+    // so that a thread waiting for work cannot miss a wake-up.
+    std::atomic<std::size_t> m_num_queued;
+
+    // The following are all guarded by m_mutex.
+    std::mutex m_mutex;
+    std::condition_variable m_work_available;
+    std::condition_variable m_idle;
+    std::size_t m_num_unfinished;  // queued or running
+    std::size_t m_next_queue;
+    bool m_stopping;
+
+};  // class TaskScheduler
+
+}  // namespace dcm
+
+#endif  // GUARD_task_scheduler_hpp_4417093268815520
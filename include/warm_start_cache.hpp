@@ -0,0 +1,175 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GUARD_warm_start_cache_hpp_2817403659914852
+#define GUARD_warm_start_cache_hpp_2817403659914852
+
+#include "account_type.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/id.hpp>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace dcm
+{
+
+// Begin forward declarations
+
+class DcmDatabaseConnection;
+
+// End forward declarations
+
+/**
+ * The Account and date range by which the user has chosen to filter
+ * the list of Entries in the main window.
+ */
+struct EntryListFilter
+{
+    boost::optional<sqloxx::Id> account_id;
+    boost::optional<boost::gregorian::date> min_date;
+    boost::optional<boost::gregorian::date> max_date;
+};
+
+/**
+ * A small file, kept alongside the database file, recording the figures
+ * that are needed to draw the main window - the favourite Accounts (see
+ * favourite_accounts(...)), and the friendly_balance() and budget() of
+ * every Account - together with the last EntryListFilter used. These
+ * can be read much more quickly than they can be calculated from the
+ * database, and so can be shown while the real figures are calculated.
+ *
+ * The cache is valid for the database only if the database has not been
+ * changed since the cache was saved. The cache file is removed once it
+ * has been read, and is written again only by save(); so if the session
+ * ends without save() being called (for example because of a crash), there
+ * is no cache next time. As a check against the database file having been
+ * changed by other means (for example, replaced by a backup copy), the
+ * cache also records a stamp, and is not used unless this still matches.
+ * The stamp is made up of the size and modification time of the database
+ * file (after a full checkpoint, so that the main file is complete),
+ * together with the number and the highest id of the Entries and of the
+ * journals. (Nothing is written to the database to mark it.)
+ */
+class WarmStartCache
+{
+public:
+
+    struct AccountFigures
+    {
+        jewel::Decimal balance;  // friendly_balance()
+        jewel::Decimal budget;   // budget(), or zero if not a P&L Account
+    };
+
+    typedef
+        std::unordered_map<sqloxx::Id, AccountFigures>
+        AccountFiguresMap;
+
+    /**
+     * Read the cache kept alongside the database at \e p_database_filepath,
+     * which should be open in \e p_database_connection, if there is a
+     * cache and it is valid for the database. Whether or not there is, the
+     * cache file is then removed (see class documentation).
+     *
+     * A cache file that is missing, unreadable or malformed is not an
+     * error: is_loaded() is then just \e false.
+     *
+     * @throws sqloxx::SQLiteException or some derivative thereof, if the
+     * database cannot be checkpointed or read (see class documentation).
+     */
+    WarmStartCache
+    (   DcmDatabaseConnection& p_database_connection,
+        boost::filesystem::path const& p_database_filepath
+    );
+
+    WarmStartCache(WarmStartCache const&) = delete;
+    WarmStartCache(WarmStartCache&&) = delete;
+    WarmStartCache& operator=(WarmStartCache const&) = delete;
+    WarmStartCache& operator=(WarmStartCache&&) = delete;
+    ~WarmStartCache() = default;
+
+    /**
+     * @returns the filepath of the cache kept alongside the database
+     * at \e p_database_filepath.
+     */
+    static boost::filesystem::path filepath_for
+    (   boost::filesystem::path const& p_database_filepath
+    );
+
+    /**
+     * @returns \e true if and only if a valid cache was read on
+     * construction. If not, favourite_accounts() and account_figures()
+     * are empty.
+     */
+    bool is_loaded() const;
+
+    std::map<AccountSuperType, sqloxx::Id> const& favourite_accounts() const;
+
+    AccountFiguresMap const& account_figures() const;
+
+    /**
+     * @returns the EntryListFilter last passed to
+     * set_entry_list_filter(...), either in this session or (if the cache
+     * was loaded) in the session in which it was saved; or an
+     * uninitialized optional if there has been none.
+     */
+    boost::optional<EntryListFilter> const& entry_list_filter() const;
+
+    void set_entry_list_filter(EntryListFilter const& p_filter);
+
+    /**
+     * Calculate the favourite Accounts and the AccountFigures afresh from
+     * the database, and write them, with the EntryListFilter, to the cache
+     * file, stamping it so that the cache is valid for the database as
+     * it now stands. Anything in the write-ahead log is checkpointed into
+     * the main database file first.
+     *
+     * @throws WarmStartCacheException if the cache file cannot be written,
+     * or the size or modification time of the database file cannot be
+     * read. There is then no cache file.
+     *
+     * @throws sqloxx::SQLiteException or some derivative thereof, if the
+     * database cannot be checkpointed.
+     */
+    void save();
+
+private:
+
+    bool load();
+
+    /**
+     * @returns the stamp for the database as it now stands (see class
+     * documentation), or an uninitialized optional if the size or
+     * modification time of the database file cannot be read.
+     */
+    boost::optional<std::string> stamp();
+
+    bool m_is_loaded;
+    DcmDatabaseConnection& m_database_connection;
+    boost::filesystem::path const m_database_filepath;
+    boost::filesystem::path const m_filepath;
+    std::map<AccountSuperType, sqloxx::Id> m_favourite_accounts;
+    AccountFiguresMap m_account_figures;
+    boost::optional<EntryListFilter> m_entry_list_filter;
+
+};  // class WarmStartCache
+
+}  // namespace dcm
+
+#endif  // GUARD_warm_start_cache_hpp_2817403659914852
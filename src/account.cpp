@@ -23,8 +23,10 @@
 #include "commodity.hpp"
 #include "dcm_database_connection.hpp"
 #include "dcm_exceptions.hpp"
+#include "ledger_snapshot.hpp"
 #include "transaction_type.hpp"
 #include "visibility.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/numeric/conversion/cast.hpp>
 #include <boost/optional.hpp>
 #include <jewel/assert.hpp>
@@ -40,6 +42,7 @@
 #include <algorithm>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -54,7 +57,9 @@ using sqloxx::Id;
 using sqloxx::SQLStatement;
 using std::find_if;
 using std::map;
+using std::pair;
 using std::string;
+using std::unordered_map;
 using std::vector;
 
 namespace gregorian = boost::gregorian;
@@ -171,24 +176,11 @@ Account::id_for_name
     wxString const& name
 )
 {
-    // This is a crude linear search, but should be fast enough
-    // unless the user has a truly huge number of Accounts.
-    // We do it this way as we need to match case-insensitively,
-    // and in a way that respects locale. So we do the string matching
-    // in the application code rather than in SQL.
-    wxString const target = name.Lower();
-    SQLStatement statement
-    (   dbc,
-        "select account_id, name from accounts"
-    );
-    while (statement.step())
+    optional<sqloxx::Id> const maybe_id =
+        DcmDatabaseConnection::AccountNameAttorney::find(dbc, name);
+    if (maybe_id)
     {
-        wxString const candidate =
-            std8_to_wx(statement.extract<string>(1)).Lower();
-        if (candidate == target)
-        {
-            return statement.extract<sqloxx::Id>(0);
-        }
+        return *maybe_id;
     }
     JEWEL_THROW
     (   InvalidAccountNameException,
@@ -231,18 +223,12 @@ Account::exists
     wxString const& p_name
 )
 {
-    wxString const target = p_name.Lower();
-    SQLStatement statement(p_database_connection, "select name from accounts");
-    while (statement.step())
-    {
-        wxString const candidate =
-            std8_to_wx(statement.extract<string>(0)).Lower();
-        if (candidate == target)
-        {
-            return true;
-        }
-    }
-    return false;
+    return static_cast<bool>
+    (   DcmDatabaseConnection::AccountNameAttorney::find
+        (   p_database_connection,
+            p_name
+        )
+    );
 }
 
 bool
@@ -489,6 +475,9 @@ void
 Account::do_save_existing()
 {
     BalanceCacheAttorney::mark_as_stale(database_connection(), id());
+    BalanceCacheAttorney::mark_opening_balances_as_stale
+    (   database_connection()
+    );
     SQLStatement updater
     (   database_connection(),
         "update accounts set "
@@ -501,6 +490,10 @@ Account::do_save_existing()
     );
     updater.bind(":account_id", id());
     process_saving_statement(updater);
+    DcmDatabaseConnection::AccountNameAttorney::mark_account_as_stale
+    (   database_connection(),
+        id()
+    );
     BudgetAttorney::regenerate(database_connection());
     return;
 }
@@ -529,6 +522,9 @@ Account::do_save_new()
         ")"
     );
     process_saving_statement(inserter);
+    DcmDatabaseConnection::AccountNameAttorney::mark_as_stale
+    (   database_connection()
+    );
     BudgetAttorney::regenerate(database_connection());
     return;
 }
@@ -544,12 +540,19 @@ Account::do_remove()
         );
     }
     BalanceCacheAttorney::mark_as_stale(database_connection(), id());
+    BalanceCacheAttorney::mark_opening_balances_as_stale
+    (   database_connection()
+    );
     string const statement_text =
         "delete from " + primary_table_name() + " where " +
         primary_key_name() + " = :p";
     SQLStatement statement(database_connection(), statement_text);
     statement.bind(":p", id());
     statement.step_final();
+    DcmDatabaseConnection::AccountNameAttorney::mark_account_as_stale
+    (   database_connection(),
+        id()
+    );
     BudgetAttorney::regenerate(database_connection());
     return;
 }
@@ -582,59 +585,40 @@ map<AccountSuperType, sqloxx::Id>
 favourite_accounts(DcmDatabaseConnection& p_database_connection)
 {
     map<AccountSuperType, sqloxx::Id> ret;
-    map<sqloxx::Id, size_t> account_map;
-    AccountTableIterator a_it(p_database_connection);
-    AccountTableIterator a_end;
-    for ( ; a_it != a_end; ++a_it)
-    {
-        JEWEL_ASSERT ((*a_it)->has_id());
-        account_map[(*a_it)->id()] = 0;
-    }
-    SQLStatement selector
-    (   p_database_connection,
-        "select account_id, count(journal_id) from "
-        "("
-            "select account_id, journal_id from entries join "
-            "ordinary_journal_detail using(journal_id) join journals "
-            "using(journal_id) where transaction_type_id != :natt and "
-            "date >= :min_date order by date"
-        ") "
-        "group by account_id;"
-    );
-    selector.bind(":natt", static_cast<int>(non_actual_transaction_type()));
-    selector.bind(":min_date", julian_int(today()) - 30);
-    while (selector.step())
-    {
-        account_map[selector.extract<sqloxx::Id>(0)] =
-            selector.extract<long long>(1);
-    }
     map<AccountSuperType, size_t> max_counts;
     for (AccountSuperType ast: account_super_types())
     {
         max_counts[ast] = 0;
     }
-    Handle<Account> const balancing_acct =
-        p_database_connection.balancing_account();
-    for (auto const& account_map_elem: account_map)
+    unordered_map<sqloxx::Id, size_t> const& usage_counts =
+        p_database_connection.ledger_snapshot().recent_usage_counts();
+    sqloxx::Id const balancing_account_id =
+        p_database_connection.balancing_account()->id();
+
+    // We read the AccountTypes straight from the table, rather than
+    // loading each Account, as we need nothing else from them.
+    SQLStatement statement
+    (   p_database_connection,
+        "select account_id, account_type_id from accounts "
+        "order by account_id"
+    );
+    while (statement.step())
     {
-        Handle<Account> const account
-        (   p_database_connection,
-            account_map_elem.first
-        );
-        auto const count = account_map_elem.second;
-        auto const stype = account->account_super_type();
+        sqloxx::Id const account_id = statement.extract<sqloxx::Id>(0);
+        auto const stype =
+            super_type(static_cast<AccountType>(statement.extract<int>(1)));
+        auto const it = usage_counts.find(account_id);
+        size_t const count = ((it == usage_counts.end())? 0: it->second);
         if
-        (   (   (account_map[account->id()] >= max_counts[stype]) ||
-                (ret[stype] == balancing_acct->id())
+        (   (   (count >= max_counts[stype]) ||
+                (ret[stype] == balancing_account_id)
             )
             &&
-            (   (account != balancing_acct)
+            (   (account_id != balancing_account_id)
             )
         )
         {
-            JEWEL_ASSERT (account->has_id());
-            JEWEL_ASSERT (account_map_elem.first == account->id());
-            ret[stype] = account->id();
+            ret[stype] = account_id;
             max_counts[stype] = count;
         }
     }
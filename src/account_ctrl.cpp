@@ -20,6 +20,7 @@
 #include "account_type.hpp"
 #include "dcm_database_connection.hpp"
 #include "dcm_exceptions.hpp"
+#include "ledger_snapshot.hpp"
 #include "string_flags.hpp"
 #include "gui/combo_box.hpp"
 #include "gui/string_set_validator.hpp"
@@ -29,8 +30,11 @@
 #include <sqloxx/id.hpp>
 #include <wx/event.h>
 #include <wx/string.h>
+#include <algorithm>
+#include <cstddef>
 #include <set>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 using jewel::Log;
@@ -38,6 +42,9 @@ using sqloxx::Handle;
 using sqloxx::Id;
 using std::ostringstream;
 using std::set;
+using std::size_t;
+using std::stable_sort;
+using std::unordered_map;
 using std::vector;
 
 namespace dcm
@@ -64,7 +71,7 @@ AccountCtrl::AccountCtrl
         wxDefaultPosition,
         p_size,
         wxArrayString(),    
-        wxCB_SORT
+        0  // not wxCB_SORT, as reset(...) puts the most used first
     ),
     m_database_connection(p_database_connection)
 {
@@ -128,8 +135,9 @@ AccountCtrl::reset(Handle<Account> const& p_preserved_account)
         );
     }    
     m_account_map.clear();
-    wxArrayString valid_account_names;
-    AccountTableIterator it(m_database_connection);
+    vector<Handle<Account> > valid_accounts;
+    AccountTableIterator it =
+        make_name_ordered_account_table_iterator(m_database_connection);
     AccountTableIterator const end;
     for ( ; it != end; ++it)
     {
@@ -145,14 +153,13 @@ AccountCtrl::reset(Handle<Account> const& p_preserved_account)
                 (acc == p_preserved_account)
             )
             {
-                wxString const name = acc->name();
-                valid_account_names.Add(name);
+                valid_accounts.push_back(acc);
 
                 // Remember the Account associated with this name (comes
                 // in handy when we have to update for a change in Account
                 // name).
                 JEWEL_ASSERT (acc->has_id());
-                m_account_map[name] = acc->id();
+                m_account_map[acc->name()] = acc->id();
             }
         }
         else
@@ -168,6 +175,31 @@ AccountCtrl::reset(Handle<Account> const& p_preserved_account)
             "this AccountCtrl."
         );
     }
+
+    // Offer the most used Accounts first, and otherwise keep them in
+    // order of name (as read above; stable_sort preserves this order among
+    // Accounts that are used equally).
+    unordered_map<Id, size_t> const& usage_counts =
+        m_database_connection.ledger_snapshot().recent_usage_counts();
+    auto const usage_count =
+        [&usage_counts](Handle<Account> const& p_acc) -> size_t
+    {
+        auto const jt = usage_counts.find(p_acc->id());
+        return (jt == usage_counts.end())? size_t(0): jt->second;
+    };
+    stable_sort
+    (   valid_accounts.begin(),
+        valid_accounts.end(),
+        [&usage_count](Handle<Account> const& lhs, Handle<Account> const& rhs)
+        {
+            return usage_count(lhs) > usage_count(rhs);
+        }
+    );
+    wxArrayString valid_account_names;
+    for (Handle<Account> const& acc: valid_accounts)
+    {
+        valid_account_names.Add(acc->name());
+    }
     JEWEL_ASSERT (!valid_account_names.IsEmpty());
     StringSetValidator validator
     (   valid_account_names[0],
@@ -22,23 +22,30 @@
 #include "finformat.hpp"
 #include "dcm_database_connection.hpp"
 #include "string_flags.hpp"
+#include "warm_start_cache.hpp"
 #include "gui/account_dialog.hpp"
 #include "gui/locale.hpp"
 #include "gui/persistent_object_event.hpp"
 #include "gui/top_panel.hpp"
 #include <jewel/assert.hpp>
+#include <jewel/decimal.hpp>
 #include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/event.h>
 #include <wx/listctrl.h>
 #include <wx/notebook.h>
 #include <wx/string.h>
 #include <algorithm>
 #include <set>
+#include <utility>
+#include <vector>
 
+using jewel::Decimal;
 using sqloxx::Handle;
 using std::is_signed;
 using std::max;
 using std::set;
+using std::vector;
 
 namespace dcm
 {
@@ -55,7 +62,8 @@ END_EVENT_TABLE()
 AccountListCtrl::AccountListCtrl
 (   wxWindow* p_parent,
     DcmDatabaseConnection& p_database_connection,
-    AccountSuperType p_account_super_type
+    AccountSuperType p_account_super_type,
+    bool p_show_balances
 ):
     wxListCtrl
     (   p_parent,
@@ -68,6 +76,7 @@ AccountListCtrl::AccountListCtrl
         wxLC_REPORT | wxLC_SINGLE_SEL | wxFULL_REPAINT_ON_RESIZE
     ),
     m_show_hidden(false),
+    m_show_balances(p_show_balances),
     m_account_super_type(p_account_super_type),
     m_database_connection(p_database_connection)
 {
@@ -88,12 +97,7 @@ AccountListCtrl::selected_accounts() const
     {
         if (GetItemState(i, wxLIST_STATE_SELECTED))
         {
-            Handle<Account> const account
-            (   m_database_connection,
-                GetItemData(i)
-            );
-            JEWEL_ASSERT (account->has_id());
-            ret.insert(account->id());
+            ret.insert(GetItemData(i));
         }
     }
     return ret;
@@ -118,6 +122,149 @@ AccountListCtrl::on_item_activated(wxListEvent& event)
 
 void
 AccountListCtrl::update()
+{
+    vector<AccountRow> rows;
+    rows.reserve(m_rows.size());
+    AccountTableIterator it = make_type_name_ordered_account_table_iterator
+    (   m_database_connection
+    );
+    AccountTableIterator const end;
+    for ( ; it != end; ++it)
+    {
+        Handle<Account> const& account = *it;
+        if
+        (   (account->account_super_type() == m_account_super_type) &&
+            (m_show_hidden || (account->visibility() == Visibility::visible))
+        )    
+        {
+            JEWEL_ASSERT (account->has_id());
+            AccountRow row;
+            row.account_id = account->id();
+            row.name = account->name();
+            row.has_figures = m_show_balances;
+            if (m_show_balances)
+            {
+                row.balance = account->friendly_balance();
+                if (showing_daily_budget())
+                {
+                    row.budget = account->budget();
+                }
+            }
+            else
+            {
+                auto const jt = m_provisional_figures.find(row.account_id);
+                if (jt != m_provisional_figures.end())
+                {
+                    row.balance = jt->second.balance;
+                    row.budget = jt->second.budget;
+                    row.has_figures = true;
+                }
+            }
+            rows.push_back(row);
+        }
+    }
+    if (has_same_accounts(rows))
+    {
+        update_cells(rows);
+    }
+    else
+    {
+        rebuild(rows);
+    }
+    m_rows = std::move(rows);
+    return;
+}
+
+void
+AccountListCtrl::show_balances()
+{
+    if (m_show_balances)
+    {
+        return;
+    }
+    m_show_balances = true;
+    m_provisional_figures.clear();
+    update();
+    return;
+}
+
+void
+AccountListCtrl::show_provisional_figures
+(   WarmStartCache::AccountFiguresMap const& p_figures
+)
+{
+    if (m_show_balances)
+    {
+        return;
+    }
+    m_provisional_figures = p_figures;
+    update();
+    return;
+}
+
+bool
+AccountListCtrl::has_same_accounts(vector<AccountRow> const& p_rows) const
+{
+    if (GetColumnCount() == 0)
+    {
+        return false;  // Never yet drawn.
+    }
+    if (p_rows.size() != m_rows.size())
+    {
+        return false;
+    }
+    for (vector<AccountRow>::size_type i = 0; i != p_rows.size(); ++i)
+    {
+        if
+        (   (p_rows[i].account_id != m_rows[i].account_id) ||
+            (p_rows[i].name != m_rows[i].name)
+        )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+AccountListCtrl::update_cells(vector<AccountRow> const& p_rows)
+{
+    JEWEL_ASSERT (has_same_accounts(p_rows));  // precondition
+    JEWEL_ASSERT (static_cast<size_t>(GetItemCount()) == p_rows.size());
+    bool changed = false;
+    long i = 0;  // because wxWidgets uses long
+    for (auto const& row: p_rows)
+    {
+        AccountRow const& old_row = m_rows[i];
+        JEWEL_ASSERT
+        (   static_cast<sqloxx::Id>(GetItemData(i)) == row.account_id
+        );
+        bool const figures_shown_changed =
+            (row.has_figures != old_row.has_figures);
+        if (figures_shown_changed || (row.balance != old_row.balance))
+        {
+            SetItem(i, s_balance_col, figure_text(row, row.balance));
+            changed = true;
+        }
+        if
+        (   showing_daily_budget() &&
+            (figures_shown_changed || (row.budget != old_row.budget))
+        )
+        {
+            SetItem(i, s_budget_col, figure_text(row, row.budget));
+            changed = true;
+        }
+        ++i;
+    }
+    if (changed)
+    {
+        configure_column_widths();
+    }
+    return;
+}
+
+void
+AccountListCtrl::rebuild(vector<AccountRow> const& p_rows)
 {
     // Remember which rows are selected currently
     auto const selected = selected_accounts();
@@ -162,72 +309,69 @@ AccountListCtrl::update()
     }
 
     long i = 0;  // because wxWidgets uses long
-    AccountTableIterator it = make_type_name_ordered_account_table_iterator
-    (   m_database_connection
-    );
-    AccountTableIterator const end;
-    for ( ; it != end; ++it)
+    for (auto const& row: p_rows)
     {
-        Handle<Account> const& account = *it;
-        if
-        (   (account->account_super_type() == m_account_super_type) &&
-            (m_show_hidden || (account->visibility() == Visibility::visible))
-        )    
-        {
-            // Insert item, with string for Column 0
-            InsertItem(i, account->name());
-        
-            JEWEL_ASSERT (account->has_id());
-            auto const id = account->id();
-            static_assert
-            (   (sizeof(id) <= sizeof(long)) &&
-                is_signed<decltype(id)>::value &&
-                is_signed<long>::value,
-                "Object Id is too wide to be safely passed to "
-                "SetItemData."
-            );
-            SetItemData(i, id);
+        // Insert item, with string for Column 0
+        InsertItem(i, row.name);
+    
+        auto const id = row.account_id;
+        static_assert
+        (   (sizeof(id) <= sizeof(long)) &&
+            is_signed<decltype(id)>::value &&
+            is_signed<long>::value,
+            "Object Id is too wide to be safely passed to "
+            "SetItemData."
+        );
+        SetItemData(i, id);
 
-            // Insert the balance string
-            SetItem
-            (   i,
-                s_balance_col,
-                finformat_wx(account->friendly_balance(), locale())
-            );
+        // Insert the balance string
+        SetItem(i, s_balance_col, figure_text(row, row.balance));
 
-            if (showing_daily_budget())
-            {
-                // Insert budget string
-                SetItem
-                (   i,
-                    s_budget_col,
-                    finformat_wx(account->budget(), locale())
-                );
-            }
-
-            ++i;
+        if (showing_daily_budget())
+        {
+            // Insert budget string
+            SetItem(i, s_budget_col, figure_text(row, row.budget));
         }
-    }
 
-    // Reinstate the selections we remembered
-    for (size_t j = 0, lim = GetItemCount(); j != lim; ++j)
-    {
-        Handle<Account> const account
-        (   m_database_connection,
-            GetItemData(j)
-        );
-        JEWEL_ASSERT (account->has_id());
-        if (selected.find(account->id()) != selected.end())
+        // Reinstate the selection we remembered
+        if (selected.find(id) != selected.end())
         {
             SetItemState
-            (   j,
+            (   i,
                 wxLIST_STATE_SELECTED,
                 wxLIST_STATE_SELECTED
             );
         }
+
+        ++i;
+    }
+
+    configure_column_widths();
+
+    // Reinstate scrolled position
+    if (bottom_item >= 0) EnsureVisible(bottom_item);
+
+    Layout();
+
+    return;
+}
+
+wxString
+AccountListCtrl::figure_text
+(   AccountRow const& p_row,
+    Decimal const& p_figure
+)
+{
+    if (!p_row.has_figures)
+    {
+        return wxEmptyString;
     }
+    return finformat_wx(p_figure, locale());
+}
 
-    // Configure column widths
+void
+AccountListCtrl::configure_column_widths()
+{
     SetColumnWidth(s_name_col, wxLIST_AUTOSIZE_USEHEADER);
     SetColumnWidth(s_name_col, max(GetColumnWidth(s_name_col), 200));
     SetColumnWidth(s_balance_col, wxLIST_AUTOSIZE);
@@ -237,12 +381,6 @@ AccountListCtrl::update()
         SetColumnWidth(s_budget_col, wxLIST_AUTOSIZE);
         SetColumnWidth(s_budget_col, max(GetColumnWidth(s_budget_col), 90));
     }
-
-    // Reinstate scrolled position
-    if (bottom_item >= 0) EnsureVisible(bottom_item);
-
-    Layout();
-
     return;
 }
 
@@ -289,12 +427,13 @@ AccountListCtrl::select_only(Handle<Account> const& p_account)
 {
     JEWEL_ASSERT (p_account->has_id());  // precondition    
 
+    sqloxx::Id const account_id = p_account->id();
     size_t const sz = GetItemCount();    
     for (size_t i = 0; i != sz; ++i)
     {
-        Handle<Account> const account(m_database_connection, GetItemData(i));
         long const filter = (wxLIST_STATE_SELECTED | wxLIST_STATE_FOCUSED);
-        long const flags = ((account == p_account)? filter: 0);
+        sqloxx::Id const id = GetItemData(i);
+        long const flags = ((id == account_id)? filter: 0);
         SetItemState(i, flags, filter);
     }
     return;
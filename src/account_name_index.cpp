@@ -0,0 +1,206 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "account_name_index.hpp"
+#include "dcm_database_connection.hpp"
+#include "string_conv.hpp"
+#include <boost/optional.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/log.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <wx/string.h>
+#include <string>
+
+using boost::optional;
+using sqloxx::Id;
+using sqloxx::SQLStatement;
+using std::string;
+
+namespace dcm
+{
+
+AccountNameIndex::AccountNameIndex
+(   DcmDatabaseConnection& p_database_connection
+):
+    m_database_connection(p_database_connection),
+    m_is_stale(true)
+{
+    JEWEL_LOG_TRACE();
+}
+
+AccountNameIndex::~AccountNameIndex()
+{
+    JEWEL_LOG_TRACE();
+}
+
+optional<Id>
+AccountNameIndex::find(wxString const& p_name)
+{
+    refresh();
+    IdMap::const_iterator const it = m_ids.find(folded_name(p_name));
+    return (it == m_ids.end())? optional<Id>(): optional<Id>(it->second);
+}
+
+void
+AccountNameIndex::mark_as_stale()
+{
+    m_is_stale = true;
+    m_stale_account_ids.clear();
+    return;
+}
+
+void
+AccountNameIndex::mark_account_as_stale(Id p_account_id)
+{
+    // If the whole index is stale, everything will be re-read anyway.
+    if (!m_is_stale) m_stale_account_ids.insert(p_account_id);
+    return;
+}
+
+string
+AccountNameIndex::folded_name(wxString const& p_name)
+{
+    // We fold using wxString::Lower() so that matching respects locale,
+    // as it did when names were compared one by one; the result is then
+    // stored as UTF-8 so that it can be hashed with std::hash.
+    return wx_to_std8(p_name.Lower());
+}
+
+void
+AccountNameIndex::refresh()
+{
+    if (m_is_stale)
+    {
+        refresh_all();
+        m_stale_account_ids.clear();
+        m_is_stale = false;
+        return;
+    }
+    try
+    {
+        for (Id const account_id: m_stale_account_ids)
+        {
+            refresh_account(account_id);
+        }
+    }
+    catch (...)
+    {
+        // We don't know how far we got, so start afresh next time.
+        mark_as_stale();
+        throw;
+    }
+    m_stale_account_ids.clear();
+    JEWEL_ASSERT (!m_is_stale);
+    return;
+}
+
+void
+AccountNameIndex::refresh_all()
+{
+    JEWEL_LOG_TRACE();
+    m_ids.clear();
+    m_names.clear();
+    try
+    {
+        SQLStatement statement
+        (   m_database_connection,
+            "select account_id, name from accounts"
+        );
+        while (statement.step())
+        {
+            insert
+            (   statement.extract<Id>(0),
+                folded_name(std8_to_wx(statement.extract<string>(1)))
+            );
+        }
+    }
+    catch (...)
+    {
+        m_ids.clear();
+        m_names.clear();
+        throw;
+    }
+    return;
+}
+
+void
+AccountNameIndex::refresh_account(Id p_account_id)
+{
+    // The Account may since have been renamed or removed, or its removal
+    // may have been rolled back, so we just re-read whatever is there now.
+    erase(p_account_id);
+    SQLStatement statement
+    (   m_database_connection,
+        "select name from accounts where account_id = :p"
+    );
+    statement.bind(":p", p_account_id);
+    if (statement.step())
+    {
+        insert
+        (   p_account_id,
+            folded_name(std8_to_wx(statement.extract<string>(0)))
+        );
+        statement.step_final();
+    }
+    return;
+}
+
+void
+AccountNameIndex::insert(Id p_account_id, string const& p_folded_name)
+{
+    JEWEL_ASSERT (m_names.find(p_account_id) == m_names.end());
+    m_names.insert(NameMap::value_type(p_account_id, p_folded_name));
+
+    // If another Account already has this name (differing only in case),
+    // it keeps the entry in m_ids.
+    m_ids.insert(IdMap::value_type(p_folded_name, p_account_id));
+    return;
+}
+
+void
+AccountNameIndex::erase(Id p_account_id)
+{
+    NameMap::iterator const it = m_names.find(p_account_id);
+    if (it == m_names.end())
+    {
+        return;
+    }
+    string const folded = it->second;
+    m_names.erase(it);
+    IdMap::iterator const jt = m_ids.find(folded);
+    JEWEL_ASSERT (jt != m_ids.end());
+    if (jt->second != p_account_id)
+    {
+        return;
+    }
+    m_ids.erase(jt);
+
+    // Another Account with this name (differing only in case) may have
+    // been shadowed by this one. This is rare, and the number of Accounts
+    // small, so a linear search is fine.
+    for (NameMap::value_type const& elem: m_names)
+    {
+        if (elem.second == folded)
+        {
+            m_ids.insert(IdMap::value_type(folded, elem.first));
+            break;
+        }
+    }
+    return;
+}
+
+}  // namespace dcm
@@ -19,15 +19,24 @@
 #include "date.hpp"
 #include "dcm_database_connection.hpp"
 #include "dcm_exceptions.hpp"
+#include "entry.hpp"
+#include "handle_cache.hpp"
+#include "ledger_snapshot.hpp"
+#include "persistent_journal.hpp"
+#include "read_only_connection.hpp"
 #include "repeater.hpp"
 #include "string_conv.hpp"
+#include "task_scheduler.hpp"
+#include "warm_start_cache.hpp"
 #include "gui/error_reporter.hpp"
 #include "gui/frame.hpp"
 #include "gui/locale.hpp"
 #include "gui/setup_wizard.hpp"
+#include "gui/task_bridge.hpp"
 #include "gui/welcome_dialog.hpp"
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
 #include <boost/optional.hpp>
 #include <jewel/assert.hpp>
 #include <jewel/exception.hpp>
@@ -35,8 +44,10 @@
 #include <jewel/on_windows.hpp>
 #include <jewel/optional.hpp>
 #include <jewel/version.hpp>
+#include <sqloxx/sql_statement.hpp>
 #include <wx/cmdline.h>
 #include <wx/config.h>
+#include <wx/event.h>
 #include <wx/filedlg.h>
 #include <wx/filename.h>
 #include <wx/fs_zip.h>
@@ -48,6 +59,7 @@
 #include <wx/wx.h>
 #include <cstddef>
 #include <cstdlib>
+#include <exception>
 #include <iostream>
 #include <memory>
 #include <stdexcept>
@@ -55,18 +67,24 @@
 #include <string>
 #include <vector>
 
+using boost::lexical_cast;
 using boost::optional;
 using jewel::clear;
 using jewel::Log;
 using jewel::value;
 using jewel::Version;
+using sqloxx::SQLStatement;
 using std::bad_alloc;
 using std::cerr;
 using std::clog;
 using std::cout;
 using std::endl;
+using std::exception_ptr;
 using std::getenv;
+using std::make_shared;
 using std::ostringstream;
+using std::rethrow_exception;
+using std::shared_ptr;
 using std::size_t;
 using std::string;
 using std::unique_ptr;
@@ -124,6 +142,34 @@ namespace
         return false;
     }
 
+    /**
+     * @returns the filepath of the backup, or an uninitialized optional if
+     * a backup could not be made. May be called on any thread.
+     */
+    optional<filesystem::path> make_backup_if_possible
+    (   filesystem::path const& p_original_filepath,
+        filesystem::path const& p_directory
+    )
+    {
+        try
+        {
+            return make_backup(p_original_filepath, p_directory, "-backup");
+        }
+        catch (UniqueNameException&)
+        {
+            // do nothing
+        }
+        catch (filesystem::filesystem_error&)
+        {
+            // do nothing
+        }
+        catch (bad_alloc&)
+        {
+            // do nothing
+        }
+        return optional<filesystem::path>();
+    }
+
     static const wxCmdLineEntryDesc cmd_line_desc[] =
     {   {   wxCMD_LINE_SWITCH,
             "h",
@@ -157,8 +203,13 @@ namespace
 
 }  // end anonymous namespace
 
+BEGIN_EVENT_TABLE(App, wxApp)
+    EVT_THREAD(gui::gui_callback_event_id, App::on_gui_callback)
+END_EVENT_TABLE()
+
 App::App():
     m_exiting_cleanly(false),
+    m_num_pending_startup_stages(0),
     m_single_instance_checker(nullptr),
     m_database_connection(nullptr)
 {
@@ -346,31 +397,147 @@ App::default_directory()
 }
 
 void
-App::make_backup(filesystem::path const& p_original_filepath)
+App::start_deferred_startup()
 {
     JEWEL_LOG_TRACE();
-    try
-    {
-        m_backup_filepath = dcm::make_backup
-        (   filesystem::absolute(p_original_filepath),
-            filesystem::absolute(p_original_filepath.parent_path()),
-            "-backup"
-        );
-    }
-    catch (UniqueNameException&)
+    JEWEL_ASSERT (m_database_filepath);
+    JEWEL_ASSERT (m_num_pending_startup_stages == 0);
+    m_num_pending_startup_stages = 2;
+    filesystem::path const filepath =
+        filesystem::absolute(*m_database_filepath);
+    filesystem::path const directory =
+        filesystem::absolute(m_database_filepath->parent_path());
+
+    // Load the ledger on a connection of its own. The LedgerSnapshot
+    // adopts the result only if nothing has been written through the main
+    // connection in the meantime; otherwise (or if the load fails), it
+    // just loads the ledger itself, on this thread, when next needed.
+    size_t const num_changes =
+        database_connection().ledger_snapshot().num_changes();
+    shared_ptr<LedgerColumns> const columns = make_shared<LedgerColumns>();
+    task_scheduler().submit
+    (   [filepath, columns](CancellationToken const& p_token)
+        {
+            ReadOnlyConnection connection(filepath);
+            ReadOnlyConnection::Snapshot const snapshot(connection);
+            p_token.throw_if_cancelled();
+            load_ledger_columns(connection, *columns);
+            return;
+        },
+        TaskPriority::high,
+        gui::on_gui_thread
+        (   [this, columns, num_changes](exception_ptr const& p_error)
+            {
+                gui::Frame* const frame = main_frame();
+                if (!frame)
+                {
+                    return;
+                }
+                if (!p_error)
+                {
+                    database_connection().ledger_snapshot().adopt_columns
+                    (   columns,
+                        num_changes
+                    );
+                }
+                frame->complete_startup();
+                on_deferred_startup_stage_done();
+                return;
+            }
+        )
+    );
+
+    // Back up the database file. The main file is complete (see
+    // DcmDatabaseConnection::do_setup()); switching off automatic
+    // checkpoints keeps it that way while it is being copied. We restore
+    // whatever setting was in force before.
+    SQLStatement checkpoint_reader
+    (   database_connection(),
+        "pragma wal_autocheckpoint"
+    );
+    checkpoint_reader.step();
+    int const old_autocheckpoint = checkpoint_reader.extract<int>(0);
+    checkpoint_reader.step_final();
+    database_connection().execute_sql("pragma wal_autocheckpoint = 0;");
+    shared_ptr<optional<filesystem::path> > const backup_filepath =
+        make_shared<optional<filesystem::path> >();
+    task_scheduler().submit
+    (   [filepath, directory, backup_filepath](CancellationToken const&)
+        {
+            *backup_filepath = make_backup_if_possible(filepath, directory);
+            return;
+        },
+        TaskPriority::normal,
+        gui::on_gui_thread
+        (   [this, backup_filepath, old_autocheckpoint]
+            (   exception_ptr const& p_error
+            )
+            {
+                // This much is done even if we are exiting, so that
+                // OnExit() can clean up the backup.
+                database_connection().execute_sql
+                (   "pragma wal_autocheckpoint = " +
+                    lexical_cast<string>(old_autocheckpoint) + ";"
+                );
+                if (*backup_filepath)
+                {
+                    m_backup_filepath = *backup_filepath;
+                    m_error_reporter.set_backup_db_file_location
+                    (   value(*backup_filepath)
+                    );
+                }
+                if (!main_frame())
+                {
+                    return;
+                }
+                if (p_error)
+                {
+                    rethrow_exception(p_error);
+                }
+                on_deferred_startup_stage_done();
+                return;
+            }
+        )
+    );
+    return;
+}
+
+void
+App::on_deferred_startup_stage_done()
+{
+    JEWEL_LOG_TRACE();
+    JEWEL_ASSERT (m_num_pending_startup_stages > 0);
+    --m_num_pending_startup_stages;
+    if (m_num_pending_startup_stages != 0)
     {
-        // do nothing
+        return;
     }
-    catch (filesystem::filesystem_error&)
+    gui::Frame* const frame = main_frame();
+    JEWEL_ASSERT (frame);
+
+    // The Repeaters are left until now: until after the backup, so that
+    // the backup is of the file as the user left it; and until after the
+    // ledger has been adopted, as the Journals they record would
+    // otherwise cause it to be discarded.
+    vector<RepeaterFiringResult> const repeater_firing_results =
+        update_repeaters(database_connection());
+    frame->report_repeater_firing_results(repeater_firing_results);
+    return;
+}
+
+gui::Frame*
+App::main_frame()
+{
+    if (!IsMainLoopRunning())
     {
-        // do nothing
+        return nullptr;
     }
-    catch (bad_alloc&)
+    wxWindow* const window = GetTopWindow();
+    if (!window || window->IsBeingDeleted())
     {
-        // do nothing
+        return nullptr;
     }
-    JEWEL_LOG_TRACE();
-    return;
+    return dynamic_cast<gui::Frame*>(window);
 }
 
 wxConfig&
@@ -538,20 +705,31 @@ bool App::OnInit()
         set_last_opened_file(*m_database_filepath);
         JEWEL_LOG_TRACE();
         m_error_reporter.set_db_file_location(*m_database_filepath);
-        make_backup(*m_database_filepath);
-        if (m_backup_filepath)
-        {
-            m_error_reporter.set_backup_db_file_location(*m_backup_filepath);
-        }
         database_connection().set_caching_level(5);
-        vector<RepeaterFiringResult> const repeater_firing_results =
-            update_repeaters(database_connection());
-        gui::Frame* frame =
-            new gui::Frame(application_name(), database_connection());
+
+        // At level 5, Entries and journals are not kept in the
+        // IdentityMaps; keep the most recently used of them instead, up to
+        // a bound, so that memory use does not grow with the ledger.
+        // (Unsaved changes are discarded by ghostifying the objects
+        // concerned, rather than by letting go of them: see HandleCache.)
+        database_connection().handle_cache<Entry>().set_capacity(8192);
+        database_connection().handle_cache<PersistentJournal>().
+            set_capacity(4096);
+        m_warm_start_cache.reset
+        (   new WarmStartCache(database_connection(), *m_database_filepath)
+        );
+
+        // Show the main window straight away; the rest of startup
+        // (see start_deferred_startup()) fills it in as it completes.
+        gui::Frame* frame = new gui::Frame
+        (   application_name(),
+            database_connection(),
+            *m_warm_start_cache
+        );
         SetTopWindow(frame);
         frame->Show(true);
         wxToolTip::Enable(true);
-        frame->report_repeater_firing_results(repeater_firing_results);
+        start_deferred_startup();
 
         // Start the event loop
         JEWEL_LOG_MESSAGE(Log::info, "Starting wxWidgets event loop.");
@@ -598,6 +776,24 @@ App::database_connection()
     return *m_database_connection;
 }
 
+TaskScheduler&
+App::task_scheduler()
+{
+    if (!m_task_scheduler)
+    {
+        m_task_scheduler.reset(new TaskScheduler);
+    }
+    return *m_task_scheduler;
+}
+
+void
+App::on_gui_callback(wxThreadEvent& event)
+{
+    (void)event;  // Silence compiler re. unused parameter.
+    gui::run_gui_callbacks();
+    return;
+}
+
 int App::OnRun()
 {
     try
@@ -631,6 +827,41 @@ int App::OnRun()
 int App::OnExit()
 {
     JEWEL_LOG_TRACE();
+
+    // Stop any background tasks before the things they might refer to
+    // are torn down.
+    m_task_scheduler.reset();
+
+    // Pick up the backup filepath, if the backup finished but its
+    // completion had not yet been run.
+    gui::run_gui_callbacks();
+
+    if (m_warm_start_cache && m_exiting_cleanly)
+    {
+        try
+        {
+            m_warm_start_cache->save();
+        }
+        catch (WarmStartCacheException&)
+        {
+            // do nothing - the next startup is just slower
+        }
+    }
+    if (m_database_connection)
+    {
+        // For tuning the capacities set in OnInit().
+        HandleCacheStatistics const& entry_cache_statistics =
+            database_connection().handle_cache<Entry>().statistics();
+        JEWEL_LOG_VALUE(Log::info, entry_cache_statistics.hits);
+        JEWEL_LOG_VALUE(Log::info, entry_cache_statistics.misses);
+        JEWEL_LOG_VALUE(Log::info, entry_cache_statistics.evictions);
+        HandleCacheStatistics const& journal_cache_statistics =
+            database_connection().handle_cache<PersistentJournal>().
+                statistics();
+        JEWEL_LOG_VALUE(Log::info, journal_cache_statistics.hits);
+        JEWEL_LOG_VALUE(Log::info, journal_cache_statistics.misses);
+        JEWEL_LOG_VALUE(Log::info, journal_cache_statistics.evictions);
+    }
     if (m_backup_filepath && m_exiting_cleanly)
     {
         filesystem::remove(*m_backup_filepath);
@@ -20,6 +20,8 @@
 #include "commodity.hpp"
 #include "dcm_database_connection.hpp"
 #include "dcm_exceptions.hpp"
+#include "ledger_snapshot.hpp"
+#include <boost/numeric/conversion/cast.hpp>
 #include <boost/optional.hpp>
 #include <jewel/assert.hpp>
 #include <jewel/checked_arithmetic.hpp>
@@ -35,6 +37,7 @@
 #include <unordered_map>
 #include <vector>
 
+using boost::numeric_cast;
 using boost::optional;
 using jewel::addition_is_unsafe;
 using jewel::Decimal;
@@ -67,7 +70,9 @@ BalanceCache::BalanceCache
 ):
     m_database_connection(p_database_connection),
     m_map(new Map),
-    m_map_is_stale(true)
+    m_map_is_stale(true),
+    m_opening_balance_map(new OpeningBalanceMap),
+    m_opening_balance_map_is_stale(true)
 {
     JEWEL_LOG_TRACE();
 }
@@ -111,48 +116,25 @@ BalanceCache::technical_balance(sqloxx::Id p_account_id)
 Decimal
 BalanceCache::technical_opening_balance(sqloxx::Id p_account_id)
 {
-    // We don't actually do any caching of opening balances, since
-    // they are quick to calculate. (We would expect only a small number
-    // of opening balance journals for any given Account.)
-    SQLStatement statement
-    (   m_database_connection,
-        "select sum(amount) from ordinary_journal_detail "
-        "join entries using(journal_id) where date = :date "
-        "and account_id = :account_id"
-    );
-    statement.bind
-    (   ":date",
-        julian_int(m_database_connection.opening_balance_journal_date())
-    );
-    statement.bind(":account_id", p_account_id);
-    Handle<Account> const account(m_database_connection, p_account_id);
-    Decimal::places_type const places = account->commodity()->precision();
-    Decimal ret(0, places);
-    if (statement.step())
-    {
-        try
-        {
-            ret = Decimal(statement.extract<Decimal::int_type>(0), places);
-        }
-        catch (ValueTypeException&)
-        {
-            // There are no entries to sum - leave ret as zero
-        }
-        statement.step_final();
-    }
-    else
+    if (m_opening_balance_map_is_stale)
     {
-        // There should be a result row even if there are no entries
-        // to sum
-        JEWEL_HARD_ASSERT (false);
+        refresh_opening_balances();
     }
-    return ret;
+    OpeningBalanceMap::const_iterator const it =
+        m_opening_balance_map->find(p_account_id);
+
+    // As for technical_balance(...), the addition of an Account will
+    // have marked the cache as stale, so there must be an entry for
+    // p_account_id by now.
+    JEWEL_ASSERT (it != m_opening_balance_map->end());
+    return it->second;
 }
 
 void
 BalanceCache::mark_as_stale()
 {
     m_map_is_stale = true;
+    m_opening_balance_map_is_stale = true;
 }
 
 void
@@ -169,6 +151,13 @@ BalanceCache::mark_as_stale(sqloxx::Id p_account_id)
     return;
 }
 
+void
+BalanceCache::mark_opening_balances_as_stale()
+{
+    m_opening_balance_map_is_stale = true;
+    return;
+}
+
 void
 BalanceCache::refresh()
 {
@@ -238,11 +227,29 @@ BalanceCache::refresh_all()
         working_map[accounts_scanner.extract<sqloxx::Id>(0)] = 0;
     }
     
-    // It has been established that this is faster than using SQL
-    // SUM and GROUP to sum Account totals.
-
-    // Bare scope
+    // Summing from the LedgerSnapshot spares us a scan of the database.
+    // However the snapshot adds the amounts in date order, which could in
+    // principle overflow part way through where adding them in the order
+    // in which they were posted would not (consider the integrity of
+    // PersistentJournal::would_cause_overflow()). In that case we fall
+    // back on scanning the database in entry_id order.
+    try
+    {
+        m_database_connection.ledger_snapshot().accumulate_totals
+        (   working_map,
+            false
+        );
+    }
+    catch (UnsafeArithmeticException&)
     {
+        for (auto& working_map_elem: working_map)
+        {
+            working_map_elem.second = 0;
+        }
+
+        // It has been established that this is faster than using SQL
+        // SUM and GROUP to sum Account totals.
+
         // Ordering by entry_id to decrease the likelihood of
         // "intermediate overflow". Also, consider the effect on the integrity
         // of PersistentJournal::would_cause_overflow().
@@ -372,4 +379,50 @@ BalanceCache::refresh_targetted(vector<sqloxx::Id> const& p_targets)
     return;
 }
 
+void
+BalanceCache::refresh_opening_balances()
+{
+    // We would expect only a small number of opening balance journals,
+    // so it is quicker to have SQLite sum them for all the Accounts at
+    // once than to go through the LedgerSnapshot. The precision is read
+    // in the same query, sparing us loading each Account and its
+    // Commodity.
+    SQLStatement statement
+    (   m_database_connection,
+        "select account_id, precision, total from accounts "
+        "join commodities using(commodity_id) left join "
+        "("
+            "select account_id, sum(amount) as total from entries "
+            "join ordinary_journal_detail using(journal_id) "
+            "where date = :date group by account_id"
+        ") using(account_id)"
+    );
+    statement.bind
+    (   ":date",
+        julian_int(m_database_connection.opening_balance_journal_date())
+    );
+    unique_ptr<OpeningBalanceMap> map_elect_ptr(new OpeningBalanceMap);
+    OpeningBalanceMap& map_elect = *map_elect_ptr;
+    while (statement.step())
+    {
+        Id const account_id = statement.extract<Id>(0);
+        auto const places =
+            numeric_cast<Decimal::places_type>(statement.extract<int>(1));
+        Decimal::int_type intval = 0;
+        try
+        {
+            intval = statement.extract<Decimal::int_type>(2);
+        }
+        catch (ValueTypeException&)
+        {
+            // There are no entries to sum - leave intval as zero
+        }
+        map_elect[account_id] = Decimal(intval, places);
+    }
+    using std::swap;
+    swap(m_opening_balance_map, map_elect_ptr);
+    m_opening_balance_map_is_stale = false;
+    return;
+}
+
 }  // namespace dcm
@@ -19,10 +19,10 @@
 #include "account_table_iterator.hpp"
 #include "account_type.hpp"
 #include "commodity.hpp"
-#include "entry_table_iterator.hpp"
 #include "dcm_database_connection.hpp"
 #include "gui/report.hpp"
 #include "gui/report_panel.hpp"
+#include "gui/report_totals.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <jewel/assert.hpp>
@@ -30,10 +30,12 @@
 #include <jewel/log.hpp>
 #include <jewel/optional.hpp>
 #include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/gdicmn.h>
 #include <wx/string.h>
 #include <wx/window.h>
 #include <list>
+#include <unordered_map>
 #include <vector>
 
 using boost::optional;
@@ -41,6 +43,7 @@ using jewel::Decimal;
 using jewel::value;
 using sqloxx::Handle;
 using std::list;
+using std::unordered_map;
 using std::vector;
 
 namespace gregorian = boost::gregorian;
@@ -72,35 +75,64 @@ BalanceSheetReport::~BalanceSheetReport()
 {
 }
 
+vector<ReportQuery>
+BalanceSheetReport::do_get_totals_queries()
+{
+    vector<ReportQuery> ret;
+    if (!covers_all_dates())
+    {
+        // Totals up to the day before the start of the period give the
+        // opening balances; totals up to the end of the period give the
+        // closing balances.
+        ReportQuery opening_query;
+        opening_query.maybe_max_date =
+            min_date() - gregorian::date_duration(1);
+        ReportQuery closing_query;
+        closing_query.maybe_max_date = maybe_max_date();
+        ret.push_back(opening_query);
+        ret.push_back(closing_query);
+    }
+    return ret;
+}
+
 void
-BalanceSheetReport::do_generate()
+BalanceSheetReport::do_generate
+(   vector<ReportTotals> const& p_totals
+)
 {
-    refresh_map();
+    refresh_map(p_totals);
     display_body();
 
-    // Don't do "FitInside()", "configure_scrollbars" or that "admin" stuff,
-    // as this is done in the Report base class, in Report::generate().
+    // Don't do "lay_out_cells()" or that "admin" stuff, as this is done
+    // in the Report base class, in Report::generate().
     return;
 }
 
+bool
+BalanceSheetReport::covers_all_dates()
+{
+    gregorian::date const earliest_possible_date =
+        database_connection().opening_balance_journal_date() +
+            gregorian::date_duration(1);
+    JEWEL_ASSERT (min_date() >= earliest_possible_date);
+    return (min_date() == earliest_possible_date) && !maybe_max_date();
+}
+
 void
-BalanceSheetReport::refresh_map()
+BalanceSheetReport::refresh_map
+(   vector<ReportTotals> const& p_totals
+)
 {
     // TODO MEDIUM PRIORITY Can we just ignore equity Accounts here?
     m_balance_map.clear();
     JEWEL_ASSERT (m_balance_map.empty());
-    optional<gregorian::date> const maybe_max_d = maybe_max_date();
-    gregorian::date const min_d = min_date();
 
     // Special case: use the opening balance and current
     // balance of each Account, to optimize for the special but probably common
     // case where the min and max date are both blank.
-    gregorian::date const earliest_possible_date =
-        database_connection().opening_balance_journal_date() +
-            gregorian::date_duration(1);
-    JEWEL_ASSERT (min_d >= earliest_possible_date);
-    if ((min_d == earliest_possible_date) && (!maybe_max_d))
+    if (p_totals.empty())
     {
+        JEWEL_ASSERT (covers_all_dates());
         AccountTableIterator atit(database_connection());
         AccountTableIterator const atend;
         for ( ; atit != atend; ++atit)
@@ -121,39 +153,27 @@ BalanceSheetReport::refresh_map()
     }
 
     // General case
-    EntryTableIterator it =
-        make_date_ordered_actual_ordinary_entry_table_iterator
-        (   database_connection()
-        );
-    EntryTableIterator const end;    
-    for ( ; it != end; ++it)
+    JEWEL_ASSERT (p_totals.size() == 2);
+    ReportTotals const& opening_totals = p_totals[0];
+    ReportTotals const& closing_totals = p_totals[1];
+    for (auto const& elem: closing_totals)
     {
-        Handle<Account> const account = (*it)->account();
+        Handle<Account> const account(database_connection(), elem.first);
         AccountSuperType const s_type = account->account_super_type();
         if (s_type != AccountSuperType::balance_sheet)
         {
             continue;
         }
-        sqloxx::Id const account_id = account->id();
-        BalanceMap::iterator jt = m_balance_map.find(account_id);
-        if (jt == m_balance_map.end())
-        {
-            BalanceDatum const balance_datum(account);
-            m_balance_map[account_id] = balance_datum;
-            jt = m_balance_map.find(account_id);
-        }
-        JEWEL_ASSERT (jt != m_balance_map.end());
-        gregorian::date const date = (*it)->date();
-        if (maybe_max_d && (date > value(maybe_max_d)))
-        {
-            break;
-        }
-        Decimal const amount = (*it)->amount();
-        jt->second.closing_balance += amount;
-        if (date < min_d)
+        Decimal::places_type const places =
+            account->commodity()->precision();
+        BalanceDatum datum(account);
+        ReportTotals::const_iterator const jt = opening_totals.find(elem.first);
+        if (jt != opening_totals.end())
         {
-            jt->second.opening_balance += amount;
+            datum.opening_balance = Decimal(jt->second, places);
         }
+        datum.closing_balance = Decimal(elem.second, places);
+        m_balance_map[elem.first] = datum;
     }
     return;
 }
@@ -85,11 +85,7 @@ BSAccountEntryListCtrl::do_set_non_date_columns
     SetItem
     (   p_row,
         amount_col_num(),
-        finformat_wx
-        (   p_entry->amount(),
-            locale(),
-            DecimalFormatFlags().clear(string_flags::dash_for_zero)
-        )
+        amount_formatter().format(p_entry->amount())
     );
     JEWEL_ASSERT (num_columns() == 3);
     return;
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gui/change_set.hpp"
+#include <jewel/assert.hpp>
+#include <sqloxx/id.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <unordered_set>
+#include <vector>
+
+using sqloxx::Id;
+using std::remove;
+using std::size_t;
+using std::unordered_set;
+using std::vector;
+
+namespace dcm
+{
+namespace gui
+{
+
+size_t const ChangeSet::s_num_kinds;
+
+ChangeSet::ChangeSet():
+    m_ids(s_num_kinds),
+    m_id_sets(s_num_kinds)
+{
+}
+
+void
+ChangeSet::record(ChangeKind p_kind, Id p_id)
+{
+    JEWEL_ASSERT (p_kind != ChangeKind::num_change_kinds);
+    switch (p_kind)
+    {
+    case ChangeKind::journal_edited:
+        if (contains(ChangeKind::journal_created, p_id))
+        {
+            return;
+        }
+        break;
+    case ChangeKind::draft_journal_deleted:
+    case ChangeKind::ordinary_journal_deleted:
+        erase(ChangeKind::journal_created, p_id);
+        erase(ChangeKind::journal_edited, p_id);
+        break;
+    case ChangeKind::ordinary_entry_deleted:
+        erase(ChangeKind::reconciliation_status, p_id);
+        break;
+    default:
+        break;
+    }
+    size_t const index = static_cast<size_t>(p_kind);
+    if (m_id_sets[index].insert(p_id).second)
+    {
+        m_ids[index].push_back(p_id);
+    }
+    return;
+}
+
+vector<Id> const&
+ChangeSet::ids(ChangeKind p_kind) const
+{
+    JEWEL_ASSERT (p_kind != ChangeKind::num_change_kinds);
+    return m_ids[static_cast<size_t>(p_kind)];
+}
+
+bool
+ChangeSet::contains(ChangeKind p_kind, Id p_id) const
+{
+    JEWEL_ASSERT (p_kind != ChangeKind::num_change_kinds);
+    unordered_set<Id> const& id_set = m_id_sets[static_cast<size_t>(p_kind)];
+    return id_set.find(p_id) != id_set.end();
+}
+
+bool
+ChangeSet::is_empty() const
+{
+    for (unordered_set<Id> const& id_set: m_id_sets)
+    {
+        if (!id_set.empty()) return false;
+    }
+    return true;
+}
+
+void
+ChangeSet::clear()
+{
+    m_ids.assign(s_num_kinds, vector<Id>());
+    m_id_sets.assign(s_num_kinds, unordered_set<Id>());
+    return;
+}
+
+void
+ChangeSet::erase(ChangeKind p_kind, Id p_id)
+{
+    size_t const index = static_cast<size_t>(p_kind);
+    if (m_id_sets[index].erase(p_id) != 0)
+    {
+        vector<Id>& ids = m_ids[index];
+        ids.erase(remove(ids.begin(), ids.end(), p_id), ids.end());
+    }
+    return;
+}
+
+}  // namespace gui
+}  // namespace dcm
@@ -74,6 +74,16 @@ DateCtrl::date()
     return validator->date();
 }
 
+void
+DateCtrl::set_date(optional<gregorian::date> const& p_date)
+{
+    SetValue(p_date? date_format_wx(value(p_date)): wxString());
+    auto* const validator = GetValidator();
+    JEWEL_ASSERT (validator);
+    validator->Validate(static_cast<wxWindow*>(this));
+    return;
+}
+
 void
 DateCtrl::on_kill_focus(wxFocusEvent& event)
 {
@@ -27,12 +27,15 @@
 #include <wx/datetime.h>
 #include <wx/intl.h>
 #include <wx/string.h>
+#include <wx/wxcrt.h>
 #include <algorithm>
 #include <exception>
 #include <iterator>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 using boost::algorithm::split;
@@ -45,10 +48,13 @@ using std::begin;
 using std::end;
 using std::find;
 using std::find_first_of;
+using std::make_pair;
 using std::map;
 using std::out_of_range;
+using std::pair;
 using std::string;
 using std::transform;
+using std::unordered_map;
 using std::unordered_set;
 using std::vector;
 
@@ -370,57 +376,355 @@ namespace
         }
     }
 
+    bool is_leap_year(int p_year)
+    {
+        return
+        (   ((p_year % 4 == 0) && (p_year % 100 != 0)) ||
+            (p_year % 400 == 0)
+        );
+    }
+
+    int days_in_month(int p_year, int p_month)
+    {
+        static int const days[] =
+            { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        JEWEL_ASSERT ((p_month >= 1) && (p_month <= 12));
+        if ((p_month == 2) && is_leap_year(p_year)) return 29;
+        return days[p_month - 1];
+    }
+
+    // The earliest and latest years that boost::gregorian::date can
+    // represent.
+    int const min_year = 1400;
+    int const max_year = 9999;
+
+    // Converts between a year, month and day, and the Julian Day number
+    // that julian_int(...) would return for the same date, by the usual
+    // arithmetic for the proleptic Gregorian calendar, without
+    // constructing a boost::gregorian::date.
+    DateRep date_rep_from_ymd(int p_year, int p_month, int p_day)
+    {
+        int const a = (14 - p_month) / 12;
+        int const y = p_year + 4800 - a;
+        int const m = p_month + 12 * a - 3;
+        return
+            p_day + (153 * m + 2) / 5 + 365 * y + y / 4 - y / 100 + y / 400 -
+            32045;
+    }
+
+    void ymd_from_date_rep
+    (   DateRep p_date_rep,
+        int& p_year,
+        int& p_month,
+        int& p_day
+    )
+    {
+        int const a = p_date_rep + 32044;
+        int const b = (4 * a + 3) / 146097;
+        int const c = a - (146097 * b) / 4;
+        int const d = (4 * c + 3) / 1461;
+        int const e = c - (1461 * d) / 4;
+        int const m = (5 * e + 2) / 153;
+        p_day = e - (153 * m + 2) / 5 + 1;
+        p_month = m + 3 - 12 * (m / 10);
+        p_year = 100 * b + d - 4800 + (m / 10);
+        return;
+    }
+
+    // Reads up to p_max_digits decimal digits, as does wxDateTime::ParseFormat
+    // for a numeric field. Returns false if there are none.
+    bool read_number
+    (   wxString::const_iterator& p_it,
+        wxString::const_iterator const& p_end,
+        int p_max_digits,
+        int& p_number
+    )
+    {
+        int number = 0;
+        int num_digits = 0;
+        for ( ; (p_it != p_end) && (num_digits != p_max_digits); ++p_it)
+        {
+            wxUniChar const c = *p_it;
+            if ((c < '0') || (c > '9')) break;
+            number = number * 10 + static_cast<int>(c.GetValue() - '0');
+            ++num_digits;
+        }
+        if (num_digits == 0) return false;
+        p_number = number;
+        return true;
+    }
+
+    // Appends p_number, zero-padded to at least p_min_digits digits.
+    void append_number(wxString& p_string, int p_number, int p_min_digits)
+    {
+        JEWEL_ASSERT (p_number >= 0);
+        wxChar buf[16];
+        wxChar* const end = buf + (sizeof(buf) / sizeof(buf[0]));
+        wxChar* begin = end;
+        int num_digits = 0;
+        do
+        {
+            JEWEL_ASSERT (begin != buf);
+            *--begin = static_cast<wxChar>(wxT('0') + (p_number % 10));
+            p_number /= 10;
+            ++num_digits;
+        }
+        while ((p_number != 0) || (num_digits < p_min_digits));
+        p_string.append(begin, end - begin);
+        return;
+    }
+
 }  // end anonymous namespace
 
 
+CompiledDateFormat::CompiledDateFormat(wxString const& p_format)
+{
+    int num_days = 0;
+    int num_months = 0;
+    int num_years = 0;
+    wxString::const_iterator it = p_format.begin();
+    wxString::const_iterator const end = p_format.end();
+    for ( ; it != end; ++it)
+    {
+        Step step;
+        step.character = *it;
+        if (step.character != '%')
+        {
+            step.type =
+            (   wxIsspace(step.character)?
+                StepType::space:
+                StepType::literal
+            );
+            m_steps.push_back(step);
+            continue;
+        }
+        ++it;
+        if (it == end)
+        {
+            m_steps.clear();
+            return;
+        }
+        switch (wxUniChar(*it).GetValue())
+        {
+        case '%':
+            step.type = StepType::literal;
+            break;
+        case 'd':
+            step.type = StepType::day;
+            ++num_days;
+            break;
+        case 'm':
+            step.type = StepType::month;
+            ++num_months;
+            break;
+        case 'y':
+            step.type = StepType::short_year;
+            ++num_years;
+            break;
+        case 'Y':
+            step.type = StepType::year;
+            ++num_years;
+            break;
+        default:
+            // Including modifiers, which we leave to wxDateTime.
+            m_steps.clear();
+            return;
+        }
+        m_steps.push_back(step);
+    }
+    if ((num_days != 1) || (num_months != 1) || (num_years != 1))
+    {
+        m_steps.clear();
+    }
+}
+
+bool
+CompiledDateFormat::is_valid() const
+{
+    return !m_steps.empty();
+}
+
+bool
+CompiledDateFormat::parse(wxString const& p_string, DateRep& p_date_rep) const
+{
+    JEWEL_ASSERT (is_valid());
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    wxString::const_iterator it = p_string.begin();
+    wxString::const_iterator const end = p_string.end();
+    for (Step const& step: m_steps)
+    {
+        switch (step.type)
+        {
+        case StepType::literal:
+            if ((it == end) || (*it != step.character)) return false;
+            ++it;
+            break;
+        case StepType::space:
+            while ((it != end) && wxIsspace(*it)) ++it;
+            break;
+        case StepType::day:
+            if (!read_number(it, end, 2, day) || (day < 1) || (day > 31))
+            {
+                return false;
+            }
+            break;
+        case StepType::month:
+            if (!read_number(it, end, 2, month) || (month < 1) || (month > 12))
+            {
+                return false;
+            }
+            break;
+        case StepType::short_year:
+            // As does wxDateTime::ParseFormat.
+            if (!read_number(it, end, 2, year)) return false;
+            year += ((year > 30)? 1900: 2000);
+            break;
+        case StepType::year:
+            if (!read_number(it, end, 4, year)) return false;
+            if (year < 100) year += 2000;
+            break;
+        default:
+            JEWEL_HARD_ASSERT (false);
+        }
+    }
+    if
+    (   (it != end) ||
+        (year < min_year) ||
+        (year > max_year) ||
+        (day > days_in_month(year, month))
+    )
+    {
+        return false;
+    }
+    p_date_rep = date_rep_from_ymd(year, month, day);
+    JEWEL_ASSERT
+    (   p_date_rep == julian_int(gregorian::date(year, month, day))
+    );
+    return true;
+}
+
+wxString
+CompiledDateFormat::format(DateRep p_date_rep) const
+{
+    JEWEL_ASSERT (is_valid());
+    JEWEL_ASSERT (is_valid_date(p_date_rep));
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    ymd_from_date_rep(p_date_rep, year, month, day);
+    wxString ret;
+    for (Step const& step: m_steps)
+    {
+        switch (step.type)
+        {
+        case StepType::literal:  // fall through
+        case StepType::space:
+            ret += step.character;
+            break;
+        case StepType::day:
+            append_number(ret, day, 2);
+            break;
+        case StepType::month:
+            append_number(ret, month, 2);
+            break;
+        case StepType::short_year:
+            append_number(ret, year % 100, 2);
+            break;
+        case StepType::year:
+            append_number(ret, year, 4);
+            break;
+        default:
+            JEWEL_HARD_ASSERT (false);
+        }
+    }
+    return ret;
+}
+
+
 DateParser::DateParser
 (   wxString const& p_primary_format,
     wxString const& p_secondary_format
 ):
     m_primary_format(p_primary_format),
-    m_secondary_format(p_secondary_format)
+    m_secondary_format(p_secondary_format),
+    m_compiled_primary_format(p_primary_format),
+    m_compiled_secondary_format(p_secondary_format)
 {
 }
 
 optional<gregorian::date>
 DateParser::parse(wxString const& p_string, bool p_be_tolerant) const
 {
-    optional<gregorian::date> ret;
-    wxString::const_iterator parsed_to_position;
-    wxDateTime date_wx;
-    
-    wxString const* const formats[] =
-    {   &m_primary_format,
-        &m_secondary_format
-    };
-    for (wxString const* const format: formats)
+    optional<DateRep> const maybe_date_rep = parse_date_rep(p_string);
+    if (maybe_date_rep)
     {
-        date_wx.ParseFormat
-        (   p_string,
-            *(format),
-            &parsed_to_position
+        return optional<gregorian::date>
+        (   boost_date_from_julian_int(*maybe_date_rep)
         );
-        if (parsed_to_position == p_string.end())
-        {
-            // Parsing was successful
-            int year = date_wx.GetYear();
-            if (year < 100) year += 2000;
-            int const month = static_cast<int>(date_wx.GetMonth()) + 1;
-            int const day = date_wx.GetDay();
-            try
-            {
-                ret = gregorian::date(year, month, day);
-                return ret;
-            }
-            catch (boost::exception&)
-            {
-            }
-        }
     }
     if (p_be_tolerant)
     {   
         return tolerant_parse(p_string);
     }
+    return optional<gregorian::date>();
+}
+
+optional<DateRep>
+DateParser::parse_date_rep(wxString const& p_string) const
+{
+    typedef pair<wxString const*, CompiledDateFormat const*> FormatPair;
+    FormatPair const formats[] =
+    {   FormatPair(&m_primary_format, &m_compiled_primary_format),
+        FormatPair(&m_secondary_format, &m_compiled_secondary_format)
+    };
+    for (FormatPair const& format: formats)
+    {
+        optional<DateRep> ret;
+        CompiledDateFormat const& compiled_format = *(format.second);
+        if (compiled_format.is_valid())
+        {
+            DateRep date_rep = null_date_rep();
+            if (compiled_format.parse(p_string, date_rep)) ret = date_rep;
+        }
+        else
+        {
+            ret = wx_parse(p_string, *(format.first));
+        }
+        if (ret)
+        {
+            return ret;
+        }
+    }
+    return optional<DateRep>();
+}
+
+optional<DateRep>
+DateParser::wx_parse
+(   wxString const& p_string,
+    wxString const& p_format
+) const
+{
+    optional<DateRep> ret;
+    wxString::const_iterator parsed_to_position;
+    wxDateTime date_wx;
+    date_wx.ParseFormat(p_string, p_format, &parsed_to_position);
+    if (parsed_to_position == p_string.end())
+    {
+        // Parsing was successful
+        int year = date_wx.GetYear();
+        if (year < 100) year += 2000;
+        int const month = static_cast<int>(date_wx.GetMonth()) + 1;
+        int const day = date_wx.GetDay();
+        try
+        {
+            ret = julian_int(gregorian::date(year, month, day));
+        }
+        catch (boost::exception&)
+        {
+        }
+    }
     return ret;
 }
 
@@ -433,4 +737,37 @@ DateParser::tolerant_parse(wxString const& p_string) const
     return (ret? ret: tolerant_parse_aux(p_string, m_secondary_format));
 }
 
+DateFormatter::DateFormatter(wxString const& p_format):
+    m_format(p_format),
+    m_compiled_format(p_format)
+{
+}
+
+wxString const&
+DateFormatter::format(DateRep p_date_rep) const
+{
+    unordered_map<DateRep, wxString>::const_iterator const it =
+        m_cache.find(p_date_rep);
+    if (it != m_cache.end())
+    {
+        return it->second;
+    }
+    wxString formatted;
+    if (m_compiled_format.is_valid())
+    {
+        formatted = m_compiled_format.format(p_date_rep);
+    }
+    else
+    {
+        gregorian::date const date = boost_date_from_julian_int(p_date_rep);
+        wxDateTime const date_wx
+        (   date.day(),
+            static_cast<wxDateTime::Month>(date.month() - 1),
+            date.year()
+        );
+        formatted = date_wx.Format(m_format);
+    }
+    return m_cache.insert(make_pair(p_date_rep, formatted)).first->second;
+}
+
 }  // namespace dcm
@@ -17,6 +17,7 @@
 #include "dcm_database_connection.hpp"
 #include "account.hpp"
 #include "account.hpp"
+#include "account_name_index.hpp"
 #include "account_table_iterator.hpp"
 #include "amalgamated_budget.hpp"
 #include "app.hpp"
@@ -26,6 +27,10 @@
 #include "date.hpp"
 #include "draft_journal.hpp"
 #include "entry.hpp"
+#include "entry_fingerprint_index.hpp"
+#include "entry_search.hpp"
+#include "handle_cache.hpp"
+#include "ledger_snapshot.hpp"
 #include "ordinary_journal.hpp"
 #include "ordinary_journal_table_iterator.hpp"
 #include "repeater.hpp"
@@ -109,17 +114,25 @@ DcmDatabaseConnection::DcmDatabaseConnection():
     DatabaseConnection(),
     m_permanent_entity_data(nullptr),
     m_balance_cache(nullptr),
+    m_entry_fingerprint_index(nullptr),
+    m_account_name_index(nullptr),
+    m_ledger_snapshot(nullptr),
     m_budget(nullptr),
     m_account_map(nullptr),
     m_budget_item_map(nullptr),
     m_commodity_map(nullptr),
     m_entry_map(nullptr),
     m_journal_map(nullptr),
-    m_repeater_map(nullptr)
+    m_repeater_map(nullptr),
+    m_entry_cache(nullptr),
+    m_journal_cache(nullptr)
 {
     JEWEL_LOG_TRACE();
     m_permanent_entity_data = new PermanentEntityData;
     m_balance_cache = new BalanceCache(*this);
+    m_entry_fingerprint_index = new EntryFingerprintIndex(*this);
+    m_account_name_index = new AccountNameIndex(*this);
+    m_ledger_snapshot = new LedgerSnapshot(*this);
     m_budget = new AmalgamatedBudget(*this);
     m_account_map = new IdentityMap<Account>(*this);
     m_budget_item_map = new IdentityMap<BudgetItem>(*this);
@@ -127,6 +140,8 @@ DcmDatabaseConnection::DcmDatabaseConnection():
     m_entry_map = new IdentityMap<Entry>(*this);
     m_journal_map = new IdentityMap<PersistentJournal>(*this);
     m_repeater_map = new IdentityMap<Repeater>(*this);
+    m_entry_cache = new HandleCache<Entry>(*this);
+    m_journal_cache = new HandleCache<PersistentJournal>(*this);
     JEWEL_LOG_TRACE();
 }
 
@@ -150,9 +165,27 @@ DcmDatabaseConnection::~DcmDatabaseConnection()
     // documentation to SQLoxx advising of the importance of the
     // order of deletion of the IdentityMaps.
 
+    // These hold Handles into the IdentityMaps, so must be deleted before
+    // any of them. Journals hold Handles to their Entries, so
+    // m_journal_cache goes first.
+    delete m_journal_cache;
+    m_journal_cache = nullptr;
+
+    delete m_entry_cache;
+    m_entry_cache = nullptr;
+
     delete m_balance_cache;
     m_balance_cache = nullptr;
 
+    delete m_entry_fingerprint_index;
+    m_entry_fingerprint_index = nullptr;
+
+    delete m_account_name_index;
+    m_account_name_index = nullptr;
+
+    delete m_ledger_snapshot;
+    m_ledger_snapshot = nullptr;
+
     delete m_budget;
     m_budget = nullptr;
 
@@ -223,6 +256,12 @@ void
 DcmDatabaseConnection::do_setup()
 {
     JEWEL_LOG_TRACE();
+
+    // In WAL mode, ReadOnlyConnections on other threads can read the
+    // file while we write to it, without either blocking the other.
+    // This setting is persistent, but is cheap to reassert.
+    execute_sql("pragma journal_mode = wal;");
+
     if (!tables_are_configured())
     {
         JEWEL_ASSERT (m_permanent_entity_data);
@@ -263,6 +302,16 @@ DcmDatabaseConnection::do_setup()
     load_entity_creation_date();
     load_default_commodity();
     perform_integrity_checks();
+
+    // This is done whether or not the tables were already configured, so
+    // that files created before there was a search index acquire one.
+    setup_entry_search(*this);
+
+    // Move anything left in the write-ahead log (for example by a
+    // session that ended abruptly) into the main file, so that a copy of
+    // the main file alone (see make_backup()) is complete.
+    execute_sql("pragma wal_checkpoint(full);");
+
     JEWEL_LOG_TRACE();
     return;
 }
@@ -373,6 +422,13 @@ DcmDatabaseConnection::set_entity_creation_date
         m_permanent_entity_data->set_creation_date(old_date);
         throw;
     }
+
+    // Which OrdinaryJournals make up the opening balances depends on the
+    // entity creation date (see opening_balance_journal_date()).
+    if (m_balance_cache)
+    {
+        m_balance_cache->mark_opening_balances_as_stale();
+    }
     return;
 }
 
@@ -382,6 +438,12 @@ DcmDatabaseConnection::budget_instrument() const
     return m_budget->instrument();
 }
 
+LedgerSnapshot&
+DcmDatabaseConnection::ledger_snapshot() const
+{
+    return *m_ledger_snapshot;
+}
+
 void
 DcmDatabaseConnection::mark_tables_as_configured()
 {
@@ -515,6 +577,15 @@ BalanceCacheAttorney::mark_as_stale
     return;
 }
 
+void
+BalanceCacheAttorney::mark_opening_balances_as_stale
+(   DcmDatabaseConnection const& p_database_connection
+)
+{
+    p_database_connection.m_balance_cache->mark_opening_balances_as_stale();
+    return;
+}
+
 Decimal
 BalanceCacheAttorney::technical_balance
 (   DcmDatabaseConnection const& p_database_connection,
@@ -538,6 +609,108 @@ BalanceCacheAttorney::technical_opening_balance
 }
 
 
+// EntryFingerprintAttorney
+
+typedef
+    DcmDatabaseConnection::EntryFingerprintAttorney
+    EntryFingerprintAttorney;
+
+void
+EntryFingerprintAttorney::mark_as_stale
+(   DcmDatabaseConnection const& p_database_connection
+)
+{
+    p_database_connection.m_entry_fingerprint_index->mark_as_stale();
+    return;
+}
+
+void
+EntryFingerprintAttorney::mark_journal_as_stale
+(   DcmDatabaseConnection const& p_database_connection,
+    sqloxx::Id p_journal_id
+)
+{
+    p_database_connection.m_entry_fingerprint_index->mark_journal_as_stale
+    (   p_journal_id
+    );
+    return;
+}
+
+void
+EntryFingerprintAttorney::mark_entry_as_stale
+(   DcmDatabaseConnection const& p_database_connection,
+    sqloxx::Id p_entry_id
+)
+{
+    p_database_connection.m_entry_fingerprint_index->mark_entry_as_stale
+    (   p_entry_id
+    );
+    return;
+}
+
+void
+EntryFingerprintAttorney::add_entry
+(   DcmDatabaseConnection const& p_database_connection,
+    sqloxx::Id p_entry_id,
+    EntryFingerprint const& p_fingerprint
+)
+{
+    p_database_connection.m_entry_fingerprint_index->add_entry
+    (   p_entry_id,
+        p_fingerprint
+    );
+    return;
+}
+
+std::size_t
+EntryFingerprintAttorney::count
+(   DcmDatabaseConnection const& p_database_connection,
+    EntryFingerprint const& p_fingerprint
+)
+{
+    return p_database_connection.m_entry_fingerprint_index->count
+    (   p_fingerprint
+    );
+}
+
+
+// AccountNameAttorney
+
+typedef
+    DcmDatabaseConnection::AccountNameAttorney
+    AccountNameAttorney;
+
+void
+AccountNameAttorney::mark_as_stale
+(   DcmDatabaseConnection const& p_database_connection
+)
+{
+    p_database_connection.m_account_name_index->mark_as_stale();
+    return;
+}
+
+void
+AccountNameAttorney::mark_account_as_stale
+(   DcmDatabaseConnection const& p_database_connection,
+    sqloxx::Id p_account_id
+)
+{
+    p_database_connection.m_account_name_index->mark_account_as_stale
+    (   p_account_id
+    );
+    return;
+}
+
+optional<sqloxx::Id>
+AccountNameAttorney::find
+(   DcmDatabaseConnection const& p_database_connection,
+    wxString const& p_name
+)
+{
+    return p_database_connection.m_account_name_index->find(p_name);
+}
+
+
 // BudgetAttorney
 
 typedef
@@ -661,6 +834,23 @@ DcmDatabaseConnection::identity_map<Repeater>()
 }
 
 
+// Getters for HandleCaches
+
+template <>
+HandleCache<Entry>&
+DcmDatabaseConnection::handle_cache<Entry>()
+{
+    return *m_entry_cache;
+}
+
+template <>
+HandleCache<PersistentJournal>&
+DcmDatabaseConnection::handle_cache<PersistentJournal>()
+{
+    return *m_journal_cache;
+}
+
+
 void
 DcmDatabaseConnection::perform_integrity_checks()
 {
@@ -25,9 +25,11 @@
 #include <jewel/exception.hpp>
 #include <wx/msgdlg.h>
 #include <wx/valtext.h>
+#include <cstddef>
 
 using jewel::Decimal;
 using jewel::round;
+using std::size_t;
 
 namespace dcm
 {
@@ -41,7 +43,8 @@ DecimalValidator::DecimalValidator
 ):
     m_print_dash_for_zero(p_print_dash_for_zero),
     m_precision(p_precision),
-    m_decimal(p_decimal)
+    m_decimal(p_decimal),
+    m_parser(locale())
 {
 }
 
@@ -68,46 +71,41 @@ DecimalValidator::Validate(wxWindow* WXUNUSED(parent))
     {
         return false;
     }
+    wxString const text(text_ctrl->GetValue());
     try
     {
-        m_decimal = round
-        (   wx_to_decimal(wxString(text_ctrl->GetValue()), locale()),
-            m_precision
+        // This is called on every keystroke in some controls, so avoid
+        // exceptions in the usual case of text that is not a number.
+        Decimal decimal;
+        size_t error_position = 0;
+        if
+        (   m_parser.parse(text, decimal, error_position) ||
+            m_parser.parse_simple_sum(text, decimal, error_position)
+        )
+        {
+            m_decimal = round(decimal, m_precision);
+            return true;
+        }
+        wxMessageBox
+        (   wxString("Could not interpret \"") + text + "\" as a number."
         );
-        return true;
+        return false;
+    }
+    catch (jewel::DecimalException&)
+    {
+        wxMessageBox
+        (   wxString("Could not safely read \"") +
+            text +
+            "\" as a number. Number may be too large or contain " +
+            "unexpected characters."
+        );
+        return false;
     }
     catch (jewel::Exception&)
     {
-        wxString const text(text_ctrl->GetValue());
-        try
-        {
-            m_decimal = round(wx_to_simple_sum(text, locale()), m_precision);
-            return true;
-        }
-        catch (jewel::DecimalFromStringException&)
-        {
-            wxMessageBox
-            (   wxString("Could not interpret \"") + text + "\" as a number."
-            );
-            return false;
-        }
-        catch (jewel::DecimalException&)
-        {
-            wxMessageBox
-            (   wxString("Could not safely read \"") +
-                text +
-                "\" as a number. Number may be too large or contain " +
-                "unexpected characters."
-            );
-            return false;
-        }
-        catch (jewel::Exception&)
-        {
-            wxMessageBox("There was an error reading the number you entered.");
-            return false;
-        }
+        wxMessageBox("There was an error reading the number you entered.");
+        return false;
     }
-    JEWEL_HARD_ASSERT (false);
 }
 
 bool
@@ -21,34 +21,41 @@
 #include "commodity.hpp"
 #include "ordinary_journal.hpp"
 #include "dcm_database_connection.hpp"
+#include "handle_cache.hpp"
+#include "ledger_snapshot.hpp"
 #include "string_conv.hpp"
 #include "transaction_side.hpp"
 #include "transaction_type.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/numeric/conversion/cast.hpp>
 #include <sqloxx/database_connection.hpp>
+#include <sqloxx/database_transaction.hpp>
 #include <sqloxx/handle.hpp>
 #include <sqloxx/id.hpp>
 #include <sqloxx/sql_statement.hpp>
+#include <sqloxx/sqloxx_exceptions.hpp>
 #include <boost/optional.hpp>
 #include <jewel/log.hpp>
 #include <jewel/decimal.hpp>
 #include <jewel/optional.hpp>
 #include <wx/string.h>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <utility>
+#include <vector>
 
+using boost::numeric_cast;
 using boost::optional;
 using jewel::clear;
 using jewel::Decimal;
 using jewel::value;
+using sqloxx::DatabaseTransaction;
 using sqloxx::Handle;
 using sqloxx::Id;
 using sqloxx::SQLStatement;
-using std::ostringstream;
+using sqloxx::ValueTypeException;
 using std::string;
-using std::unique_ptr;
+using std::vector;
 
 namespace gregorian = boost::gregorian;
 
@@ -58,14 +65,49 @@ namespace dcm
 
 struct Entry::EntryData
 {
+    EntryData();
+    void clear_dirty_flags();
+
     optional<Id> journal_id;
+
+    // The date of the OrdinaryJournal, if any, to which the Entry belongs,
+    // held here so that date() need not load the journal.
+    optional<DateRep> journal_date;
+
     optional<Handle<Account> > account;
     optional<wxString> comment;
     optional<jewel::Decimal> amount;
     optional<bool> is_reconciled;
     optional<TransactionSide> transaction_side;
+
+    // Record which of the above have been set to a different value since
+    // the Entry was last loaded or saved, so that saving an existing Entry
+    // need only touch the database (and the caches) as far as required.
+    bool journal_id_is_dirty;
+    bool account_is_dirty;
+    bool comment_is_dirty;
+    bool amount_is_dirty;
+    bool is_reconciled_is_dirty;
+    bool transaction_side_is_dirty;
 };
 
+Entry::EntryData::EntryData()
+{
+    clear_dirty_flags();
+}
+
+void
+Entry::EntryData::clear_dirty_flags()
+{
+    journal_id_is_dirty = false;
+    account_is_dirty = false;
+    comment_is_dirty = false;
+    amount_is_dirty = false;
+    is_reconciled_is_dirty = false;
+    transaction_side_is_dirty = false;
+    return;
+}
+
 
 
 
@@ -136,15 +178,32 @@ void
 Entry::set_journal_id(Id p_journal_id)
 {
     load();
+    if (m_data->journal_id != optional<Id>(p_journal_id))
+    {
+        clear(m_data->journal_date);
+        m_data->journal_id_is_dirty = true;
+    }
     m_data->journal_id = p_journal_id;
     return;
 }
 
+void
+Entry::set_journal_date(gregorian::date const& p_date)
+{
+    load();
+    m_data->journal_date = julian_int(p_date);
+    return;
+}
+
 
 void
 Entry::set_account(Handle<Account> const& p_account)
 {
     load();
+    if (m_data->account != optional<Handle<Account> >(p_account))
+    {
+        m_data->account_is_dirty = true;
+    }
     m_data->account = p_account;
     return;
 }
@@ -154,6 +213,10 @@ void
 Entry::set_comment(wxString const& p_comment)
 {
     load();
+    if (m_data->comment != optional<wxString>(p_comment))
+    {
+        m_data->comment_is_dirty = true;
+    }
     m_data->comment = p_comment;
     return;
 }
@@ -163,6 +226,16 @@ void
 Entry::set_amount(Decimal const& p_amount)
 {
     load();
+
+    // The number of places counts as well, as it is not stored.
+    if
+    (   !m_data->amount ||
+        (m_data->amount->intval() != p_amount.intval()) ||
+        (m_data->amount->places() != p_amount.places())
+    )
+    {
+        m_data->amount_is_dirty = true;
+    }
     m_data->amount = p_amount;
     return;
 }
@@ -171,6 +244,10 @@ void
 Entry::set_whether_reconciled(bool p_is_reconciled)
 {
     load();
+    if (m_data->is_reconciled != optional<bool>(p_is_reconciled))
+    {
+        m_data->is_reconciled_is_dirty = true;
+    }
     m_data->is_reconciled = p_is_reconciled;
     return;
 }
@@ -181,6 +258,13 @@ Entry::set_transaction_side
 )
 {
     load();
+    if
+    (   m_data->transaction_side !=
+        optional<TransactionSide>(p_transaction_side)
+    )
+    {
+        m_data->transaction_side_is_dirty = true;
+    }
     m_data->transaction_side = p_transaction_side;
 }
 
@@ -239,11 +323,15 @@ void
 Entry::do_load()
 {
     Entry temp(*this);
+    // The date is read along with the Entry, so that date() can be
+    // answered without loading the journal (and all its other Entries).
+    // It is null if the journal is not an OrdinaryJournal.
     SQLStatement statement
     (   database_connection(),
         "select account_id, comment, amount, journal_id, is_reconciled, "
-        "transaction_side_id "
-        " from entries where "
+        "transaction_side_id, date "
+        " from entries left join ordinary_journal_detail "
+        "using(journal_id) where "
         "entry_id = :p"
     );
     statement.bind(":p", id());
@@ -267,6 +355,16 @@ Entry::do_load()
         static_cast<TransactionSide>
         (   statement.extract<int>(5)
         );
+    try
+    {
+        temp.m_data->journal_date =
+            numeric_cast<DateRep>(statement.extract<long long>(6));
+    }
+    catch (ValueTypeException&)
+    {
+        // Not an OrdinaryJournal - leave journal_date uninitialized.
+    }
+    temp.m_data->clear_dirty_flags();
     
     swap(temp);
     return;
@@ -297,25 +395,33 @@ void
 Entry::do_save_existing()
 {
     JEWEL_LOG_TRACE();
-
-    // We need to get the old Account so we can mark it as stale
-    SQLStatement old_account_capturer
-    (   database_connection(),
-        "select account_id from entries where entry_id = :p"
-    );
-    old_account_capturer.bind(":p", id());
-    old_account_capturer.step();
-    DcmDatabaseConnection::BalanceCacheAttorney::mark_as_stale
-    (   database_connection(),
-        old_account_capturer.extract<sqloxx::Id>(0)
-    );
-    old_account_capturer.step_final();
-
-    // And we also need to mark the new Account as stale
-    DcmDatabaseConnection::BalanceCacheAttorney::mark_as_stale
-    (   database_connection(),
-        account()->id()
-    );
+    if (!has_unsaved_changes())
+    {
+        return;
+    }
+    if (m_data->account_is_dirty)
+    {
+        // We need to get the old Account so we can mark it as stale
+        SQLStatement old_account_capturer
+        (   database_connection(),
+            "select account_id from entries where entry_id = :p"
+        );
+        old_account_capturer.bind(":p", id());
+        old_account_capturer.step();
+        DcmDatabaseConnection::BalanceCacheAttorney::mark_as_stale
+        (   database_connection(),
+            old_account_capturer.extract<sqloxx::Id>(0)
+        );
+        old_account_capturer.step_final();
+    }
+    if (has_unsaved_balance_changes())
+    {
+        // And we also need to mark the new Account as stale
+        DcmDatabaseConnection::BalanceCacheAttorney::mark_as_stale
+        (   database_connection(),
+            account()->id()
+        );
+    }
 
     // And now we can update the Entry itself
     SQLStatement updater
@@ -331,6 +437,14 @@ Entry::do_save_existing()
     );
     updater.bind(":entry_id", id());
     process_saving_statement(updater);
+    DcmDatabaseConnection::EntryFingerprintAttorney::mark_journal_as_stale
+    (   database_connection(),
+        value(m_data->journal_id)
+    );
+    database_connection().ledger_snapshot().mark_journal_as_stale
+    (   value(m_data->journal_id)
+    );
+    m_data->clear_dirty_flags();
 
     JEWEL_LOG_TRACE();
     return;
@@ -368,6 +482,14 @@ Entry::do_save_new()
         ")"
     );
     process_saving_statement(inserter);
+    DcmDatabaseConnection::EntryFingerprintAttorney::mark_journal_as_stale
+    (   database_connection(),
+        value(m_data->journal_id)
+    );
+    database_connection().ledger_snapshot().mark_journal_as_stale
+    (   value(m_data->journal_id)
+    );
+    m_data->clear_dirty_flags();
 
     JEWEL_LOG_TRACE();
     return;
@@ -376,7 +498,9 @@ Entry::do_save_new()
 void
 Entry::do_ghostify()
 {
+    m_data->clear_dirty_flags();
     clear(m_data->journal_id);
+    clear(m_data->journal_date);
     clear(m_data->account);
     clear(m_data->comment);
     clear(m_data->amount);
@@ -398,6 +522,11 @@ Entry::do_remove()
     SQLStatement statement(database_connection(), statement_text);
     statement.bind(":p", id());
     statement.step_final();
+    DcmDatabaseConnection::EntryFingerprintAttorney::mark_entry_as_stale
+    (   database_connection(),
+        id()
+    );
+    database_connection().ledger_snapshot().mark_entry_as_stale(id());
 }
 
 std::string
@@ -429,10 +558,41 @@ Entry::mimic(Entry& rhs)
 gregorian::date
 Entry::date()
 {
-    Handle<OrdinaryJournal> const oj(database_connection(), journal_id());
+    load();
+    if (m_data->journal_date)
+    {
+        return boost_date_from_julian_int(*(m_data->journal_date));
+    }
+
+    // The Entry has not yet been saved with an OrdinaryJournal.
+    Handle<OrdinaryJournal> const oj =
+        database_connection().handle_cache<PersistentJournal>().
+            provide<OrdinaryJournal>(journal_id());
     return oj->date();
 }
 
+bool
+Entry::has_unsaved_changes()
+{
+    return
+        !has_id() ||
+        m_data->journal_id_is_dirty ||
+        m_data->account_is_dirty ||
+        m_data->comment_is_dirty ||
+        m_data->amount_is_dirty ||
+        m_data->is_reconciled_is_dirty ||
+        m_data->transaction_side_is_dirty;
+}
+
+bool
+Entry::has_unsaved_balance_changes()
+{
+    return
+        !has_id() ||
+        m_data->account_is_dirty ||
+        m_data->amount_is_dirty;
+}
+
 sqloxx::Id
 Entry::journal_id()
 {
@@ -440,37 +600,36 @@ Entry::journal_id()
     return value(m_data->journal_id);
 }
 
-unique_ptr<SQLStatement>
-create_date_ordered_actual_ordinary_entry_selector
+vector<Id>
+set_whether_reconciled
 (   DcmDatabaseConnection& p_database_connection,
-    optional<gregorian::date> const& p_maybe_min_date,
-    optional<gregorian::date> const& p_maybe_max_date,
-    optional<Handle<Account> > const& p_maybe_account
+    vector<Handle<Entry> > const& p_entries,
+    bool p_is_reconciled
 )
 {
-    ostringstream oss;
-    oss << "select entry_id from entries join ordinary_journal_detail "
-        << "using(journal_id) join journals using(journal_id) where "
-        << "transaction_type_id != "
-        << static_cast<int>(non_actual_transaction_type());
-    if (p_maybe_min_date) oss << " and date >= :min_date";
-    if (p_maybe_max_date) oss << " and date <= :max_date";
-    if (p_maybe_account) oss <<  " and account_id = :account_id";
-    oss << " order by date";
-    unique_ptr<SQLStatement> ret
-    (   new SQLStatement(p_database_connection, oss.str())
-    );
-    if (p_maybe_min_date)
-    {
-        ret->bind(":min_date", julian_int(*p_maybe_min_date));
-    }
-    if (p_maybe_max_date)
+    vector<Id> ret;
+    DatabaseTransaction transaction(p_database_connection);
+    try
     {
-        ret->bind(":max_date", julian_int(*p_maybe_max_date));
+        for (Handle<Entry> const& entry: p_entries)
+        {
+            if (entry->is_reconciled() != p_is_reconciled)
+            {
+                entry->set_whether_reconciled(p_is_reconciled);
+                entry->save();
+                ret.push_back(entry->id());
+            }
+        }
+        transaction.commit();
     }
-    if (p_maybe_account && (*p_maybe_account)->has_id())
+    catch (...)
     {
-        ret->bind(":account_id", (*p_maybe_account)->id());
+        transaction.cancel();
+        for (Handle<Entry> const& entry: p_entries)
+        {
+            entry->ghostify();
+        }
+        throw;
     }
     return ret;
 }
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "entry_fingerprint_index.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include <jewel/assert.hpp>
+#include <jewel/decimal.hpp>
+#include <jewel/log.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using jewel::Decimal;
+using sqloxx::Id;
+using sqloxx::SQLStatement;
+using std::hash;
+using std::size_t;
+using std::string;
+using std::unordered_set;
+
+namespace dcm
+{
+
+namespace
+{
+    string normalized_comment(string const& p_comment)
+    {
+        string ret;
+        ret.reserve(p_comment.size());
+        bool pending_space = false;
+        for (char c: p_comment)
+        {
+            if ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\r'))
+            {
+                pending_space = !ret.empty();
+                continue;
+            }
+            if (pending_space)
+            {
+                ret += ' ';
+                pending_space = false;
+            }
+            // Only ASCII letters are folded. Bytes of multibyte UTF-8
+            // sequences are left alone.
+            if ((c >= 'A') && (c <= 'Z'))
+            {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+            ret += c;
+        }
+        return ret;
+    }
+
+    void combine_hash(size_t& p_seed, size_t p_value)
+    {
+        // As per boost::hash_combine
+        p_seed ^= p_value + 0x9e3779b9 + (p_seed << 6) + (p_seed >> 2);
+        return;
+    }
+
+}  // end anonymous namespace
+
+
+EntryFingerprint::EntryFingerprint
+(   Id p_account_id,
+    DateRep p_date,
+    Decimal::int_type p_amount_intval,
+    string const& p_comment
+):
+    m_account_id(p_account_id),
+    m_date(p_date),
+    m_amount_intval(p_amount_intval),
+    m_comment(normalized_comment(p_comment))
+{
+}
+
+bool
+EntryFingerprint::operator==(EntryFingerprint const& rhs) const
+{
+    return
+        (m_account_id == rhs.m_account_id) &&
+        (m_date == rhs.m_date) &&
+        (m_amount_intval == rhs.m_amount_intval) &&
+        (m_comment == rhs.m_comment);
+}
+
+size_t
+EntryFingerprint::Hasher::operator()
+(   EntryFingerprint const& p_fingerprint
+) const
+{
+    size_t ret = hash<Id>()(p_fingerprint.m_account_id);
+    combine_hash(ret, hash<DateRep>()(p_fingerprint.m_date));
+    combine_hash
+    (   ret,
+        hash<Decimal::int_type>()(p_fingerprint.m_amount_intval)
+    );
+    combine_hash(ret, hash<string>()(p_fingerprint.m_comment));
+    return ret;
+}
+
+
+EntryFingerprintIndex::EntryFingerprintIndex
+(   DcmDatabaseConnection& p_database_connection
+):
+    m_database_connection(p_database_connection),
+    m_is_stale(true)
+{
+    JEWEL_LOG_TRACE();
+}
+
+EntryFingerprintIndex::~EntryFingerprintIndex()
+{
+    JEWEL_LOG_TRACE();
+}
+
+size_t
+EntryFingerprintIndex::count(EntryFingerprint const& p_fingerprint)
+{
+    refresh();
+    CountMap::const_iterator const it = m_counts.find(p_fingerprint);
+    return (it == m_counts.end())? 0: it->second;
+}
+
+void
+EntryFingerprintIndex::add_entry
+(   Id p_entry_id,
+    EntryFingerprint const& p_fingerprint
+)
+{
+    if (!m_is_stale)
+    {
+        erase(p_entry_id);
+        insert(p_entry_id, p_fingerprint);
+    }
+    return;
+}
+
+void
+EntryFingerprintIndex::mark_as_stale()
+{
+    m_is_stale = true;
+    m_stale_journal_ids.clear();
+    m_stale_entry_ids.clear();
+    return;
+}
+
+void
+EntryFingerprintIndex::mark_journal_as_stale(Id p_journal_id)
+{
+    // If the whole index is stale, there's no point tracking individual
+    // Journals, as everything will be re-read anyway.
+    if (!m_is_stale) m_stale_journal_ids.insert(p_journal_id);
+    return;
+}
+
+void
+EntryFingerprintIndex::mark_entry_as_stale(Id p_entry_id)
+{
+    if (!m_is_stale) m_stale_entry_ids.insert(p_entry_id);
+    return;
+}
+
+void
+EntryFingerprintIndex::refresh()
+{
+    // Beyond this many stale Journals, we assume it's quicker to rebuild
+    // the whole index with a single scan than to re-read each Journal's
+    // Entries with a separate query. As with the fulcrum in
+    // BalanceCache::refresh(), this is an educated guess.
+    static unordered_set<Id>::size_type const fulcrum = 100;
+
+    if (!m_is_stale && (m_stale_journal_ids.size() > fulcrum))
+    {
+        mark_as_stale();
+    }
+    if (m_is_stale)
+    {
+        refresh_all();
+        m_stale_journal_ids.clear();
+        m_stale_entry_ids.clear();
+        m_is_stale = false;
+        return;
+    }
+    try
+    {
+        for (Id const entry_id: m_stale_entry_ids)
+        {
+            // The removal of the Entry may since have been rolled back, so
+            // we check whether it's still there, and if it is, re-read its
+            // Journal.
+            erase(entry_id);
+            SQLStatement statement
+            (   m_database_connection,
+                "select journal_id from entries where entry_id = :p"
+            );
+            statement.bind(":p", entry_id);
+            if (statement.step())
+            {
+                m_stale_journal_ids.insert(statement.extract<Id>(0));
+                statement.step_final();
+            }
+        }
+        m_stale_entry_ids.clear();
+        for (Id const journal_id: m_stale_journal_ids)
+        {
+            refresh_journal(journal_id);
+        }
+    }
+    catch (...)
+    {
+        // We don't know how far we got, so start afresh next time.
+        mark_as_stale();
+        throw;
+    }
+    m_stale_journal_ids.clear();
+    JEWEL_ASSERT (!m_is_stale);
+    return;
+}
+
+void
+EntryFingerprintIndex::refresh_all()
+{
+    JEWEL_LOG_TRACE();
+    CountMap counts_elect;
+    EntryMap entries_elect;
+    SQLStatement statement
+    (   m_database_connection,
+        "select entry_id, account_id, date, amount, comment from entries "
+        "join ordinary_journal_detail using(journal_id)"
+    );
+    while (statement.step())
+    {
+        EntryFingerprint const fingerprint
+        (   statement.extract<Id>(1),
+            statement.extract<DateRep>(2),
+            statement.extract<Decimal::int_type>(3),
+            statement.extract<string>(4)
+        );
+        entries_elect.insert(EntryMap::value_type
+        (   statement.extract<Id>(0),
+            fingerprint
+        ));
+        ++counts_elect[fingerprint];
+    }
+    using std::swap;
+    swap(m_counts, counts_elect);
+    swap(m_entries, entries_elect);
+    JEWEL_LOG_TRACE();
+    return;
+}
+
+void
+EntryFingerprintIndex::refresh_journal(Id p_journal_id)
+{
+    SQLStatement statement
+    (   m_database_connection,
+        "select entry_id, account_id, date, amount, comment from entries "
+        "join ordinary_journal_detail using(journal_id) "
+        "where journal_id = :p"
+    );
+    statement.bind(":p", p_journal_id);
+    while (statement.step())
+    {
+        Id const entry_id = statement.extract<Id>(0);
+        erase(entry_id);
+        insert
+        (   entry_id,
+            EntryFingerprint
+            (   statement.extract<Id>(1),
+                statement.extract<DateRep>(2),
+                statement.extract<Decimal::int_type>(3),
+                statement.extract<string>(4)
+            )
+        );
+    }
+    return;
+}
+
+void
+EntryFingerprintIndex::insert
+(   Id p_entry_id,
+    EntryFingerprint const& p_fingerprint
+)
+{
+    JEWEL_ASSERT (m_entries.find(p_entry_id) == m_entries.end());
+    m_entries.insert(EntryMap::value_type(p_entry_id, p_fingerprint));
+    ++m_counts[p_fingerprint];
+    return;
+}
+
+void
+EntryFingerprintIndex::erase(Id p_entry_id)
+{
+    EntryMap::iterator const it = m_entries.find(p_entry_id);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+    CountMap::iterator const count_it = m_counts.find(it->second);
+    JEWEL_ASSERT (count_it != m_counts.end());
+    JEWEL_ASSERT (count_it->second > 0);
+    if (--(count_it->second) == 0)
+    {
+        m_counts.erase(count_it);
+    }
+    m_entries.erase(it);
+    return;
+}
+
+}  // namespace dcm
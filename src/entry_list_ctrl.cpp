@@ -22,6 +22,8 @@
 #include "date_parser.hpp"
 #include "entry.hpp"
 #include "entry_table_iterator.hpp"
+#include "finformat.hpp"
+#include "handle_cache.hpp"
 #include "ordinary_journal.hpp"
 #include "dcm_database_connection.hpp"
 #include "gui/bs_account_entry_list_ctrl.hpp"
@@ -29,6 +31,7 @@
 #include "gui/persistent_object_event.hpp"
 #include "gui/pl_account_entry_list_ctrl.hpp"
 #include "gui/reconciliation_entry_list_ctrl.hpp"
+#include "gui/search_entry_list_ctrl.hpp"
 #include "gui/summary_datum.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/lexical_cast.hpp>
@@ -54,11 +57,9 @@ using boost::optional;
 using jewel::value;
 using sqloxx::Handle;
 using sqloxx::Id;
-using sqloxx::SQLStatement;
 using std::is_signed;
 using std::pair;
 using std::string;
-using std::unique_ptr;
 using std::vector;
 
 namespace gregorian = boost::gregorian;
@@ -87,7 +88,11 @@ EntryListCtrl::EntryListCtrl
         p_size,
         wxLC_REPORT | wxFULL_REPAINT_ON_RESIZE
     ),
-    m_database_connection(p_database_connection)
+    m_database_connection(p_database_connection),
+    m_amount_formatter
+    (   locale(),
+        DecimalFormatFlags().clear(string_flags::dash_for_zero)
+    )
 {
 }
 
@@ -157,6 +162,24 @@ EntryListCtrl::create_reconciliation_entry_list
     return ret;
 }
 
+EntryListCtrl*
+EntryListCtrl::create_search_entry_list
+(   wxWindow* p_parent,
+    wxSize const& p_size,
+    DcmDatabaseConnection& p_database_connection,
+    vector<Id> const& p_entry_ids
+)
+{
+    EntryListCtrl* ret = new SearchEntryListCtrl
+    (   p_parent,
+        p_size,
+        p_database_connection,
+        p_entry_ids
+    );
+    initialize(ret);
+    return ret;
+}
+
 void
 EntryListCtrl::initialize(EntryListCtrl* p_entry_list_ctrl)
 {
@@ -187,14 +210,10 @@ EntryListCtrl::insert_date_column()
 void
 EntryListCtrl::populate()
 {
-    unique_ptr<SQLStatement> statement = do_create_entry_selector();
-    while (statement->step())
+    for (Id const entry_id: do_select_entry_ids())
     {
         process_push_candidate_entry
-        (   Handle<Entry>
-            (   database_connection(),
-                statement->extract<Id>(0)
-            )
+        (   database_connection().handle_cache<Entry>().provide(entry_id)
         );
     }
     return;
@@ -234,12 +253,12 @@ EntryListCtrl::adjust_comment_column_to_fit()
 
 }
 
-gregorian::date
-EntryListCtrl::date_displayed(long p_row, DateParser const& p_parser) const
+DateRep
+EntryListCtrl::date_displayed(long p_row) const
 {
     JEWEL_ASSERT (date_col_num() == 0);
-    optional<gregorian::date> const maybe_date =
-        p_parser.parse(GetItemText(p_row));
+    optional<DateRep> const maybe_date =
+        m_date_parser.parse_date_rep(GetItemText(p_row));
     JEWEL_ASSERT (maybe_date);
     return value(maybe_date);
 }
@@ -259,8 +278,11 @@ EntryListCtrl::row_for_date(gregorian::date const& p_date) const
     }
     JEWEL_ASSERT (max == num_rows);
     JEWEL_ASSERT (max > 0);
-    DateParser const parser;
-    if (date_displayed(max - 1, parser) <= p_date)
+
+    // Compare as DateReps, so that each probe is just a parse of the
+    // displayed text.
+    DateRep const target = julian_int(p_date);
+    if (date_displayed(max - 1) <= target)
     {
         // Very end
         return max;
@@ -273,32 +295,32 @@ EntryListCtrl::row_for_date(gregorian::date const& p_date) const
         if (guess == min)
         {
             // Find end of contiguous rows showing this date
-            while ((date_displayed(guess, parser) == p_date) && (guess != num_rows))
+            while ((guess != num_rows) && (date_displayed(guess) == target))
             {
                 ++guess;
             }
             return guess;
         }
-        gregorian::date const date = date_displayed(guess, parser);
+        DateRep const date = date_displayed(guess);
         JEWEL_ASSERT (guess > 0);
-        gregorian::date const predecessor_date = date_displayed(guess - 1, parser);
+        DateRep const predecessor_date = date_displayed(guess - 1);
         JEWEL_ASSERT (predecessor_date <= date);
-        if ((predecessor_date <= p_date) && (p_date <= date))
+        if ((predecessor_date <= target) && (target <= date))
         {
             // Find end of contiguous rows showing this date
-            while ((date_displayed(guess, parser) == p_date) && (guess != num_rows))
+            while ((guess != num_rows) && (date_displayed(guess) == target))
             {
                 ++guess;
             }
             return guess;
         }
-        JEWEL_ASSERT ((p_date < predecessor_date) || (date < p_date));
-        if (p_date < predecessor_date)
+        JEWEL_ASSERT ((target < predecessor_date) || (date < target));
+        if (target < predecessor_date)
         {
             JEWEL_ASSERT (guess < max);
             max = guess;
         }
-        else if (date < p_date)
+        else if (date < target)
         {
             JEWEL_ASSERT (guess > min);
             min = guess;
@@ -381,8 +403,6 @@ EntryListCtrl::update_for_amended(Handle<OrdinaryJournal> const& p_journal)
         return;
     }
     JEWEL_ASSERT (p_journal->is_actual());
-    wxString const wx_date_string = date_format_wx(p_journal->date());
-    DateParser const parser;
     for (Handle<Entry> const& entry: p_journal->entries())
     {
         long updated_pos = -1;
@@ -395,11 +415,11 @@ EntryListCtrl::update_for_amended(Handle<OrdinaryJournal> const& p_journal)
             (   GetItemData(pos) ==
                 static_cast<unsigned long>(entry->id())
             );
-            gregorian::date const old_date = date_displayed(pos, parser);
+            DateRep const old_date = date_displayed(pos);
             do_process_removal_for_summary(pos);
             DeleteItem(pos);
             m_id_set.erase(jt);
-            if (old_date == entry->date())
+            if (old_date == julian_int(entry->date()))
             {
                 updated_pos = pos;    
             }
@@ -445,8 +465,11 @@ EntryListCtrl::selected_entries()
     {
         if (GetItemState(i, wxLIST_STATE_SELECTED))
         {
-            Handle<Entry> const entry(m_database_connection, GetItemData(i));
-            ret.push_back(entry);
+            ret.push_back
+            (   m_database_connection.handle_cache<Entry>().provide
+                (   GetItemData(i)
+                )
+            );
         }
     }
     return ret;
@@ -522,7 +545,7 @@ EntryListCtrl::push_back_entry(Handle<Entry> const& p_entry)
 {
     auto const i = GetItemCount();
     JEWEL_ASSERT (date_col_num() == 0);
-    InsertItem(i, date_format_wx(p_entry->date()));
+    InsertItem(i, m_date_formatter.format(julian_int(p_entry->date())));
     do_set_non_date_columns(i, p_entry);
 
     // The item may change position due to e.g. sorting, so store the
@@ -545,7 +568,7 @@ EntryListCtrl::insert_entry(Handle<Entry> const& p_entry, long p_row)
     gregorian::date const date = p_entry->date();
     JEWEL_ASSERT (p_row >= -1);
     long const pos = ((p_row == -1)? row_for_date(date): p_row);
-    InsertItem(pos, date_format_wx(date));
+    InsertItem(pos, m_date_formatter.format(julian_int(date)));
     do_set_non_date_columns(pos, p_entry);
     sqloxx::Id const id = p_entry->id();
     SetItemData(pos, id);
@@ -583,5 +606,11 @@ EntryListCtrl::database_connection() const
     return m_database_connection;
 }
 
+DecimalFormatter const&
+EntryListCtrl::amount_formatter() const
+{
+    return m_amount_formatter;
+}
+
 }  // namespace gui
 }  // namespace dcm
@@ -21,6 +21,7 @@
 #include "entry.hpp"
 #include "ordinary_journal.hpp"
 #include "string_flags.hpp"
+#include "warm_start_cache.hpp"
 #include "gui/account_ctrl.hpp"
 #include "gui/button.hpp"
 #include "gui/date_ctrl.hpp"
@@ -33,7 +34,6 @@
 #include <boost/optional.hpp>
 #include <jewel/assert.hpp>
 #include <jewel/log.hpp>
-#include <jewel/on_windows.hpp>
 #include <jewel/optional.hpp>
 #include <sqloxx/handle.hpp>
 #include <wx/event.h>
@@ -72,7 +72,10 @@ namespace
 {
     wxString reconciliation_hint()
     {
-        return wxString("(Right-click item to toggle whether reconciled.)");
+        return wxString
+        (   "(Right-click item to toggle whether reconciled. Select several "
+            "items, or hold shift, and right-click for more options.)"
+        );
     }
 
 }  // end anonymous namespace
@@ -268,6 +271,16 @@ EntryListPanel::update_for_deleted(vector<sqloxx::Id> const& p_doomed_ids)
     return;
 }
 
+void
+EntryListPanel::update_for_bulk_changes()
+{
+    // Rebuilding the list from scratch is much cheaper than updating it
+    // piecemeal for each of a large number of new journals.
+    if (m_entry_list_ctrl) configure_entry_list_ctrl();
+    postconfigure_summary();
+    return;
+}
+
 vector<Handle<Entry> >
 EntryListPanel::selected_entries()
 {
@@ -276,26 +289,53 @@ EntryListPanel::selected_entries()
     return ret;
 }
 
+EntryListFilter
+EntryListPanel::filter()
+{
+    EntryListFilter ret;
+    Handle<Account> const account = selected_account();
+    if (account) ret.account_id = account->id();
+    ret.min_date = selected_min_date();
+    ret.max_date = selected_max_date();
+    return ret;
+}
+
+void
+EntryListPanel::set_filter(EntryListFilter const& p_filter)
+{
+    JEWEL_ASSERT (m_account_ctrl);
+    JEWEL_ASSERT (m_min_date_ctrl);
+    JEWEL_ASSERT (m_max_date_ctrl);
+    if (p_filter.account_id)
+    {
+        m_account_ctrl->set_account
+        (   Handle<Account>(m_database_connection, value(p_filter.account_id))
+        );
+    }
+    bool const allow_blank_dates = !m_support_reconciliations;
+    if (p_filter.min_date || allow_blank_dates)
+    {
+        m_min_date_ctrl->set_date(p_filter.min_date);
+    }
+    if (p_filter.max_date || allow_blank_dates)
+    {
+        m_max_date_ctrl->set_date(p_filter.max_date);
+    }
+    return;
+}
+
 void
 EntryListPanel::configure_entry_list_ctrl()
 {
     wxWindowUpdateLocker const update_locker(this);
 
-    // TODO LOW PRIORITY This is an ugly hack. Make it nicer.
-    if (m_client_size_aux < 100)
-    {
-        m_client_size_aux = GetClientSize().GetY();
-    }
     int const num_extra_rows = 2;
-    int height_aux =
-        m_client_size_aux -
-        m_account_ctrl->GetSize().GetY() * num_extra_rows -
-        standard_gap() * (num_extra_rows + 1) -
-        standard_border() * 2;
-
-#   ifdef JEWEL_ON_WINDOWS
-        height_aux -= standard_gap() * (num_extra_rows + 1);
-#   endif
+    int const height_aux = list_height_below_rows
+    (   *this,
+        m_client_size_aux,
+        num_extra_rows,
+        m_account_ctrl->GetSize().GetY()
+    );
 
     EntryListCtrl* temp = 0;
     if (m_support_reconciliations)
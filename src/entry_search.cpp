@@ -0,0 +1,329 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "entry_search.hpp"
+#include "commodity.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include "string_conv.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/decimal.hpp>
+#include <jewel/log.hpp>
+#include <jewel/optional.hpp>
+#include <sqloxx/database_transaction.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <sqloxx/sqloxx_exceptions.hpp>
+#include <wx/string.h>
+#include <cctype>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using boost::lexical_cast;
+using jewel::Decimal;
+using jewel::Log;
+using jewel::value;
+using sqloxx::DatabaseTransaction;
+using sqloxx::Id;
+using sqloxx::SQLiteException;
+using sqloxx::SQLStatement;
+using std::isalnum;
+using std::istringstream;
+using std::size_t;
+using std::string;
+using std::vector;
+
+namespace dcm
+{
+
+namespace
+{
+    string index_name()
+    {
+        return "entry_search";
+    }
+
+    bool index_exists(DcmDatabaseConnection& p_database_connection)
+    {
+        SQLStatement statement
+        (   p_database_connection,
+            "select name from sqlite_master where type = 'table' and "
+            "name = :name"
+        );
+        statement.bind(":name", index_name());
+        return statement.step();
+    }
+
+    // The words of p_text that are worth looking for, i.e. that contain
+    // at least one letter or digit, in UTF-8. (As far as the FTS5
+    // tokenizer is concerned, a word consisting only of punctuation is no
+    // word at all, so it would match nothing.)
+    vector<string> search_words(wxString const& p_text)
+    {
+        vector<string> ret;
+        istringstream stream(wx_to_std8(p_text));
+        string word;
+        while (stream >> word)
+        {
+            for (char const c: word)
+            {
+                unsigned char const u = static_cast<unsigned char>(c);
+                if ((u >= 0x80) || isalnum(u))
+                {
+                    ret.push_back(word);
+                    break;
+                }
+            }
+        }
+        return ret;
+    }
+
+    // Quoting each word means that the user cannot (inadvertently) use
+    // the FTS5 query syntax; the trailing '*' lets each word match the
+    // beginning of a longer one, so that results can be shown as the
+    // user types.
+    string fts_query(vector<string> const& p_words)
+    {
+        string ret;
+        for (string const& word: p_words)
+        {
+            if (!ret.empty()) ret += " AND ";
+            ret += '"';
+            for (char const c: word)
+            {
+                if (c == '"') ret += '"';
+                ret += c;
+            }
+            ret += "\"*";
+        }
+        return ret;
+    }
+
+    string like_pattern(string const& p_word)
+    {
+        string ret("%");
+        for (char const c: p_word)
+        {
+            if ((c == '%') || (c == '_') || (c == '\\')) ret += '\\';
+            ret += c;
+        }
+        ret += '%';
+        return ret;
+    }
+
+    Decimal::int_type stored_amount
+    (   Decimal const& p_amount,
+        Decimal::places_type p_precision
+    )
+    {
+        Decimal const rounded = round(p_amount, p_precision);
+        return (rounded.intval() < 0)? -rounded.intval(): rounded.intval();
+    }
+
+}  // end anonymous namespace
+
+void
+setup_entry_search(DcmDatabaseConnection& p_database_connection)
+{
+    JEWEL_LOG_TRACE();
+    DcmDatabaseConnection& dbc = p_database_connection;
+    if (index_exists(dbc))
+    {
+        return;
+    }
+    DatabaseTransaction transaction(dbc);
+    try
+    {
+        // The rowid of the index is the entry_id. The comments are
+        // stored in the index (rather than it being "contentless"), so
+        // that the triggers can update and delete rows without having to
+        // supply the old text.
+        dbc.execute_sql
+        (   "create virtual table " + index_name() + " using fts5"
+            "(entry_comment, journal_comment)"
+        );
+        dbc.execute_sql
+        (   "create trigger entry_search_entry_insert after insert on "
+                "entries "
+            "begin "
+                "insert into entry_search"
+                "(rowid, entry_comment, journal_comment) "
+                "values(new.entry_id, new.comment, "
+                "(select comment from journals where journal_id = "
+                "new.journal_id)); "
+            "end"
+        );
+        dbc.execute_sql
+        (   "create trigger entry_search_entry_update after update of "
+                "comment, journal_id on entries "
+            "when (new.comment is not old.comment) or "
+                "(new.journal_id is not old.journal_id) "
+            "begin "
+                "update entry_search set entry_comment = new.comment, "
+                "journal_comment = (select comment from journals where "
+                "journal_id = new.journal_id) "
+                "where rowid = new.entry_id; "
+            "end"
+        );
+        dbc.execute_sql
+        (   "create trigger entry_search_entry_delete after delete on "
+                "entries "
+            "begin "
+                "delete from entry_search where rowid = old.entry_id; "
+            "end"
+        );
+        dbc.execute_sql
+        (   "create trigger entry_search_journal_update after update of "
+                "comment on journals "
+            "when new.comment is not old.comment "
+            "begin "
+                "update entry_search set journal_comment = new.comment "
+                "where rowid in (select entry_id from entries where "
+                "journal_id = new.journal_id); "
+            "end"
+        );
+
+        // The database may have been created before there was an index.
+        dbc.execute_sql
+        (   "insert into entry_search"
+            "(rowid, entry_comment, journal_comment) "
+            "select entry_id, entries.comment, journals.comment "
+            "from entries join journals using(journal_id)"
+        );
+        transaction.commit();
+    }
+    catch (SQLiteException&)
+    {
+        // Most likely the SQLite library was built without FTS5.
+        transaction.cancel();
+        JEWEL_LOG_MESSAGE
+        (   Log::warning,
+            "Could not set up full-text index; searches will scan comments."
+        );
+    }
+    return;
+}
+
+vector<Id>
+search_entries
+(   DcmDatabaseConnection& p_database_connection,
+    EntrySearchQuery const& p_query
+)
+{
+    JEWEL_LOG_TRACE();
+    DcmDatabaseConnection& dbc = p_database_connection;
+    vector<Id> ret;
+    vector<string> const words = search_words(p_query.text);
+    if (words.empty() || (p_query.max_results == 0))
+    {
+        return ret;
+    }
+    bool const use_index = index_exists(dbc);
+
+    string filters;
+    if (p_query.min_date) filters += " and date >= :min_date";
+    if (p_query.max_date) filters += " and date <= :max_date";
+    if (p_query.min_amount) filters += " and abs(amount) >= :min_amount";
+    if (p_query.max_amount) filters += " and abs(amount) <= :max_amount";
+
+    // Within equally good matches (and with no index, all matches are
+    // equally good), the most recent Entries come first.
+    string text;
+    if (use_index)
+    {
+        text =
+            "select entry_id from entry_search join entries on "
+            "entries.entry_id = entry_search.rowid "
+            "join ordinary_journal_detail using(journal_id) "
+            "where entry_search match :query" + filters + " "
+            "order by bm25(entry_search, 2.0, 1.0), date desc, "
+            "entry_id desc limit :limit";
+    }
+    else
+    {
+        text =
+            "select entry_id from entries join journals using(journal_id) "
+            "join ordinary_journal_detail using(journal_id) where 1";
+        for (size_t i = 0; i != words.size(); ++i)
+        {
+            string const param = ":word" + lexical_cast<string>(i);
+            text +=
+                " and ((entries.comment like " + param + " escape '\\') or "
+                "(journals.comment like " + param + " escape '\\'))";
+        }
+        text += filters + " order by date desc, entry_id desc limit :limit";
+    }
+    SQLStatement statement(dbc, text);
+    if (use_index)
+    {
+        statement.bind(":query", fts_query(words));
+    }
+    else
+    {
+        for (size_t i = 0; i != words.size(); ++i)
+        {
+            statement.bind
+            (   ":word" + lexical_cast<string>(i),
+                like_pattern(words[i])
+            );
+        }
+    }
+    if (p_query.min_date)
+    {
+        statement.bind(":min_date", julian_int(value(p_query.min_date)));
+    }
+    if (p_query.max_date)
+    {
+        statement.bind(":max_date", julian_int(value(p_query.max_date)));
+    }
+    if (p_query.min_amount || p_query.max_amount)
+    {
+        Decimal::places_type const precision =
+            dbc.default_commodity()->precision();
+        if (p_query.min_amount)
+        {
+            statement.bind
+            (   ":min_amount",
+                stored_amount(value(p_query.min_amount), precision)
+            );
+        }
+        if (p_query.max_amount)
+        {
+            statement.bind
+            (   ":max_amount",
+                stored_amount(value(p_query.max_amount), precision)
+            );
+        }
+    }
+    statement.bind
+    (   ":limit",
+        static_cast<long long>(p_query.max_results)
+    );
+    while (statement.step())
+    {
+        ret.push_back(statement.extract<Id>(0));
+    }
+    JEWEL_ASSERT (ret.size() <= p_query.max_results);
+    return ret;
+}
+
+}  // namespace dcm
@@ -16,23 +16,25 @@
 
 #include "gui/filtered_entry_list_ctrl.hpp"
 #include "account.hpp"
+#include "dcm_database_connection.hpp"
 #include "entry.hpp"
 #include "gui/entry_list_ctrl.hpp"
+#include "ledger_snapshot.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <jewel/decimal.hpp>
 #include <jewel/optional.hpp>
 #include <sqloxx/handle.hpp>
-#include <sqloxx/sql_statement.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/window.h>
-#include <memory>
+#include <vector>
 
 using boost::optional;
 using jewel::Decimal;
 using jewel::value;
 using sqloxx::Handle;
-using sqloxx::SQLStatement;
-using std::unique_ptr;
+using sqloxx::Id;
+using std::vector;
 
 namespace gregorian = boost::gregorian;
 
@@ -122,18 +124,14 @@ FilteredEntryListCtrl::do_set_column_widths()
     return;
 }
 
-unique_ptr<SQLStatement>
-FilteredEntryListCtrl::do_create_entry_selector()
+vector<Id>
+FilteredEntryListCtrl::do_select_entry_ids()
 {
-    unique_ptr<SQLStatement> ret
-    (   create_date_ordered_actual_ordinary_entry_selector
-        (   database_connection(),
-            m_min_date,
-            m_maybe_max_date,
-            m_account
-        )
+    return database_connection().ledger_snapshot().actual_entry_ids
+    (   m_min_date,
+        m_maybe_max_date,
+        m_account->id()
     );
-    return ret;
 }
 
 }  // namespace gui
@@ -20,26 +20,27 @@
 #include <jewel/assert.hpp>
 #include <jewel/decimal.hpp>
 #include <jewel/decimal_exceptions.hpp>
+#include <jewel/exception.hpp>
 #include <jewel/log.hpp>
 #include <wx/intl.h>
 #include <wx/string.h>
 #include <algorithm>
-#include <deque>
+#include <cstddef>
 #include <limits>
 #include <locale>
-#include <ostream>
+#include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 using jewel::Decimal;
 using jewel::DecimalFromStringException;
-using std::back_inserter;
 using std::copy;
-using std::deque;
 using std::locale;
 using std::numeric_limits;
 using std::numpunct;
 using std::ostringstream;
+using std::size_t;
 using std::string;
 using std::use_facet;
 using std::vector;
@@ -49,175 +50,499 @@ namespace dcm
 
 namespace
 {
-    vector<wxString> split_plus_minus(wxString const& p_string)
+    // The characters removed by wxString::Trim().
+    bool is_trimmed_space(wxUniChar p_char)
     {
-        vector<wxString> ret;
-        wxString current_slice;
-        for (wxChar const wx_char: p_string)
+        switch (p_char.GetValue())
         {
-            if ((wx_char == wxChar('+')) || (wx_char == wxChar('-')))
-            {
-                ret.push_back(current_slice);
-                current_slice.clear();
-            }
-            if (wx_char != wxChar(' '))
+        case ' ': case '\t': case '\n': case '\r': case '\v': case '\f':
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Whether the characters from p_it onwards begin with the (non-empty)
+    // p_token; if they do, p_it is moved past them.
+    bool skip_token
+    (   wxString::const_iterator& p_it,
+        wxString::const_iterator const& p_end,
+        wxString const& p_token
+    )
+    {
+        JEWEL_ASSERT (!p_token.IsEmpty());
+        wxString::const_iterator it = p_it;
+        for (wxUniChar const token_char: p_token)
+        {
+            if ((it == p_end) || (*it != token_char))
             {
-                current_slice.Append(wx_char);
+                return false;
             }
+            ++it;
         }
-        ret.push_back(current_slice);
-        return ret;
+        p_it = it;
+        return true;
     }
 
+    typedef
+        std::make_unsigned<Decimal::int_type>::type
+        Magnitude;
+
+    // Enough for the digits of any Magnitude.
+    size_t const max_magnitude_digits =
+        numeric_limits<Magnitude>::digits10 + 1;
+
+    // Enough for almost any separators; DecimalFormatter::format(...)
+    // falls back on the heap otherwise.
+    size_t const stack_buffer_size = 128;
+
+    // The two digits of each number from 0 to 99, in turn.
+    char const digit_pairs[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
 }  // end anonymous namespace
 
+DecimalFormatter::DecimalFormatter
+(   wxLocale const& p_locale,
+    DecimalFormatFlags p_flags
+):
+#   ifdef DCM_DISALLOW_DASH_FOR_ZERO
+        m_dash_for_zero(false),
+#   else
+        m_dash_for_zero(p_flags.test(string_flags::dash_for_zero)),
+#   endif
+    m_pad(!p_flags.test(string_flags::hard_align_right)),
+    m_decimal_point
+    (   p_locale.GetInfo(wxLOCALE_DECIMAL_POINT, wxLOCALE_CAT_MONEY)
+    ),
+    m_thousands_sep
+    (   p_locale.GetInfo(wxLOCALE_THOUSANDS_SEP, wxLOCALE_CAT_MONEY)
+    )
+{
+}
+
+wxString
+DecimalFormatter::format(Decimal const& p_decimal) const
+{
+    Decimal::places_type const places = p_decimal.places();
+    size_t const length = max_length(places);
+    wxChar stack_buffer[stack_buffer_size];
+    vector<wxChar> heap_buffer;
+    wxChar* buffer = stack_buffer;
+    if (length > stack_buffer_size)
+    {
+        // Only for very long separators.
+        heap_buffer.resize(length);
+        buffer = &heap_buffer[0];
+    }
+    wxChar* const end = buffer + length;
+    size_t const num_written =
+        write_backwards(p_decimal.intval(), places, end);
+    return wxString(end - num_written, num_written);
+}
+
+size_t
+DecimalFormatter::max_length(Decimal::places_type p_places) const
+{
+    // Digits of the whole part, in the worst case; there may be a leading
+    // zero as well as the fractional digits.
+    size_t const max_whole_digits = max_magnitude_digits + 1;
+    size_t const max_separators = max_whole_digits / 3;
+    return
+        max_whole_digits + p_places + m_decimal_point.size() +
+        max_separators * m_thousands_sep.size() +
+        2;  // parentheses, or dash and padding
+}
+
+size_t
+DecimalFormatter::write_backwards
+(   Decimal::int_type p_intval,
+    Decimal::places_type p_places,
+    wxChar* p_end
+) const
+{
+    wxChar* pos = p_end;
+    bool const is_negative = (p_intval < 0);
+    if (is_negative)
+    {
+        *--pos = wxChar(')');
+    }
+    else if (m_pad)
+    {
+        *--pos = wxChar(' ');
+    }
+    if (m_dash_for_zero && (p_intval == 0))
+    {
+        for (Decimal::places_type i = 0; i != p_places; ++i)
+        {
+            *--pos = wxChar(' ');
+        }
+        *--pos = wxChar('-');
+        return p_end - pos;
+    }
+
+    // The digits of the absolute value of the underlying integer, two at
+    // a time. This is done unsigned, so that the lowest int_type does not
+    // overflow.
+    Magnitude magnitude =
+    (   is_negative?
+        (Magnitude(0) - static_cast<Magnitude>(p_intval)):
+        static_cast<Magnitude>(p_intval)
+    );
+    char digits[max_magnitude_digits];
+    char* const digits_end = digits + max_magnitude_digits;
+    char* digits_begin = digits_end;
+    while (magnitude >= 100)
+    {
+        size_t const pair_pos = static_cast<size_t>(magnitude % 100) * 2;
+        magnitude /= 100;
+        *--digits_begin = digit_pairs[pair_pos + 1];
+        *--digits_begin = digit_pairs[pair_pos];
+    }
+    if (magnitude >= 10)
+    {
+        size_t const pair_pos = static_cast<size_t>(magnitude) * 2;
+        *--digits_begin = digit_pairs[pair_pos + 1];
+        *--digits_begin = digit_pairs[pair_pos];
+    }
+    else
+    {
+        *--digits_begin = static_cast<char>('0' + magnitude);
+    }
+
+    // The fractional part, with zeroes in front of the digits if there
+    // are not enough of them.
+    char const* digit = digits_end;
+    for (Decimal::places_type i = 0; i != p_places; ++i)
+    {
+        *--pos = ((digit != digits_begin)? wxChar(*--digit): wxChar('0'));
+    }
+    if (p_places != 0)
+    {
+        pos -= m_decimal_point.size();
+        copy(m_decimal_point.begin(), m_decimal_point.end(), pos);
+    }
+
+    // The whole part, grouped in threes.
+    // TODO MEDIUM PRIORITY Is this a safe assumption? There doesn't seem to
+    // be an equivalent of grouping() for wxLocale.
+    if (digit == digits_begin)
+    {
+        *--pos = wxChar('0');
+    }
+    for (int group_size = 0; digit != digits_begin; ++group_size)
+    {
+        if (group_size == 3)
+        {
+            pos -= m_thousands_sep.size();
+            copy(m_thousands_sep.begin(), m_thousands_sep.end(), pos);
+            group_size = 0;
+        }
+        *--pos = wxChar(*--digit);
+    }
+    if (is_negative)
+    {
+        *--pos = wxChar('(');
+    }
+    JEWEL_ASSERT (static_cast<size_t>(p_end - pos) <= max_length(p_places));
+    return p_end - pos;
+}
+
 wxString finformat_wx
 (   jewel::Decimal const& decimal,
     wxLocale const& loc,
     DecimalFormatFlags p_flags
 )
 {
-#   ifdef DCM_DISALLOW_DASH_FOR_ZERO
-        bool const dash_for_zero = false;
-#   else
-        bool const dash_for_zero = p_flags.test(string_flags::dash_for_zero);
-#   endif
+    return DecimalFormatter(loc, p_flags).format(decimal);
+}
+
+DecimalParser::DecimalParser
+(   wxLocale const& p_locale,
+    DecimalParsingFlags p_flags
+):
+    m_allow_parens(p_flags.test(string_flags::allow_negative_parens)),
+    m_decimal_point
+    (   p_locale.GetInfo(wxLOCALE_DECIMAL_POINT, wxLOCALE_CAT_MONEY)
+    ),
+    m_thousands_sep
+    (   p_locale.GetInfo(wxLOCALE_THOUSANDS_SEP, wxLOCALE_CAT_MONEY)
+    ),
+    m_std_decimal_point
+    (   use_facet<numpunct<char> >(locale()).decimal_point()
+    )
+{
+    if (m_decimal_point.IsEmpty())
+    {
+        m_decimal_point = wxString(".");
+    }
+}
 
-    bool const pad = !p_flags.test(string_flags::hard_align_right);
+DecimalParser::DecimalParser
+(   wxString const& p_decimal_point,
+    wxString const& p_thousands_sep,
+    DecimalParsingFlags p_flags
+):
+    m_allow_parens(p_flags.test(string_flags::allow_negative_parens)),
+    m_decimal_point(p_decimal_point),
+    m_thousands_sep(p_thousands_sep),
+    m_std_decimal_point
+    (   use_facet<numpunct<char> >(locale()).decimal_point()
+    )
+{
+    JEWEL_ASSERT (!m_decimal_point.IsEmpty());
+    JEWEL_ASSERT (m_decimal_point != m_thousands_sep);
+}
 
-    // TODO LOW PRIORITY Make this cleaner and more efficient.
-    Decimal::places_type const places = decimal.places();
-    Decimal::int_type const intval = decimal.intval();
-    typedef wxChar CharT;
-    static CharT const zeroc = wxChar('0');
-    wxString const decimal_point_s = loc.GetInfo
-    (   wxLOCALE_DECIMAL_POINT,
-        wxLOCALE_CAT_MONEY
-    );
-    wxString const thousands_sep_s = loc.GetInfo
-    (   wxLOCALE_THOUSANDS_SEP,
-        wxLOCALE_CAT_MONEY
+bool
+DecimalParser::parse
+(   wxString const& p_string,
+    Decimal& p_decimal,
+    size_t& p_error_position
+) const
+{
+    wxString::const_iterator begin = p_string.begin();
+    wxString::const_iterator end = p_string.end();
+    size_t position = 0;
+    while ((begin != end) && is_trimmed_space(*begin))
+    {
+        ++begin;
+        ++position;
+    }
+    while ((begin != end) && is_trimmed_space(*(end - 1)))
+    {
+        --end;
+    }
+    bool is_negated = false;
+    if
+    (   m_allow_parens &&
+        (begin != end) &&
+        (*begin == wxChar('(')) &&
+        (*(end - 1) == wxChar(')'))
+    )
+    {
+        if (begin + 1 == end)
+        {
+            p_error_position = position + 1;
+            return false;
+        }
+        is_negated = true;
+        ++begin;
+        ++position;
+        --end;
+    }
+    return parse_term
+    (   begin,
+        end,
+        position,
+        is_negated,
+        false,
+        p_decimal,
+        p_error_position
     );
-    // We will build it backwards.
-    deque<CharT> ret;
-    JEWEL_ASSERT (ret.empty());
-    // Special case of zero
-    if (dash_for_zero && (intval == 0))
+}
+
+bool
+DecimalParser::parse_simple_sum
+(   wxString const& p_string,
+    Decimal& p_decimal,
+    size_t& p_error_position
+) const
+{
+    // Each '+' or '-' begins a new term, of which it is the sign.
+    Decimal sum(0, 0);
+    wxString::const_iterator const end = p_string.end();
+    wxString::const_iterator term_begin = p_string.begin();
+    size_t term_position = 0;
+    wxString::const_iterator it = term_begin;
+    size_t position = 0;
+    while (true)
     {
-        ret.push_back(CharT('-'));
-        if (places > 0)
+        bool const is_term_end =
+        (   (it == end) ||
+            (   (it != term_begin) &&
+                ((*it == wxChar('+')) || (*it == wxChar('-')))
+            )
+        );
+        if (is_term_end)
         {
-            for (deque<CharT>::size_type i = 0; i != places; ++i)
+            Decimal term;
+            if
+            (   !parse_term
+                (   term_begin,
+                    it,
+                    term_position,
+                    false,
+                    true,
+                    term,
+                    p_error_position
+                )
+            )
             {
-                ret.push_back(CharT(' '));
+                return false;
             }
+            sum += term;
+            if (it == end)
+            {
+                break;
+            }
+            term_begin = it;
+            term_position = position;
         }
+        ++it;
+        ++position;
     }
-    else
+    p_decimal = sum;
+    return true;
+}
+
+bool
+DecimalParser::parse_term
+(   wxString::const_iterator p_begin,
+    wxString::const_iterator p_end,
+    size_t p_position,
+    bool p_is_negated,
+    bool p_ignore_spaces,
+    Decimal& p_decimal,
+    size_t& p_error_position
+) const
+{
+    wxString::const_iterator it = p_begin;
+    size_t position = p_position;
+    bool is_negative = p_is_negated;
+    bool has_sign = false;
+    if ((it != p_end) && ((*it == wxChar('-')) || (*it == wxChar('+'))))
     {
-        // Our starting point is the string of digits representing the
-        // absolute value of the underlying integer.
-        ostringstream tempstream;
-        tempstream.imbue(locale::classic());
-        wxString wxtemp;
-        if (intval == numeric_limits<Decimal::int_type>::min())
+        if (p_is_negated)
         {
-            // Special case as we can't use std::abs here without
-            // overflow.
-            tempstream << intval;
-            wxtemp = std8_to_wx(tempstream.str());
-            wxString::const_iterator it = wxtemp.begin();
-            JEWEL_ASSERT (*it == CharT('-'));
-            ++it;
-            wxtemp = wxString(it, wxtemp.end());
+            p_error_position = position;
+            return false;
         }
-        else
+        is_negative = (*it == wxChar('-'));
+        has_sign = true;
+        ++it;
+        ++position;
+    }
+    Magnitude const max_magnitude =
+        static_cast<Magnitude>(numeric_limits<Decimal::int_type>::max());
+    Magnitude magnitude = 0;
+    size_t places = 0;
+    size_t num_digits = 0;
+    bool has_decimal_point = false;
+    bool has_separator = false;
+    bool is_small = true;
+    while (it != p_end)
+    {
+        wxString::const_iterator const token_begin = it;
+        if
+        (   !m_thousands_sep.IsEmpty() &&
+            skip_token(it, p_end, m_thousands_sep)
+        )
         {
-            tempstream << std::abs(intval);
-            wxtemp = std8_to_wx(tempstream.str());
+            has_separator = true;
+            position += (it - token_begin);
+            continue;
         }
-
-        // Write the fractional part
-        wxString::reverse_iterator const rend = wxtemp.rend();
-        wxString::reverse_iterator rit = wxtemp.rbegin();
-        wxString::size_type digits_written = 0;
-        for
-        (   ;
-            (digits_written != places) && (rit != rend);
-            ++rit, ++digits_written
-        )
+        if (!has_decimal_point && skip_token(it, p_end, m_decimal_point))
         {
-            ret.push_front(*rit);
+            has_decimal_point = true;
+            position += (it - token_begin);
+            continue;
         }
-        // Deal with any "filler zerooes" required in the fractional
-        // part
-        while (digits_written != places)
+        wxUniChar const c = *it;
+        if (p_ignore_spaces && (c == wxChar(' ')))
         {
-            ret.push_front(zeroc);
-            ++digits_written;
+            // skip
         }
-        // Write the decimal point at front if required.
-        if (places != 0)
+        else if ((c >= wxChar('0')) && (c <= wxChar('9')))
         {
-            for (auto k = decimal_point_s.size(); k != 0; --k)
+            Magnitude const digit = c.GetValue() - wxChar('0');
+            ++num_digits;
+            if (has_decimal_point) ++places;
+            if (magnitude > (max_magnitude - digit) / 10)
             {
-                JEWEL_ASSERT (k >= 1);
-                ret.push_front(decimal_point_s[k - 1]);
+                is_small = false;
             }
-        }
-
-        // Write the whole part
-
-        // Assume the grouping of digits is normal "threes".
-        // TODO MEDIUM PRIORITY Is this a safe assumption? There doesn't seem to
-        // be an equivalent of grouping() for wxLocale.
-        static vector<wxString::size_type> const grouping(1, 3);
-        vector<wxString::size_type>::const_iterator grouping_it =
-            grouping.begin();
-        vector<wxString::size_type>::const_iterator last_group_datum =
-            grouping.end() - 1;
-        wxString::size_type digits_written_this_group = 0;
-        for
-        (   ;
-            rit != rend;
-            ++rit, ++digits_written, ++digits_written_this_group
-        )
-        {
-            if
-            (   digits_written_this_group ==
-                static_cast<wxString::size_type>(*grouping_it)
-            )
+            else
             {
-                // Write thousands separator at front.
-                for (auto k = thousands_sep_s.size(); k != 0; --k)
-                {
-                    JEWEL_ASSERT (k >= 1);
-                    ret.push_front(thousands_sep_s[k - 1]);
-                }
-                digits_written_this_group = 0;
-                if (grouping_it != last_group_datum) ++grouping_it;
+                magnitude = magnitude * 10 + digit;
             }
-            ret.push_front(*rit);
         }
-        // Write a leading zero if required
-        if (digits_written == places)
+        else
         {
-            ret.push_front(zeroc);
+            p_error_position = position;
+            return false;
         }
+        ++it;
+        ++position;
     }
-    // Indicate negative if required
-    if (intval < 0)
+    if (num_digits == 0)
     {
-        ret.push_front(CharT('('));
-        ret.push_back(CharT(')'));
+        // Nothing at all, or a lone minus sign, is read as zero (see
+        // wx_to_decimal(...)); but not empty parentheses.
+        bool const is_blank = !has_decimal_point && !has_separator;
+        if (is_blank && !p_is_negated && (!has_sign || is_negative))
+        {
+            p_decimal = Decimal(0, 0);
+            return true;
+        }
+        p_error_position = position;
+        return false;
+    }
+    if (!is_small || (places > Decimal::maximum_precision()))
+    {
+        p_decimal = parse_large_term
+        (   p_begin + (has_sign? 1: 0),
+            p_end,
+            is_negative,
+            p_ignore_spaces
+        );
+        return true;
     }
-    else if (pad)
+    Decimal::int_type const intval = static_cast<Decimal::int_type>(magnitude);
+    p_decimal = Decimal
+    (   is_negative? -intval: intval,
+        static_cast<Decimal::places_type>(places)
+    );
+    return true;
+}
+
+Decimal
+DecimalParser::parse_large_term
+(   wxString::const_iterator p_begin,
+    wxString::const_iterator p_end,
+    bool p_is_negative,
+    bool p_ignore_spaces
+) const
+{
+    string s;
+    if (p_is_negative) s.push_back('-');
+    wxString::const_iterator it = p_begin;
+    while (it != p_end)
     {
-        ret.push_back(CharT(' '));
+        if
+        (   !m_thousands_sep.IsEmpty() &&
+            skip_token(it, p_end, m_thousands_sep)
+        )
+        {
+            continue;
+        }
+        if (skip_token(it, p_end, m_decimal_point))
+        {
+            s.push_back(m_std_decimal_point);
+            continue;
+        }
+        if (!p_ignore_spaces || (*it != wxChar(' ')))
+        {
+            s.push_back(static_cast<char>(wxUniChar(*it).GetValue()));
+        }
+        ++it;
     }
-    wxString wret;
-    for (CharT const& elem: ret) wret.Append(elem);
-    return wret;
+    return Decimal(s);
 }
 
 jewel::Decimal
@@ -227,63 +552,29 @@ wx_to_decimal
     DecimalParsingFlags p_flags
 )
 {
-    bool const allow_parens =
-        p_flags.test(string_flags::allow_negative_parens);
-    wxs = wxs.Trim().Trim(false);  // trim both right and left.
-    typedef wxChar CharT;
-    static CharT const open_paren = wxChar('(');
-    static CharT const close_paren = wxChar(')');
-    static CharT const minus_sign = wxChar('-');
-    wxString const decimal_point_s = loc.GetInfo
-    (   wxLOCALE_DECIMAL_POINT,
-        wxLOCALE_CAT_MONEY
-    );
-    wxString const thousands_sep_s = loc.GetInfo
-    (   wxLOCALE_THOUSANDS_SEP,
-        wxLOCALE_CAT_MONEY
-    );
-    if (wxs.IsEmpty())
-    {
-        return Decimal(0, 0);
-    }
-    JEWEL_ASSERT (wxs.Len() >= 1);
-    if ((wxs.Len() == 1) && (*(wxs.begin()) == minus_sign))
-    {
-        return Decimal(0, 0);
-    }
-
-    // We first convert wxs into a canonical form in which there are no
-    // thousands separators, negativity is indicated only by a minus
-    // sign, and the decimal point is '.'.
-    if (allow_parens && (wxs[0] == open_paren) && (wxs.Last() == close_paren))
+    Decimal ret;
+    size_t error_position = 0;
+    if (!DecimalParser(loc, p_flags).parse(wxs, ret, error_position))
     {
-        wxs[0] = minus_sign;  // Replace left parenthesis with minus sign
-        wxs.RemoveLast();  // Drop right parenthesis
+        ostringstream oss;
+        oss << "Could not read number: unexpected character at position "
+            << error_position << '.';
+        JEWEL_THROW(DecimalFromStringException, oss.str().c_str());
     }
-    wxs.Replace(thousands_sep_s, wxEmptyString);
-
-    // We need to get the std::locale (not wxLocale) related decimal point
-    // character, so that we can ensure the Decimal constructor-from-string
-    // sees that appropriate decimal point character.
-    locale const gloc;  // global locale
-    char const spot_char = use_facet<numpunct<char> >(gloc).decimal_point();
-    char const spot_str[] = { spot_char, '\0' };
-    wxs.Replace(decimal_point_s, wxString(spot_str));
-
-    string const s = wx_to_std8(wxs);
-    Decimal const ret(s);
     return ret;
 }
 
 Decimal
 wx_to_simple_sum(wxString wxs, wxLocale const& loc)
 {
-    Decimal ret(0, 0);
-    auto const flags =
-        DecimalParsingFlags().clear(string_flags::allow_negative_parens);
-    for (auto const& elem: split_plus_minus(wxs))
+    Decimal ret;
+    size_t error_position = 0;
+    if (!DecimalParser(loc).parse_simple_sum(wxs, ret, error_position))
     {
-        ret += wx_to_decimal(elem, loc, flags);
+        ostringstream oss;
+        oss << "Could not read sum: unexpected character at position "
+            << error_position << '.';
+        JEWEL_THROW(DecimalFromStringException, oss.str().c_str());
     }
     return ret;
 }
@@ -16,39 +16,57 @@
 
 #include "gui/frame.hpp"
 #include "account.hpp"
+#include "account_table_iterator.hpp"
 #include "app.hpp"
 #include "date.hpp"
+#include "date_parser.hpp"
+#include "dcm_exceptions.hpp"
 #include "draft_journal.hpp"
 #include "entry.hpp"
+#include "finformat.hpp"
+#include "ledger_export.hpp"
+#include "ledger_import.hpp"
 #include "ordinary_journal.hpp"
+#include "period_close.hpp"
 #include "persistent_journal.hpp"
 #include "dcm_database_connection.hpp"
 #include "repeater.hpp"
 #include "repeater_firing_result.hpp"
 #include "string_conv.hpp"
 #include "string_flags.hpp"
+#include "warm_start_cache.hpp"
 #include "gui/account_dialog.hpp"
 #include "gui/account_list_ctrl.hpp"
+#include "gui/change_set.hpp"
 #include "gui/entry_list_ctrl.hpp"
 #include "gui/envelope_transfer_dialog.hpp"
+#include "gui/locale.hpp"
 #include "gui/persistent_object_event.hpp"
 #include "gui/top_panel.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/optional.hpp>
 #include <jewel/assert.hpp>
+#include <jewel/exception.hpp>
 #include <jewel/log.hpp>
 #include <jewel/on_windows.hpp>
 #include <jewel/version.hpp>
 #include <sqloxx/handle.hpp>
 #include <sqloxx/id.hpp>
 #include <wx/aboutdlg.h>
+#include <wx/choicdlg.h>
 #include <wx/event.h>
+#include <wx/filedlg.h>
 #include <wx/gdicmn.h>
 #include <wx/menu.h>
 #include <wx/msgdlg.h>
 #include <wx/string.h>
+#include <wx/textdlg.h>
 #include <wx/icon.h>
+#include <wx/utils.h>
 #include <wx/wupdlock.h>
 #include <wx/wx.h>
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -56,14 +74,19 @@
 
 #include "../images/icon_48_48.xpm"
 
+using boost::optional;
 using sqloxx::Handle;
 using sqloxx::Id;
 using std::endl;
+using std::ifstream;
+using std::ofstream;
 using std::ostringstream;
 using std::stable_partition;
 using std::string;
 using std::vector;
 
+namespace gregorian = boost::gregorian;
+
 namespace dcm
 {
 namespace gui
@@ -75,6 +98,18 @@ BEGIN_EVENT_TABLE(Frame, wxFrame)
         Frame::on_menu_quit
     )
     EVT_MENU
+    (   s_import_id,
+        Frame::on_menu_import
+    )
+    EVT_MENU
+    (   s_export_id,
+        Frame::on_menu_export
+    )
+    EVT_MENU
+    (   s_close_period_id,
+        Frame::on_menu_close_period
+    )
+    EVT_MENU
     (   s_new_bs_account_id,
         Frame::on_menu_new_bs_account
     )
@@ -122,6 +157,8 @@ BEGIN_EVENT_TABLE(Frame, wxFrame)
     (   wxID_ABOUT,
         Frame::on_menu_about
     )
+    EVT_IDLE(Frame::on_idle)
+    EVT_CLOSE(Frame::on_close)
     DCM_EVT_ACCOUNT_EDITING
     (   wxID_ANY,
         Frame::on_account_editing_requested
@@ -188,11 +225,56 @@ namespace
         return ret;
     }
 
+    // Ask the user to choose one of the Accounts for which p_predicate
+    // returns true, in a dialog captioned p_title. Returns a null Handle if
+    // there are no such Accounts, or if the user cancels.
+    template <typename Predicate>
+    Handle<Account> elicit_account
+    (   wxWindow* p_parent,
+        DcmDatabaseConnection& p_database_connection,
+        wxString const& p_title,
+        wxString const& p_message,
+        Predicate p_predicate
+    )
+    {
+        vector<Handle<Account> > accounts;
+        wxArrayString names;
+        AccountTableIterator it = make_type_name_ordered_account_table_iterator
+        (   p_database_connection
+        );
+        AccountTableIterator const end;
+        for ( ; it != end; ++it)
+        {
+            Handle<Account> const& account = *it;
+            if (p_predicate(account))
+            {
+                accounts.push_back(account);
+                names.Add(account->name());
+            }
+        }
+        if (accounts.empty())
+        {
+            return Handle<Account>();
+        }
+        wxSingleChoiceDialog dialog
+        (   p_parent,
+            p_message,
+            p_title,
+            names
+        );
+        if (dialog.ShowModal() != wxID_OK)
+        {
+            return Handle<Account>();
+        }
+        return accounts.at(dialog.GetSelection());
+    }
+
 }  // end anonymous namespace
 
 Frame::Frame
 (   wxString const& title,
-    DcmDatabaseConnection& p_database_connection
+    DcmDatabaseConnection& p_database_connection,
+    WarmStartCache& p_warm_start_cache
 ):
     wxFrame(0, wxID_ANY, title, wxDefaultPosition, screen_size()),
     m_database_connection(p_database_connection),
@@ -225,6 +307,22 @@ Frame::Frame
     // Configure "file" menu
     JEWEL_LOG_TRACE();
     m_file_menu->Append
+    (   s_import_id,
+        wxString("&Import transactions..."),
+        wxString("Import transactions from a CSV, OFX or QIF file")
+    );
+    m_file_menu->Append
+    (   s_export_id,
+        wxString("&Export ledger..."),
+        wxString("Export all data to a compact file for use by other tools")
+    );
+    m_file_menu->Append
+    (   s_close_period_id,
+        wxString("&Close period..."),
+        wxString("Archive old transactions and carry forward their balances")
+    );
+    m_file_menu->AppendSeparator();
+    m_file_menu->Append
     (   wxID_EXIT,
         wxString("E&xit\tAlt-X"),
         wxString("Quit this program")
@@ -327,7 +425,11 @@ Frame::Frame
         Maximize();
 #   endif
 
-    m_top_panel = new TopPanel(this, m_database_connection);
+    m_top_panel = new TopPanel
+    (   this,
+        m_database_connection,
+        p_warm_start_cache
+    );
     JEWEL_LOG_TRACE();
 }
 
@@ -341,6 +443,229 @@ Frame::on_menu_quit(wxCommandEvent& event)
     return;
 }
 
+void
+Frame::on_menu_import(wxCommandEvent& event)
+{
+    JEWEL_LOG_TRACE();
+    (void)event;  // Silence compiler warning re. unused parameter.
+    wxString const title("Import transactions");
+    wxFileDialog file_dialog
+    (   this,
+        title,
+        wxEmptyString,
+        wxEmptyString,
+        wxString
+        (   "Statement files (*.csv;*.ofx;*.qif)|*.csv;*.ofx;*.qif|"
+            "All files|*"
+        ),
+        wxFD_OPEN | wxFD_FILE_MUST_EXIST
+    );
+    if (file_dialog.ShowModal() != wxID_OK)
+    {
+        return;
+    }
+    string const filepath = wx_to_std8(file_dialog.GetPath());
+    Handle<Account> const statement_account = elicit_account
+    (   this,
+        m_database_connection,
+        title,
+        wxString("Account to which the statement relates:"),
+        [](Handle<Account> const& a)
+        {
+            return a->account_super_type() == AccountSuperType::balance_sheet;
+        }
+    );
+    if (!statement_account)
+    {
+        return;
+    }
+    Handle<Account> const balancing_account =
+        m_database_connection.balancing_account();
+    Handle<Account> const counterparty = elicit_account
+    (   this,
+        m_database_connection,
+        title,
+        wxString("Account to which imported transactions should be posted:"),
+        [&statement_account, &balancing_account](Handle<Account> const& a)
+        {
+            return (a != statement_account) && (a != balancing_account);
+        }
+    );
+    if (!counterparty)
+    {
+        return;
+    }
+    ostringstream oss;
+    try
+    {
+        ifstream stream(filepath.c_str());
+        if (!stream)
+        {
+            wxMessageBox("Could not open file.");
+            return;
+        }
+        LedgerImporter importer
+        (   m_database_connection,
+            statement_account,
+            counterparty
+        );
+        importer.set_amount_parser(DecimalParser(locale()));
+        std::size_t const num_imported = importer.import
+        (   stream,
+            import_format_from_filepath(filepath)
+        );
+        oss << num_imported << " transaction"
+            << ((num_imported == 1)? " was": "s were") << " imported.";
+        std::size_t const num_skipped = importer.num_duplicates_skipped();
+        if (num_skipped != 0)
+        {
+            oss << ' ' << num_skipped << " transaction"
+                << ((num_skipped == 1)? " was": "s were")
+                << " skipped as already recorded.";
+        }
+    }
+    catch (DcmException& e)
+    {
+        wxMessageBox
+        (   wxString("Transactions could not be imported: ") +
+            std8_to_wx(e.what())
+        );
+        return;
+    }
+    wxWindowUpdateLocker const update_locker(this);
+    JEWEL_ASSERT (m_top_panel);
+    m_top_panel->update_for_bulk_changes();
+    wxMessageBox(std8_to_wx(oss.str()));
+    return;
+}
+
+void
+Frame::on_menu_export(wxCommandEvent& event)
+{
+    JEWEL_LOG_TRACE();
+    (void)event;  // Silence compiler warning re. unused parameter.
+    wxFileDialog file_dialog
+    (   this,
+        wxString("Export ledger"),
+        wxEmptyString,
+        wxEmptyString,
+        wxString("Ledger export files (*.dcmx)|*.dcmx"),
+        wxFD_SAVE | wxFD_OVERWRITE_PROMPT
+    );
+    if (file_dialog.ShowModal() != wxID_OK)
+    {
+        return;
+    }
+    string const filepath = wx_to_std8(file_dialog.GetPath());
+    try
+    {
+        ofstream stream(filepath.c_str(), std::ios::binary);
+        if (!stream)
+        {
+            wxMessageBox("Could not open file for writing.");
+            return;
+        }
+        wxBusyCursor const busy_cursor;
+        LedgerExporter exporter(m_database_connection);
+        exporter.write(stream);
+    }
+    catch (DcmException& e)
+    {
+        wxMessageBox
+        (   wxString("Ledger could not be exported: ") +
+            std8_to_wx(e.what())
+        );
+        return;
+    }
+    return;
+}
+
+void
+Frame::on_menu_close_period(wxCommandEvent& event)
+{
+    JEWEL_LOG_TRACE();
+    (void)event;  // Silence compiler warning re. unused parameter.
+    wxTextEntryDialog date_dialog
+    (   this,
+        wxString
+        (   "Transactions dated before this date will be archived, and "
+            "replaced with a single balance carried forward for each "
+            "account. Date:"
+        ),
+        wxString("Close period"),
+        date_format_wx(today())
+    );
+    if (date_dialog.ShowModal() != wxID_OK)
+    {
+        return;
+    }
+    optional<gregorian::date> const cutoff =
+        DateParser().parse(date_dialog.GetValue(), true);
+    if (!cutoff)
+    {
+        wxMessageBox("Date not recognized.");
+        return;
+    }
+    wxFileDialog file_dialog
+    (   this,
+        wxString("Archive closed period to"),
+        wxEmptyString,
+        wxEmptyString,
+        wxString("Archive files (*.dcma)|*.dcma"),
+        wxFD_SAVE
+    );
+    if (file_dialog.ShowModal() != wxID_OK)
+    {
+        return;
+    }
+    wxString const confirmation_message =
+        wxString("Transactions dated before ") + date_format_wx(*cutoff) +
+        wxString
+        (   " will no longer be able to be viewed or edited in this file. "
+            "Continue?"
+        );
+    if (wxMessageBox(confirmation_message, "Close period", wxYES_NO) != wxYES)
+    {
+        return;
+    }
+    // Changes still pending may refer to journals that are about to be
+    // archived, so bring the display up to date for them first.
+    dispatch_pending_changes();
+    ostringstream oss;
+    try
+    {
+        wxBusyCursor const busy_cursor;
+        std::size_t const num_archived = close_period
+        (   m_database_connection,
+            *cutoff,
+            wx_to_std8(file_dialog.GetPath())
+        );
+        oss << num_archived << " transaction"
+            << ((num_archived == 1)? " was": "s were") << " archived.";
+    }
+    catch (jewel::Exception& e)
+    {
+        // As well as DcmException, this catches the sqloxx exceptions
+        // thrown if the archive file cannot be written; in any case
+        // close_period(...) leaves the database unchanged.
+        wxMessageBox
+        (   wxString("Period could not be closed: ") +
+            std8_to_wx(e.what())
+        );
+        return;
+    }
+    wxWindowUpdateLocker const update_locker(this);
+    JEWEL_ASSERT (m_top_panel);
+    m_top_panel->update_for_bulk_changes();
+
+    // Unlike after an import, the TransactionCtrl must be rebuilt, as
+    // its earliest permitted date has moved to the cutoff date, and it
+    // may be showing a transaction that has just been archived.
+    m_top_panel->configure_transaction_ctrl();
+    wxMessageBox(std8_to_wx(oss.str()));
+    return;
+}
+
 void
 Frame::on_menu_new_bs_account(wxCommandEvent& event)
 {
@@ -585,9 +910,7 @@ void
 Frame::on_account_created_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    wxWindowUpdateLocker const update_locker(this);
-    Handle<Account> const account(m_database_connection, event.po_id());
-    m_top_panel->update_for_new(account);
+    record_change(ChangeKind::account_created, event.po_id());
     return;
 }
 
@@ -595,9 +918,7 @@ void
 Frame::on_account_edited_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    wxWindowUpdateLocker const update_locker(this);
-    Handle<Account> const account(m_database_connection, event.po_id());
-    m_top_panel->update_for_amended(account);
+    record_change(ChangeKind::account_edited, event.po_id());
     return;
 }
 
@@ -605,22 +926,7 @@ void
 Frame::on_journal_created_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    wxWindowUpdateLocker const update_locker(this);
-    JEWEL_ASSERT (m_top_panel);
-    Id const journal_id = event.po_id();
-    if (journal_id_is_draft(m_database_connection, journal_id))
-    {
-        Handle<DraftJournal> const journal(m_database_connection, journal_id);
-        m_top_panel->update_for_new(journal);
-    }
-    else
-    {
-        Handle<OrdinaryJournal> const journal
-        (   m_database_connection,
-            journal_id
-        );
-        m_top_panel->update_for_new(journal);
-    }
+    record_change(ChangeKind::journal_created, event.po_id());
     return;
 }
 
@@ -628,25 +934,7 @@ void
 Frame::on_journal_edited_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    wxWindowUpdateLocker const update_locker(this);
-
-    // TODO LOW PRIORITY Factor code duplicated from
-    // on_journal_created_event(...).
-    JEWEL_ASSERT (m_top_panel);
-    Id const journal_id = event.po_id();
-    if (journal_id_is_draft(m_database_connection, journal_id))
-    {
-        Handle<DraftJournal> const journal(m_database_connection, journal_id);
-        m_top_panel->update_for_amended(journal);
-    }
-    else
-    {
-        Handle<OrdinaryJournal> const journal
-        (   m_database_connection,
-            journal_id
-        );
-        m_top_panel->update_for_amended(journal);
-    }
+    record_change(ChangeKind::journal_edited, event.po_id());
     return;
 }
 
@@ -654,9 +942,7 @@ void
 Frame::on_draft_journal_deleted_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    wxWindowUpdateLocker const update_locker(this);
-    JEWEL_ASSERT (m_top_panel);
-    m_top_panel->update_for_deleted_draft_journal(event.po_id());
+    record_change(ChangeKind::draft_journal_deleted, event.po_id());
     return;
 }
 
@@ -664,9 +950,7 @@ void
 Frame::on_ordinary_journal_deleted_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    wxWindowUpdateLocker const update_locker(this);
-    JEWEL_ASSERT (m_top_panel);
-    m_top_panel->update_for_deleted_ordinary_journal(event.po_id());
+    record_change(ChangeKind::ordinary_journal_deleted, event.po_id());
     return;
 }
 
@@ -674,16 +958,7 @@ void
 Frame::on_draft_entry_deleted_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    // TODO LOW PRIORITY The chain of functions that are now called
-    // (via m_top_panel) expect a vector. This is now just pointlessly wasteful
-    // given what we are now processing one event at a time!
-    wxWindowUpdateLocker const update_locker(this);
-    static vector<Id> doomed_ids(1, 0);
-    JEWEL_ASSERT (doomed_ids.size() == 1);
-    doomed_ids[0] = event.po_id();
-    JEWEL_ASSERT (m_top_panel);
-    m_top_panel->update_for_deleted_draft_entries(doomed_ids);
-    JEWEL_LOG_TRACE();
+    record_change(ChangeKind::draft_entry_deleted, event.po_id());
     return;
 }
 
@@ -691,15 +966,7 @@ void
 Frame::on_ordinary_entry_deleted_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    // TODO LOW PRIORITY The chain of functions that are now called
-    // (via m_top_panel) a vector. This is now just pointlessly wasteful given
-    // what we are now processing one event at a time!
-    wxWindowUpdateLocker const update_locker(this);
-    static vector<Id> doomed_ids(1, 0);
-    JEWEL_ASSERT (doomed_ids.size() == 1);
-    doomed_ids[0] = event.po_id();
-    JEWEL_ASSERT (m_top_panel);
-    m_top_panel->update_for_deleted_ordinary_entries(doomed_ids);
+    record_change(ChangeKind::ordinary_entry_deleted, event.po_id());
     return;
 }
 
@@ -707,10 +974,7 @@ void
 Frame::on_budget_edited_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
-    wxWindowUpdateLocker const update_locker(this);
-    Handle<Account> account(m_database_connection, event.po_id());
-    JEWEL_ASSERT (m_top_panel);
-    m_top_panel->update_for_amended_budget(account);
+    record_change(ChangeKind::budget_edited, event.po_id());
     return;
 }
 
@@ -718,10 +982,56 @@ void
 Frame::on_reconciliation_status_event(PersistentObjectEvent& event)
 {
     JEWEL_LOG_TRACE();
+    record_change(ChangeKind::reconciliation_status, event.po_id());
+    return;
+}
+
+void
+Frame::on_idle(wxIdleEvent& event)
+{
+    dispatch_pending_changes();
+    event.Skip();
+    return;
+}
+
+void
+Frame::on_close(wxCloseEvent& event)
+{
+    JEWEL_LOG_TRACE();
+    m_top_panel->record_warm_start_state();
+    event.Skip();  // Let the default handler destroy the Frame.
+    return;
+}
+
+void
+Frame::record_change(ChangeKind p_kind, Id p_id)
+{
+    m_pending_changes.record(p_kind, p_id);
+
+    // Make sure an idle event follows, even if the user then leaves the
+    // application alone.
+    wxWakeUpIdle();
+    return;
+}
+
+void
+Frame::dispatch_pending_changes()
+{
+    if (m_pending_changes.is_empty())
+    {
+        return;
+    }
+    JEWEL_LOG_TRACE();
+
+    // Take the pending changes out of m_pending_changes before processing
+    // them, so that any further changes notified in the course of
+    // updating the display are kept for the next dispatch.
+    ChangeSet changes;
+    using std::swap;
+    swap(changes, m_pending_changes);
     wxWindowUpdateLocker const update_locker(this);
-    Handle<Entry> const entry(m_database_connection, event.po_id());
     JEWEL_ASSERT (m_top_panel);
-    m_top_panel->update_for_reconciliation_status(entry);
+    m_top_panel->update_for_changes(changes);
     return;
 }
 
@@ -753,6 +1063,14 @@ Frame::selected_draft_journals() const
     return m_top_panel->selected_draft_journals();
 }
 
+void
+Frame::complete_startup()
+{
+    JEWEL_LOG_TRACE();
+    m_top_panel->complete_startup();
+    return;
+}
+
 void
 Frame::report_repeater_firing_results
 (   vector<RepeaterFiringResult> p_results
@@ -765,6 +1083,14 @@ Frame::report_repeater_firing_results
         return;
     }
     JEWEL_LOG_TRACE();
+
+    // bare scope
+    {
+        // The Repeaters are fired after the Frame is shown, so bring it
+        // up to date with the Journals they have recorded.
+        wxWindowUpdateLocker const update_locker(this);
+        m_top_panel->update_for_bulk_changes();
+    }
     auto const end_all = p_results.end();
     auto const end_normal = stable_partition
     (   p_results.begin(),
@@ -0,0 +1,885 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ledger_export.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/exception.hpp>
+#include <jewel/log.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <cstddef>
+#include <ios>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using jewel::Log;
+using sqloxx::SQLStatement;
+using std::istream;
+using std::make_pair;
+using std::ostream;
+using std::size_t;
+using std::string;
+using std::unordered_map;
+using std::vector;
+
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+
+namespace
+{
+    char const magic[] = "DCMLEDGR";
+    size_t const magic_size = sizeof(magic) - 1;
+    unsigned long long const format_version = 1;
+
+    // Magic, preceded by the footer offset
+    size_t const trailer_size = 8 + magic_size;
+
+    struct TableSpec
+    {
+        char const* name;
+        char const* query;
+        vector<ExportColumn> columns;
+    };
+
+    vector<TableSpec> table_specs()
+    {
+        ExportEncoding const plain = ExportEncoding::integer_plain;
+        ExportEncoding const delta = ExportEncoding::integer_delta;
+        ExportEncoding const date = ExportEncoding::date_delta;
+        ExportEncoding const dict = ExportEncoding::integer_dictionary;
+        ExportEncoding const text = ExportEncoding::text_dictionary;
+
+        // Each query must select its columns in the order in which they
+        // are listed. Rows are ordered by primary key so that SQLite can
+        // stream them without sorting.
+        vector<TableSpec> ret;
+        ret.push_back(TableSpec
+        {   "commodities",
+            "select commodity_id, abbreviation, name, "
+            "coalesce(description, ''), precision, "
+            "multiplier_to_base_intval, multiplier_to_base_places "
+            "from commodities order by commodity_id",
+            {   {"commodity_id", delta},
+                {"abbreviation", text},
+                {"name", text},
+                {"description", text},
+                {"precision", plain},
+                {"multiplier_to_base_intval", plain},
+                {"multiplier_to_base_places", plain}
+            }
+        });
+        ret.push_back(TableSpec
+        {   "accounts",
+            "select account_id, account_type_id, name, "
+            "coalesce(description, ''), coalesce(commodity_id, 0), "
+            "coalesce(visibility_id, 0) "
+            "from accounts order by account_id",
+            {   {"account_id", delta},
+                {"account_type_id", dict},
+                {"name", text},
+                {"description", text},
+                {"commodity_id", dict},
+                {"visibility_id", dict}
+            }
+        });
+        ret.push_back(TableSpec
+        {   "ordinary_journals",
+            "select journal_id, date, transaction_type_id, "
+            "coalesce(comment, '') "
+            "from journals join ordinary_journal_detail using(journal_id) "
+            "order by journal_id",
+            {   {"journal_id", delta},
+                {"date", date},
+                {"transaction_type_id", dict},
+                {"comment", text}
+            }
+        });
+        ret.push_back(TableSpec
+        {   "draft_journals",
+            "select journal_id, name, transaction_type_id, "
+            "coalesce(comment, '') "
+            "from journals join draft_journal_detail using(journal_id) "
+            "order by journal_id",
+            {   {"journal_id", delta},
+                {"name", text},
+                {"transaction_type_id", dict},
+                {"comment", text}
+            }
+        });
+        ret.push_back(TableSpec
+        {   "entries",
+            "select entry_id, journal_id, account_id, amount, "
+            "is_reconciled, transaction_side_id, coalesce(comment, '') "
+            "from entries order by entry_id",
+            {   {"entry_id", delta},
+                {"journal_id", delta},
+                {"account_id", dict},
+                {"amount", plain},
+                {"is_reconciled", dict},
+                {"transaction_side_id", dict},
+                {"comment", text}
+            }
+        });
+        ret.push_back(TableSpec
+        {   "repeaters",
+            "select repeater_id, journal_id, interval_type_id, "
+            "interval_units, next_date "
+            "from repeaters order by repeater_id",
+            {   {"repeater_id", delta},
+                {"journal_id", delta},
+                {"interval_type_id", dict},
+                {"interval_units", plain},
+                {"next_date", date}
+            }
+        });
+        ret.push_back(TableSpec
+        {   "budget_items",
+            "select budget_item_id, account_id, coalesce(description, ''), "
+            "interval_units, interval_type_id, amount "
+            "from budget_items order by budget_item_id",
+            {   {"budget_item_id", delta},
+                {"account_id", dict},
+                {"description", text},
+                {"interval_units", plain},
+                {"interval_type_id", dict},
+                {"amount", plain}
+            }
+        });
+        return ret;
+    }
+
+    // Zigzag encoding maps signed integers of small magnitude to small
+    // unsigned integers: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+    // Arithmetic is done on unsigned values so that deltas wrap rather
+    // than overflow.
+    unsigned long long zigzag(unsigned long long p_value)
+    {
+        return (p_value << 1) ^ (0 - (p_value >> 63));
+    }
+
+    unsigned long long unzigzag(unsigned long long p_value)
+    {
+        return (p_value >> 1) ^ (0 - (p_value & 1));
+    }
+
+    void append_varint(string& p_out, unsigned long long p_value)
+    {
+        while (p_value >= 0x80)
+        {
+            p_out += static_cast<char>((p_value & 0x7F) | 0x80);
+            p_value >>= 7;
+        }
+        p_out += static_cast<char>(p_value);
+        return;
+    }
+
+    void append_text(string& p_out, string const& p_text)
+    {
+        append_varint(p_out, p_text.size());
+        p_out += p_text;
+        return;
+    }
+
+    void append_fixed64(string& p_out, unsigned long long p_value)
+    {
+        for (int i = 0; i != 8; ++i)
+        {
+            p_out += static_cast<char>((p_value >> (8 * i)) & 0xFF);
+        }
+        return;
+    }
+
+    /**
+     * Decodes values from a range of bytes, checking each read against
+     * the end of the range, so that a corrupt or truncated file results
+     * in an exception rather than undefined behaviour.
+     */
+    class ByteReader
+    {
+    public:
+        ByteReader(char const* p_begin, char const* p_end):
+            m_pos(p_begin),
+            m_end(p_end)
+        {
+        }
+        bool at_end() const
+        {
+            return m_pos == m_end;
+        }
+        size_t remaining() const
+        {
+            return static_cast<size_t>(m_end - m_pos);
+        }
+        unsigned long long varint()
+        {
+            unsigned long long ret = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                check(1);
+                unsigned char const byte = static_cast<unsigned char>(*m_pos);
+                ++m_pos;
+                ret |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return ret;
+                }
+            }
+            JEWEL_THROW(LedgerExportException, "Malformed varint.");
+        }
+        size_t size()
+        {
+            unsigned long long const ret = varint();
+            if (ret > remaining())
+            {
+                // No valid count or length can exceed the number of bytes
+                // left, as each item occupies at least one byte.
+                JEWEL_THROW(LedgerExportException, "Malformed export.");
+            }
+            return static_cast<size_t>(ret);
+        }
+        string raw(size_t p_length)
+        {
+            check(p_length);
+            string const ret(m_pos, m_pos + p_length);
+            m_pos += p_length;
+            return ret;
+        }
+        string text()
+        {
+            return raw(size());
+        }
+        unsigned long long fixed64()
+        {
+            check(8);
+            unsigned long long ret = 0;
+            for (int i = 0; i != 8; ++i)
+            {
+                unsigned char const byte = static_cast<unsigned char>(*m_pos);
+                ret |= static_cast<unsigned long long>(byte) << (8 * i);
+                ++m_pos;
+            }
+            return ret;
+        }
+        ByteReader sub_reader(size_t p_length)
+        {
+            check(p_length);
+            ByteReader const ret(m_pos, m_pos + p_length);
+            m_pos += p_length;
+            return ret;
+        }
+    private:
+        void check(size_t p_length) const
+        {
+            if (p_length > remaining())
+            {
+                JEWEL_THROW(LedgerExportException, "Truncated export.");
+            }
+            return;
+        }
+        char const* m_pos;
+        char const* m_end;
+    };
+
+    ByteReader buffer_reader(vector<char> const& p_buffer)
+    {
+        return ByteReader(p_buffer.data(), p_buffer.data() + p_buffer.size());
+    }
+
+    void encode_integers
+    (   ExportEncoding p_encoding,
+        vector<long long> const& p_values,
+        string& p_out
+    )
+    {
+        switch (p_encoding)
+        {
+        case ExportEncoding::integer_plain:
+            for (long long value: p_values)
+            {
+                append_varint(p_out, zigzag(value));
+            }
+            break;
+        case ExportEncoding::integer_delta:  // fall through
+        case ExportEncoding::date_delta:
+            {
+                unsigned long long previous = 0;
+                for (long long value: p_values)
+                {
+                    unsigned long long const current = value;
+                    append_varint(p_out, zigzag(current - previous));
+                    previous = current;
+                }
+            }
+            break;
+        case ExportEncoding::integer_dictionary:
+            {
+                unordered_map<long long, size_t> indices;
+                vector<long long> dictionary;
+                string index_data;
+                for (long long value: p_values)
+                {
+                    auto const result =
+                        indices.insert(make_pair(value, indices.size()));
+                    if (result.second) dictionary.push_back(value);
+                    append_varint(index_data, result.first->second);
+                }
+                append_varint(p_out, dictionary.size());
+                for (long long value: dictionary)
+                {
+                    append_varint(p_out, zigzag(value));
+                }
+                p_out += index_data;
+            }
+            break;
+        default:
+            JEWEL_HARD_ASSERT (false);
+        }
+        return;
+    }
+
+    void encode_texts(vector<string> const& p_values, string& p_out)
+    {
+        unordered_map<string, size_t> indices;
+        vector<string const*> dictionary;
+        string index_data;
+        for (string const& value: p_values)
+        {
+            auto const result =
+                indices.insert(make_pair(value, indices.size()));
+            if (result.second) dictionary.push_back(&result.first->first);
+            append_varint(index_data, result.first->second);
+        }
+        append_varint(p_out, dictionary.size());
+        for (string const* value: dictionary)
+        {
+            append_text(p_out, *value);
+        }
+        p_out += index_data;
+        return;
+    }
+
+    void decode_integers
+    (   ExportEncoding p_encoding,
+        ByteReader& p_reader,
+        size_t p_num_rows,
+        vector<long long>& p_values
+    )
+    {
+        p_values.clear();
+        switch (p_encoding)
+        {
+        case ExportEncoding::integer_plain:
+            for (size_t i = 0; i != p_num_rows; ++i)
+            {
+                p_values.push_back(unzigzag(p_reader.varint()));
+            }
+            break;
+        case ExportEncoding::integer_delta:  // fall through
+        case ExportEncoding::date_delta:
+            {
+                unsigned long long current = 0;
+                for (size_t i = 0; i != p_num_rows; ++i)
+                {
+                    current += unzigzag(p_reader.varint());
+                    p_values.push_back(current);
+                }
+            }
+            break;
+        case ExportEncoding::integer_dictionary:
+            {
+                vector<long long> dictionary(p_reader.size());
+                for (long long& value: dictionary)
+                {
+                    value = unzigzag(p_reader.varint());
+                }
+                for (size_t i = 0; i != p_num_rows; ++i)
+                {
+                    unsigned long long const index = p_reader.varint();
+                    if (index >= dictionary.size())
+                    {
+                        JEWEL_THROW
+                        (   LedgerExportException,
+                            "Dictionary index out of range."
+                        );
+                    }
+                    p_values.push_back(dictionary[index]);
+                }
+            }
+            break;
+        default:
+            JEWEL_HARD_ASSERT (false);
+        }
+        return;
+    }
+
+    void decode_texts
+    (   ByteReader& p_reader,
+        size_t p_num_rows,
+        vector<string>& p_values
+    )
+    {
+        p_values.clear();
+        vector<string> dictionary(p_reader.size());
+        for (string& value: dictionary)
+        {
+            value = p_reader.text();
+        }
+        for (size_t i = 0; i != p_num_rows; ++i)
+        {
+            unsigned long long const index = p_reader.varint();
+            if (index >= dictionary.size())
+            {
+                JEWEL_THROW
+                (   LedgerExportException,
+                    "Dictionary index out of range."
+                );
+            }
+            p_values.push_back(dictionary[index]);
+        }
+        return;
+    }
+
+    void write_csv_field(ostream& p_stream, string const& p_field)
+    {
+        // As per RFC 4180
+        if (p_field.find_first_of(",\"\r\n") == string::npos)
+        {
+            p_stream << p_field;
+            return;
+        }
+        p_stream << '"';
+        for (char c: p_field)
+        {
+            if (c == '"') p_stream << '"';
+            p_stream << c;
+        }
+        p_stream << '"';
+        return;
+    }
+
+    void reset(ExportBlock& p_block, size_t p_num_columns)
+    {
+        p_block.num_rows = 0;
+        p_block.integers.resize(p_num_columns);
+        p_block.texts.resize(p_num_columns);
+        for (size_t i = 0; i != p_num_columns; ++i)
+        {
+            p_block.integers[i].clear();
+            p_block.texts[i].clear();
+        }
+        return;
+    }
+
+}  // end anonymous namespace
+
+
+bool
+is_text(ExportEncoding p_encoding)
+{
+    return p_encoding == ExportEncoding::text_dictionary;
+}
+
+
+LedgerExporter::LedgerExporter
+(   DcmDatabaseConnection& p_database_connection
+):
+    m_database_connection(p_database_connection)
+{
+}
+
+LedgerExporter::~LedgerExporter()
+{
+}
+
+size_t
+LedgerExporter::block_size()
+{
+    return 4096;
+}
+
+size_t
+LedgerExporter::write(ostream& p_stream)
+{
+    JEWEL_LOG_TRACE();
+    unsigned long long offset = 0;
+    auto const put = [&p_stream, &offset](string const& p_bytes)
+    {
+        p_stream.write(p_bytes.data(), p_bytes.size());
+        offset += p_bytes.size();
+    };
+
+    string bytes(magic, magic_size);
+    append_varint(bytes, format_version);
+    put(bytes);
+
+    size_t ret = 0;
+    vector<ExportTableInfo> tables;
+    vector<TableSpec> const specs = table_specs();
+    for (TableSpec const& spec: specs)
+    {
+        ExportTableInfo table;
+        table.name = spec.name;
+        table.columns = spec.columns;
+        table.num_rows = 0;
+        size_t const num_columns = spec.columns.size();
+        ExportBlock block;
+        reset(block, num_columns);
+
+        auto const flush = [&]() -> void
+        {
+            if (block.num_rows == 0)
+            {
+                return;
+            }
+            bytes.clear();
+            append_varint(bytes, block.num_rows);
+            string data;
+            for (size_t i = 0; i != num_columns; ++i)
+            {
+                data.clear();
+                ExportEncoding const encoding = spec.columns[i].encoding;
+                if (is_text(encoding))
+                {
+                    encode_texts(block.texts[i], data);
+                }
+                else
+                {
+                    encode_integers(encoding, block.integers[i], data);
+                }
+                append_varint(bytes, data.size());
+                bytes += data;
+            }
+            ExportBlockInfo const block_info =
+                {   offset,
+                    bytes.size(),
+                    block.num_rows
+                };
+            table.blocks.push_back(block_info);
+            put(bytes);
+            reset(block, num_columns);
+        };
+
+        SQLStatement statement(m_database_connection, spec.query);
+        while (statement.step())
+        {
+            for (size_t i = 0; i != num_columns; ++i)
+            {
+                int const index = static_cast<int>(i);
+                if (is_text(spec.columns[i].encoding))
+                {
+                    block.texts[i].push_back(statement.extract<string>(index));
+                }
+                else
+                {
+                    block.integers[i].push_back
+                    (   statement.extract<long long>(index)
+                    );
+                }
+            }
+            ++block.num_rows;
+            ++table.num_rows;
+            if (block.num_rows == block_size())
+            {
+                flush();
+            }
+        }
+        flush();
+        ret += table.num_rows;
+        tables.push_back(table);
+    }
+
+    unsigned long long const footer_offset = offset;
+    bytes.clear();
+    append_varint(bytes, tables.size());
+    for (ExportTableInfo const& table: tables)
+    {
+        append_text(bytes, table.name);
+        append_varint(bytes, table.columns.size());
+        for (ExportColumn const& column: table.columns)
+        {
+            append_text(bytes, column.name);
+            append_varint(bytes, static_cast<unsigned int>(column.encoding));
+        }
+        append_varint(bytes, table.num_rows);
+        append_varint(bytes, table.blocks.size());
+        for (ExportBlockInfo const& block: table.blocks)
+        {
+            append_varint(bytes, block.offset);
+            append_varint(bytes, block.size);
+            append_varint(bytes, block.num_rows);
+        }
+    }
+    append_fixed64(bytes, footer_offset);
+    bytes.append(magic, magic_size);
+    put(bytes);
+    p_stream.flush();
+    if (!p_stream)
+    {
+        JEWEL_THROW(LedgerExportException, "Error writing ledger export.");
+    }
+    JEWEL_LOG_VALUE(Log::info, ret);
+    return ret;
+}
+
+
+LedgerExportReader::LedgerExportReader(istream& p_stream):
+    m_stream(p_stream)
+{
+    JEWEL_LOG_TRACE();
+    m_stream.seekg(0, std::ios::end);
+    istream::pos_type const end_pos = m_stream.tellg();
+    if (!m_stream || (end_pos < 0))
+    {
+        JEWEL_THROW(LedgerExportException, "Error reading ledger export.");
+    }
+    unsigned long long const file_size =
+        static_cast<std::streamoff>(end_pos);
+    unsigned long long const header_size = magic_size + 1;
+    if (file_size < header_size + trailer_size)
+    {
+        JEWEL_THROW(LedgerExportException, "Not a ledger export.");
+    }
+    read_range(0, header_size);
+    ByteReader header = buffer_reader(m_buffer);
+    if (header.raw(magic_size) != magic)
+    {
+        JEWEL_THROW(LedgerExportException, "Not a ledger export.");
+    }
+    if (header.varint() != format_version)
+    {
+        JEWEL_THROW
+        (   LedgerExportException,
+            "Ledger export was written by an unsupported version of the "
+            "application."
+        );
+    }
+    unsigned long long const footer_end = file_size - trailer_size;
+    read_range(footer_end, trailer_size);
+    ByteReader trailer = buffer_reader(m_buffer);
+    unsigned long long const footer_offset = trailer.fixed64();
+    if
+    (   (trailer.raw(magic_size) != magic) ||
+        (footer_offset < header_size) ||
+        (footer_offset > footer_end)
+    )
+    {
+        JEWEL_THROW(LedgerExportException, "Malformed ledger export.");
+    }
+
+    read_range(footer_offset, footer_end - footer_offset);
+    ByteReader footer = buffer_reader(m_buffer);
+    vector<ExportTableInfo> tables(footer.size());
+    for (ExportTableInfo& table: tables)
+    {
+        table.name = footer.text();
+        table.columns.resize(footer.size());
+        for (ExportColumn& column: table.columns)
+        {
+            column.name = footer.text();
+            unsigned long long const encoding = footer.varint();
+            if
+            (   encoding >=
+                static_cast<unsigned int>(ExportEncoding::num_export_encodings)
+            )
+            {
+                JEWEL_THROW(LedgerExportException, "Unknown encoding.");
+            }
+            column.encoding = static_cast<ExportEncoding>(encoding);
+        }
+        table.num_rows = footer.varint();
+        table.blocks.resize(footer.size());
+        size_t num_rows = 0;
+        for (ExportBlockInfo& block: table.blocks)
+        {
+            block.offset = footer.varint();
+            block.size = footer.varint();
+            block.num_rows = footer.varint();
+            if
+            (   (block.offset < header_size) ||
+                (block.offset > footer_offset) ||
+                (block.size > footer_offset - block.offset)
+            )
+            {
+                JEWEL_THROW(LedgerExportException, "Malformed ledger export.");
+            }
+            num_rows += block.num_rows;
+        }
+        if (num_rows != table.num_rows)
+        {
+            JEWEL_THROW(LedgerExportException, "Malformed ledger export.");
+        }
+    }
+    if (!footer.at_end())
+    {
+        JEWEL_THROW(LedgerExportException, "Malformed ledger export.");
+    }
+    using std::swap;
+    swap(m_tables, tables);
+}
+
+LedgerExportReader::~LedgerExportReader()
+{
+}
+
+vector<ExportTableInfo> const&
+LedgerExportReader::tables() const
+{
+    return m_tables;
+}
+
+ExportTableInfo const&
+LedgerExportReader::table(string const& p_table_name) const
+{
+    for (ExportTableInfo const& table: m_tables)
+    {
+        if (table.name == p_table_name)
+        {
+            return table;
+        }
+    }
+    JEWEL_THROW
+    (   LedgerExportException,
+        "There is no table with this name in the ledger export."
+    );
+}
+
+void
+LedgerExportReader::read_block
+(   ExportTableInfo const& p_table,
+    size_t p_block_index,
+    ExportBlock& p_block
+)
+{
+    if (p_block_index >= p_table.blocks.size())
+    {
+        JEWEL_THROW(LedgerExportException, "Block index out of range.");
+    }
+    ExportBlockInfo const& block_info = p_table.blocks[p_block_index];
+    read_range(block_info.offset, block_info.size);
+    ByteReader reader = buffer_reader(m_buffer);
+    if (reader.varint() != block_info.num_rows)
+    {
+        JEWEL_THROW(LedgerExportException, "Malformed block.");
+    }
+    size_t const num_columns = p_table.columns.size();
+    reset(p_block, num_columns);
+    for (size_t i = 0; i != num_columns; ++i)
+    {
+        ByteReader column_reader = reader.sub_reader(reader.size());
+        ExportEncoding const encoding = p_table.columns[i].encoding;
+        if (is_text(encoding))
+        {
+            decode_texts(column_reader, block_info.num_rows, p_block.texts[i]);
+        }
+        else
+        {
+            decode_integers
+            (   encoding,
+                column_reader,
+                block_info.num_rows,
+                p_block.integers[i]
+            );
+        }
+        if (!column_reader.at_end())
+        {
+            JEWEL_THROW(LedgerExportException, "Malformed block.");
+        }
+    }
+    if (!reader.at_end())
+    {
+        JEWEL_THROW(LedgerExportException, "Malformed block.");
+    }
+    p_block.num_rows = block_info.num_rows;
+    return;
+}
+
+void
+LedgerExportReader::write_csv(string const& p_table_name, ostream& p_stream)
+{
+    JEWEL_LOG_TRACE();
+    ExportTableInfo const& info = table(p_table_name);
+    size_t const num_columns = info.columns.size();
+    for (size_t i = 0; i != num_columns; ++i)
+    {
+        if (i != 0) p_stream << ',';
+        write_csv_field(p_stream, info.columns[i].name);
+    }
+    p_stream << "\r\n";
+    ExportBlock block;
+    for (size_t j = 0; j != info.blocks.size(); ++j)
+    {
+        read_block(info, j, block);
+        for (size_t row = 0; row != block.num_rows; ++row)
+        {
+            for (size_t i = 0; i != num_columns; ++i)
+            {
+                if (i != 0) p_stream << ',';
+                ExportEncoding const encoding = info.columns[i].encoding;
+                if (is_text(encoding))
+                {
+                    write_csv_field(p_stream, block.texts[i][row]);
+                    continue;
+                }
+                long long const value = block.integers[i][row];
+                if
+                (   (encoding == ExportEncoding::date_delta) &&
+                    (value >= earliest_date_rep()) &&
+                    (value <= latest_date_rep())
+                )
+                {
+                    p_stream << gregorian::to_iso_extended_string
+                    (   boost_date_from_julian_int(static_cast<DateRep>(value))
+                    );
+                }
+                else
+                {
+                    p_stream << value;
+                }
+            }
+            p_stream << "\r\n";
+        }
+    }
+    if (!p_stream)
+    {
+        JEWEL_THROW(LedgerExportException, "Error writing CSV.");
+    }
+    return;
+}
+
+void
+LedgerExportReader::read_range(unsigned long long p_offset, size_t p_size)
+{
+    m_buffer.resize(p_size);
+    m_stream.clear();
+    m_stream.seekg(static_cast<std::streamoff>(p_offset));
+    m_stream.read(m_buffer.data(), p_size);
+    if (!m_stream)
+    {
+        JEWEL_THROW(LedgerExportException, "Error reading ledger export.");
+    }
+    return;
+}
+
+}  // namespace dcm
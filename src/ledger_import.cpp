@@ -0,0 +1,1064 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ledger_import.hpp"
+#include "account.hpp"
+#include "commodity.hpp"
+#include "date.hpp"
+#include "date_parser.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include "entry_fingerprint_index.hpp"
+#include "finformat.hpp"
+#include "ledger_snapshot.hpp"
+#include "string_conv.hpp"
+#include "transaction_side.hpp"
+#include "transaction_type.hpp"
+#include <boost/algorithm/string.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/decimal.hpp>
+#include <jewel/log.hpp>
+#include <sqloxx/database_transaction.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/next_auto_key.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <wx/string.h>
+#include <cctype>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using boost::optional;
+using jewel::Decimal;
+using jewel::DecimalAdditionException;
+using jewel::DecimalException;
+using jewel::Log;
+using sqloxx::DatabaseTransaction;
+using sqloxx::Handle;
+using sqloxx::Id;
+using sqloxx::next_auto_key;
+using sqloxx::SQLStatement;
+using std::istream;
+using std::make_pair;
+using std::ostringstream;
+using std::out_of_range;
+using std::pair;
+using std::size_t;
+using std::string;
+using std::unique_ptr;
+using std::unordered_map;
+using std::vector;
+
+namespace algorithm = boost::algorithm;
+namespace filesystem = boost::filesystem;
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+
+namespace
+{
+    bool is_digits(string const& p_string, size_t p_begin, size_t p_end)
+    {
+        JEWEL_ASSERT (p_end <= p_string.size());
+        for (size_t i = p_begin; i != p_end; ++i)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(p_string[i])))
+            {
+                return false;
+            }
+        }
+        return p_begin != p_end;
+    }
+
+    int to_int(string const& p_string, size_t p_begin, size_t p_end)
+    {
+        JEWEL_ASSERT (is_digits(p_string, p_begin, p_end));
+        int ret = 0;
+        for (size_t i = p_begin; i != p_end; ++i)
+        {
+            ret = ret * 10 + (p_string[i] - '0');
+        }
+        return ret;
+    }
+
+    // Returns an initialized optional if p_string is a date in "YYYY-MM-DD"
+    // or "YYYYMMDD" form, which are by far the commonest in bank exports,
+    // and which we can parse much more cheaply than DateParser can.
+    optional<gregorian::date> maybe_iso_date(string const& p_string)
+    {
+        optional<gregorian::date> ret;
+        int year = 0;
+        int month = 0;
+        int day = 0;
+        if
+        (   (p_string.size() == 10) &&
+            (p_string[4] == '-') &&
+            (p_string[7] == '-') &&
+            is_digits(p_string, 0, 4) &&
+            is_digits(p_string, 5, 7) &&
+            is_digits(p_string, 8, 10)
+        )
+        {
+            year = to_int(p_string, 0, 4);
+            month = to_int(p_string, 5, 7);
+            day = to_int(p_string, 8, 10);
+        }
+        else if ((p_string.size() == 8) && is_digits(p_string, 0, 8))
+        {
+            year = to_int(p_string, 0, 4);
+            month = to_int(p_string, 4, 6);
+            day = to_int(p_string, 6, 8);
+        }
+        else
+        {
+            return ret;
+        }
+        try
+        {
+            ret = gregorian::date(year, month, day);
+        }
+        catch (out_of_range&)
+        {
+            // leave ret uninitialized
+        }
+        return ret;
+    }
+
+    // Decode the handful of character entities likely to appear in OFX text.
+    string decode_entities(string p_string)
+    {
+        if (p_string.find('&') == string::npos)
+        {
+            return p_string;
+        }
+        algorithm::replace_all(p_string, "&lt;", "<");
+        algorithm::replace_all(p_string, "&gt;", ">");
+        algorithm::replace_all(p_string, "&quot;", "\"");
+        algorithm::replace_all(p_string, "&apos;", "'");
+        algorithm::replace_all(p_string, "&amp;", "&");
+        return p_string;
+    }
+
+    wxString join_description(string const& p_first, string const& p_second)
+    {
+        if (p_first.empty() || (p_first == p_second))
+        {
+            return std8_to_wx(p_second);
+        }
+        if (p_second.empty())
+        {
+            return std8_to_wx(p_first);
+        }
+        return std8_to_wx(p_first + " - " + p_second);
+    }
+
+
+    class CsvRecordReader: public ImportRecordReader
+    {
+    public:
+        explicit CsvRecordReader(istream& p_stream):
+            ImportRecordReader(p_stream),
+            m_at_start(true)
+        {
+        }
+
+        CsvRecordReader(CsvRecordReader const&) = delete;
+        CsvRecordReader(CsvRecordReader&&) = delete;
+        CsvRecordReader& operator=(CsvRecordReader const&) = delete;
+        CsvRecordReader& operator=(CsvRecordReader&&) = delete;
+        virtual ~CsvRecordReader() = default;
+
+    private:
+        bool do_read(ImportRecord& p_record) override
+        {
+            while (next_row())
+            {
+                if ((m_fields.size() == 1) && m_fields[0].empty())
+                {
+                    continue;  // blank line
+                }
+                if ((m_fields.size() != 3) && (m_fields.size() != 4))
+                {
+                    JEWEL_THROW
+                    (   LedgerImportException,
+                        parsing_error_message
+                        (   "CSV row does not have 3 or 4 fields."
+                        ).c_str()
+                    );
+                }
+                if (m_at_start)
+                {
+                    m_at_start = false;
+                    if (is_header_row()) continue;
+                }
+                p_record.date = parse_date(m_fields[0]);
+                p_record.description = std8_to_wx(m_fields[1]);
+                if (m_fields.size() == 3)
+                {
+                    p_record.amount = parse_amount(m_fields[2]);
+                }
+                else
+                {
+                    JEWEL_ASSERT (m_fields.size() == 4);
+                    Decimal const zero(0, 0);
+                    // Some banks sign their withdrawals and some don't.
+                    Decimal withdrawal =
+                    (   m_fields[2].empty()? zero: parse_amount(m_fields[2])
+                    );
+                    if (withdrawal < zero) withdrawal = -withdrawal;
+                    Decimal const deposit =
+                    (   m_fields[3].empty()? zero: parse_amount(m_fields[3])
+                    );
+                    p_record.amount = deposit - withdrawal;
+                }
+                return true;
+            }
+            return false;
+        }
+
+        // A header row is one in which the first field is not a date.
+        bool is_header_row()
+        {
+            try
+            {
+                parse_date(m_fields[0]);
+                return false;
+            }
+            catch (LedgerImportException&)
+            {
+                return true;
+            }
+        }
+
+        // Split the next row into m_fields, as per RFC 4180. A quoted field
+        // may span several lines.
+        bool next_row()
+        {
+            if (!next_line(m_line))
+            {
+                return false;
+            }
+            m_fields.clear();
+            m_fields.push_back(string());
+            bool in_quotes = false;
+            size_t i = 0;
+            while (true)
+            {
+                if (i == m_line.size())
+                {
+                    if (!in_quotes)
+                    {
+                        break;
+                    }
+                    if (!next_line(m_line))
+                    {
+                        JEWEL_THROW
+                        (   LedgerImportException,
+                            parsing_error_message
+                            (   "Unterminated quoted field in CSV."
+                            ).c_str()
+                        );
+                    }
+                    m_fields.back() += '\n';
+                    i = 0;
+                    continue;
+                }
+                char const c = m_line[i++];
+                if (in_quotes)
+                {
+                    if (c != '"')
+                    {
+                        m_fields.back() += c;
+                    }
+                    else if ((i < m_line.size()) && (m_line[i] == '"'))
+                    {
+                        m_fields.back() += '"';  // escaped quote
+                        ++i;
+                    }
+                    else
+                    {
+                        in_quotes = false;
+                    }
+                }
+                else if (c == '"')
+                {
+                    in_quotes = true;
+                }
+                else if (c == ',')
+                {
+                    m_fields.push_back(string());
+                }
+                else
+                {
+                    m_fields.back() += c;
+                }
+            }
+            for (string& field: m_fields) algorithm::trim(field);
+            return true;
+        }
+
+        bool m_at_start;
+        string m_line;
+        vector<string> m_fields;
+
+    };  // class CsvRecordReader
+
+
+    class OfxRecordReader: public ImportRecordReader
+    {
+    public:
+        explicit OfxRecordReader(istream& p_stream):
+            ImportRecordReader(p_stream),
+            m_position(0)
+        {
+        }
+
+        OfxRecordReader(OfxRecordReader const&) = delete;
+        OfxRecordReader(OfxRecordReader&&) = delete;
+        OfxRecordReader& operator=(OfxRecordReader const&) = delete;
+        OfxRecordReader& operator=(OfxRecordReader&&) = delete;
+        virtual ~OfxRecordReader() = default;
+
+    private:
+        bool do_read(ImportRecord& p_record) override
+        {
+            string tag;
+            string text;
+
+            // Find the start of the next transaction.
+            do
+            {
+                if (!next_element(tag, text)) return false;
+            }
+            while (tag != "STMTTRN");
+
+            string date_posted;
+            string amount;
+            string name;
+            string memo;
+            while (true)
+            {
+                if (!next_element(tag, text))
+                {
+                    JEWEL_THROW
+                    (   LedgerImportException,
+                        parsing_error_message
+                        (   "Unterminated STMTTRN aggregate in OFX."
+                        ).c_str()
+                    );
+                }
+                if (tag == "/STMTTRN") break;
+                if (tag == "DTPOSTED") date_posted = text;
+                else if (tag == "TRNAMT") amount = text;
+                else if (tag == "NAME") name = decode_entities(text);
+                else if (tag == "MEMO") memo = decode_entities(text);
+            }
+            if (date_posted.size() < 8 || amount.empty())
+            {
+                JEWEL_THROW
+                (   LedgerImportException,
+                    parsing_error_message
+                    (   "OFX transaction lacks DTPOSTED or TRNAMT."
+                    ).c_str()
+                );
+            }
+            // DTPOSTED may carry a time and time zone after the date.
+            p_record.date = parse_date(date_posted.substr(0, 8));
+            p_record.amount = parse_amount(amount);
+            p_record.description = join_description(name, memo);
+            return true;
+        }
+
+        // Reads the next tag, and any text following it up to the next tag,
+        // into p_tag (upper-cased) and p_text (trimmed).
+        bool next_element(string& p_tag, string& p_text)
+        {
+            size_t open = string::npos;
+            while
+            (   (open = m_line.find('<', m_position)) ==
+                string::npos
+            )
+            {
+                if (!next_line(m_line)) return false;
+                m_position = 0;
+            }
+            size_t const close = m_line.find('>', open);
+            if (close == string::npos)
+            {
+                JEWEL_THROW
+                (   LedgerImportException,
+                    parsing_error_message("Unterminated tag in OFX.").c_str()
+                );
+            }
+            p_tag = m_line.substr(open + 1, close - open - 1);
+            algorithm::trim(p_tag);
+            algorithm::to_upper(p_tag);
+            size_t const next_open = m_line.find('<', close);
+            m_position =
+                ((next_open == string::npos)? m_line.size(): next_open);
+            p_text = m_line.substr(close + 1, m_position - close - 1);
+            algorithm::trim(p_text);
+            return true;
+        }
+
+        string m_line;
+        size_t m_position;
+
+    };  // class OfxRecordReader
+
+
+    class QifRecordReader: public ImportRecordReader
+    {
+    public:
+        explicit QifRecordReader(istream& p_stream):
+            ImportRecordReader(p_stream)
+        {
+        }
+
+        QifRecordReader(QifRecordReader const&) = delete;
+        QifRecordReader(QifRecordReader&&) = delete;
+        QifRecordReader& operator=(QifRecordReader const&) = delete;
+        QifRecordReader& operator=(QifRecordReader&&) = delete;
+        virtual ~QifRecordReader() = default;
+
+    private:
+        bool do_read(ImportRecord& p_record) override
+        {
+            optional<gregorian::date> date;
+            optional<Decimal> amount;
+            string payee;
+            string memo;
+            bool started = false;
+            while (next_line(m_line))
+            {
+                algorithm::trim(m_line);
+                if (m_line.empty() || (m_line[0] == '!'))
+                {
+                    continue;
+                }
+                char const code = m_line[0];
+                string const rest = m_line.substr(1);
+                started = true;
+                switch (code)
+                {
+                case 'D':
+                    date = parse_date(normalized_qif_date(rest));
+                    break;
+                case 'T':  // fall through
+                case 'U':
+                    amount = parse_amount(rest);
+                    break;
+                case 'P':
+                    payee = rest;
+                    break;
+                case 'M':
+                    memo = rest;
+                    break;
+                case '^':
+                    return finish(p_record, date, amount, payee, memo);
+                default:
+                    ;  // other fields are not relevant
+                }
+            }
+            // Tolerate a final record lacking its terminating '^'.
+            return started && finish(p_record, date, amount, payee, memo);
+        }
+
+        bool finish
+        (   ImportRecord& p_record,
+            optional<gregorian::date> const& p_date,
+            optional<Decimal> const& p_amount,
+            string const& p_payee,
+            string const& p_memo
+        )
+        {
+            if (!p_date || !p_amount)
+            {
+                JEWEL_THROW
+                (   LedgerImportException,
+                    parsing_error_message
+                    (   "QIF record lacks date or amount."
+                    ).c_str()
+                );
+            }
+            p_record.date = *p_date;
+            p_record.amount = *p_amount;
+            p_record.description = join_description(p_payee, p_memo);
+            return true;
+        }
+
+        // QIF dates are often of the form "1/ 5'13" - i.e. with padding
+        // spaces, and an apostrophe before a two-digit year.
+        static string normalized_qif_date(string p_string)
+        {
+            algorithm::erase_all(p_string, " ");
+            algorithm::replace_all(p_string, "'", "/");
+            return p_string;
+        }
+
+        string m_line;
+
+    };  // class QifRecordReader
+
+}  // end anonymous namespace
+
+
+ImportFormat
+import_format_from_filepath(filesystem::path const& p_filepath)
+{
+    string extension = p_filepath.extension().string();
+    algorithm::to_lower(extension);
+    if (extension == ".csv") return ImportFormat::csv;
+    if (extension == ".ofx") return ImportFormat::ofx;
+    if (extension == ".qif") return ImportFormat::qif;
+    JEWEL_THROW
+    (   LedgerImportException,
+        "File extension does not correspond to a supported import format."
+    );
+}
+
+
+unique_ptr<ImportRecordReader>
+ImportRecordReader::create
+(   istream& p_stream,
+    ImportFormat p_format,
+    DecimalParser const& p_amount_parser
+)
+{
+    unique_ptr<ImportRecordReader> ret;
+    switch (p_format)
+    {
+    case ImportFormat::csv:
+        ret.reset(new CsvRecordReader(p_stream));
+        break;
+    case ImportFormat::ofx:
+        ret.reset(new OfxRecordReader(p_stream));
+        break;
+    case ImportFormat::qif:
+        ret.reset(new QifRecordReader(p_stream));
+        break;
+    default:
+        JEWEL_HARD_ASSERT (false);
+    }
+    JEWEL_ASSERT (ret);
+    ret->m_amount_parser = p_amount_parser;
+    return ret;
+}
+
+ImportRecordReader::ImportRecordReader(istream& p_stream):
+    m_stream(p_stream),
+    m_line_number(0),
+    m_amount_parser(wxString("."), wxString(","))
+{
+}
+
+ImportRecordReader::~ImportRecordReader() = default;
+
+bool
+ImportRecordReader::read(ImportRecord& p_record)
+{
+    return do_read(p_record);
+}
+
+bool
+ImportRecordReader::next_line(string& p_line)
+{
+    if (!std::getline(m_stream, p_line))
+    {
+        return false;
+    }
+    ++m_line_number;
+    if (!p_line.empty() && (p_line[p_line.size() - 1] == '\r'))
+    {
+        p_line.resize(p_line.size() - 1);
+    }
+    return true;
+}
+
+istream&
+ImportRecordReader::stream()
+{
+    return m_stream;
+}
+
+size_t
+ImportRecordReader::line_number() const
+{
+    return m_line_number;
+}
+
+gregorian::date
+ImportRecordReader::parse_date(string const& p_string)
+{
+    optional<gregorian::date> ret = maybe_iso_date(p_string);
+    if (!ret)
+    {
+        if (!m_date_parser)
+        {
+            m_date_parser.reset(new DateParser);
+        }
+        ret = m_date_parser->parse(std8_to_wx(p_string), true);
+    }
+    if (!ret)
+    {
+        JEWEL_THROW
+        (   LedgerImportException,
+            parsing_error_message("Could not parse date: " + p_string).c_str()
+        );
+    }
+    return *ret;
+}
+
+Decimal
+ImportRecordReader::parse_amount(string const& p_string)
+{
+    // Strip out the characters the class documentation says are ignored,
+    // or mark the amount as negative, and leave the rest, including the
+    // separators, to m_amount_parser.
+    string number;
+    number.reserve(p_string.size());
+    bool negative = false;
+    bool has_digit = false;
+    for (char const c: p_string)
+    {
+        if ((c == '-') || (c == '(') || (c == ')'))
+        {
+            negative = true;
+        }
+        else if
+        (   (c == '+') ||
+            (c == '$') ||
+            (c == ' ') ||
+            (static_cast<unsigned char>(c) >= 0x80)
+        )
+        {
+            // ignore
+        }
+        else
+        {
+            if (std::isdigit(static_cast<unsigned char>(c))) has_digit = true;
+            number += c;
+        }
+    }
+    Decimal ret;
+    size_t error_position = 0;
+    bool parsed = false;
+    if (has_digit)
+    {
+        try
+        {
+            parsed = m_amount_parser.parse
+            (   std8_to_wx(number),
+                ret,
+                error_position
+            );
+        }
+        catch (DecimalException&)
+        {
+            parsed = false;
+        }
+    }
+    if (!parsed)
+    {
+        JEWEL_THROW
+        (   LedgerImportException,
+            parsing_error_message("Could not parse amount: " + p_string).c_str()
+        );
+    }
+    return negative? -ret: ret;
+}
+
+string
+ImportRecordReader::parsing_error_message(string const& p_detail) const
+{
+    ostringstream oss;
+    oss << "Line " << m_line_number << ": " << p_detail;
+    return oss.str();
+}
+
+
+LedgerImporter::LedgerImporter
+(   DcmDatabaseConnection& p_database_connection,
+    Handle<Account> const& p_statement_account,
+    Handle<Account> const& p_default_counterparty
+):
+    m_database_connection(p_database_connection),
+    m_statement_account(p_statement_account),
+    m_default_counterparty(p_default_counterparty),
+    m_skipping_duplicates(true),
+    m_num_duplicates_skipped(0),
+    m_amount_parser(wxString("."), wxString(","))
+{
+    JEWEL_ASSERT (m_statement_account->has_id());
+    JEWEL_ASSERT (m_default_counterparty->has_id());
+    JEWEL_ASSERT (m_statement_account != m_default_counterparty);
+}
+
+LedgerImporter::~LedgerImporter() = default;
+
+void
+LedgerImporter::set_skipping_duplicates(bool p_skipping_duplicates)
+{
+    m_skipping_duplicates = p_skipping_duplicates;
+    return;
+}
+
+void
+LedgerImporter::set_amount_parser(DecimalParser const& p_amount_parser)
+{
+    m_amount_parser = p_amount_parser;
+    return;
+}
+
+size_t
+LedgerImporter::num_duplicates_skipped() const
+{
+    return m_num_duplicates_skipped;
+}
+
+void
+LedgerImporter::add_mapping_rule
+(   wxString const& p_keyword,
+    Handle<Account> const& p_account
+)
+{
+    JEWEL_ASSERT (p_account->has_id());
+    JEWEL_ASSERT (p_account != m_statement_account);
+    m_mapping_rules.push_back(make_pair(p_keyword.Lower(), p_account));
+    return;
+}
+
+Handle<Account> const&
+LedgerImporter::counterparty_for(wxString const& p_description) const
+{
+    if (!m_mapping_rules.empty())
+    {
+        wxString const description = p_description.Lower();
+        for (auto const& rule: m_mapping_rules)
+        {
+            if (description.Find(rule.first) != wxNOT_FOUND)
+            {
+                return rule.second;
+            }
+        }
+    }
+    return m_default_counterparty;
+}
+
+size_t
+LedgerImporter::import(istream& p_stream, ImportFormat p_format)
+{
+    JEWEL_LOG_TRACE();
+    DcmDatabaseConnection& dbc = m_database_connection;
+    unique_ptr<ImportRecordReader> const reader =
+        ImportRecordReader::create(p_stream, p_format, m_amount_parser);
+    gregorian::date const min_date = dbc.entity_creation_date();
+    Decimal const zero(0, 0);
+
+    // Per Account, keyed by Account id: the technical balance the Account
+    // would have after posting the records read so far; and the precision
+    // of the Account's Commodity.
+    unordered_map<Id, Decimal> prospective_balances;
+    unordered_map<Id, Decimal::places_type> precisions;
+
+    // Keyed by counterparty Account id
+    unordered_map<Id, TransactionType> transaction_types;
+
+    // The number of times each fingerprint has been encountered so far
+    // in this import, for comparison against the number of existing
+    // Entries in the database with that fingerprint.
+    unordered_map<EntryFingerprint, size_t, EntryFingerprint::Hasher>
+        batch_fingerprint_counts;
+
+    auto const prepare_account =
+        [&](Handle<Account> const& p_account) -> Id
+    {
+        Id const account_id = p_account->id();
+        if (precisions.find(account_id) == precisions.end())
+        {
+            precisions[account_id] = p_account->commodity()->precision();
+            prospective_balances[account_id] = p_account->technical_balance();
+        }
+        return account_id;
+    };
+    auto const rounded_intval =
+        [&](Id p_account_id, Decimal const& p_amount) -> Decimal::int_type
+    {
+        Decimal const rounded = round(p_amount, precisions.at(p_account_id));
+        if (rounded != p_amount)
+        {
+            JEWEL_THROW
+            (   LedgerImportException,
+                "Imported amount has more decimal places than the Account's "
+                "Commodity supports."
+            );
+        }
+        try
+        {
+            Decimal& balance = prospective_balances.at(p_account_id);
+            balance += rounded;
+        }
+        catch (DecimalAdditionException&)
+        {
+            JEWEL_THROW
+            (   JournalOverflowException,
+                "Importing transactions would cause overflow in Account "
+                "balance."
+            );
+        }
+        return rounded.intval();
+    };
+
+    // The Entries inserted, with their fingerprints, to be added to the
+    // EntryFingerprintIndex once the transaction has been committed.
+    vector<pair<Id, EntryFingerprint> > new_entries;
+
+    Id const statement_account_id = prepare_account(m_statement_account);
+    m_num_duplicates_skipped = 0;
+    size_t ret = 0;
+    Id first_journal_id = 0;
+    DatabaseTransaction transaction(dbc);
+    try
+    {
+        Id journal_id = next_auto_key<DcmDatabaseConnection, Id>
+        (   dbc,
+            "journals"
+        );
+        first_journal_id = journal_id;
+        Id entry_id = next_auto_key<DcmDatabaseConnection, Id>
+        (   dbc,
+            "entries"
+        );
+        SQLStatement journal_inserter
+        (   dbc,
+            "insert into journals(journal_id, transaction_type_id, comment) "
+            "values(:journal_id, :transaction_type_id, :comment)"
+        );
+        SQLStatement detail_inserter
+        (   dbc,
+            "insert into ordinary_journal_detail(journal_id, date) "
+            "values(:journal_id, :date)"
+        );
+        SQLStatement entry_inserter
+        (   dbc,
+            "insert into entries"
+            "("
+                "entry_id, "
+                "journal_id, "
+                "comment, "
+                "account_id, "
+                "amount, "
+                "is_reconciled, "
+                "transaction_side_id"
+            ") "
+            "values"
+            "("
+                ":entry_id, "
+                ":journal_id, "
+                ":comment, "
+                ":account_id, "
+                ":amount, "
+                ":is_reconciled, "
+                ":transaction_side_id"
+            ")"
+        );
+        auto const insert_entry = [&]
+        (   string const& p_comment,
+            Id p_account_id,
+            Decimal const& p_amount,
+            DateRep p_date
+        ) -> void
+        {
+            Decimal::int_type const intval =
+                rounded_intval(p_account_id, p_amount);
+            entry_inserter.bind(":entry_id", entry_id);
+            entry_inserter.bind(":journal_id", journal_id);
+            entry_inserter.bind(":comment", p_comment);
+            entry_inserter.bind(":account_id", p_account_id);
+            entry_inserter.bind(":amount", intval);
+            entry_inserter.bind(":is_reconciled", 0);
+            entry_inserter.bind
+            (   ":transaction_side_id",
+                static_cast<int>
+                (   (p_amount < zero)?
+                    TransactionSide::source:
+                    TransactionSide::destination
+                )
+            );
+            entry_inserter.step_final();
+            new_entries.push_back
+            (   make_pair
+                (   entry_id,
+                    EntryFingerprint(p_account_id, p_date, intval, p_comment)
+                )
+            );
+            ++entry_id;
+        };
+
+        ImportRecord record;
+        while (reader->read(record))
+        {
+            if (record.amount == zero)
+            {
+                continue;
+            }
+            if (record.date < min_date)
+            {
+                JEWEL_THROW
+                (   InvalidJournalDateException,
+                    "Imported transaction is dated earlier than the entity "
+                    "creation date."
+                );
+            }
+            string const comment = wx_to_std8(record.description);
+            if (m_skipping_duplicates)
+            {
+                // The index is refreshed, if need be, on the first lookup
+                // here, before we have inserted anything; thereafter it is
+                // not affected by our insertions (which bypass Entry, and
+                // are added to the index only after committing), so the
+                // counts it gives us reflect only the Entries that existed
+                // before the import.
+                Decimal const rounded = round
+                (   record.amount,
+                    precisions.at(statement_account_id)
+                );
+                EntryFingerprint const fingerprint
+                (   statement_account_id,
+                    julian_int(record.date),
+                    rounded.intval(),
+                    comment
+                );
+                size_t const num_encountered =
+                    ++batch_fingerprint_counts[fingerprint];
+                if
+                (   (rounded == record.amount) &&
+                    (   num_encountered <=
+                        DcmDatabaseConnection::EntryFingerprintAttorney::count
+                        (   dbc,
+                            fingerprint
+                        )
+                    )
+                )
+                {
+                    ++m_num_duplicates_skipped;
+                    continue;
+                }
+            }
+            Handle<Account> const& counterparty =
+                counterparty_for(record.description);
+            Id const counterparty_id = prepare_account(counterparty);
+            auto ttype_it = transaction_types.find(counterparty_id);
+            if (ttype_it == transaction_types.end())
+            {
+                ttype_it = transaction_types.insert
+                (   make_pair
+                    (   counterparty_id,
+                        natural_transaction_type
+                        (   m_statement_account,
+                            counterparty
+                        )
+                    )
+                ).first;
+            }
+
+            journal_inserter.bind(":journal_id", journal_id);
+            journal_inserter.bind
+            (   ":transaction_type_id",
+                static_cast<int>(ttype_it->second)
+            );
+            journal_inserter.bind(":comment", comment);
+            journal_inserter.step_final();
+
+            DateRep const date = julian_int(record.date);
+            detail_inserter.bind(":journal_id", journal_id);
+            detail_inserter.bind(":date", date);
+            detail_inserter.step_final();
+
+            // Source (i.e. credit) side first, as per the convention in
+            // ProtoJournals created via the GUI.
+            if (record.amount < zero)
+            {
+                insert_entry
+                (   comment,
+                    statement_account_id,
+                    record.amount,
+                    date
+                );
+                insert_entry(comment, counterparty_id, -record.amount, date);
+            }
+            else
+            {
+                insert_entry(comment, counterparty_id, -record.amount, date);
+                insert_entry
+                (   comment,
+                    statement_account_id,
+                    record.amount,
+                    date
+                );
+            }
+            ++journal_id;
+            ++ret;
+        }
+        transaction.commit();
+    }
+    catch (...)
+    {
+        transaction.cancel();
+        throw;
+    }
+    DcmDatabaseConnection::BalanceCacheAttorney::mark_as_stale(dbc);
+    try
+    {
+        for (auto const& new_entry: new_entries)
+        {
+            DcmDatabaseConnection::EntryFingerprintAttorney::add_entry
+            (   dbc,
+                new_entry.first,
+                new_entry.second
+            );
+        }
+    }
+    catch (...)
+    {
+        // The journals have been posted regardless, so this is no reason
+        // to fail; the index will just be re-read in full when next
+        // consulted.
+        DcmDatabaseConnection::EntryFingerprintAttorney::mark_as_stale(dbc);
+    }
+    // The Journals posted have consecutive ids, so the LedgerSnapshot can
+    // read them all back with a single query.
+    LedgerSnapshot& snapshot = dbc.ledger_snapshot();
+    for (size_t i = 0; i != ret; ++i)
+    {
+        snapshot.mark_journal_as_stale(first_journal_id + static_cast<Id>(i));
+    }
+    JEWEL_LOG_VALUE(Log::info, ret);
+    return ret;
+}
+
+}  // namespace dcm
@@ -0,0 +1,671 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ledger_snapshot.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include "transaction_type.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/optional.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/checked_arithmetic.hpp>
+#include <jewel/decimal.hpp>
+#include <jewel/exception.hpp>
+#include <jewel/log.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+using boost::optional;
+using jewel::addition_is_unsafe;
+using jewel::Decimal;
+using sqloxx::Id;
+using sqloxx::SQLStatement;
+using std::lower_bound;
+using std::make_pair;
+using std::make_shared;
+using std::map;
+using std::max;
+using std::minmax_element;
+using std::pair;
+using std::shared_ptr;
+using std::size_t;
+using std::sort;
+using std::string;
+using std::unordered_map;
+using std::unordered_set;
+using std::upper_bound;
+using std::vector;
+
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+
+namespace
+{
+    string const row_selection_text =
+        "select entry_id, journal_id, account_id, date, amount, "
+        "transaction_type_id, is_reconciled from entries "
+        "join ordinary_journal_detail using(journal_id) "
+        "join journals using(journal_id)";
+
+    void push_row(LedgerColumns& p_columns, SQLStatement& p_statement)
+    {
+        p_columns.entry_ids.push_back(p_statement.extract<Id>(0));
+        p_columns.journal_ids.push_back(p_statement.extract<Id>(1));
+        p_columns.account_ids.push_back(p_statement.extract<Id>(2));
+        p_columns.dates.push_back(p_statement.extract<DateRep>(3));
+        p_columns.amounts.push_back
+        (   p_statement.extract<Decimal::int_type>(4)
+        );
+        p_columns.transaction_types.push_back
+        (   static_cast<TransactionType>(p_statement.extract<int>(5))
+        );
+        p_columns.reconciled_flags.push_back
+        (   static_cast<unsigned char>(p_statement.extract<int>(6) != 0)
+        );
+        return;
+    }
+
+    void copy_row
+    (   LedgerColumns const& p_source,
+        LedgerColumns::size_type p_index,
+        LedgerColumns& p_destination
+    )
+    {
+        p_destination.entry_ids.push_back(p_source.entry_ids[p_index]);
+        p_destination.journal_ids.push_back(p_source.journal_ids[p_index]);
+        p_destination.account_ids.push_back(p_source.account_ids[p_index]);
+        p_destination.dates.push_back(p_source.dates[p_index]);
+        p_destination.amounts.push_back(p_source.amounts[p_index]);
+        p_destination.transaction_types.push_back
+        (   p_source.transaction_types[p_index]
+        );
+        p_destination.reconciled_flags.push_back
+        (   p_source.reconciled_flags[p_index]
+        );
+        return;
+    }
+
+    // Ordering of rows within LedgerColumns
+    bool precedes
+    (   LedgerColumns const& p_lhs,
+        LedgerColumns::size_type p_lhs_index,
+        LedgerColumns const& p_rhs,
+        LedgerColumns::size_type p_rhs_index
+    )
+    {
+        DateRep const lhs_date = p_lhs.dates[p_lhs_index];
+        DateRep const rhs_date = p_rhs.dates[p_rhs_index];
+        if (lhs_date != rhs_date) return lhs_date < rhs_date;
+        return p_lhs.entry_ids[p_lhs_index] < p_rhs.entry_ids[p_rhs_index];
+    }
+
+}  // end anonymous namespace
+
+
+LedgerColumns::size_type
+LedgerColumns::size() const
+{
+    JEWEL_ASSERT (journal_ids.size() == entry_ids.size());
+    JEWEL_ASSERT (account_ids.size() == entry_ids.size());
+    JEWEL_ASSERT (dates.size() == entry_ids.size());
+    JEWEL_ASSERT (amounts.size() == entry_ids.size());
+    JEWEL_ASSERT (transaction_types.size() == entry_ids.size());
+    JEWEL_ASSERT (reconciled_flags.size() == entry_ids.size());
+    return entry_ids.size();
+}
+
+void
+LedgerColumns::clear()
+{
+    entry_ids.clear();
+    journal_ids.clear();
+    account_ids.clear();
+    dates.clear();
+    amounts.clear();
+    transaction_types.clear();
+    reconciled_flags.clear();
+    return;
+}
+
+void
+LedgerColumns::reserve(size_type p_capacity)
+{
+    entry_ids.reserve(p_capacity);
+    journal_ids.reserve(p_capacity);
+    account_ids.reserve(p_capacity);
+    dates.reserve(p_capacity);
+    amounts.reserve(p_capacity);
+    transaction_types.reserve(p_capacity);
+    reconciled_flags.reserve(p_capacity);
+    return;
+}
+
+pair<LedgerColumns::size_type, LedgerColumns::size_type>
+rows_between
+(   LedgerColumns const& p_columns,
+    optional<gregorian::date> const& p_maybe_min_date,
+    optional<gregorian::date> const& p_maybe_max_date
+)
+{
+    vector<DateRep> const& dates = p_columns.dates;
+    vector<DateRep>::const_iterator const first =
+    (   p_maybe_min_date?
+        lower_bound(dates.begin(), dates.end(), julian_int(*p_maybe_min_date)):
+        dates.begin()
+    );
+    vector<DateRep>::const_iterator const last =
+    (   p_maybe_max_date?
+        upper_bound(first, dates.end(), julian_int(*p_maybe_max_date)):
+        dates.end()
+    );
+    return make_pair(first - dates.begin(), last - dates.begin());
+}
+
+void
+accumulate_totals
+(   LedgerColumns const& p_columns,
+    LedgerColumns::size_type p_begin,
+    LedgerColumns::size_type p_end,
+    unordered_map<Id, Decimal::int_type>& p_totals,
+    bool p_actual_only
+)
+{
+    JEWEL_ASSERT (p_begin <= p_end);
+    JEWEL_ASSERT (p_end <= p_columns.size());
+    TransactionType const natt = non_actual_transaction_type();
+    for (LedgerColumns::size_type i = p_begin; i != p_end; ++i)
+    {
+        if (p_actual_only && (p_columns.transaction_types[i] == natt))
+        {
+            continue;
+        }
+        Decimal::int_type& total = p_totals[p_columns.account_ids[i]];
+        Decimal::int_type const amount = p_columns.amounts[i];
+        if (addition_is_unsafe(total, amount))
+        {
+            JEWEL_THROW
+            (   UnsafeArithmeticException,
+                "Unsafe addition while totalling LedgerSnapshot."
+            );
+        }
+        total += amount;
+    }
+    return;
+}
+
+
+void
+load_ledger_columns
+(   sqloxx::DatabaseConnection& p_database_connection,
+    LedgerColumns& p_columns
+)
+{
+    p_columns.clear();
+    SQLStatement counter
+    (   p_database_connection,
+        "select count(*) from entries "
+        "join ordinary_journal_detail using(journal_id)"
+    );
+    counter.step();
+    p_columns.reserve(counter.extract<long long>(0));
+    counter.step_final();
+    SQLStatement statement
+    (   p_database_connection,
+        row_selection_text + " order by date, entry_id"
+    );
+    while (statement.step())
+    {
+        push_row(p_columns, statement);
+    }
+    return;
+}
+
+LedgerSnapshot::LedgerSnapshot
+(   DcmDatabaseConnection& p_database_connection
+):
+    m_database_connection(p_database_connection),
+    m_columns(make_shared<LedgerColumns>()),
+    m_is_stale(true),
+    m_num_changes(0),
+    m_usage_window_start(latest_date_rep())
+{
+    JEWEL_LOG_TRACE();
+}
+
+LedgerSnapshot::~LedgerSnapshot()
+{
+    JEWEL_LOG_TRACE();
+}
+
+LedgerColumns const&
+LedgerSnapshot::columns()
+{
+    refresh();
+    return *m_columns;
+}
+
+shared_ptr<LedgerColumns const>
+LedgerSnapshot::shared_columns()
+{
+    refresh();
+    return m_columns;
+}
+
+pair<LedgerSnapshot::size_type, LedgerSnapshot::size_type>
+LedgerSnapshot::rows_between
+(   optional<gregorian::date> const& p_maybe_min_date,
+    optional<gregorian::date> const& p_maybe_max_date
+)
+{
+    refresh();
+    return dcm::rows_between(*m_columns, p_maybe_min_date, p_maybe_max_date);
+}
+
+vector<Id>
+LedgerSnapshot::actual_entry_ids
+(   optional<gregorian::date> const& p_maybe_min_date,
+    optional<gregorian::date> const& p_maybe_max_date,
+    optional<Id> const& p_maybe_account_id
+)
+{
+    pair<size_type, size_type> const range =
+        rows_between(p_maybe_min_date, p_maybe_max_date);
+    LedgerColumns const& columns = *m_columns;
+    TransactionType const natt = non_actual_transaction_type();
+    vector<Id> ret;
+    for (size_type i = range.first; i != range.second; ++i)
+    {
+        if
+        (   (columns.transaction_types[i] != natt) &&
+            (   !p_maybe_account_id ||
+                (columns.account_ids[i] == *p_maybe_account_id)
+            )
+        )
+        {
+            ret.push_back(columns.entry_ids[i]);
+        }
+    }
+    return ret;
+}
+
+void
+LedgerSnapshot::accumulate_totals
+(   unordered_map<Id, Decimal::int_type>& p_totals,
+    bool p_actual_only,
+    optional<gregorian::date> const& p_maybe_min_date,
+    optional<gregorian::date> const& p_maybe_max_date
+)
+{
+    pair<size_type, size_type> const range =
+        rows_between(p_maybe_min_date, p_maybe_max_date);
+    dcm::accumulate_totals
+    (   *m_columns,
+        range.first,
+        range.second,
+        p_totals,
+        p_actual_only
+    );
+    return;
+}
+
+unordered_map<Id, size_t> const&
+LedgerSnapshot::recent_usage_counts()
+{
+    refresh();
+    DateRep const window_start =
+        julian_int(today() - gregorian::date_duration(recent_usage_days()));
+    if (window_start < m_usage_window_start)
+    {
+        // Only on the first call, or if the clock has gone backwards.
+        rebuild_usage();
+    }
+    else
+    {
+        // Drop the days that have fallen out of the window.
+        auto const end = m_usage_buckets.lower_bound(window_start);
+        for (auto it = m_usage_buckets.begin(); it != end; ++it)
+        {
+            for (auto const& elem: it->second)
+            {
+                auto const jt = m_usage_counts.find(elem.first);
+                JEWEL_ASSERT (jt != m_usage_counts.end());
+                JEWEL_ASSERT (jt->second >= elem.second);
+                jt->second -= elem.second;
+                if (jt->second == 0) m_usage_counts.erase(jt);
+            }
+        }
+        m_usage_buckets.erase(m_usage_buckets.begin(), end);
+        m_usage_window_start = window_start;
+    }
+    return m_usage_counts;
+}
+
+int
+LedgerSnapshot::recent_usage_days()
+{
+    return 30;
+}
+
+void
+LedgerSnapshot::mark_as_stale()
+{
+    m_is_stale = true;
+    m_stale_journal_ids.clear();
+    m_stale_entry_ids.clear();
+    ++m_num_changes;
+    return;
+}
+
+void
+LedgerSnapshot::mark_journal_as_stale(Id p_journal_id)
+{
+    if (!m_is_stale) m_stale_journal_ids.insert(p_journal_id);
+    ++m_num_changes;
+    return;
+}
+
+void
+LedgerSnapshot::mark_entry_as_stale(Id p_entry_id)
+{
+    if (!m_is_stale) m_stale_entry_ids.insert(p_entry_id);
+    ++m_num_changes;
+    return;
+}
+
+size_t
+LedgerSnapshot::num_changes() const
+{
+    return m_num_changes;
+}
+
+bool
+LedgerSnapshot::adopt_columns
+(   shared_ptr<LedgerColumns const> const& p_columns,
+    size_t p_num_changes
+)
+{
+    JEWEL_ASSERT (p_columns);
+    if (p_num_changes != m_num_changes)
+    {
+        return false;
+    }
+    m_columns = p_columns;
+    m_stale_journal_ids.clear();
+    m_stale_entry_ids.clear();
+    m_is_stale = false;
+    rebuild_usage();
+    return true;
+}
+
+void
+LedgerSnapshot::refresh()
+{
+    // Merging the stale Journals in is a single pass over the columns, and
+    // their rows are read in a single query if they are clustered (see
+    // refresh_stale_journals()), so only once a sizeable proportion of the
+    // ledger is stale is it quicker just to read everything afresh. (Cf.
+    // the fulcrum in EntryFingerprintIndex::refresh(), which must re-read
+    // each Journal with a separate query.) This is an educated guess.
+    static unordered_set<Id>::size_type const fulcrum = 100;
+
+    if
+    (   !m_is_stale &&
+        (   m_stale_journal_ids.size() >
+            max(fulcrum, m_columns->size() / 4)
+        )
+    )
+    {
+        mark_as_stale();
+    }
+    if (m_is_stale)
+    {
+        try
+        {
+            refresh_all();
+        }
+        catch (...)
+        {
+            m_columns = make_shared<LedgerColumns>();
+            rebuild_usage();
+            throw;
+        }
+        m_stale_journal_ids.clear();
+        m_stale_entry_ids.clear();
+        m_is_stale = false;
+        return;
+    }
+    if (m_stale_journal_ids.empty() && m_stale_entry_ids.empty())
+    {
+        return;
+    }
+    try
+    {
+        refresh_stale_journals();
+    }
+    catch (...)
+    {
+        // We don't know how far we got, so start afresh next time.
+        mark_as_stale();
+        throw;
+    }
+    m_stale_journal_ids.clear();
+    m_stale_entry_ids.clear();
+    JEWEL_ASSERT (!m_is_stale);
+    return;
+}
+
+void
+LedgerSnapshot::refresh_all()
+{
+    JEWEL_LOG_TRACE();
+    shared_ptr<LedgerColumns> const columns = make_shared<LedgerColumns>();
+    load_ledger_columns(m_database_connection, *columns);
+    m_columns = columns;
+    rebuild_usage();
+    JEWEL_LOG_TRACE();
+    return;
+}
+
+void
+LedgerSnapshot::refresh_stale_journals()
+{
+    // The removal of an Entry may since have been rolled back, so we check
+    // whether it's still there, and if it is, re-read its Journal.
+    for (Id const entry_id: m_stale_entry_ids)
+    {
+        SQLStatement statement
+        (   m_database_connection,
+            "select journal_id from entries where entry_id = :p"
+        );
+        statement.bind(":p", entry_id);
+        if (statement.step())
+        {
+            m_stale_journal_ids.insert(statement.extract<Id>(0));
+            statement.step_final();
+        }
+    }
+
+    // Read the current state of the stale Journals. Where their ids are
+    // clustered, as after an import (which posts Journals with consecutive
+    // ids), a single query over the range of their ids is much quicker than
+    // a query per Journal...
+    LedgerColumns fresh;
+    if (!m_stale_journal_ids.empty())
+    {
+        auto const bounds = minmax_element
+        (   m_stale_journal_ids.begin(),
+            m_stale_journal_ids.end()
+        );
+        Id const min_id = *bounds.first;
+        Id const max_id = *bounds.second;
+        if
+        (   static_cast<size_t>(max_id - min_id) <
+            m_stale_journal_ids.size() * 4
+        )
+        {
+            SQLStatement statement
+            (   m_database_connection,
+                row_selection_text +
+                    " where journal_id between :min and :max"
+            );
+            statement.bind(":min", min_id);
+            statement.bind(":max", max_id);
+            while (statement.step())
+            {
+                Id const journal_id = statement.extract<Id>(1);
+                if (m_stale_journal_ids.count(journal_id) != 0)
+                {
+                    push_row(fresh, statement);
+                }
+            }
+        }
+        else
+        {
+            for (Id const journal_id: m_stale_journal_ids)
+            {
+                SQLStatement statement
+                (   m_database_connection,
+                    row_selection_text + " where journal_id = :p"
+                );
+                statement.bind(":p", journal_id);
+                while (statement.step())
+                {
+                    push_row(fresh, statement);
+                }
+            }
+        }
+    }
+    vector<size_type> fresh_order(fresh.size());
+    for (size_type i = 0; i != fresh_order.size(); ++i) fresh_order[i] = i;
+    sort
+    (   fresh_order.begin(),
+        fresh_order.end(),
+        [&fresh](size_type lhs, size_type rhs)
+        {
+            return precedes(fresh, lhs, fresh, rhs);
+        }
+    );
+
+    // ...and merge them, in a single pass, with the rows we already have,
+    // dropping the superseded ones. The usage counts are adjusted as we go;
+    // if anything throws from here on, the whole snapshot is marked as
+    // stale (see refresh()), and so the counts are rebuilt with it.
+    LedgerColumns const& old_columns = *m_columns;
+    shared_ptr<LedgerColumns> const merged = make_shared<LedgerColumns>();
+    merged->reserve(old_columns.size() + fresh.size());
+    size_type const old_size = old_columns.size();
+    size_type i = 0;
+    auto j = fresh_order.begin();
+    while ((i != old_size) || (j != fresh_order.end()))
+    {
+        if
+        (   (i != old_size) &&
+            (   (m_stale_journal_ids.count(old_columns.journal_ids[i]) != 0) ||
+                (m_stale_entry_ids.count(old_columns.entry_ids[i]) != 0)
+            )
+        )
+        {
+            count_usage(old_columns, i++, false);
+        }
+        else if
+        (   (j == fresh_order.end()) ||
+            ((i != old_size) && precedes(old_columns, i, fresh, *j))
+        )
+        {
+            copy_row(old_columns, i++, *merged);
+        }
+        else
+        {
+            count_usage(fresh, *j, true);
+            copy_row(fresh, *j++, *merged);
+        }
+    }
+    m_columns = merged;
+    return;
+}
+
+void
+LedgerSnapshot::rebuild_usage()
+{
+    m_usage_buckets.clear();
+    m_usage_counts.clear();
+    m_usage_window_start =
+        julian_int(today() - gregorian::date_duration(recent_usage_days()));
+    LedgerColumns const& columns = *m_columns;
+    vector<DateRep>::const_iterator const first = lower_bound
+    (   columns.dates.begin(),
+        columns.dates.end(),
+        m_usage_window_start
+    );
+    size_type const size = columns.size();
+    for (size_type i = first - columns.dates.begin(); i != size; ++i)
+    {
+        count_usage(columns, i, true);
+    }
+    return;
+}
+
+void
+LedgerSnapshot::count_usage
+(   LedgerColumns const& p_columns,
+    size_type p_index,
+    bool p_increment
+)
+{
+    DateRep const date = p_columns.dates[p_index];
+    if
+    (   (date < m_usage_window_start) ||
+        (p_columns.transaction_types[p_index] == non_actual_transaction_type())
+    )
+    {
+        return;
+    }
+    Id const account_id = p_columns.account_ids[p_index];
+    if (p_increment)
+    {
+        ++m_usage_buckets[date][account_id];
+        ++m_usage_counts[account_id];
+        return;
+    }
+    auto const bucket_it = m_usage_buckets.find(date);
+    JEWEL_ASSERT (bucket_it != m_usage_buckets.end());
+    unordered_map<Id, size_t>& bucket = bucket_it->second;
+    auto const it = bucket.find(account_id);
+    JEWEL_ASSERT ((it != bucket.end()) && (it->second > 0));
+    if (--(it->second) == 0)
+    {
+        bucket.erase(it);
+        if (bucket.empty()) m_usage_buckets.erase(bucket_it);
+    }
+    auto const jt = m_usage_counts.find(account_id);
+    JEWEL_ASSERT ((jt != m_usage_counts.end()) && (jt->second > 0));
+    if (--(jt->second) == 0) m_usage_counts.erase(jt);
+    return;
+}
+
+}  // namespace dcm
@@ -21,6 +21,7 @@
 #include "ordinary_journal.hpp"
 #include "persistent_journal.hpp"
 #include "dcm_database_connection.hpp"
+#include "ledger_snapshot.hpp"
 #include "proto_journal.hpp"
 #include "transaction_type.hpp"
 #include <sqloxx/database_connection.hpp>
@@ -183,6 +184,14 @@ OrdinaryJournal::do_load()
 void
 OrdinaryJournal::do_save_new()
 {
+    DateRep const opening_balance_date =
+        julian_int(database_connection().opening_balance_journal_date());
+    if (value(m_date) == opening_balance_date)
+    {
+        DcmDatabaseConnection::BalanceCacheAttorney::
+            mark_opening_balances_as_stale(database_connection());
+    }
+
     // Save the Journal    (base) part of the object and record the id.
     Id const journal_id = save_new_journal_core();
 
@@ -195,6 +204,7 @@ OrdinaryJournal::do_save_new()
     statement.bind(":journal_id", journal_id);
     statement.bind(":date", value(m_date));
     statement.step_final();
+    update_entry_dates();
 
     return;
 }
@@ -204,23 +214,71 @@ OrdinaryJournal::do_save_existing()
 {
     JEWEL_LOG_TRACE();
 
+    // Opening balances need recalculating only if this is, or was, an
+    // opening balance journal.
+    DateRep const opening_balance_date =
+        julian_int(database_connection().opening_balance_journal_date());
+    SQLStatement old_date_capturer
+    (   database_connection(),
+        "select date from ordinary_journal_detail where journal_id = :p"
+    );
+    old_date_capturer.bind(":p", id());
+    old_date_capturer.step();
+    DateRep const old_date =
+        numeric_cast<DateRep>(old_date_capturer.extract<long long>(0));
+    old_date_capturer.step_final();
+    if
+    (   (old_date == opening_balance_date) ||
+        (value(m_date) == opening_balance_date)
+    )
+    {
+        DcmDatabaseConnection::BalanceCacheAttorney::
+            mark_opening_balances_as_stale(database_connection());
+    }
+
     // Save the Journal (base) part of the object
     save_existing_journal_core();
     JEWEL_LOG_TRACE();
 
     // Save the derived, OrdinaryJournal part of the object
-    SQLStatement updater
-    (   database_connection(),    
-        "update ordinary_journal_detail set date = :date "
-        "where journal_id = :journal_id"
-    );
-    updater.bind(":date", value(m_date));
-    updater.bind(":journal_id", id());
-    updater.step_final();
+    if (value(m_date) != old_date)
+    {
+        SQLStatement updater
+        (   database_connection(),    
+            "update ordinary_journal_detail set date = :date "
+            "where journal_id = :journal_id"
+        );
+        updater.bind(":date", value(m_date));
+        updater.bind(":journal_id", id());
+        updater.step_final();
+
+        // The Entries themselves may not have been saved, but their
+        // fingerprints include the date.
+        DcmDatabaseConnection::EntryFingerprintAttorney::mark_journal_as_stale
+        (   database_connection(),
+            id()
+        );
+    }
+
+    // The date or TransactionType may have changed even if the Entries
+    // haven't.
+    database_connection().ledger_snapshot().mark_journal_as_stale(id());
+    update_entry_dates();
     JEWEL_LOG_TRACE();
     return;
 }
 
+void
+OrdinaryJournal::update_entry_dates()
+{
+    gregorian::date const d = boost_date_from_julian_int(value(m_date));
+    for (Handle<Entry> const& entry: entries())
+    {
+        entry->set_journal_date(d);
+    }
+    return;
+}
+
 void
 OrdinaryJournal::do_ghostify()
 {
@@ -0,0 +1,405 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "period_close.hpp"
+#include "account.hpp"
+#include "account_type.hpp"
+#include "commodity.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include "entry.hpp"
+#include "ordinary_journal.hpp"
+#include "transaction_side.hpp"
+#include "transaction_type.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/filesystem.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/decimal.hpp>
+#include <jewel/exception.hpp>
+#include <jewel/log.hpp>
+#include <sqloxx/database_transaction.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <wx/string.h>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+using jewel::Decimal;
+using jewel::Log;
+using sqloxx::DatabaseTransaction;
+using sqloxx::Handle;
+using sqloxx::Id;
+using sqloxx::SQLStatement;
+using std::map;
+using std::size_t;
+using std::string;
+using std::vector;
+
+namespace filesystem = boost::filesystem;
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+
+namespace
+{
+    // Totals, in terms of Decimal::intval(), of the Entries for an
+    // Account in the closed period.
+    struct CarriedForwardAmounts
+    {
+        CarriedForwardAmounts(): reconciled(0), unreconciled(0)
+        {
+        }
+        Decimal::int_type reconciled;
+        Decimal::int_type unreconciled;
+    };
+
+    // Discard from the archive whatever was written to it by a closure
+    // whose changes to the main database were never committed (see
+    // close_period(...)). The journals it archived are then still in the
+    // main database (journal ids are never reused); and its row in
+    // period_closures is for a cutoff later than the entity creation date.
+    void discard_incomplete_closures
+    (   DcmDatabaseConnection& p_database_connection
+    )
+    {
+        DcmDatabaseConnection& dbc = p_database_connection;
+        dbc.execute_sql
+        (   "delete from archive.entries where journal_id in "
+            "(select journal_id from main.journals); "
+            "delete from archive.ordinary_journal_detail where journal_id in "
+            "(select journal_id from main.journals); "
+            "delete from archive.journals where journal_id in "
+            "(select journal_id from main.journals);"
+        );
+        SQLStatement statement
+        (   dbc,
+            "delete from archive.period_closures "
+            "where cutoff_date > :creation_date"
+        );
+        statement.bind
+        (   ":creation_date",
+            julian_int(dbc.entity_creation_date())
+        );
+        statement.step_final();
+        return;
+    }
+
+    void copy_to_archive
+    (   DcmDatabaseConnection& p_database_connection,
+        DateRep p_cutoff
+    )
+    {
+        DcmDatabaseConnection& dbc = p_database_connection;
+
+        // The archive tables mirror the columns (though not the
+        // constraints) of those in the main database.
+        char const* const archived_tables[] =
+            {   "commodities",
+                "accounts",
+                "journals",
+                "ordinary_journal_detail",
+                "entries"
+            };
+        for (char const* table: archived_tables)
+        {
+            dbc.execute_sql
+            (   string("create table if not exists archive.") + table +
+                " as select * from main." + table + " where 0"
+            );
+        }
+        dbc.execute_sql
+        (   "create table if not exists archive.period_closures"
+            "(cutoff_date integer not null)"
+        );
+        discard_incomplete_closures(dbc);
+
+        // Accounts and Commodities may have been amended since any
+        // previous closure, so replace these wholesale.
+        dbc.execute_sql
+        (   "delete from archive.commodities; "
+            "insert into archive.commodities select * from main.commodities; "
+            "delete from archive.accounts; "
+            "insert into archive.accounts select * from main.accounts;"
+        );
+
+        char const* const copiers[] =
+            {   "insert into archive.journals select * from main.journals "
+                "where journal_id in "
+                "(select journal_id from main.ordinary_journal_detail "
+                "where date < :cutoff)",
+
+                "insert into archive.ordinary_journal_detail "
+                "select * from main.ordinary_journal_detail "
+                "where date < :cutoff",
+
+                "insert into archive.entries select * from main.entries "
+                "where journal_id in "
+                "(select journal_id from main.ordinary_journal_detail "
+                "where date < :cutoff)",
+
+                // Last, so that it is present only if the copy is complete.
+                "insert into archive.period_closures(cutoff_date) "
+                "values(:cutoff)"
+            };
+        for (char const* copier: copiers)
+        {
+            SQLStatement statement(dbc, copier);
+            statement.bind(":cutoff", p_cutoff);
+            statement.step_final();
+        }
+        return;
+    }
+
+    void post_carried_forward_journal
+    (   Handle<Account> const& p_account,
+        CarriedForwardAmounts const& p_amounts
+    )
+    {
+        DcmDatabaseConnection& dbc = p_account->database_connection();
+        Handle<Account> const balancing_account = dbc.balancing_account();
+        Decimal::places_type const places =
+            p_account->commodity()->precision();
+        Handle<OrdinaryJournal> const journal(dbc);
+        auto const push_entries =
+            [&](Decimal::int_type p_intval, bool p_is_reconciled) -> void
+        {
+            if (p_intval == 0)
+            {
+                return;
+            }
+            Decimal const amount(p_intval, places);
+            Handle<Entry> const primary_entry(dbc);
+            primary_entry->set_account(p_account);
+            primary_entry->set_comment("Balance carried forward");
+            primary_entry->set_amount(amount);
+            primary_entry->set_whether_reconciled(p_is_reconciled);
+            primary_entry->set_transaction_side(TransactionSide::source);
+            journal->push_entry(primary_entry);
+
+            Handle<Entry> const balancing_entry(dbc);
+            balancing_entry->set_account(balancing_account);
+            balancing_entry->set_comment("Balance carried forward");
+            balancing_entry->set_amount(-amount);
+            balancing_entry->set_whether_reconciled(false);
+            balancing_entry->set_transaction_side
+            (   TransactionSide::destination
+            );
+            journal->push_entry(balancing_entry);
+        };
+        push_entries(p_amounts.reconciled, true);
+        push_entries(p_amounts.unreconciled, false);
+        JEWEL_ASSERT (!journal->entries().empty());
+
+        // As per create_opening_balance_journal(...)
+        journal->set_comment("Balance carried forward");
+        if (p_account->account_super_type() == AccountSuperType::balance_sheet)
+        {
+            journal->set_transaction_type(TransactionType::generic);
+        }
+        else
+        {
+            journal->set_transaction_type(TransactionType::envelope);
+        }
+        journal->set_date_unrestricted(dbc.opening_balance_journal_date());
+        journal->save();
+        return;
+    }
+
+}  // end anonymous namespace
+
+
+size_t
+close_period
+(   DcmDatabaseConnection& p_database_connection,
+    gregorian::date const& p_cutoff_date,
+    filesystem::path const& p_archive_filepath
+)
+{
+    JEWEL_LOG_TRACE();
+    DcmDatabaseConnection& dbc = p_database_connection;
+    gregorian::date const old_creation_date = dbc.entity_creation_date();
+    if (p_cutoff_date <= old_creation_date)
+    {
+        JEWEL_THROW
+        (   PeriodCloseException,
+            "Cutoff date must be later than the entity creation date."
+        );
+    }
+    if (p_cutoff_date > today())
+    {
+        JEWEL_THROW
+        (   PeriodCloseException,
+            "Cutoff date cannot be later than today."
+        );
+    }
+    DateRep const cutoff = julian_int(p_cutoff_date);
+    SQLStatement repeater_checker
+    (   dbc,
+        "select repeater_id from repeaters where next_date < :cutoff"
+    );
+    repeater_checker.bind(":cutoff", cutoff);
+    if (repeater_checker.step())
+    {
+        JEWEL_THROW
+        (   PeriodCloseException,
+            "There are recurring transactions due before the cutoff date "
+            "that have not yet been posted."
+        );
+    }
+
+    // Read what is to be carried forward, and which OrdinaryJournals are
+    // to be archived, before anything is changed.
+    map<Id, CarriedForwardAmounts> carried_forward;
+    SQLStatement totaller
+    (   dbc,
+        "select account_id, is_reconciled, sum(amount) from entries "
+        "join ordinary_journal_detail using(journal_id) "
+        "where date < :cutoff group by account_id, is_reconciled"
+    );
+    totaller.bind(":cutoff", cutoff);
+    while (totaller.step())
+    {
+        CarriedForwardAmounts& amounts =
+            carried_forward[totaller.extract<Id>(0)];
+        Decimal::int_type const total =
+            totaller.extract<Decimal::int_type>(2);
+        if (totaller.extract<int>(1) != 0) amounts.reconciled = total;
+        else amounts.unreconciled = total;
+    }
+    vector<Id> doomed_journal_ids;
+    SQLStatement selector
+    (   dbc,
+        "select journal_id from ordinary_journal_detail "
+        "where date < :cutoff"
+    );
+    selector.bind(":cutoff", cutoff);
+    while (selector.step())
+    {
+        doomed_journal_ids.push_back(selector.extract<Id>(0));
+    }
+    Id const balancing_account_id = dbc.balancing_account()->id();
+
+    SQLStatement attacher(dbc, "attach database :filepath as archive");
+    attacher.bind(":filepath", p_archive_filepath.string());
+    attacher.step_final();
+
+    // The database is in WAL mode, in which SQLite does not make a
+    // transaction atomic across attached databases. So the archive is
+    // committed first, and then the main database, separately. If the
+    // second commit does not happen, the archive holds copies of journals
+    // that are still in the main database; these are discarded either
+    // below or, if we are interrupted, when a period is next closed.
+    try
+    {
+        DatabaseTransaction archive_transaction(dbc);
+        try
+        {
+            copy_to_archive(dbc, cutoff);
+            archive_transaction.commit();
+        }
+        catch (...)
+        {
+            archive_transaction.cancel();
+            throw;
+        }
+        DatabaseTransaction transaction(dbc);
+        try
+        {
+            // We remove the journals via OrdinaryJournal::remove() rather
+            // than by bulk SQL, so that any cached objects, the balance
+            // cache and the entry fingerprint index are kept consistent
+            // with the database.
+            for (Id const journal_id: doomed_journal_ids)
+            {
+                Handle<OrdinaryJournal> const journal(dbc, journal_id);
+                journal->remove();
+            }
+
+            // The carried-forward journals become the opening balance
+            // journals, so we must move the entity creation date before
+            // posting them.
+            dbc.set_entity_creation_date(p_cutoff_date);
+            for (auto const& elem: carried_forward)
+            {
+                CarriedForwardAmounts const& amounts = elem.second;
+                if
+                (   (elem.first == balancing_account_id) ||
+                    ((amounts.reconciled == 0) && (amounts.unreconciled == 0))
+                )
+                {
+                    continue;
+                }
+                post_carried_forward_journal
+                (   Handle<Account>(dbc, elem.first),
+                    amounts
+                );
+            }
+            transaction.commit();
+        }
+        catch (...)
+        {
+            transaction.cancel();
+            dbc.set_entity_creation_date(old_creation_date);
+            try
+            {
+                DatabaseTransaction cleanup(dbc);
+                try
+                {
+                    discard_incomplete_closures(dbc);
+                    cleanup.commit();
+                }
+                catch (...)
+                {
+                    cleanup.cancel();
+                    throw;
+                }
+            }
+            catch (...)
+            {
+                // Don't mask the original exception. The archive will be
+                // tidied up next time.
+                JEWEL_LOG_MESSAGE
+                (   Log::error,
+                    "Could not discard incomplete closure from archive."
+                );
+            }
+            throw;
+        }
+    }
+    catch (...)
+    {
+        try
+        {
+            dbc.execute_sql("detach database archive");
+        }
+        catch (...)
+        {
+            // Don't mask the original exception.
+        }
+        throw;
+    }
+    dbc.execute_sql("detach database archive");
+    size_t const ret = doomed_journal_ids.size();
+    JEWEL_LOG_VALUE(Log::info, ret);
+    return ret;
+}
+
+}  // namespace dcm
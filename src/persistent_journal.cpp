@@ -19,7 +19,9 @@
 #include "entry.hpp"
 #include "journal.hpp"
 #include "dcm_database_connection.hpp"
+#include "handle_cache.hpp"
 #include "dcm_exceptions.hpp"
+#include <boost/lexical_cast.hpp>
 #include <jewel/decimal.hpp>
 #include <jewel/exception.hpp>
 #include <jewel/log.hpp>
@@ -32,8 +34,10 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
+using boost::lexical_cast;
 using jewel::Log;
 using jewel::Decimal;
 using jewel::DecimalAdditionException;
@@ -104,7 +108,9 @@ PersistentJournal::PersistentJournal
     IdentityMap::Signature const& p_signature
 ):
     PersistentObject(p_identity_map),
-    Journal()
+    Journal(),
+    m_core_is_dirty(false),
+    m_entries_may_be_removed(false)
 {
     (void)p_signature;  // silence compiler re. unused parameter
 }
@@ -115,7 +121,9 @@ PersistentJournal::PersistentJournal
     IdentityMap::Signature const& p_signature
 ):
     PersistentObject(p_identity_map, p_id),
-    Journal()
+    Journal(),
+    m_core_is_dirty(false),
+    m_entries_may_be_removed(false)
 {
     (void)p_signature;  // silence compiler re. unused parameter
 }
@@ -124,7 +132,9 @@ PersistentJournal::~PersistentJournal() = default;
 
 PersistentJournal::PersistentJournal(PersistentJournal const& rhs):
     PersistentObject(rhs),
-    Journal(rhs)
+    Journal(rhs),
+    m_core_is_dirty(rhs.m_core_is_dirty),
+    m_entries_may_be_removed(rhs.m_entries_may_be_removed)
 {
 }
 
@@ -133,6 +143,9 @@ PersistentJournal::swap(PersistentJournal& rhs)
 {
     Journal::swap(rhs);
     PersistentObject::swap(rhs);
+    using std::swap;
+    swap(m_core_is_dirty, rhs.m_core_is_dirty);
+    swap(m_entries_may_be_removed, rhs.m_entries_may_be_removed);
     return;
 }
 
@@ -176,6 +189,7 @@ PersistentJournal::save_new_journal_core()
         entry->set_journal_id(journal_id);
         entry->save();
     }
+    clear_dirty_flags();
     return journal_id;
 }
 
@@ -199,55 +213,111 @@ PersistentJournal::save_existing_journal_core()
             "Cannot save journal core in unbalanced state."
         );
     }
-    SQLStatement updater
-    (   database_connection(),
-        "update journals "
-        "set comment = :comment, "
-        "transaction_type_id = :transaction_type_id "
-        "where journal_id = :id"
-    );
-    updater.bind
-    (   ":transaction_type_id",
-        static_cast<int>(Journal::do_get_transaction_type())
-    );
-    updater.bind(":comment", wx_to_std8(Journal::do_get_comment()));
-    updater.bind(":id", id());
-    updater.step_final();
+    if (m_core_is_dirty)
+    {
+        SQLStatement updater
+        (   database_connection(),
+            "update journals "
+            "set comment = :comment, "
+            "transaction_type_id = :transaction_type_id "
+            "where journal_id = :id"
+        );
+        updater.bind
+        (   ":transaction_type_id",
+            static_cast<int>(Journal::do_get_transaction_type())
+        );
+        updater.bind(":comment", wx_to_std8(Journal::do_get_comment()));
+        updater.bind(":id", id());
+        updater.step_final();
+    }
+
+    // Only the Entries that have actually changed are written.
     unordered_set<Id> saved_entry_ids;
     for (Handle<Entry> const& entry: Journal::do_get_entries())
     {
-        entry->save();
+        if (entry->has_unsaved_changes())
+        {
+            entry->save();
+        }
         JEWEL_ASSERT (entry->has_id());
         saved_entry_ids.insert(entry->id());
     }
-    // Remove any entries in the database with this journal's journal_id, that
-    // no longer exist in the in-memory journal
-    SQLStatement entry_finder
-    (   database_connection(),    
-        "select entry_id from entries where journal_id = :journal_id"
-    );
-    entry_finder.bind(":journal_id", id());
-    unordered_set<Id>::const_iterator const saved_entries_end =
-        saved_entry_ids.end();
-    while (entry_finder.step())
+    if (m_entries_may_be_removed)
     {
-        Id const entry_id = entry_finder.extract<Id>(0);
-        if (saved_entry_ids.find(entry_id) == saved_entries_end)
+        // Remove any entries in the database with this journal's
+        // journal_id, that no longer exist in the in-memory journal
+        SQLStatement entry_finder
+        (   database_connection(),    
+            "select entry_id, account_id from entries "
+            "where journal_id = :journal_id"
+        );
+        entry_finder.bind(":journal_id", id());
+        vector<Id> doomed_entry_ids;
+        unordered_set<Id> affected_account_ids;
+        while (entry_finder.step())
         {
-            Handle<Entry> const doomed_entry(database_connection(), entry_id);
-            // This entry is in the database but no longer in the in-memory
-            // journal, so should be deleted.
-            doomed_entry->remove();
-            // Note it's OK even if the last entry is deleted. Another
-            // entry will never be reassigned its id - SQLite makes sure
-            // of that - providing we let SQLite assign all the ids
-            // automatically.
+            Id const entry_id = entry_finder.extract<Id>(0);
+            if (saved_entry_ids.find(entry_id) == saved_entry_ids.end())
+            {
+                doomed_entry_ids.push_back(entry_id);
+                affected_account_ids.insert(entry_finder.extract<Id>(1));
+            }
+        }
+        if (!doomed_entry_ids.empty())
+        {
+            remove_entries(doomed_entry_ids, affected_account_ids);
         }
     }
+    clear_dirty_flags();
     JEWEL_LOG_TRACE();
     return;
 }
 
+void
+PersistentJournal::remove_entries
+(   vector<Id> const& p_entry_ids,
+    unordered_set<Id> const& p_account_ids
+)
+{
+    // The Entries are deleted with a single statement, rather than through
+    // Entry::remove() one at a time; so the caches that Entry::remove()
+    // would keep in step with the database are dealt with here instead.
+    // Note it's OK even if the last entry is deleted. Another entry will
+    // never be reassigned its id - SQLite makes sure of that - providing
+    // we let SQLite assign all the ids automatically.
+    DcmDatabaseConnection& dbc = database_connection();
+    string statement_text = "delete from entries where entry_id in (";
+    for (vector<Id>::size_type i = 0; i != p_entry_ids.size(); ++i)
+    {
+        if (i != 0) statement_text += ", ";
+        statement_text += lexical_cast<string>(p_entry_ids[i]);
+    }
+    statement_text += ")";
+    dbc.execute_sql(statement_text);
+
+    for (Id const account_id: p_account_ids)
+    {
+        DcmDatabaseConnection::BalanceCacheAttorney::mark_as_stale
+        (   dbc,
+            account_id
+        );
+    }
+    HandleCache<Entry>& entry_cache = dbc.handle_cache<Entry>();
+    for (Id const entry_id: p_entry_ids)
+    {
+        DcmDatabaseConnection::EntryFingerprintAttorney::mark_entry_as_stale
+        (   dbc,
+            entry_id
+        );
+        dbc.ledger_snapshot().mark_entry_as_stale(entry_id);
+
+        // The in-memory Entry, if there is one, still has the id, so must
+        // not be handed out again under it.
+        entry_cache.evict(entry_id);
+    }
+    return;
+}
+
 void
 PersistentJournal::load_journal_core()
 {
@@ -268,7 +338,8 @@ PersistentJournal::load_journal_core()
     while (entry_finder.step())
     {
         Id const entr_id = entry_finder.extract<Id>(0);
-        Handle<Entry> const entry(database_connection(), entr_id);
+        Handle<Entry> const entry =
+            database_connection().handle_cache<Entry>().provide(entr_id);
         temp.push_entry(entry);
     }
     temp.set_transaction_type
@@ -278,6 +349,7 @@ PersistentJournal::load_journal_core()
     );
     temp.set_comment(std8_to_wx(statement.extract<string>(1)));
     Journal::swap(temp);    
+    clear_dirty_flags();
     return;
 }
 
@@ -289,6 +361,7 @@ PersistentJournal::ghostify_journal_core()
         entry->ghostify();
     }
     clear_core();
+    clear_dirty_flags();
     return;
 }
 
@@ -303,6 +376,13 @@ void
 PersistentJournal::do_set_transaction_type(TransactionType p_transaction_type)
 {
     load();
+    if
+    (   !has_id() ||
+        (Journal::do_get_transaction_type() != p_transaction_type)
+    )
+    {
+        m_core_is_dirty = true;
+    }
     Journal::do_set_transaction_type(p_transaction_type);
     return;
 }
@@ -311,6 +391,10 @@ void
 PersistentJournal::do_set_comment(wxString const& p_comment)
 {
     load();
+    if (!has_id() || (Journal::do_get_comment() != p_comment))
+    {
+        m_core_is_dirty = true;
+    }
     Journal::do_set_comment(p_comment);
     return;
 }
@@ -332,6 +416,7 @@ PersistentJournal::do_remove_entry(Handle<Entry> const& p_entry)
 {
     load();
     Journal::do_remove_entry(p_entry);
+    m_entries_may_be_removed = true;
     return;
 }
 
@@ -340,6 +425,7 @@ PersistentJournal::do_clear_entries()
 {
     load();
     Journal::do_clear_entries();
+    m_entries_may_be_removed = true;
     return;
 }
 
@@ -357,6 +443,14 @@ PersistentJournal::do_get_transaction_type()
     return Journal::do_get_transaction_type();
 }
 
+void
+PersistentJournal::clear_dirty_flags()
+{
+    m_core_is_dirty = false;
+    m_entries_may_be_removed = false;
+    return;
+}
+
 void
 PersistentJournal::ensure_pl_only_budget()
 {
@@ -386,6 +480,12 @@ PersistentJournal::would_cause_overflow()
     unordered_map<Id, Decimal> prospective_balances;
     for (auto const& entry: entries())
     {
+        // Entries whose Account and amount are as already saved do not
+        // change any balance.
+        if (!entry->has_unsaved_balance_changes())
+        {
+            continue;
+        }
         Handle<Account> account;
         try
         {
@@ -150,6 +150,20 @@ PersistentObjectEvent::notify_doomed_ordinary_entries
     return;
 }
 
+void
+PersistentObjectEvent::notify_reconciliation_statuses
+(   wxWindow* p_originator,
+    vector<Id> const& p_entry_ids
+)
+{
+    notify_many
+    (   p_originator,
+        DCM_RECONCILIATION_STATUS_EVENT,
+        p_entry_ids
+    );
+    return;
+}
+
 void
 PersistentObjectEvent::notify_many
 (   wxWindow* p_originator,
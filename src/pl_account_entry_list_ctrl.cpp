@@ -89,11 +89,7 @@ PLAccountEntryListCtrl::do_set_non_date_columns
     SetItem
     (   p_row,
         amount_col_num(),
-        finformat_wx
-        (   friendly_amount(p_entry),
-            locale(),
-            DecimalFormatFlags().clear(string_flags::dash_for_zero)
-        )
+        amount_formatter().format(friendly_amount(p_entry))
     );
     JEWEL_ASSERT (num_columns() == 3);
     return;
@@ -19,30 +19,29 @@
 #include "account_type.hpp"
 #include "commodity.hpp"
 #include "date.hpp"
-#include "entry.hpp"
-#include "entry_table_iterator.hpp"
 #include "dcm_database_connection.hpp"
 #include "gui/report.hpp"
 #include "gui/report_panel.hpp"
+#include "gui/report_totals.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <jewel/assert.hpp>
 #include <jewel/decimal.hpp>
 #include <jewel/optional.hpp>
 #include <sqloxx/handle.hpp>
-#include <sqloxx/sql_statement.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/gdicmn.h>
 #include <wx/string.h>
 #include <list>
+#include <unordered_map>
 #include <vector>
 
 using boost::optional;
 using jewel::Decimal;
 using jewel::value;
 using sqloxx::Handle;
-using sqloxx::SQLStatement;
-using std::unique_ptr;
 using std::list;
+using std::unordered_map;
 using std::vector;
 
 namespace gregorian = boost::gregorian;
@@ -73,14 +72,24 @@ PLReport::~PLReport()
 {
 }
 
+vector<ReportQuery>
+PLReport::do_get_totals_queries()
+{
+    ReportQuery query;
+    query.maybe_min_date = min_date();
+    query.maybe_max_date = maybe_max_date();
+    return vector<ReportQuery>(1, query);
+}
+
 void
-PLReport::do_generate()
+PLReport::do_generate(vector<ReportTotals> const& p_totals)
 {
-    refresh_map();
+    JEWEL_ASSERT (p_totals.size() == 1);
+    refresh_map(p_totals[0]);
     display_body();
 
-    // Don't do "FitInside()", "configure_scrollbars" or that "admin" stuff,
-    // as this is done in the Report base class, in Report::generate().
+    // Don't do "lay_out_cells()" or that "admin" stuff, as this is done
+    // in the Report base class, in Report::generate().
     return;
 }
 
@@ -121,30 +130,15 @@ PLReport::display_mean
 }
 
 void
-PLReport::refresh_map()
+PLReport::refresh_map(ReportTotals const& p_totals)
 {
     m_map.clear();
     JEWEL_ASSERT (m_map.empty());
-    optional<gregorian::date> const maybe_max_d = maybe_max_date();
-    gregorian::date const min_d = min_date();
-    Decimal const zero
-    (   0,
-        database_connection().default_commodity()->precision()
-    );
-
-    unique_ptr<SQLStatement> statement =
-        create_date_ordered_actual_ordinary_entry_selector
-        (   database_connection(),
-            min_date(),
-            maybe_max_date()
-        );
-    while (statement->step())
+    Decimal::places_type const places =
+        database_connection().default_commodity()->precision();
+    for (auto const& elem: p_totals)
     {
-        Handle<Entry> const entry
-        (   database_connection(),
-            statement->extract<sqloxx::Id>(0)
-        );
-        Handle<Account> const account = entry->account();
+        Handle<Account> const account(database_connection(), elem.first);
         AccountType const atype = account->account_type();
         if
         (   (atype != AccountType::revenue) &&
@@ -153,22 +147,11 @@ PLReport::refresh_map()
         {
             continue;
         }
-        sqloxx::Id const account_id = account->id();
-        Map::iterator jt = m_map.find(account_id);
-        if (jt == m_map.end())
-        {
-            JEWEL_ASSERT
-            (   database_connection().default_commodity() ==
-                account->commodity()
-            );
-            m_map[account_id] = zero;
-            jt = m_map.find(account_id);
-        }
-        JEWEL_ASSERT (jt != m_map.end());
-        gregorian::date const date = entry->date();
-        JEWEL_ASSERT (!maybe_max_d || (date <= value(maybe_max_d)))
-        JEWEL_ASSERT (date >= min_d);
-        jt->second += entry->amount();
+        JEWEL_ASSERT
+        (   database_connection().default_commodity() ==
+            account->commodity()
+        );
+        m_map[elem.first] = Decimal(elem.second, places);
     }
     return;
 }
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "read_only_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include <boost/filesystem.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/exception.hpp>
+#include <sqloxx/database_connection.hpp>
+#include <sqloxx/database_transaction.hpp>
+
+namespace filesystem = boost::filesystem;
+
+namespace dcm
+{
+
+ReadOnlyConnection::ReadOnlyConnection(filesystem::path const& p_filepath)
+{
+    if (!filesystem::exists(p_filepath))
+    {
+        JEWEL_THROW
+        (   ReadOnlyConnectionException,
+            "No database file to open read-only."
+        );
+    }
+    open(p_filepath);
+    JEWEL_ASSERT (is_valid());
+}
+
+ReadOnlyConnection::~ReadOnlyConnection()
+{
+}
+
+void
+ReadOnlyConnection::do_setup()
+{
+    // Makes SQLite refuse any statement that would change the file.
+    execute_sql("pragma query_only = on;");
+    return;
+}
+
+ReadOnlyConnection::Snapshot::Snapshot(ReadOnlyConnection& p_connection):
+    m_transaction(p_connection)
+{
+    // Under WAL, the snapshot is fixed by the first read within the
+    // transaction, rather than by its beginning; so read something now.
+    p_connection.execute_sql("select count(*) from sqlite_master;");
+}
+
+ReadOnlyConnection::Snapshot::~Snapshot()
+{
+    try
+    {
+        // Nothing was written, so this just releases the snapshot.
+        m_transaction.cancel();
+    }
+    catch (...)
+    {
+    }
+}
+
+}  // namespace dcm
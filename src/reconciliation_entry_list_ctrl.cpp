@@ -17,32 +17,44 @@
 #include "gui/reconciliation_entry_list_ctrl.hpp"
 #include "account.hpp"
 #include "commodity.hpp"
+#include "dcm_database_connection.hpp"
 #include "entry.hpp"
 #include "finformat.hpp"
+#include "handle_cache.hpp"
 #include "gui/filtered_entry_list_ctrl.hpp"
 #include "gui/locale.hpp"
 #include "gui/persistent_object_event.hpp"
 #include "gui/summary_datum.hpp"
+#include "ledger_snapshot.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <jewel/assert.hpp>
 #include <jewel/decimal.hpp>
+#include <jewel/decimal_exceptions.hpp>
+#include <jewel/exception.hpp>
 #include <jewel/optional.hpp>
 #include <sqloxx/handle.hpp>
-#include <sqloxx/sql_statement.hpp>
+#include <sqloxx/id.hpp>
 #include <wx/bitmap.h>
 #include <wx/colour.h>
 #include <wx/imaglist.h>
 #include <wx/listctrl.h>
+#include <wx/menu.h>
+#include <wx/utils.h>
+#include <wx/wupdlock.h>
+#include <cstddef>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 using boost::optional;
 using jewel::Decimal;
+using jewel::DecimalFromStringException;
 using jewel::value;
 using sqloxx::Handle;
-using sqloxx::SQLStatement;
-using std::unique_ptr;
+using sqloxx::Id;
+using std::size_t;
+using std::unordered_set;
 using std::vector;
 
 namespace gregorian = boost::gregorian;
@@ -87,6 +99,18 @@ namespace
     {
         return wxString();
     }
+    int reconcile_selected_menu_id()
+    {
+        return wxID_HIGHEST + 1;
+    }
+    int unreconcile_selected_menu_id()
+    {
+        return reconcile_selected_menu_id() + 1;
+    }
+    int reconcile_to_date_menu_id()
+    {
+        return unreconcile_selected_menu_id() + 1;
+    }
 
 }  // end anonymous namespace
 
@@ -106,7 +130,8 @@ ReconciliationEntryListCtrl::ReconciliationEntryListCtrl
     ),
     m_max_date(p_max_date),
     m_closing_balance(0, p_account->commodity()->precision()),
-    m_reconciled_closing_balance(0, p_account->commodity()->precision())
+    m_reconciled_closing_balance(0, p_account->commodity()->precision()),
+    m_amount_parser(locale())
 {
     JEWEL_LOG_TRACE();
 }
@@ -122,11 +147,8 @@ ReconciliationEntryListCtrl::do_set_non_date_columns
 )
 {
     SetItem(p_row, comment_col_num(), p_entry->comment());
-    wxString const amount_text = finformat_wx
-    (   p_entry->amount(),
-        locale(),
-        DecimalFormatFlags().clear(string_flags::dash_for_zero)
-    );
+    wxString const amount_text =
+        amount_formatter().format(p_entry->amount());
     SetItem(p_row, amount_col_num(), amount_text);
     SetItem
     (   p_row,
@@ -280,46 +302,137 @@ ReconciliationEntryListCtrl::do_process_removal_for_summary(long p_row)
 void
 ReconciliationEntryListCtrl::on_item_right_click(wxListEvent& event)
 {
-    int const col = reconciled_col_num();
     sqloxx::Id const entry_id = event.GetData();    
     long const pos = event.GetIndex();
     JEWEL_ASSERT (FindItem(-1, entry_id) == pos);
     JEWEL_ASSERT (entry_id >= 0);
     JEWEL_ASSERT (GetItemData(pos) == static_cast<size_t>(entry_id));
 
-    Handle<Entry> const entry(database_connection(), entry_id);
-    bool const old_reconciliation_status = entry->is_reconciled();
-    entry->set_whether_reconciled(!old_reconciliation_status);
-    Decimal const amount = entry->amount();
-    SetItem
-    (   pos,
-        col,
-        entry->is_reconciled()?
-            finformat_wx
-            (   amount,
-                locale(),
-                DecimalFormatFlags().clear(string_flags::dash_for_zero)
-            ):
-            unreconciled_string()
+    bool const is_among_selected =
+        (GetSelectedItemCount() > 1) &&
+        GetItemState(pos, wxLIST_STATE_SELECTED);
+    if (!is_among_selected && !wxGetKeyState(WXK_SHIFT))
+    {
+        // Just toggle this one, so that the user can click rapidly
+        // through the list.
+        Handle<Entry> const entry =
+            database_connection().handle_cache<Entry>().provide(entry_id);
+        reconcile_rows(vector<long>(1, pos), !entry->is_reconciled());
+        return;
+    }
+    vector<long> selected_rows;
+    if (is_among_selected)
+    {
+        long row = -1;
+        while (true)
+        {
+            row = GetNextItem(row, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED);
+            if (row == -1) break;
+            selected_rows.push_back(row);
+        }
+    }
+    else
+    {
+        selected_rows.push_back(pos);
+    }
+    wxMenu menu;
+    menu.Append
+    (   reconcile_selected_menu_id(),
+        wxString("Mark selected as reconciled")
     );
-    
-    if (entry->is_reconciled())
+    menu.Append
+    (   unreconcile_selected_menu_id(),
+        wxString("Mark selected as unreconciled")
+    );
+    menu.Append
+    (   reconcile_to_date_menu_id(),
+        wxString("Mark all to ") + GetItemText(pos) +
+            wxString(" as reconciled")
+    );
+    int const choice = GetPopupMenuSelectionFromUser(menu);
+    if (choice == reconcile_selected_menu_id())
     {
-        m_reconciled_closing_balance += entry->amount();
+        reconcile_rows(selected_rows, true);
+    }
+    else if (choice == unreconcile_selected_menu_id())
+    {
+        reconcile_rows(selected_rows, false);
+    }
+    else if (choice == reconcile_to_date_menu_id())
+    {
+        DateRep const last_date = date_displayed(pos);
+        vector<long> rows;
+        long const num_rows = GetItemCount();
+        for (long row = 0; row != num_rows; ++row)
+        {
+            if (date_displayed(row) <= last_date) rows.push_back(row);
+        }
+        reconcile_rows(rows, true);
     }
     else
     {
-        m_reconciled_closing_balance -= entry->amount();
+        JEWEL_ASSERT (choice == wxID_NONE);
+    }
+    return;
+}
+
+void
+ReconciliationEntryListCtrl::reconcile_rows
+(   vector<long> const& p_rows,
+    bool p_is_reconciled
+)
+{
+    vector<Handle<Entry> > entries;
+    for (long const row: p_rows)
+    {
+        entries.push_back
+        (   database_connection().handle_cache<Entry>().provide
+            (   GetItemData(row)
+            )
+        );
     }
-    entry->save();
 
-    JEWEL_ASSERT (entry->has_id());
-    JEWEL_ASSERT (entry->id() == entry_id);
-    PersistentObjectEvent::fire
-    (   this,
-        DCM_RECONCILIATION_STATUS_EVENT,
-        entry_id
+    // All the changes are saved in a single DatabaseTransaction.
+    vector<Id> const changed_ids = set_whether_reconciled
+    (   database_connection(),
+        entries,
+        p_is_reconciled
     );
+    if (changed_ids.empty())
+    {
+        return;
+    }
+    unordered_set<Id> const changed(changed_ids.begin(), changed_ids.end());
+
+    // bare scope
+    {
+        wxWindowUpdateLocker const update_locker(this);
+        for (vector<long>::size_type i = 0; i != p_rows.size(); ++i)
+        {
+            Handle<Entry> const& entry = entries[i];
+            if (changed.find(entry->id()) == changed.end())
+            {
+                continue;
+            }
+            Decimal const amount = entry->amount();
+            SetItem
+            (   p_rows[i],
+                reconciled_col_num(),
+                p_is_reconciled?
+                    amount_formatter().format(amount):
+                    unreconciled_string()
+            );
+            if (p_is_reconciled)
+            {
+                m_reconciled_closing_balance += amount;
+            }
+            else
+            {
+                m_reconciled_closing_balance -= amount;
+            }
+        }
+    }
+    PersistentObjectEvent::notify_reconciliation_statuses(this, changed_ids);
 
     ReconciliationListPanel* parent =
         dynamic_cast<ReconciliationListPanel*>(GetParent());
@@ -335,7 +448,15 @@ ReconciliationEntryListCtrl::amount_for_row(long p_row) const
     item.SetId(p_row);
     item.SetColumn(amount_col_num());
     GetItem(item);
-    Decimal ret = wx_to_decimal(item.GetText(), locale());
+    Decimal ret;
+    size_t error_position = 0;
+    if (!m_amount_parser.parse(item.GetText(), ret, error_position))
+    {
+        JEWEL_THROW
+        (   DecimalFromStringException,
+            "Could not read amount in reconciliation list."
+        );
+    }
     return ret;
 }
 
@@ -345,18 +466,14 @@ ReconciliationEntryListCtrl::max_date() const
     return m_max_date;
 }
 
-unique_ptr<SQLStatement>
-ReconciliationEntryListCtrl::do_create_entry_selector()
+vector<Id>
+ReconciliationEntryListCtrl::do_select_entry_ids()
 {
-    unique_ptr<SQLStatement> ret
-    (   create_date_ordered_actual_ordinary_entry_selector
-        (   database_connection(),
-            optional<gregorian::date>(),
-            max_date(),
-            account()
-        )
+    return database_connection().ledger_snapshot().actual_entry_ids
+    (   optional<gregorian::date>(),
+        max_date(),
+        account()->id()
     );
-    return ret;
 }
 
 }  // namespace gui
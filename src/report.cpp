@@ -21,10 +21,11 @@
 #include "ordinary_journal.hpp"
 #include "dcm_database_connection.hpp"
 #include "gui/balance_sheet_report.hpp"
-#include "gui/gridded_scrolled_panel.hpp"
 #include "gui/locale.hpp"
 #include "gui/pl_report.hpp"
+#include "gui/report_grid.hpp"
 #include "gui/report_panel.hpp"
+#include "gui/report_totals.hpp"
 #include "gui/sizing.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <jewel/decimal.hpp>
@@ -94,7 +95,8 @@ Report::Report
     optional<gregorian::date> const& p_maybe_min_date,
     optional<gregorian::date> const& p_maybe_max_date
 ):
-    GriddedScrolledPanel(p_parent, p_size, p_database_connection),
+    ReportGrid(p_parent, p_size),
+    m_database_connection(p_database_connection),
     m_min_date
     (   database_connection().opening_balance_journal_date() +
         gregorian::date_duration(1)
@@ -127,6 +129,18 @@ Report::maybe_max_date() const
     return m_maybe_max_date;
 }
 
+DcmDatabaseConnection&
+Report::database_connection()
+{
+    return m_database_connection;
+}
+
+DcmDatabaseConnection const&
+Report::database_connection() const
+{
+    return m_database_connection;
+}
+
 void
 Report::update_for_new(Handle<OrdinaryJournal> const& p_journal)
 {
@@ -169,16 +183,19 @@ Report::update_for_deleted(std::vector<sqloxx::Id> const& p_doomed_ids)
     return;
 }
 
+std::vector<ReportQuery>
+Report::totals_queries()
+{
+    return do_get_totals_queries();
+}
+
 void
-Report::generate()
+Report::generate(std::vector<ReportTotals> const& p_totals)
 {
     wxWindowUpdateLocker const window_update_locker(this);
-    do_generate();
-    // GetParent()->Layout();
-    // m_top_sizer->Fit(this);
-    // m_top_sizer->SetSizeHints(this);
-    FitInside();
-    // Layout();
+    clear_cells();
+    do_generate(p_totals);
+    lay_out_cells();
     return;
 }
 
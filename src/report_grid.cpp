@@ -0,0 +1,255 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gui/report_grid.hpp"
+#include "finformat.hpp"
+#include "gui/locale.hpp"
+#include "gui/sizing.hpp"
+#include <jewel/assert.hpp>
+#include <jewel/decimal.hpp>
+#include <wx/dcclient.h>
+#include <wx/event.h>
+#include <wx/gdicmn.h>
+#include <wx/scrolwin.h>
+#include <wx/string.h>
+#include <wx/window.h>
+#include <algorithm>
+#include <vector>
+
+using std::max;
+using std::min;
+using std::vector;
+
+namespace dcm
+{
+namespace gui
+{
+
+BEGIN_EVENT_TABLE(ReportGrid, wxScrolledWindow)
+    EVT_PAINT(ReportGrid::on_paint)
+END_EVENT_TABLE()
+
+ReportGrid::Cell::Cell(): alignment_flags(wxALIGN_LEFT), width(0)
+{
+}
+
+ReportGrid::ReportGrid(wxWindow* p_parent, wxSize const& p_size):
+    wxScrolledWindow
+    (   p_parent,
+        wxID_ANY,
+        wxDefaultPosition,
+        p_size,
+        wxVSCROLL
+    ),
+    m_current_row(0),
+    m_num_rows(0),
+    m_num_columns(0),
+    m_row_height(0),
+    m_column_positions(1, 0),
+    m_formatter
+    (   locale(),
+        DecimalFormatFlags().clear(string_flags::dash_for_zero)
+    ),
+    m_dash_for_zero_formatter
+    (   locale(),
+        DecimalFormatFlags().set(string_flags::dash_for_zero)
+    )
+{
+    int const standard_scrolling_increment = 10;
+    SetScrollRate(0, standard_scrolling_increment);
+}
+
+ReportGrid::~ReportGrid()
+{
+}
+
+int
+ReportGrid::current_row() const
+{
+    return m_current_row;
+}
+
+void
+ReportGrid::increment_row(int p_inc)
+{
+    m_current_row += p_inc;
+    return;
+}
+
+void
+ReportGrid::decrement_row()
+{
+    increment_row(-1);
+    return;
+}
+
+void
+ReportGrid::set_row(int p_row)
+{
+    m_current_row = p_row;
+    return;
+}
+
+void
+ReportGrid::display_text
+(   wxString const& p_text,
+    int p_column,
+    int p_alignment_flags
+)
+{
+    Cell& cell = cell_at(current_row(), p_column);
+    cell.text = p_text;
+    cell.alignment_flags = p_alignment_flags;
+    return;
+}
+
+void
+ReportGrid::display_decimal
+(   jewel::Decimal const& p_decimal,
+    int p_column,
+    bool p_dash_for_zero
+)
+{
+    DecimalFormatter const& formatter =
+        (p_dash_for_zero? m_dash_for_zero_formatter: m_formatter);
+    display_text(formatter.format(p_decimal), p_column, wxALIGN_RIGHT);
+    return;
+}
+
+void
+ReportGrid::clear_cells()
+{
+    m_current_row = 0;
+    m_num_rows = 0;
+    m_num_columns = 0;
+    m_cells.clear();
+    m_column_positions.assign(1, 0);
+    return;
+}
+
+void
+ReportGrid::lay_out_cells()
+{
+    wxClientDC dc(this);
+    dc.SetFont(GetFont());
+    vector<int> column_widths(m_num_columns, 0);
+    for (int row = 0; row != m_num_rows; ++row)
+    {
+        for (int column = 0; column != m_num_columns; ++column)
+        {
+            Cell& cell = m_cells[row * m_num_columns + column];
+            if (!cell.text.IsEmpty())
+            {
+                wxCoord width = 0;
+                wxCoord height = 0;
+                dc.GetTextExtent(cell.text, &width, &height);
+                cell.width = width;
+                column_widths[column] = max(column_widths[column], width);
+            }
+        }
+    }
+    m_row_height = dc.GetCharHeight() + standard_gap();
+    m_column_positions.assign(m_num_columns + 1, 0);
+    for (int column = 0; column != m_num_columns; ++column)
+    {
+        m_column_positions[column + 1] =
+            m_column_positions[column] + column_widths[column] +
+            standard_gap();
+    }
+    SetVirtualSize(m_column_positions.back(), m_num_rows * m_row_height);
+    Refresh();
+    return;
+}
+
+void
+ReportGrid::on_paint(wxPaintEvent& event)
+{
+    (void)event;  // Silence compiler re. unused parameter.
+    wxPaintDC dc(this);
+    DoPrepareDC(dc);
+    if ((m_num_rows == 0) || (m_row_height == 0))
+    {
+        return;
+    }
+    dc.SetFont(GetFont());
+    dc.SetTextForeground(GetForegroundColour());
+
+    // Draw only the rows that are at least partly visible.
+    int view_x = 0;
+    int view_y = 0;
+    CalcUnscrolledPosition(0, 0, &view_x, &view_y);
+    int const first_row = view_y / m_row_height;
+    int const end_row = min
+    (   m_num_rows,
+        (view_y + GetClientSize().GetHeight()) / m_row_height + 1
+    );
+    JEWEL_ASSERT
+    (   m_column_positions.size() ==
+        static_cast<vector<int>::size_type>(m_num_columns + 1)
+    );
+    for (int row = first_row; row < end_row; ++row)
+    {
+        int const y = row * m_row_height;
+        for (int column = 0; column != m_num_columns; ++column)
+        {
+            Cell const& cell = m_cells[row * m_num_columns + column];
+            if (cell.text.IsEmpty())
+            {
+                continue;
+            }
+            int x = m_column_positions[column];
+            if (cell.alignment_flags & wxALIGN_RIGHT)
+            {
+                int const column_width =
+                    m_column_positions[column + 1] - x - standard_gap();
+                x += column_width - cell.width;
+            }
+            dc.DrawText(cell.text, x, y);
+        }
+    }
+    return;
+}
+
+ReportGrid::Cell&
+ReportGrid::cell_at(int p_row, int p_column)
+{
+    JEWEL_ASSERT (p_row >= 0);
+    JEWEL_ASSERT (p_column >= 0);
+    if (p_column >= m_num_columns)
+    {
+        int const num_columns = p_column + 1;
+        vector<Cell> cells(m_num_rows * num_columns);
+        for (int row = 0; row != m_num_rows; ++row)
+        {
+            for (int column = 0; column != m_num_columns; ++column)
+            {
+                cells[row * num_columns + column] =
+                    m_cells[row * m_num_columns + column];
+            }
+        }
+        m_cells.swap(cells);
+        m_num_columns = num_columns;
+    }
+    if (p_row >= m_num_rows)
+    {
+        m_num_rows = p_row + 1;
+        m_cells.resize(m_num_rows * m_num_columns);
+    }
+    return m_cells[p_row * m_num_columns + p_column];
+}
+
+}  // namespace gui
+}  // namespace dcm
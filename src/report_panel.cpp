@@ -17,25 +17,41 @@
 #include "gui/report_panel.hpp"
 #include "account.hpp"
 #include "account_type.hpp"
+#include "app.hpp"
 #include "date.hpp"
 #include "ordinary_journal.hpp"
 #include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include "ledger_snapshot.hpp"
+#include "task_scheduler.hpp"
 #include "gui/button.hpp"
 #include "gui/combo_box.hpp"
 #include "gui/date_ctrl.hpp"
 #include "gui/report.hpp"
+#include "gui/report_totals.hpp"
 #include "gui/sizing.hpp"
 #include "gui/string_set_validator.hpp"
+#include "gui/task_bridge.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <jewel/assert.hpp>
 #include <sqloxx/handle.hpp>
+#include <wx/app.h>
 #include <wx/event.h>
+#include <wx/gauge.h>
 #include <wx/gbsizer.h>
 #include <wx/panel.h>
 #include <wx/stattext.h>
-#include <utility>
+#include <exception>
+#include <memory>
+#include <vector>
 
 using sqloxx::Handle;
+using std::exception_ptr;
+using std::make_shared;
+using std::rethrow_exception;
+using std::shared_ptr;
+using std::vector;
+using std::weak_ptr;
 
 namespace gregorian = boost::gregorian;
 
@@ -46,6 +62,8 @@ namespace gui
 
 BEGIN_EVENT_TABLE(ReportPanel, wxPanel)
     EVT_BUTTON(s_run_button_id, ReportPanel::on_run_button_click)
+    EVT_TEXT(s_min_date_ctrl_id, ReportPanel::on_date_text_changed)
+    EVT_TEXT(s_max_date_ctrl_id, ReportPanel::on_date_text_changed)
 END_EVENT_TABLE()
 
 namespace
@@ -74,7 +92,11 @@ ReportPanel::ReportPanel
     m_min_date_ctrl(nullptr),
     m_max_date_ctrl(nullptr),
     m_run_button(nullptr),
+    m_progress_gauge(nullptr),
     m_report(nullptr),
+    m_is_generating(false),
+    m_job_id(0),
+    m_lifeline(make_shared<char>(0)),
     m_database_connection(p_database_connection)
 {
     m_top_sizer = new wxGridBagSizer(standard_gap(), standard_gap());
@@ -93,6 +115,7 @@ ReportPanel::ReportPanel
 
 ReportPanel::~ReportPanel()
 {
+    cancel_generation();
 }
 
 void
@@ -174,6 +197,22 @@ ReportPanel::configure_top()
     m_run_button->SetDefault();
     m_top_sizer->Add(m_run_button, wxGBPosition(m_next_row, 4));
 
+    // Shows progress while the Report is being prepared
+    m_progress_gauge = new wxGauge
+    (   this,
+        wxID_ANY,
+        100,
+        wxDefaultPosition,
+        m_run_button->GetSize()
+    );
+    m_top_sizer->Add
+    (   m_progress_gauge,
+        wxGBPosition(m_next_row, 5),
+        wxDefaultSpan,
+        wxALIGN_CENTER_VERTICAL
+    );
+    m_progress_gauge->Hide();
+
     ++m_next_row;
 
     return;
@@ -220,7 +259,7 @@ ReportPanel::configure_bottom()
         --m_next_row;
     }
     JEWEL_ASSERT (m_report);
-    m_report->generate();
+    start_generation();
     m_top_sizer->Add(m_report, wxGBPosition(m_next_row, 1), wxGBSpan(1, 4));
     // m_top_sizer->Fit(this);
     // m_top_sizer->SetSizeHints(this);
@@ -232,6 +271,92 @@ ReportPanel::configure_bottom()
     return;
 }
 
+void
+ReportPanel::start_generation()
+{
+    JEWEL_ASSERT (m_report);
+    cancel_generation();
+    vector<ReportQuery> const queries = m_report->totals_queries();
+    if (queries.empty())
+    {
+        m_report->generate(vector<ReportTotals>());
+        return;
+    }
+    App* const app = dynamic_cast<App*>(wxTheApp);
+    JEWEL_ASSERT (app);
+    ++m_job_id;
+    long const job_id = m_job_id;
+    shared_ptr<LedgerColumns const> const columns =
+        m_database_connection.ledger_snapshot().shared_columns();
+    shared_ptr<vector<ReportTotals> > const totals =
+        make_shared<vector<ReportTotals> >();
+    weak_ptr<char> const lifeline = m_lifeline;
+
+    // The task does not touch this ReportPanel; it just passes the
+    // pointer on to the callbacks it posts to the GUI thread.
+    auto const on_progress = [this, lifeline, job_id](int p_percentage)
+    {
+        post_to_gui_thread
+        (   [this, lifeline, job_id, p_percentage]()
+            {
+                if (!lifeline.expired())
+                {
+                    on_report_progress(job_id, p_percentage);
+                }
+                return;
+            }
+        );
+        return;
+    };
+    m_cancellation_token = app->task_scheduler().submit
+    (   [columns, queries, totals, on_progress]
+        (   CancellationToken const& p_token
+        )
+        {
+            *totals = accumulate_report_totals
+            (   *columns,
+                queries,
+                p_token,
+                on_progress
+            );
+            return;
+        },
+        TaskPriority::high,
+        on_gui_thread
+        (   [this, lifeline, job_id, totals](exception_ptr const& p_error)
+            {
+                if (!lifeline.expired())
+                {
+                    on_report_finished(job_id, p_error, *totals);
+                }
+                return;
+            }
+        )
+    );
+    m_is_generating = true;
+    JEWEL_ASSERT (m_progress_gauge);
+    m_progress_gauge->SetValue(0);
+    m_progress_gauge->Show();
+    Layout();
+    return;
+}
+
+void
+ReportPanel::cancel_generation()
+{
+    if (m_is_generating)
+    {
+        m_cancellation_token.cancel();
+        m_is_generating = false;
+    }
+    if (m_progress_gauge && m_progress_gauge->IsShown())
+    {
+        m_progress_gauge->Hide();
+        Layout();
+    }
+    return;
+}
+
 AccountSuperType
 ReportPanel::selected_account_super_type() const
 {
@@ -297,6 +422,57 @@ ReportPanel::on_run_button_click(wxCommandEvent& event)
     return;
 }
 
+void
+ReportPanel::on_date_text_changed(wxCommandEvent& event)
+{
+    // The Report being prepared is no longer for the range the
+    // user wants.
+    (void)event;  // Silence compiler re. unused parameter.
+    cancel_generation();
+    return;
+}
+
+void
+ReportPanel::on_report_progress(long p_job_id, int p_percentage)
+{
+    if (m_is_generating && (p_job_id == m_job_id))
+    {
+        JEWEL_ASSERT (m_progress_gauge);
+        m_progress_gauge->SetValue(p_percentage);
+    }
+    return;
+}
+
+void
+ReportPanel::on_report_finished
+(   long p_job_id,
+    exception_ptr const& p_error,
+    vector<ReportTotals> const& p_totals
+)
+{
+    if (!m_is_generating || (p_job_id != m_job_id))
+    {
+        // From a task that has since been cancelled.
+        return;
+    }
+    cancel_generation();  // hides the gauge
+    if (p_error)
+    {
+        try
+        {
+            rethrow_exception(p_error);
+        }
+        catch (TaskCancelledException&)
+        {
+            // The TaskScheduler is shutting down.
+            return;
+        }
+    }
+    JEWEL_ASSERT (m_report);
+    m_report->generate(p_totals);
+    Layout();
+    return;
+}
 
 }  // namespace gui
 }  // namespace dcm
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gui/report_totals.hpp"
+#include "ledger_snapshot.hpp"
+#include "task_scheduler.hpp"
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
+using std::function;
+using std::min;
+using std::pair;
+using std::vector;
+
+namespace dcm
+{
+namespace gui
+{
+
+vector<ReportTotals>
+accumulate_report_totals
+(   LedgerColumns const& p_columns,
+    vector<ReportQuery> const& p_queries,
+    CancellationToken const& p_token,
+    function<void(int)> const& p_on_progress
+)
+{
+    // NOTE This may be run on a TaskScheduler thread, so must not log,
+    // or touch the DcmDatabaseConnection.
+    typedef LedgerColumns::size_type size_type;
+
+    // The rows are scanned in chunks, between which we check whether we
+    // have been asked to stop, and report progress.
+    static size_type const chunk_size = 1 << 14;
+
+    vector<pair<size_type, size_type> > ranges;
+    size_type total_rows = 0;
+    for (ReportQuery const& query: p_queries)
+    {
+        ranges.push_back
+        (   rows_between
+            (   p_columns,
+                query.maybe_min_date,
+                query.maybe_max_date
+            )
+        );
+        total_rows += ranges.back().second - ranges.back().first;
+    }
+    vector<ReportTotals> ret(p_queries.size());
+    size_type rows_done = 0;
+    int last_percentage = 0;
+    for (vector<ReportQuery>::size_type i = 0; i != ranges.size(); ++i)
+    {
+        size_type chunk_begin = ranges[i].first;
+        while (chunk_begin != ranges[i].second)
+        {
+            p_token.throw_if_cancelled();
+            size_type const chunk_end =
+                min(chunk_begin + chunk_size, ranges[i].second);
+            accumulate_totals(p_columns, chunk_begin, chunk_end, ret[i], true);
+            rows_done += chunk_end - chunk_begin;
+            chunk_begin = chunk_end;
+            int const percentage =
+                static_cast<int>(100.0 * rows_done / total_rows);
+            if (p_on_progress && (percentage != last_percentage))
+            {
+                p_on_progress(percentage);
+                last_percentage = percentage;
+            }
+        }
+    }
+    return ret;
+}
+
+}  // namespace gui
+}  // namespace dcm
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gui/search_entry_list_ctrl.hpp"
+#include "account.hpp"
+#include "dcm_database_connection.hpp"
+#include "entry.hpp"
+#include "handle_cache.hpp"
+#include "gui/entry_list_ctrl.hpp"
+#include <jewel/assert.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <wx/string.h>
+#include <wx/window.h>
+#include <vector>
+
+using sqloxx::Handle;
+using sqloxx::Id;
+using std::vector;
+
+namespace dcm
+{
+namespace gui
+{
+
+namespace
+{
+    int account_col_num()
+    {
+        return 1;
+    }
+    int comment_col_num()
+    {
+        return 2;
+    }
+    int amount_col_num()
+    {
+        return 3;
+    }
+    int anon_num_columns()
+    {
+        return 4;
+    }
+
+}  // end anonymous namespace
+
+
+SearchEntryListCtrl::SearchEntryListCtrl
+(   wxWindow* p_parent,
+    wxSize const& p_size,
+    DcmDatabaseConnection& p_database_connection,
+    vector<Id> const& p_entry_ids
+):
+    EntryListCtrl(p_parent, p_size, p_database_connection),
+    m_entry_ids(p_entry_ids),
+    m_entry_id_set(p_entry_ids.begin(), p_entry_ids.end())
+{
+}
+
+SearchEntryListCtrl::~SearchEntryListCtrl()
+{
+}
+
+bool
+SearchEntryListCtrl::do_require_progress_log() const
+{
+    return false;
+}
+
+void
+SearchEntryListCtrl::do_insert_non_date_columns()
+{
+    InsertColumn(account_col_num(), wxString("Account"), wxLIST_FORMAT_LEFT);
+    InsertColumn(comment_col_num(), wxString("Memo"), wxLIST_FORMAT_LEFT);
+    InsertColumn(amount_col_num(), wxString("Amount"), wxLIST_FORMAT_RIGHT);
+    JEWEL_ASSERT (num_columns() == 4);
+    return;
+}
+
+bool
+SearchEntryListCtrl::do_approve_entry(Handle<Entry> const& p_entry) const
+{
+    return
+        p_entry->has_id() &&
+        (m_entry_id_set.find(p_entry->id()) != m_entry_id_set.end());
+}
+
+void
+SearchEntryListCtrl::do_set_non_date_columns
+(   long p_row,
+    Handle<Entry> const& p_entry
+)
+{
+    SetItem(p_row, account_col_num(), p_entry->account()->name());
+    SetItem(p_row, comment_col_num(), p_entry->comment());
+    SetItem
+    (   p_row,
+        amount_col_num(),
+        amount_formatter().format(p_entry->amount())
+    );
+    JEWEL_ASSERT (num_columns() == 4);
+    return;
+}
+
+void
+SearchEntryListCtrl::do_set_column_widths()
+{
+    autosize_column_widths();
+    adjust_comment_column_to_fit();
+    return;
+}
+
+int
+SearchEntryListCtrl::do_get_num_columns() const
+{
+    return anon_num_columns();
+}
+
+int
+SearchEntryListCtrl::do_get_comment_col_num() const
+{
+    return comment_col_num();
+}
+
+vector<Id>
+SearchEntryListCtrl::do_select_entry_ids()
+{
+    return m_entry_ids;
+}
+
+void
+SearchEntryListCtrl::do_update_for_amended(Handle<Account> const& p_account)
+{
+    // The Account may have been renamed. There are few enough rows that
+    // we can just look at them all.
+    HandleCache<Entry>& cache = database_connection().handle_cache<Entry>();
+    long const num_rows = GetItemCount();
+    for (long i = 0; i != num_rows; ++i)
+    {
+        Handle<Entry> const entry = cache.provide(GetItemData(i));
+        if (entry->account() == p_account)
+        {
+            SetItem(i, account_col_num(), p_account->name());
+        }
+    }
+    return;
+}
+
+}  // namespace gui
+}  // namespace dcm
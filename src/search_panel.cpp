@@ -0,0 +1,314 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gui/search_panel.hpp"
+#include "commodity.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include "entry.hpp"
+#include "entry_search.hpp"
+#include "string_conv.hpp"
+#include "gui/button.hpp"
+#include "gui/date_ctrl.hpp"
+#include "gui/decimal_text_ctrl.hpp"
+#include "gui/entry_list_ctrl.hpp"
+#include "gui/sizing.hpp"
+#include "gui/text_ctrl.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/decimal.hpp>
+#include <jewel/optional.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <wx/event.h>
+#include <wx/gbsizer.h>
+#include <wx/panel.h>
+#include <wx/stattext.h>
+#include <wx/string.h>
+#include <wx/window.h>
+#include <wx/wupdlock.h>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+using boost::lexical_cast;
+using boost::optional;
+using jewel::Decimal;
+using jewel::value;
+using sqloxx::Handle;
+using sqloxx::Id;
+using std::string;
+using std::vector;
+
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+namespace gui
+{
+
+BEGIN_EVENT_TABLE(SearchPanel, wxPanel)
+    EVT_BUTTON(s_search_button_id, SearchPanel::on_search_button_click)
+END_EVENT_TABLE()
+
+
+namespace
+{
+    wxString result_count_text
+    (   vector<Id>::size_type p_num_results,
+        std::size_t p_max_results
+    )
+    {
+        if (p_num_results == 0)
+        {
+            return wxString("No matches found.");
+        }
+        if (p_num_results == 1)
+        {
+            return wxString("1 match found.");
+        }
+        wxString const num = std8_to_wx(lexical_cast<string>(p_num_results));
+        if (p_num_results == p_max_results)
+        {
+            return
+                wxString("Showing the best ") + num +
+                wxString(" matches; narrow the search to see others.");
+        }
+        return num + wxString(" matches found, best first.");
+    }
+
+}  // end anonymous namespace
+
+
+SearchPanel::SearchPanel
+(   wxWindow* p_parent,
+    DcmDatabaseConnection& p_database_connection
+):
+    wxPanel(p_parent, wxID_ANY),
+    m_next_row(0),
+    m_client_size_aux(0),
+    m_top_sizer(nullptr),
+    m_text_ctrl(nullptr),
+    m_min_date_ctrl(nullptr),
+    m_max_date_ctrl(nullptr),
+    m_min_amount_ctrl(nullptr),
+    m_max_amount_ctrl(nullptr),
+    m_search_button(nullptr),
+    m_result_count_text(nullptr),
+    m_entry_list_ctrl(nullptr),
+    m_database_connection(p_database_connection)
+{
+    m_top_sizer = new wxGridBagSizer(standard_gap(), standard_gap());
+    SetSizer(m_top_sizer);
+
+    ++m_next_row;  // To leave some space at top.
+
+    wxString const label_texts[] =
+    {   wxString(" Search for:"),
+        wxString(" From:"),
+        wxString(" To:"),
+        wxString(" Amount at least:"),
+        wxString(" Amount at most:")
+    };
+    int col = 1;
+    for (wxString const& label_text: label_texts)
+    {
+        wxStaticText* label = new wxStaticText(this, wxID_ANY, label_text);
+        label->Wrap((col == 1)? large_width(): medium_width());
+        m_top_sizer->Add(label, wxGBPosition(m_next_row, col));
+        ++col;
+    }
+
+    ++m_next_row;
+
+    m_text_ctrl = new TextCtrl
+    (   this,
+        s_text_ctrl_id,
+        wxEmptyString,
+        wxDefaultPosition,
+        wxSize(large_width(), wxDefaultSize.y)
+    );
+    int const std_height = m_text_ctrl->GetSize().GetHeight();
+    m_top_sizer->Add(m_text_ctrl, wxGBPosition(m_next_row, 1));
+
+    bool const allow_blank_dates = true;
+    m_min_date_ctrl = new DateCtrl
+    (   this,
+        s_min_date_ctrl_id,
+        wxSize(medium_width(), std_height),
+        today(),
+        allow_blank_dates
+    );
+    m_min_date_ctrl->set_date(optional<gregorian::date>());
+    m_top_sizer->Add(m_min_date_ctrl, wxGBPosition(m_next_row, 2));
+    m_max_date_ctrl = new DateCtrl
+    (   this,
+        s_max_date_ctrl_id,
+        wxSize(medium_width(), std_height),
+        today(),
+        allow_blank_dates
+    );
+    m_max_date_ctrl->set_date(optional<gregorian::date>());
+    m_top_sizer->Add(m_max_date_ctrl, wxGBPosition(m_next_row, 3));
+
+    Decimal::places_type const precision =
+        m_database_connection.default_commodity()->precision();
+    m_min_amount_ctrl = new DecimalTextCtrl
+    (   this,
+        s_min_amount_ctrl_id,
+        wxSize(medium_width(), std_height),
+        precision
+    );
+    m_min_amount_ctrl->set_amount(Decimal(0, precision));
+    m_top_sizer->Add(m_min_amount_ctrl, wxGBPosition(m_next_row, 4));
+    m_max_amount_ctrl = new DecimalTextCtrl
+    (   this,
+        s_max_amount_ctrl_id,
+        wxSize(medium_width(), std_height),
+        precision
+    );
+    m_max_amount_ctrl->set_amount(Decimal(0, precision));
+    m_top_sizer->Add(m_max_amount_ctrl, wxGBPosition(m_next_row, 5));
+
+    m_search_button = new Button
+    (   this,
+        s_search_button_id,
+        wxString("&Search"),
+        wxDefaultPosition,
+        m_max_amount_ctrl->GetSize()
+    );
+    m_search_button->SetDefault();
+    m_top_sizer->Add(m_search_button, wxGBPosition(m_next_row, 6));
+
+    ++m_next_row;
+
+    m_result_count_text = new wxStaticText
+    (   this,
+        wxID_ANY,
+        wxEmptyString,
+        wxDefaultPosition,
+        wxSize(large_width(), wxDefaultSize.y)
+    );
+    m_top_sizer->Add(m_result_count_text, wxGBPosition(m_next_row, 1));
+
+    ++m_next_row;
+
+    // "Admin"
+    m_top_sizer->Fit(this);
+    m_top_sizer->SetSizeHints(this);
+    Fit();
+    Layout();
+}
+
+SearchPanel::~SearchPanel()
+{
+}
+
+void
+SearchPanel::on_search_button_click(wxCommandEvent& event)
+{
+    (void)event;  // Silence compiler re. unused parameter.
+    run(query_from_controls());
+    return;
+}
+
+void
+SearchPanel::update_for_changes()
+{
+    if (m_maybe_query) run(value(m_maybe_query));
+    return;
+}
+
+vector<Handle<Entry> >
+SearchPanel::selected_entries()
+{
+    vector<Handle<Entry> > ret;
+    if (m_entry_list_ctrl) ret = m_entry_list_ctrl->selected_entries();
+    return ret;
+}
+
+void
+SearchPanel::run(EntrySearchQuery const& p_query)
+{
+    wxWindowUpdateLocker const update_locker(this);
+    vector<Id> const entry_ids =
+        search_entries(m_database_connection, p_query);
+    m_maybe_query = p_query;
+
+    int const num_extra_rows = 3;
+    int const height_aux = list_height_below_rows
+    (   *this,
+        m_client_size_aux,
+        num_extra_rows,
+        m_text_ctrl->GetSize().GetY()
+    );
+
+    EntryListCtrl* temp = EntryListCtrl::create_search_entry_list
+    (   this,
+        wxSize
+        (   large_width() + medium_width() * 5 + standard_gap() * 5,
+            height_aux
+        ),
+        m_database_connection,
+        entry_ids
+    );
+    using std::swap;
+    swap(temp, m_entry_list_ctrl);
+    if (temp)
+    {
+        m_top_sizer->Detach(temp);
+        temp->Destroy();
+        temp = nullptr;
+        --m_next_row;
+    }
+    JEWEL_ASSERT (m_entry_list_ctrl);
+    m_top_sizer->Add
+    (   m_entry_list_ctrl,
+        wxGBPosition(m_next_row, 1),
+        wxGBSpan(1, 6),
+        wxEXPAND
+    );
+    ++m_next_row;
+
+    JEWEL_ASSERT (m_result_count_text);
+    m_result_count_text->SetLabel
+    (   result_count_text(entry_ids.size(), p_query.max_results)
+    );
+    Fit();
+    Layout();
+    return;
+}
+
+EntrySearchQuery
+SearchPanel::query_from_controls()
+{
+    EntrySearchQuery ret;
+    JEWEL_ASSERT (m_text_ctrl);
+    ret.text = m_text_ctrl->GetValue();
+    ret.min_date = m_min_date_ctrl->date();
+    ret.max_date = m_max_date_ctrl->date();
+    Decimal const min_amount = m_min_amount_ctrl->amount();
+    if (min_amount != Decimal(0, 0)) ret.min_amount = min_amount;
+    Decimal const max_amount = m_max_amount_ctrl->amount();
+    if (max_amount != Decimal(0, 0)) ret.max_amount = max_amount;
+    return ret;
+}
+
+}  // namespace gui
+}  // namespace dcm
@@ -15,8 +15,10 @@
  */
 
 #include "gui/sizing.hpp"
+#include <jewel/on_windows.hpp>
 #include <wx/gdicmn.h>
 #include <wx/settings.h>
+#include <wx/window.h>
 
 namespace dcm
 {
@@ -84,5 +86,30 @@ int scrollbar_width_allowance()
     return 20;
 }
 
+int
+list_height_below_rows
+(   wxWindow const& p_window,
+    int& p_client_height,
+    int p_num_rows,
+    int p_row_height
+)
+{
+    if (p_client_height < 100)
+    {
+        p_client_height = p_window.GetClientSize().GetY();
+    }
+    int ret =
+        p_client_height -
+        p_row_height * p_num_rows -
+        standard_gap() * (p_num_rows + 1) -
+        standard_border() * 2;
+
+#   ifdef JEWEL_ON_WINDOWS
+        ret -= standard_gap() * (p_num_rows + 1);
+#   endif
+
+    return ret;
+}
+
 }  // namespace gui
 }  // namespace dcm
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gui/task_bridge.hpp"
+#include "task_scheduler.hpp"
+#include <wx/app.h>
+#include <wx/event.h>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+using std::deque;
+using std::exception_ptr;
+using std::function;
+using std::lock_guard;
+using std::mutex;
+
+namespace dcm
+{
+namespace gui
+{
+
+namespace
+{
+    mutex& callbacks_mutex()
+    {
+        static mutex ret;
+        return ret;
+    }
+
+    // Guarded by callbacks_mutex().
+    deque<function<void()> >& callbacks()
+    {
+        static deque<function<void()> > ret;
+        return ret;
+    }
+
+    // Should be called with callbacks_mutex() held.
+    void queue_event()
+    {
+        wxEvtHandler* const app = wxTheApp;
+        if (app)
+        {
+            wxQueueEvent
+            (   app,
+                new wxThreadEvent(wxEVT_COMMAND_THREAD, gui_callback_event_id)
+            );
+        }
+        return;
+    }
+
+}  // end anonymous namespace
+
+void
+post_to_gui_thread(function<void()> const& p_callback)
+{
+    lock_guard<mutex> const lock(callbacks_mutex());
+    callbacks().push_back(p_callback);
+
+    // If there were already callbacks waiting, an event has already
+    // been queued for them, which will pick this one up too.
+    if (callbacks().size() == 1)
+    {
+        queue_event();
+    }
+    return;
+}
+
+TaskScheduler::Completion
+on_gui_thread(TaskScheduler::Completion const& p_completion)
+{
+    return [p_completion](exception_ptr const& p_error)
+    {
+        post_to_gui_thread
+        (   [p_completion, p_error]() { p_completion(p_error); }
+        );
+    };
+}
+
+void
+run_gui_callbacks()
+{
+    while (true)
+    {
+        function<void()> callback;
+        {
+            lock_guard<mutex> const lock(callbacks_mutex());
+            if (callbacks().empty())
+            {
+                return;
+            }
+            callback = callbacks().front();
+            callbacks().pop_front();
+        }
+        try
+        {
+            callback();
+        }
+        catch (...)
+        {
+            // Make sure any remaining callbacks are not stranded.
+            lock_guard<mutex> const lock(callbacks_mutex());
+            if (!callbacks().empty()) queue_event();
+            throw;
+        }
+    }
+}
+
+}  // namespace gui
+}  // namespace dcm
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "task_scheduler.hpp"
+#include "dcm_exceptions.hpp"
+#include <jewel/assert.hpp>
+#include <jewel/log.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using std::atomic;
+using std::current_exception;
+using std::deque;
+using std::exception_ptr;
+using std::lock_guard;
+using std::make_shared;
+using std::move;
+using std::mutex;
+using std::size_t;
+using std::thread;
+using std::unique_lock;
+using std::unique_ptr;
+using std::vector;
+
+namespace dcm
+{
+
+CancellationToken::CancellationToken():
+    m_flag(make_shared<atomic<bool> >(false))
+{
+}
+
+void
+CancellationToken::cancel()
+{
+    m_flag->store(true);
+    return;
+}
+
+bool
+CancellationToken::is_cancelled() const
+{
+    return m_flag->load();
+}
+
+void
+CancellationToken::throw_if_cancelled() const
+{
+    if (is_cancelled())
+    {
+        JEWEL_THROW(TaskCancelledException, "Task cancelled.");
+    }
+    return;
+}
+
+size_t const TaskScheduler::s_num_priorities;
+
+TaskScheduler::TaskScheduler(size_t p_num_threads):
+    m_num_queued(0),
+    m_num_unfinished(0),
+    m_next_queue(0),
+    m_stopping(false)
+{
+    JEWEL_LOG_TRACE();
+    if (p_num_threads == 0)
+    {
+        p_num_threads = default_num_threads();
+    }
+    for (size_t i = 0; i != p_num_threads; ++i)
+    {
+        m_queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue));
+    }
+    try
+    {
+        for (size_t i = 0; i != p_num_threads; ++i)
+        {
+            m_threads.push_back(thread(&TaskScheduler::run_worker, this, i));
+        }
+    }
+    catch (...)
+    {
+        {
+            lock_guard<mutex> const lock(m_mutex);
+            m_stopping = true;
+        }
+        m_work_available.notify_all();
+        for (thread& t: m_threads) t.join();
+        throw;
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    JEWEL_LOG_TRACE();
+    {
+        lock_guard<mutex> const lock(m_mutex);
+        m_stopping = true;
+        for (unique_ptr<WorkerQueue> const& queue: m_queues)
+        {
+            lock_guard<mutex> const queue_lock(queue->mutex);
+            for (deque<Job>& jobs: queue->jobs)
+            {
+                for (Job& job: jobs) job.token.cancel();
+            }
+            if (queue->current_token) queue->current_token->cancel();
+        }
+    }
+    // The threads now abandon whatever remains in the queues, calling
+    // the Completions, before they stop.
+    m_work_available.notify_all();
+    for (thread& t: m_threads) t.join();
+    JEWEL_ASSERT (m_num_queued == 0);
+    JEWEL_ASSERT (m_num_unfinished == 0);
+}
+
+CancellationToken
+TaskScheduler::submit
+(   Task const& p_task,
+    TaskPriority p_priority,
+    Completion const& p_completion
+)
+{
+    JEWEL_ASSERT (p_task);
+    JEWEL_ASSERT (p_priority != TaskPriority::num_task_priorities);
+    Job job;
+    job.task = p_task;
+    job.completion = p_completion;
+    CancellationToken const ret = job.token;
+    {
+        lock_guard<mutex> const lock(m_mutex);
+        JEWEL_ASSERT (!m_stopping);
+        ++m_num_unfinished;
+        ++m_num_queued;
+        WorkerQueue& queue = *m_queues[m_next_queue];
+        m_next_queue = (m_next_queue + 1) % m_queues.size();
+        lock_guard<mutex> const queue_lock(queue.mutex);
+        queue.jobs[static_cast<size_t>(p_priority)].push_back(move(job));
+    }
+    m_work_available.notify_one();
+    return ret;
+}
+
+void
+TaskScheduler::wait_until_idle()
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (m_num_unfinished != 0)
+    {
+        m_idle.wait(lock);
+    }
+    return;
+}
+
+size_t
+TaskScheduler::num_threads() const
+{
+    return m_threads.size();
+}
+
+size_t
+TaskScheduler::default_num_threads()
+{
+    // hardware_concurrency() returns 0 if it cannot tell.
+    size_t const hardware_threads = thread::hardware_concurrency();
+    return (hardware_threads > 2)? (hardware_threads - 1): 1;
+}
+
+void
+TaskScheduler::run_worker(size_t p_index)
+{
+    while (true)
+    {
+        Job job;
+        if (pop_job(p_index, job))
+        {
+            run_job(p_index, job);
+            lock_guard<mutex> const lock(m_mutex);
+            JEWEL_ASSERT (m_num_unfinished > 0);
+            if (--m_num_unfinished == 0)
+            {
+                m_idle.notify_all();
+            }
+            continue;
+        }
+        unique_lock<mutex> lock(m_mutex);
+        if (m_num_queued == 0)
+        {
+            if (m_stopping)
+            {
+                return;
+            }
+            m_work_available.wait(lock);
+        }
+    }
+}
+
+bool
+TaskScheduler::pop_job(size_t p_index, Job& p_job)
+{
+    size_t const num_queues = m_queues.size();
+    for (size_t priority = 0; priority != s_num_priorities; ++priority)
+    {
+        // Own queue first, from the front; then the others, from the
+        // back.
+        for (size_t i = 0; i != num_queues; ++i)
+        {
+            WorkerQueue& queue = *m_queues[(p_index + i) % num_queues];
+            lock_guard<mutex> const queue_lock(queue.mutex);
+            deque<Job>& jobs = queue.jobs[priority];
+            if (jobs.empty())
+            {
+                continue;
+            }
+            if (i == 0)
+            {
+                p_job = move(jobs.front());
+                jobs.pop_front();
+            }
+            else
+            {
+                p_job = move(jobs.back());
+                jobs.pop_back();
+            }
+            --m_num_queued;
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+TaskScheduler::run_job(size_t p_index, Job& p_job)
+{
+    WorkerQueue& queue = *m_queues[p_index];
+    {
+        lock_guard<mutex> const queue_lock(queue.mutex);
+        queue.current_token.reset(new CancellationToken(p_job.token));
+    }
+    exception_ptr error;
+    try
+    {
+        p_job.token.throw_if_cancelled();
+        p_job.task(p_job.token);
+    }
+    catch (...)
+    {
+        error = current_exception();
+    }
+    {
+        lock_guard<mutex> const queue_lock(queue.mutex);
+        queue.current_token.reset();
+    }
+    if (p_job.completion)
+    {
+        // An exception escaping this thread would terminate the
+        // application, and there is nobody else to pass it on to. Nor can
+        // we log it, as we are not on the GUI thread. Completions must not
+        // throw.
+        try
+        {
+            p_job.completion(error);
+        }
+        catch (...)
+        {
+            // Discard it, and carry on running tasks.
+        }
+    }
+    return;
+}
+
+}  // namespace dcm
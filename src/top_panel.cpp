@@ -22,16 +22,20 @@
 #include "draft_journal_table_iterator.hpp"
 #include "entry.hpp"
 #include "ordinary_journal.hpp"
+#include "persistent_journal.hpp"
 #include "proto_journal.hpp"
 #include "dcm_database_connection.hpp"
 #include "transaction_side.hpp"
 #include "transaction_type.hpp"
+#include "warm_start_cache.hpp"
 #include "gui/account_list_ctrl.hpp"
+#include "gui/change_set.hpp"
 #include "gui/draft_journal_list_ctrl.hpp"
 #include "gui/entry_list_panel.hpp"
 #include "gui/frame.hpp"
 #include "gui/reconciliation_list_panel.hpp"
 #include "gui/report_panel.hpp"
+#include "gui/search_panel.hpp"
 #include "gui/sizing.hpp"
 #include "gui/transaction_ctrl.hpp"
 #include <boost/optional.hpp>
@@ -40,6 +44,8 @@
 #include <jewel/optional.hpp>
 #include <sqloxx/handle.hpp>
 #include <sqloxx/id.hpp>
+#include <wx/bookctrl.h>
+#include <wx/event.h>
 #include <wx/notebook.h>
 #include <wx/panel.h>
 #include <wx/sizer.h>
@@ -67,9 +73,17 @@ namespace dcm
 namespace gui
 {
 
+BEGIN_EVENT_TABLE(TopPanel, wxPanel)
+    EVT_NOTEBOOK_PAGE_CHANGED
+    (   wxID_ANY,
+        TopPanel::on_notebook_page_changed
+    )
+END_EVENT_TABLE()
+
 TopPanel::TopPanel
 (   Frame* p_parent,
-    DcmDatabaseConnection& p_database_connection
+    DcmDatabaseConnection& p_database_connection,
+    WarmStartCache& p_warm_start_cache
 ):
     wxPanel
     (   p_parent,
@@ -79,20 +93,26 @@ TopPanel::TopPanel
         wxFULL_REPAINT_ON_RESIZE
     ),
     m_database_connection(p_database_connection),
+    m_warm_start_cache(p_warm_start_cache),
     m_top_sizer(nullptr),
     m_notebook(nullptr),
     m_notebook_page_accounts(nullptr),
     m_notebook_page_transactions(nullptr),
     m_notebook_page_reconciliations(nullptr),
     m_notebook_page_reports(nullptr),
+    m_notebook_page_search(nullptr),
     m_right_column_sizer(nullptr),
     m_bs_account_list(nullptr),
     m_pl_account_list(nullptr),
     m_entry_list_panel(nullptr),
     m_reconciliation_panel(nullptr),
     m_report_panel(nullptr),
+    m_search_panel(nullptr),
     m_transaction_ctrl(nullptr),
-    m_draft_journal_list(nullptr)
+    m_draft_journal_list(nullptr),
+    m_entry_list_page_stale(false),
+    m_reconciliation_page_stale(false),
+    m_search_page_stale(false)
 {
     m_top_sizer = new wxBoxSizer(wxHORIZONTAL);
     SetSizer(m_top_sizer);
@@ -113,6 +133,7 @@ TopPanel::TopPanel
     m_notebook_page_transactions = new wxPanel(m_notebook, wxID_ANY);
     m_notebook_page_reconciliations = new wxPanel(m_notebook, wxID_ANY);
     m_notebook_page_reports = new wxPanel(m_notebook, wxID_ANY);
+    m_notebook_page_search = new wxPanel(m_notebook, wxID_ANY);
     m_notebook->AddPage
     (   m_notebook_page_accounts,
         wxString("Balances"),
@@ -133,22 +154,91 @@ TopPanel::TopPanel
         wxString("Reports"),
         false
     );
+    m_notebook->AddPage
+    (   m_notebook_page_search,
+        wxString("Search"),
+        false
+    );
     m_top_sizer->Add
     (   m_right_column_sizer,
         wxSizerFlags(4).Expand().
             Border(wxNORTH | wxSOUTH | wxWEST | wxEAST, standard_border())
     );
     configure_account_lists();
-    configure_entry_list();
-    configure_reconciliation_page();
-    configure_report_page();
-    configure_transaction_ctrl();
+
+    // The other notebook pages are populated only when first shown (see
+    // on_notebook_page_changed(...)). The balances, the initial selection
+    // of Accounts and the TransactionCtrl wait for complete_startup(),
+    // unless the WarmStartCache can stand in for them until then.
+
+    if (m_warm_start_cache.is_loaded())
+    {
+        m_bs_account_list->show_provisional_figures
+        (   m_warm_start_cache.account_figures()
+        );
+        m_pl_account_list->show_provisional_figures
+        (   m_warm_start_cache.account_figures()
+        );
+        select_accounts(m_warm_start_cache.favourite_accounts());
+        configure_transaction_ctrl();
+    }
     configure_draft_journal_list_ctrl();
     m_top_sizer->Fit(this);
     m_top_sizer->SetSizeHints(this);
     Layout();
 }
 
+void
+TopPanel::complete_startup()
+{
+    JEWEL_ASSERT (m_bs_account_list);
+    JEWEL_ASSERT (m_pl_account_list);
+    wxWindowUpdateLocker const window_update_locker(this);
+
+    // If the user has already caused the TransactionCtrl to be
+    // configured, then leave their selection alone.
+    if (!m_transaction_ctrl)
+    {
+        select_accounts(favourite_accounts(m_database_connection));
+        configure_transaction_ctrl();
+    }
+    m_bs_account_list->show_balances();
+    m_pl_account_list->show_balances();
+    Layout();
+    return;
+}
+
+void
+TopPanel::record_warm_start_state()
+{
+    if (m_entry_list_panel)
+    {
+        m_warm_start_cache.set_entry_list_filter(m_entry_list_panel->filter());
+    }
+    return;
+}
+
+void
+TopPanel::select_accounts
+(   map<AccountSuperType, sqloxx::Id> const& p_account_ids
+)
+{
+    JEWEL_ASSERT (p_account_ids.size() == 2);
+    m_bs_account_list->select_only
+    (   Handle<Account>
+        (   m_database_connection,
+            p_account_ids.at(AccountSuperType::balance_sheet)
+        )
+    );
+    m_pl_account_list->select_only
+    (   Handle<Account>
+        (   m_database_connection,
+            p_account_ids.at(AccountSuperType::pl)
+        )
+    );
+    return;
+}
+
 // TODO LOW PRIORITY We have no consistent convention here about what is named
 // "configure" and what is named "update", in relation to when each such
 // function gets called (i.e. once, or every update, or...?).
@@ -160,27 +250,14 @@ TopPanel::configure_account_lists()
     m_bs_account_list = new AccountListCtrl
     (   m_notebook_page_accounts,
         m_database_connection,
-        AccountSuperType::balance_sheet
+        AccountSuperType::balance_sheet,
+        false
     );
     m_pl_account_list = new AccountListCtrl
     (   m_notebook_page_accounts,
         m_database_connection,
-        AccountSuperType::pl
-    );
-    map<AccountSuperType, sqloxx::Id> const fav_accts =
-        favourite_accounts(m_database_connection);
-    JEWEL_ASSERT (fav_accts.size() == 2);
-    m_bs_account_list->select_only
-    (   Handle<Account>
-        (   m_database_connection,
-            fav_accts.at(AccountSuperType::balance_sheet)
-        )
-    );
-    m_pl_account_list->select_only
-    (   Handle<Account>
-        (   m_database_connection,
-            fav_accts.at(AccountSuperType::pl)
-        )
+        AccountSuperType::pl,
+        false
     );
     wxBoxSizer* page_1_sizer = new wxBoxSizer(wxHORIZONTAL);
     page_1_sizer->Add
@@ -210,6 +287,12 @@ TopPanel::configure_entry_list()
     (   m_notebook_page_transactions,
         m_database_connection
     );
+    if (m_warm_start_cache.entry_list_filter())
+    {
+        m_entry_list_panel->set_filter
+        (   value(m_warm_start_cache.entry_list_filter())
+        );
+    }
     wxBoxSizer* page_2_sizer = new wxBoxSizer(wxHORIZONTAL);
     page_2_sizer->Add(m_entry_list_panel, wxSizerFlags(1).Expand());
     m_notebook_page_transactions->SetSizer(page_2_sizer);
@@ -258,6 +341,100 @@ TopPanel::configure_report_page()
     return;
 }
 
+void
+TopPanel::configure_search_page()
+{
+    JEWEL_ASSERT (m_notebook_page_search);
+    JEWEL_ASSERT (!m_search_panel);
+    m_search_panel =
+        new SearchPanel(m_notebook_page_search, m_database_connection);
+    wxBoxSizer* page_5_sizer = new wxBoxSizer(wxHORIZONTAL);
+    page_5_sizer->Add(m_search_panel, wxSizerFlags(1).Expand());
+    m_notebook_page_search->SetSizer(page_5_sizer);
+    page_5_sizer->Fit(m_notebook_page_search);
+    page_5_sizer->SetSizeHints(m_notebook_page_search);
+    m_notebook_page_search->Fit();
+    Layout();
+    return;
+}
+
+void
+TopPanel::on_notebook_page_changed(wxBookCtrlEvent& event)
+{
+    // Notebooks nested within the pages would also send us this event.
+    if (event.GetEventObject() != m_notebook)
+    {
+        event.Skip();
+        return;
+    }
+    wxWindow* const page = m_notebook->GetPage(event.GetSelection());
+    bool created = false;
+    if (page == static_cast<wxWindow*>(m_notebook_page_transactions))
+    {
+        if (!m_entry_list_panel)
+        {
+            configure_entry_list();
+            created = true;
+        }
+        else if (m_entry_list_page_stale)
+        {
+            m_entry_list_panel->update_for_bulk_changes();
+        }
+        m_entry_list_page_stale = false;
+    }
+    else if (page == static_cast<wxWindow*>(m_notebook_page_reconciliations))
+    {
+        if (!m_reconciliation_panel)
+        {
+            configure_reconciliation_page();
+            created = true;
+        }
+        else if (m_reconciliation_page_stale)
+        {
+            m_reconciliation_panel->update_for_bulk_changes();
+        }
+        m_reconciliation_page_stale = false;
+    }
+    else if (page == static_cast<wxWindow*>(m_notebook_page_reports))
+    {
+        // The Report does not update itself for changes (the user must
+        // re-run it), so it is never stale.
+        if (!m_report_panel)
+        {
+            configure_report_page();
+            created = true;
+        }
+    }
+    else if (page == static_cast<wxWindow*>(m_notebook_page_search))
+    {
+        if (!m_search_panel)
+        {
+            configure_search_page();
+            created = true;
+        }
+        else if (m_search_page_stale)
+        {
+            m_search_panel->update_for_changes();
+        }
+        m_search_page_stale = false;
+    }
+    if (created)
+    {
+        // Fitting the new page to its contents may have left it smaller
+        // than the notebook; have the notebook size it again.
+        m_notebook->SendSizeEvent();
+    }
+    event.Skip();
+    return;
+}
+
+bool
+TopPanel::is_current_page(wxWindow* p_page) const
+{
+    JEWEL_ASSERT (m_notebook);
+    return m_notebook->GetCurrentPage() == p_page;
+}
+
 ProtoJournal
 TopPanel::make_proto_journal() const
 {
@@ -483,14 +660,27 @@ TopPanel::selected_ordinary_journals() const
     vector<Handle<Entry> > entries;
     JEWEL_ASSERT (m_notebook);
     wxWindow* const page = m_notebook->GetCurrentPage();
-    if (page == static_cast<wxWindow*>(m_notebook_page_transactions))
+    if
+    (   (page == static_cast<wxWindow*>(m_notebook_page_transactions)) &&
+        m_entry_list_panel
+    )
     {
         entries = m_entry_list_panel->selected_entries();
     }
-    else if (page == static_cast<wxWindow*>(m_notebook_page_reconciliations))
+    else if
+    (   (page == static_cast<wxWindow*>(m_notebook_page_reconciliations)) &&
+        m_reconciliation_panel
+    )
     {
         entries = m_reconciliation_panel->selected_entries();
     }
+    else if
+    (   (page == static_cast<wxWindow*>(m_notebook_page_search)) &&
+        m_search_panel
+    )
+    {
+        entries = m_search_panel->selected_entries();
+    }
     for (Handle<Entry> const& entry: entries)
     {
         Handle<OrdinaryJournal> const oj
@@ -509,149 +699,235 @@ TopPanel::selected_draft_journals() const
 }
 
 void
-TopPanel::update_for_new(Handle<OrdinaryJournal> const& p_saved_object)
+TopPanel::update_for_changes(ChangeSet const& p_changes)
 {
-    m_bs_account_list->update();
-    m_pl_account_list->update();
-    m_entry_list_panel->update_for_new(p_saved_object);
-    m_reconciliation_panel->update_for_new(p_saved_object);
-    m_report_panel->update_for_new(p_saved_object);
-    // configure_transaction_ctrl();  // Don't do this!
-    configure_draft_journal_list_ctrl();
-    return;
-}
+    JEWEL_LOG_TRACE();
+    JEWEL_ASSERT (m_bs_account_list);
+    JEWEL_ASSERT (m_pl_account_list);
 
-void
-TopPanel::update_for_new(Handle<DraftJournal> const& p_saved_object)
-{
-    (void)p_saved_object;  // Silence compiler re. unused parameter.
-    // m_bs_account_list->update();  // No point doing this here.
-    // m_pl_account_list->update(); // No point doing this here.
-    // configure_transaction_ctrl();  // Don't do this!
-    configure_draft_journal_list_ctrl();
-    return;
-}
+    // Sort the created and edited journals by type up front, as only
+    // OrdinaryJournals bear on the balances shown in the AccountListCtrls.
+    vector<Handle<OrdinaryJournal> > new_ordinary_journals;
+    vector<Handle<OrdinaryJournal> > amended_ordinary_journals;
+    bool draft_journals_changed =
+        !p_changes.ids(ChangeKind::draft_journal_deleted).empty();
+    for (sqloxx::Id const id: p_changes.ids(ChangeKind::journal_created))
+    {
+        if (journal_id_is_draft(m_database_connection, id))
+        {
+            draft_journals_changed = true;
+        }
+        else
+        {
+            new_ordinary_journals.push_back
+            (   Handle<OrdinaryJournal>(m_database_connection, id)
+            );
+        }
+    }
+    for (sqloxx::Id const id: p_changes.ids(ChangeKind::journal_edited))
+    {
+        if (journal_id_is_draft(m_database_connection, id))
+        {
+            draft_journals_changed = true;
+        }
+        else
+        {
+            amended_ordinary_journals.push_back
+            (   Handle<OrdinaryJournal>(m_database_connection, id)
+            );
+        }
+    }
+    vector<sqloxx::Id> const& new_account_ids =
+        p_changes.ids(ChangeKind::account_created);
+    vector<sqloxx::Id> const& amended_account_ids =
+        p_changes.ids(ChangeKind::account_edited);
+    vector<sqloxx::Id> const& budget_account_ids =
+        p_changes.ids(ChangeKind::budget_edited);
+
+    // Editing a DraftJournal does not change any balances, but the
+    // AccountListCtrls have always been refreshed for it, so we keep
+    // doing that.
+    bool const balances_changed =
+        !new_ordinary_journals.empty() ||
+        !p_changes.ids(ChangeKind::journal_edited).empty() ||
+        !p_changes.ids(ChangeKind::ordinary_journal_deleted).empty() ||
+        !new_account_ids.empty() ||
+        !amended_account_ids.empty();
+    if (balances_changed)
+    {
+        m_bs_account_list->update();
+    }
+    if (balances_changed || !budget_account_ids.empty())
+    {
+        m_pl_account_list->update();
+    }
 
-void
-TopPanel::update_for_new(Handle<Account> const& p_saved_object)
-{
-    m_bs_account_list->update();
-    m_pl_account_list->update();
-    m_entry_list_panel->update_for_new(p_saved_object);
-    m_reconciliation_panel->update_for_new(p_saved_object);
-    m_report_panel->update_for_new(p_saved_object);
-    m_transaction_ctrl->update_for_new(p_saved_object);
-    configure_draft_journal_list_ctrl();
-    return;
-}
+    // Notebook pages not currently shown are not updated now, but are
+    // marked as stale, to be brought up to date when next shown. Pages
+    // not yet shown at all have not been created yet, and will reflect
+    // the database when they are.
+    vector<sqloxx::Id> const& doomed_entry_ids =
+        p_changes.ids(ChangeKind::ordinary_entry_deleted);
+    bool const entries_changed =
+        !doomed_entry_ids.empty() ||
+        !new_account_ids.empty() ||
+        !amended_account_ids.empty() ||
+        !new_ordinary_journals.empty() ||
+        !amended_ordinary_journals.empty();
+    EntryListPanel* entry_list_panel = m_entry_list_panel;
+    if (entry_list_panel && !is_current_page(m_notebook_page_transactions))
+    {
+        if (entries_changed) m_entry_list_page_stale = true;
+        entry_list_panel = nullptr;
+    }
+    ReconciliationListPanel* reconciliation_panel = m_reconciliation_panel;
+    if
+    (   reconciliation_panel &&
+        !is_current_page(m_notebook_page_reconciliations)
+    )
+    {
+        if (entries_changed) m_reconciliation_page_stale = true;
+        reconciliation_panel = nullptr;
+    }
+    ReportPanel* const report_panel = m_report_panel;
 
-void
-TopPanel::update_for_amended(Handle<OrdinaryJournal> const& p_saved_object)
-{
-    m_bs_account_list->update();
-    m_pl_account_list->update();
-    m_entry_list_panel->update_for_amended(p_saved_object);
-    m_reconciliation_panel->update_for_amended(p_saved_object);
-    m_report_panel->update_for_amended(p_saved_object);
-    // configure_transaction_ctrl();  // Don't do this!
-    configure_draft_journal_list_ctrl();
-    return;
-}
+    // The SearchPanel runs its search again, rather than being updated
+    // piecemeal, so that its results stay in order of relevance.
+    if (m_search_panel && entries_changed)
+    {
+        if (is_current_page(m_notebook_page_search))
+        {
+            m_search_panel->update_for_changes();
+        }
+        else
+        {
+            m_search_page_stale = true;
+        }
+    }
 
-void
-TopPanel::update_for_amended(Handle<DraftJournal> const& p_saved_object)
-{
-    (void)p_saved_object;  // Silence compiler re. unused parameter.
-    m_bs_account_list->update();
-    m_pl_account_list->update();
-    // m_entry_list_panel->update_for_amended(p_saved_object);  // Does not apply for DraftJournal.
-    // m_reconciliation_panel->update_for_amended(p_saved_object);  // Does not apply for DraftJournal.
-    // configure_transaction_ctrl();  // Don't do this!
-    configure_draft_journal_list_ctrl();
-    return;
-}
+    // Deletions. DraftJournal Entries are not displayed individually
+    // in the top panel (except possibly TransactionCtrl, but that can take
+    // care of itself), so ChangeKind::draft_entry_deleted needs no
+    // processing here.
+    if (!doomed_entry_ids.empty())
+    {
+        if (entry_list_panel)
+        {
+            entry_list_panel->update_for_deleted(doomed_entry_ids);
+        }
+        if (reconciliation_panel)
+        {
+            reconciliation_panel->update_for_deleted(doomed_entry_ids);
+        }
+        if (report_panel) report_panel->update_for_deleted(doomed_entry_ids);
+    }
 
-void
-TopPanel::update_for_amended(Handle<Account> const& p_saved_object)
-{
-    m_bs_account_list->update();
-    m_pl_account_list->update();
-    m_entry_list_panel->update_for_amended(p_saved_object);
-    m_reconciliation_panel->update_for_amended(p_saved_object);
-    m_report_panel->update_for_amended(p_saved_object);
-    m_transaction_ctrl->update_for_amended(p_saved_object);
-    configure_draft_journal_list_ctrl();
-    return;
-}
-    
-void
-TopPanel::update_for_amended_budget(Handle<Account> const& p_account)
-{
-    (void)p_account;  // Silence compiler re. unused parameter.
-    JEWEL_ASSERT (p_account->account_super_type() == AccountSuperType::pl);
-    JEWEL_ASSERT (m_pl_account_list);
-    JEWEL_ASSERT (m_report_panel);
-    m_pl_account_list->update();
-    m_report_panel->update_for_amended_budget(p_account);
-    return;
-}
+    // Creations
+    for (sqloxx::Id const id: new_account_ids)
+    {
+        Handle<Account> const account(m_database_connection, id);
+        if (entry_list_panel) entry_list_panel->update_for_new(account);
+        if (reconciliation_panel) reconciliation_panel->update_for_new(account);
+        if (report_panel) report_panel->update_for_new(account);
+        if (m_transaction_ctrl) m_transaction_ctrl->update_for_new(account);
+    }
+    for (Handle<OrdinaryJournal> const& journal: new_ordinary_journals)
+    {
+        if (entry_list_panel) entry_list_panel->update_for_new(journal);
+        if (reconciliation_panel) reconciliation_panel->update_for_new(journal);
+        if (report_panel) report_panel->update_for_new(journal);
+    }
 
-void
-TopPanel::update_for_reconciliation_status(Handle<Entry> const& p_entry)
-{
-    JEWEL_ASSERT (m_transaction_ctrl);
-    m_transaction_ctrl->update_for_reconciliation_status(p_entry);
-    return;
-}
+    // Amendments
+    for (sqloxx::Id const id: amended_account_ids)
+    {
+        Handle<Account> const account(m_database_connection, id);
+        if (entry_list_panel) entry_list_panel->update_for_amended(account);
+        if (reconciliation_panel)
+        {
+            reconciliation_panel->update_for_amended(account);
+        }
+        if (report_panel) report_panel->update_for_amended(account);
+        if (m_transaction_ctrl)
+        {
+            m_transaction_ctrl->update_for_amended(account);
+        }
+    }
+    for (Handle<OrdinaryJournal> const& journal: amended_ordinary_journals)
+    {
+        if (entry_list_panel) entry_list_panel->update_for_amended(journal);
+        if (reconciliation_panel)
+        {
+            reconciliation_panel->update_for_amended(journal);
+        }
+        if (report_panel) report_panel->update_for_amended(journal);
+    }
+    for (sqloxx::Id const id: budget_account_ids)
+    {
+        Handle<Account> const account(m_database_connection, id);
+        JEWEL_ASSERT (account->account_super_type() == AccountSuperType::pl);
+        if (report_panel) report_panel->update_for_amended_budget(account);
+    }
+    for (sqloxx::Id const id: p_changes.ids(ChangeKind::reconciliation_status))
+    {
+        Handle<Entry> const entry(m_database_connection, id);
+        if (m_transaction_ctrl)
+        {
+            m_transaction_ctrl->update_for_reconciliation_status(entry);
+        }
+    }
 
-void
-TopPanel::update_for_deleted_ordinary_journal(sqloxx::Id p_doomed_id)
-{
-    (void)p_doomed_id;  // Silence compiler re. unused parameter.
-    m_bs_account_list->update();
-    m_pl_account_list->update();
     // configure_transaction_ctrl();  // Don't do this!
-    configure_draft_journal_list_ctrl();
+    if (balances_changed || draft_journals_changed)
+    {
+        configure_draft_journal_list_ctrl();
+    }
     return;
 }
 
 void
-TopPanel::update_for_deleted_draft_journal(sqloxx::Id p_doomed_id)
+TopPanel::update_for_bulk_changes()
 {
-    JEWEL_LOG_TRACE();
-    (void)p_doomed_id;  // Silence compiler re. unused parameter.
+    m_bs_account_list->update();
+    m_pl_account_list->update();
+    if (m_entry_list_panel)
+    {
+        if (is_current_page(m_notebook_page_transactions))
+        {
+            m_entry_list_panel->update_for_bulk_changes();
+        }
+        else
+        {
+            m_entry_list_page_stale = true;
+        }
+    }
+    if (m_reconciliation_panel)
+    {
+        if (is_current_page(m_notebook_page_reconciliations))
+        {
+            m_reconciliation_panel->update_for_bulk_changes();
+        }
+        else
+        {
+            m_reconciliation_page_stale = true;
+        }
+    }
+    if (m_search_panel)
+    {
+        if (is_current_page(m_notebook_page_search))
+        {
+            m_search_panel->update_for_changes();
+        }
+        else
+        {
+            m_search_page_stale = true;
+        }
+    }
     // configure_transaction_ctrl();  // Don't do this!
     configure_draft_journal_list_ctrl();
     return;
 }
 
-void
-TopPanel::update_for_deleted_ordinary_entries
-(   vector<sqloxx::Id> const& p_doomed_ids
-)
-{
-    m_entry_list_panel->update_for_deleted(p_doomed_ids);
-    m_reconciliation_panel->update_for_deleted(p_doomed_ids);
-    m_report_panel->update_for_deleted(p_doomed_ids);
-    return;
-}
-
-void
-TopPanel::update_for_deleted_draft_entries
-(   vector<sqloxx::Id> const& p_doomed_ids
-)
-{
-    JEWEL_LOG_TRACE();
-    (void)p_doomed_ids;  // Silence compiler re. unused parameter
-
-    // Nothing to do, as DraftJournal Entries are not displayed individually
-    // in the top panel (except possibly TransactionCtrl, but that can take
-    // care of itself). The deleted DraftJournal itself is processed via
-    // update_for_deleted_draft_journal.
-    JEWEL_LOG_TRACE();
-    return;
-}
-
 }  // namespace gui
 }  // namespace dcm
 
@@ -780,6 +780,13 @@ TransactionCtrl::reset()
     TopPanel* const parent = dynamic_cast<TopPanel*>(GetParent());
     JEWEL_ASSERT (parent);
     ProtoJournal proto_journal = parent->make_proto_journal();
+
+    // In case an existing journal is being abandoned with changes that
+    // have not been saved (see save_existing_journal()).
+    if (m_journal && m_journal->has_id())
+    {
+        m_journal->ghostify();
+    }
     clear_all();
     configure_for_editing_proto_journal(proto_journal);
     m_transaction_type_ctrl->SetFocus();
@@ -995,6 +1002,49 @@ TransactionCtrl::remove_journal()
 
 bool
 TransactionCtrl::save_existing_journal()
+{
+    JEWEL_LOG_TRACE();
+    JEWEL_ASSERT (m_journal);
+
+    // The journal and its Entries may be retained in the HandleCaches of
+    // the database connection, and so outlive this TransactionCtrl. If the
+    // journal is not saved, the changes made to them along the way must be
+    // discarded, lest they turn up next time the journal is opened, or be
+    // saved along with some later, unrelated change.
+    vector<Handle<Entry> > const old_entries = m_journal->entries();
+    bool saved = false;
+    try
+    {
+        saved = save_existing_journal_core();
+    }
+    catch (...)
+    {
+        discard_journal_changes(old_entries);
+        throw;
+    }
+    if (!saved)
+    {
+        discard_journal_changes(old_entries);
+    }
+    return saved;
+}
+
+void
+TransactionCtrl::discard_journal_changes
+(   vector<Handle<Entry> > const& p_old_entries
+)
+{
+    JEWEL_ASSERT (m_journal);
+    m_journal->ghostify();
+    for (Handle<Entry> const& entry: p_old_entries)
+    {
+        entry->ghostify();
+    }
+    return;
+}
+
+bool
+TransactionCtrl::save_existing_journal_core()
 {
     JEWEL_LOG_TRACE();
 
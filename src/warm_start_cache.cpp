@@ -0,0 +1,410 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "warm_start_cache.hpp"
+#include "account.hpp"
+#include "account_table_iterator.hpp"
+#include "account_type.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include <boost/cstdint.hpp>
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <boost/system/error_code.hpp>
+#include <jewel/assert.hpp>
+#include <jewel/decimal.hpp>
+#include <jewel/exception.hpp>
+#include <jewel/log.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+using boost::optional;
+using jewel::Decimal;
+using sqloxx::Handle;
+using sqloxx::Id;
+using sqloxx::SQLStatement;
+using std::getline;
+using std::ifstream;
+using std::istringstream;
+using std::map;
+using std::ofstream;
+using std::ostream;
+using std::ostringstream;
+using std::string;
+
+namespace filesystem = boost::filesystem;
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+
+namespace
+{
+    // Change this if the format of the file changes, so that files in
+    // the old format are ignored.
+    char const* file_header()
+    {
+        return "dcm-warm-start-cache 1";
+    }
+
+    char const* blank_field()
+    {
+        return "-";
+    }
+
+    template <typename T>
+    void write_field(ostream& p_os, optional<T> const& p_maybe_value)
+    {
+        p_os << ' ';
+        if (p_maybe_value) p_os << *p_maybe_value;
+        else p_os << blank_field();
+        return;
+    }
+
+    template <typename T>
+    bool read_field(istringstream& p_is, optional<T>& p_maybe_value)
+    {
+        string field;
+        if (!(p_is >> field)) return false;
+        if (field == blank_field())
+        {
+            p_maybe_value = optional<T>();
+            return true;
+        }
+        istringstream field_stream(field);
+        T value;
+        if (!(field_stream >> value)) return false;
+        p_maybe_value = value;
+        return true;
+    }
+
+    optional<DateRep> julian_field(optional<gregorian::date> const& p_date)
+    {
+        optional<DateRep> ret;
+        if (p_date) ret = julian_int(*p_date);
+        return ret;
+    }
+
+    optional<gregorian::date> date_field(optional<DateRep> const& p_julian)
+    {
+        optional<gregorian::date> ret;
+        if (p_julian) ret = boost_date_from_julian_int(*p_julian);
+        return ret;
+    }
+
+    bool read_decimal(istringstream& p_is, Decimal& p_decimal)
+    {
+        Decimal::int_type intval;
+        unsigned int places;
+        if (!(p_is >> intval >> places)) return false;
+        if (places > Decimal::maximum_precision()) return false;
+        p_decimal = Decimal(intval, static_cast<Decimal::places_type>(places));
+        return true;
+    }
+
+    void remove_if_possible(filesystem::path const& p_filepath)
+    {
+        boost::system::error_code error;
+        filesystem::remove(p_filepath, error);
+        return;
+    }
+
+}  // end anonymous namespace
+
+WarmStartCache::WarmStartCache
+(   DcmDatabaseConnection& p_database_connection,
+    filesystem::path const& p_database_filepath
+):
+    m_is_loaded(false),
+    m_database_connection(p_database_connection),
+    m_database_filepath(p_database_filepath),
+    m_filepath(filepath_for(p_database_filepath))
+{
+    JEWEL_LOG_TRACE();
+    m_is_loaded = load();
+    if (!m_is_loaded)
+    {
+        m_favourite_accounts.clear();
+        m_account_figures.clear();
+        m_entry_list_filter = optional<EntryListFilter>();
+    }
+
+    // Whatever is done to the database from here on is not reflected in
+    // the file until save() is called; so until then there must be no file.
+    remove_if_possible(m_filepath);
+}
+
+filesystem::path
+WarmStartCache::filepath_for(filesystem::path const& p_database_filepath)
+{
+    // After the manner of SQLite's own "-wal" and "-shm" files.
+    return filesystem::path(p_database_filepath.string() + "-cache");
+}
+
+bool
+WarmStartCache::is_loaded() const
+{
+    return m_is_loaded;
+}
+
+map<AccountSuperType, Id> const&
+WarmStartCache::favourite_accounts() const
+{
+    return m_favourite_accounts;
+}
+
+WarmStartCache::AccountFiguresMap const&
+WarmStartCache::account_figures() const
+{
+    return m_account_figures;
+}
+
+optional<EntryListFilter> const&
+WarmStartCache::entry_list_filter() const
+{
+    return m_entry_list_filter;
+}
+
+void
+WarmStartCache::set_entry_list_filter(EntryListFilter const& p_filter)
+{
+    m_entry_list_filter = p_filter;
+    return;
+}
+
+void
+WarmStartCache::save()
+{
+    JEWEL_LOG_TRACE();
+    m_favourite_accounts = dcm::favourite_accounts(m_database_connection);
+    m_account_figures.clear();
+    AccountTableIterator it(m_database_connection);
+    AccountTableIterator const end;
+    for ( ; it != end; ++it)
+    {
+        Handle<Account> const& account = *it;
+        AccountFigures figures;
+        figures.balance = account->friendly_balance();
+        if (account->account_super_type() == AccountSuperType::pl)
+        {
+            figures.budget = account->budget();
+        }
+        m_account_figures[account->id()] = figures;
+    }
+
+    optional<string> const maybe_stamp = stamp();
+    if (!maybe_stamp)
+    {
+        JEWEL_THROW
+        (   WarmStartCacheException,
+            "Could not stamp database file for warm start cache."
+        );
+    }
+
+    // Write to a temporary file first, so that an existing cache file is
+    // never left half-written.
+    filesystem::path const temp_filepath(m_filepath.string() + ".tmp");
+    try
+    {
+        ofstream file(temp_filepath.string().c_str());
+        file << file_header() << '\n';
+        file << "stamp " << *maybe_stamp << '\n';
+        file << "favourites "
+             << m_favourite_accounts.at(AccountSuperType::balance_sheet)
+             << ' '
+             << m_favourite_accounts.at(AccountSuperType::pl)
+             << '\n';
+        if (m_entry_list_filter)
+        {
+            EntryListFilter const& filter = *m_entry_list_filter;
+            file << "filter";
+            write_field(file, filter.account_id);
+            write_field(file, julian_field(filter.min_date));
+            write_field(file, julian_field(filter.max_date));
+            file << '\n';
+        }
+        for (auto const& entry: m_account_figures)
+        {
+            AccountFigures const& figures = entry.second;
+            file << "account " << entry.first
+                 << ' ' << figures.balance.intval()
+                 << ' ' << static_cast<unsigned int>(figures.balance.places())
+                 << ' ' << figures.budget.intval()
+                 << ' ' << static_cast<unsigned int>(figures.budget.places())
+                 << '\n';
+        }
+        file << "end\n";
+        file.close();
+        if (!file)
+        {
+            JEWEL_THROW
+            (   WarmStartCacheException,
+                "Error writing warm start cache."
+            );
+        }
+        filesystem::rename(temp_filepath, m_filepath);
+    }
+    catch (filesystem::filesystem_error&)
+    {
+        remove_if_possible(temp_filepath);
+        JEWEL_THROW
+        (   WarmStartCacheException,
+            "Error writing warm start cache."
+        );
+    }
+    catch (WarmStartCacheException&)
+    {
+        remove_if_possible(temp_filepath);
+        throw;
+    }
+    return;
+}
+
+bool
+WarmStartCache::load()
+{
+    ifstream file(m_filepath.string().c_str());
+    if (!file)
+    {
+        return false;
+    }
+    string line;
+    if (!getline(file, line) || (line != file_header()))
+    {
+        return false;
+    }
+    if (!getline(file, line) || (line.compare(0, 6, "stamp ") != 0))
+    {
+        return false;
+    }
+    optional<string> const database_stamp = stamp();
+    if (!database_stamp || (line.substr(6) != *database_stamp))
+    {
+        return false;
+    }
+    while (getline(file, line))
+    {
+        istringstream line_stream(line);
+        string kind;
+        line_stream >> kind;
+        if (kind == "end")
+        {
+            // Without this, the file is taken to be truncated.
+            return m_favourite_accounts.size() == 2;
+        }
+        if (kind == "favourites")
+        {
+            Id bs_account_id;
+            Id pl_account_id;
+            if (!(line_stream >> bs_account_id >> pl_account_id))
+            {
+                return false;
+            }
+            m_favourite_accounts[AccountSuperType::balance_sheet] =
+                bs_account_id;
+            m_favourite_accounts[AccountSuperType::pl] = pl_account_id;
+        }
+        else if (kind == "filter")
+        {
+            EntryListFilter filter;
+            optional<DateRep> min_julian;
+            optional<DateRep> max_julian;
+            if
+            (   !read_field(line_stream, filter.account_id) ||
+                !read_field(line_stream, min_julian) ||
+                !read_field(line_stream, max_julian)
+            )
+            {
+                return false;
+            }
+            filter.min_date = date_field(min_julian);
+            filter.max_date = date_field(max_julian);
+            m_entry_list_filter = filter;
+        }
+        else if (kind == "account")
+        {
+            Id account_id;
+            AccountFigures figures;
+            if
+            (   !(line_stream >> account_id) ||
+                !read_decimal(line_stream, figures.balance) ||
+                !read_decimal(line_stream, figures.budget)
+            )
+            {
+                return false;
+            }
+            m_account_figures[account_id] = figures;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+optional<string>
+WarmStartCache::stamp()
+{
+    // The size and modification time are those of the main database file,
+    // so anything still in the write-ahead log must first be moved into it.
+    // (SQLite's own "file change counter" is no use here, as it is not
+    // reliably incremented in WAL mode.)
+    m_database_connection.execute_sql("pragma wal_checkpoint(full);");
+    boost::system::error_code error;
+    boost::uintmax_t const size =
+        filesystem::file_size(m_database_filepath, error);
+    if (error)
+    {
+        return optional<string>();
+    }
+    std::time_t const modification_time =
+        filesystem::last_write_time(m_database_filepath, error);
+    if (error)
+    {
+        return optional<string>();
+    }
+    ostringstream oss;
+    oss << size << ' ' << modification_time;
+
+    // In case the file is changed within the resolution of the file
+    // system's timestamps, without its size changing.
+    SQLStatement statement
+    (   m_database_connection,
+        "select "
+        "(select count(*) from entries), "
+        "(select coalesce(max(entry_id), 0) from entries), "
+        "(select count(*) from journals), "
+        "(select coalesce(max(journal_id), 0) from journals)"
+    );
+    statement.step();
+    for (int i = 0; i != 4; ++i)
+    {
+        oss << ' ' << statement.extract<Id>(i);
+    }
+    statement.step_final();
+    return oss.str();
+}
+
+}  // namespace dcm
@@ -24,6 +24,7 @@
 #include "interval_type.hpp"
 #include "ordinary_journal.hpp"
 #include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
 #include "dcm_tests_common.hpp"
 #include "visibility.hpp"
 #include <boost/date_time/gregorian/gregorian.hpp>
@@ -91,6 +92,43 @@ BOOST_FIXTURE_TEST_CASE(test_account_exists, TestFixture)
     BOOST_CHECK(Account::exists(dbc, "food"));
 }
 
+BOOST_FIXTURE_TEST_CASE(test_account_id_for_name, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    Id const food_id = Account::id_for_name(dbc, "FOOD");
+    BOOST_CHECK_EQUAL(Handle<Account>(dbc, food_id)->name(), "food");
+    BOOST_CHECK_THROW
+    (   Account::id_for_name(dbc, "groceries"),
+        InvalidAccountNameException
+    );
+
+    // Renaming is reflected once saved.
+    Handle<Account> const food(dbc, food_id);
+    food->set_name("Groceries");
+    food->save();
+    BOOST_CHECK_EQUAL(Account::id_for_name(dbc, "groceries"), food_id);
+    BOOST_CHECK(!Account::exists(dbc, "food"));
+
+    // Where two names differ only in case, either may be found; but
+    // removing one leaves the other to be found.
+    Handle<Account> const a0(dbc);
+    a0->set_account_type(AccountType::expense);
+    a0->set_name("groceries");
+    a0->set_commodity(Handle<Commodity>(dbc, 1));
+    a0->set_description("");
+    a0->set_visibility(Visibility::visible);
+    a0->save();
+    Id const a0_id = a0->id();
+    Id const found_id = Account::id_for_name(dbc, "GROCERIES");
+    BOOST_CHECK((found_id == food_id) || (found_id == a0_id));
+    Handle<Account>(dbc, found_id)->remove();
+    Id const other_id = ((found_id == food_id)? a0_id: food_id);
+    BOOST_CHECK_EQUAL(Account::id_for_name(dbc, "Groceries"), other_id);
+    Handle<Account>(dbc, other_id)->remove();
+    BOOST_CHECK(!Account::exists(dbc, "groceries"));
+    BOOST_CHECK(Account::exists(dbc, "Cash"));
+}
+
 BOOST_FIXTURE_TEST_CASE(test_no_user_pl_accounts_saved, TestFixture)
 {
     DcmDatabaseConnection& dbc = *pdbc;
@@ -590,6 +628,21 @@ BOOST_FIXTURE_TEST_CASE(test_account_opening_balance, TestFixture)
     obj1b->save();
     BOOST_CHECK_EQUAL(a1->technical_opening_balance(), Decimal("7.01"));
     BOOST_CHECK_EQUAL(a1->friendly_opening_balance(), Decimal("7.01"));
+
+    // Moving a journal off the opening balance date, or removing it,
+    // affects the (cached) opening balances.
+    obj1b->set_date(dbc.entity_creation_date());
+    obj1b->save();
+    BOOST_CHECK_EQUAL(a1->technical_opening_balance(), Decimal("306.90"));
+    BOOST_CHECK_EQUAL(a1->technical_balance(), Decimal("7.01"));
+    BOOST_CHECK_EQUAL(a2->technical_opening_balance(), Decimal("-50.00"));
+    obj1b->remove();
+    BOOST_CHECK_EQUAL(a1->technical_opening_balance(), Decimal("306.90"));
+    BOOST_CHECK_EQUAL(a1->technical_balance(), Decimal("306.90"));
+    obj1->remove();
+    BOOST_CHECK_EQUAL(a1->technical_opening_balance(), Decimal("0.00"));
+    BOOST_CHECK_EQUAL(a1->technical_balance(), Decimal("0.00"));
+    BOOST_CHECK_EQUAL(a2->technical_opening_balance(), Decimal("-50.00"));
 }
 
 BOOST_FIXTURE_TEST_CASE(test_account_budget_and_budget_items, TestFixture)
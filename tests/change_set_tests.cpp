@@ -0,0 +1,124 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gui/change_set.hpp"
+#include <boost/test/unit_test.hpp>
+#include <sqloxx/id.hpp>
+#include <cstddef>
+#include <vector>
+
+using sqloxx::Id;
+using std::size_t;
+using std::vector;
+
+namespace dcm
+{
+namespace test
+{
+
+using gui::ChangeKind;
+using gui::ChangeSet;
+
+BOOST_AUTO_TEST_CASE(test_change_set_coalescing)
+{
+    // Deleting a journal with 20 Entries gives rise to a notification for
+    // each Entry as well as one for the journal; these should all be
+    // taken in by a single ChangeSet, and so by a single refresh of the
+    // GUI.
+    ChangeSet changes;
+    BOOST_CHECK(changes.is_empty());
+    Id const journal_id = 7;
+    vector<Id> entry_ids;
+    for (Id entry_id = 100; entry_id != 120; ++entry_id)
+    {
+        changes.record(ChangeKind::ordinary_entry_deleted, entry_id);
+        entry_ids.push_back(entry_id);
+    }
+    changes.record(ChangeKind::ordinary_journal_deleted, journal_id);
+    changes.record(ChangeKind::ordinary_journal_deleted, journal_id);
+    BOOST_CHECK(!changes.is_empty());
+    BOOST_CHECK(changes.ids(ChangeKind::ordinary_entry_deleted) == entry_ids);
+    BOOST_REQUIRE_EQUAL
+    (   changes.ids(ChangeKind::ordinary_journal_deleted).size(),
+        size_t(1)
+    );
+    BOOST_CHECK_EQUAL
+    (   changes.ids(ChangeKind::ordinary_journal_deleted)[0],
+        journal_id
+    );
+    BOOST_CHECK(changes.ids(ChangeKind::journal_edited).empty());
+
+    // Ids are kept in the order in which they were first recorded.
+    changes.record(ChangeKind::ordinary_entry_deleted, 105);
+    BOOST_CHECK(changes.ids(ChangeKind::ordinary_entry_deleted) == entry_ids);
+
+    changes.clear();
+    BOOST_CHECK(changes.is_empty());
+    BOOST_CHECK(changes.ids(ChangeKind::ordinary_entry_deleted).empty());
+    BOOST_CHECK(!changes.contains(ChangeKind::ordinary_journal_deleted, 7));
+}
+
+BOOST_AUTO_TEST_CASE(test_change_set_create_then_delete)
+{
+    ChangeSet changes;
+    changes.record(ChangeKind::journal_created, 1);
+    changes.record(ChangeKind::journal_created, 2);
+
+    // Editing a journal already recorded as created adds nothing.
+    changes.record(ChangeKind::journal_edited, 1);
+    BOOST_CHECK(!changes.contains(ChangeKind::journal_edited, 1));
+
+    // Once deleted, it is of no interest that it was created.
+    changes.record(ChangeKind::ordinary_journal_deleted, 1);
+    BOOST_CHECK(!changes.contains(ChangeKind::journal_created, 1));
+    BOOST_CHECK(changes.contains(ChangeKind::ordinary_journal_deleted, 1));
+    vector<Id> const created = changes.ids(ChangeKind::journal_created);
+    BOOST_REQUIRE_EQUAL(created.size(), size_t(1));
+    BOOST_CHECK_EQUAL(created[0], 2);
+
+    changes.record(ChangeKind::draft_journal_deleted, 2);
+    BOOST_CHECK(changes.ids(ChangeKind::journal_created).empty());
+    BOOST_CHECK(!changes.is_empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_change_set_amend_then_delete)
+{
+    ChangeSet changes;
+    changes.record(ChangeKind::journal_edited, 3);
+    changes.record(ChangeKind::journal_edited, 4);
+    changes.record(ChangeKind::reconciliation_status, 30);
+    changes.record(ChangeKind::reconciliation_status, 31);
+
+    // Once deleted, it is of no interest that it was edited.
+    changes.record(ChangeKind::ordinary_journal_deleted, 3);
+    BOOST_CHECK(!changes.contains(ChangeKind::journal_edited, 3));
+    BOOST_CHECK(changes.contains(ChangeKind::journal_edited, 4));
+
+    // Nor, once an Entry is deleted, that its reconciliation status
+    // changed.
+    changes.record(ChangeKind::ordinary_entry_deleted, 30);
+    BOOST_CHECK(!changes.contains(ChangeKind::reconciliation_status, 30));
+    BOOST_CHECK(changes.contains(ChangeKind::reconciliation_status, 31));
+
+    // Ids of other kinds of object are unaffected by journal deletions.
+    changes.record(ChangeKind::account_edited, 4);
+    changes.record(ChangeKind::ordinary_journal_deleted, 4);
+    BOOST_CHECK(!changes.contains(ChangeKind::journal_edited, 4));
+    BOOST_CHECK(changes.contains(ChangeKind::account_edited, 4));
+}
+
+}  // namespace test
+}  // namespace dcm
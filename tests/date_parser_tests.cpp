@@ -19,9 +19,11 @@
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/optional.hpp>
 #include <boost/test/unit_test.hpp>
+#include <wx/string.h>
 #include <iostream>
 
 using boost::gregorian::date;
+using boost::gregorian::date_duration;
 using boost::optional;
 using std::cout;
 using std::endl;
@@ -202,6 +204,55 @@ BOOST_AUTO_TEST_CASE(test_date_parser_tolerant_parse)
     if (md5c) BOOST_CHECK_EQUAL(*md5c, date(today().year(), today().month(), 3));
 }
 
+BOOST_AUTO_TEST_CASE(test_compiled_date_format)
+{
+    BOOST_CHECK(CompiledDateFormat("%d/%m/%Y").is_valid());
+    BOOST_CHECK(CompiledDateFormat("%y%%%m %d").is_valid());
+    BOOST_CHECK(!CompiledDateFormat("%A, %d %B %Y").is_valid());
+    BOOST_CHECK(!CompiledDateFormat("%d/%m").is_valid());
+    BOOST_CHECK(!CompiledDateFormat("%d/%m/%Y %y").is_valid());
+    BOOST_CHECK(!CompiledDateFormat("%d/%m/%Y%").is_valid());
+
+    CompiledDateFormat const cdf0("%d/%m/%Y");
+    BOOST_CHECK(cdf0.format(julian_int(date(2013, 3, 7))) == "07/03/2013");
+    DateRep date_rep = null_date_rep();
+    BOOST_CHECK(cdf0.parse("7/3/2013", date_rep));
+    BOOST_CHECK_EQUAL(date_rep, julian_int(date(2013, 3, 7)));
+    BOOST_CHECK(cdf0.parse("29/02/2012", date_rep));
+    BOOST_CHECK_EQUAL(date_rep, julian_int(date(2012, 2, 29)));
+    BOOST_CHECK(!cdf0.parse("29/02/2013", date_rep));
+    BOOST_CHECK(!cdf0.parse("31/04/2013", date_rep));
+    BOOST_CHECK(!cdf0.parse("1/1/1399", date_rep));
+    BOOST_CHECK(!cdf0.parse("07/03/2013 ", date_rep));
+    BOOST_CHECK_EQUAL(date_rep, julian_int(date(2012, 2, 29)));
+
+    // Whatever is formatted can be parsed back again.
+    CompiledDateFormat const cdf1("%y%%%m %d");
+    BOOST_CHECK(cdf1.format(julian_int(date(2005, 11, 1))) == "05%11 01");
+    for (date d(1999, 12, 1); d != date(2031, 1, 1); d += date_duration(1))
+    {
+        BOOST_CHECK(cdf0.parse(cdf0.format(julian_int(d)), date_rep));
+        BOOST_CHECK_EQUAL(date_rep, julian_int(d));
+        BOOST_CHECK(cdf1.parse(cdf1.format(julian_int(d)), date_rep));
+        BOOST_CHECK_EQUAL(date_rep, julian_int(d));
+    }
+
+    DateParser const dp0("%d/%m/%y", "%A, %d %B %Y");
+    optional<DateRep> const mdr0a = dp0.parse_date_rep("13/10/13");
+    BOOST_CHECK(mdr0a);
+    if (mdr0a) BOOST_CHECK_EQUAL(*mdr0a, julian_int(date(2013, 10, 13)));
+}
+
+BOOST_AUTO_TEST_CASE(test_date_formatter)
+{
+    DateFormatter const df0("%Y-%m-%d");
+    DateRep const date_rep = julian_int(date(1999, 12, 31));
+    wxString const& formatted = df0.format(date_rep);
+    BOOST_CHECK(formatted == "1999-12-31");
+    BOOST_CHECK_EQUAL(&df0.format(date_rep), &formatted);
+    BOOST_CHECK(df0.format(date_rep + 1) == "2000-01-01");
+    BOOST_CHECK(formatted == "1999-12-31");
+}
 
 }  // namespace test
 }  // namespace dcm
@@ -19,13 +19,19 @@
 #include "account_type.hpp"
 #include "commodity.hpp"
 #include "dcm_database_connection.hpp"
+#include "entry.hpp"
+#include "ordinary_journal.hpp"
+#include "transaction_side.hpp"
+#include "transaction_type.hpp"
 #include "visibility.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/filesystem.hpp>
 #include <jewel/decimal.hpp>
 #include <jewel/assert.hpp>
 #include <sqloxx/handle.hpp>
 #include <cstdlib>
 #include <iostream>
+#include <string>
 
 using jewel::Decimal;
 using sqloxx::Handle;
@@ -33,8 +39,10 @@ using std::abort;
 using std::cout;
 using std::cerr;
 using std::endl;
+using std::string;
 
 namespace filesystem = boost::filesystem;
+namespace gregorian = boost::gregorian;
 
 namespace dcm
 {
@@ -105,6 +113,53 @@ void setup_test_accounts(DcmDatabaseConnection& dbc)
     return;
 }
 
+Handle<OrdinaryJournal> post_cash_journal
+(   DcmDatabaseConnection& dbc,
+    gregorian::date const& p_date,
+    string const& p_comment,
+    Decimal const& p_cash_amount
+)
+{
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    bool const is_purchase = (p_cash_amount < Decimal(0, 0));
+
+    Handle<OrdinaryJournal> const journal(dbc);
+    journal->set_transaction_type(TransactionType::expenditure);
+    journal->set_comment(p_comment);
+    journal->set_date(p_date);
+
+    Handle<Entry> const cash_entry(dbc);
+    cash_entry->set_account(cash);
+    cash_entry->set_comment(p_comment);
+    cash_entry->set_whether_reconciled(false);
+    cash_entry->set_amount(p_cash_amount);
+    cash_entry->set_transaction_side
+    (   is_purchase?
+        TransactionSide::source:
+        TransactionSide::destination
+    );
+
+    Handle<Entry> const food_entry(dbc);
+    food_entry->set_account(food);
+    food_entry->set_comment(p_comment);
+    food_entry->set_whether_reconciled(false);
+    food_entry->set_amount(-p_cash_amount);
+    food_entry->set_transaction_side
+    (   is_purchase?
+        TransactionSide::destination:
+        TransactionSide::source
+    );
+
+    // Source side first, as in ProtoJournals created via the GUI.
+    journal->push_entry(is_purchase? cash_entry: food_entry);
+    journal->push_entry(is_purchase? food_entry: cash_entry);
+
+    JEWEL_ASSERT (journal->is_balanced());
+    journal->save();
+    return journal;
+}
+
 TestFixture::TestFixture():
     db_filepath("Testfile_827787293.db"),
     pdbc(0)
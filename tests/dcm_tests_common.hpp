@@ -18,20 +18,44 @@
 #define GUARD_dcm_tests_common_hpp_7922174706087529
 
 #include "dcm_database_connection.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/filesystem.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/handle_fwd.hpp>
 #include <iostream>
+#include <string>
 
 namespace dcm
 {
+
+// Begin forward declarations
+
+class OrdinaryJournal;
+
+// End forward declarations
+
 namespace test
 {
 
-
 bool file_exists(boost::filesystem::path const& filepath);
 void abort_if_exists(boost::filesystem::path const& dbc);
 void setup_test_commodities(DcmDatabaseConnection& dbc);
 void setup_test_accounts(DcmDatabaseConnection& dbc);
 
+/**
+ * Save, and return, an OrdinaryJournal dated \e p_date between the
+ * "cash" and "food" Accounts set up by setup_test_accounts(...), in which
+ * the cash Entry has amount \e p_cash_amount - so a negative amount is
+ * a purchase of food, and a positive amount a refund. The journal and
+ * both its Entries have the comment \e p_comment.
+ */
+sqloxx::Handle<OrdinaryJournal> post_cash_journal
+(   DcmDatabaseConnection& dbc,
+    boost::gregorian::date const& p_date,
+    std::string const& p_comment,
+    jewel::Decimal const& p_cash_amount
+);
+
 struct TestFixture
 {
     // Setup
@@ -0,0 +1,199 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "entry_search.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_tests_common.hpp"
+#include "entry.hpp"
+#include "ordinary_journal.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/test/unit_test.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using boost::gregorian::date;
+using jewel::Decimal;
+using sqloxx::Handle;
+using sqloxx::Id;
+using sqloxx::SQLStatement;
+using std::size_t;
+using std::sort;
+using std::vector;
+
+namespace dcm
+{
+namespace test
+{
+
+namespace
+{
+    // Posts an expenditure of p_amount from cash on food (see
+    // post_cash_journal(...)), with both Entries bearing p_entry_comment.
+    Handle<OrdinaryJournal> post_journal
+    (   DcmDatabaseConnection& p_dbc,
+        date const& p_date,
+        char const* p_journal_comment,
+        char const* p_entry_comment,
+        Decimal const& p_amount
+    )
+    {
+        Handle<OrdinaryJournal> const journal =
+            post_cash_journal(p_dbc, p_date, p_journal_comment, -p_amount);
+        for (Handle<Entry> const& entry: journal->entries())
+        {
+            entry->set_comment(p_entry_comment);
+        }
+        journal->save();
+        return journal;
+    }
+
+    vector<Id> entry_ids(Handle<OrdinaryJournal> const& p_journal)
+    {
+        vector<Id> ret;
+        for (Handle<Entry> const& entry: p_journal->entries())
+        {
+            ret.push_back(entry->id());
+        }
+        return ret;
+    }
+
+    vector<Id> sorted(vector<Id> p_ids)
+    {
+        sort(p_ids.begin(), p_ids.end());
+        return p_ids;
+    }
+
+    bool index_exists(DcmDatabaseConnection& p_dbc)
+    {
+        SQLStatement statement
+        (   p_dbc,
+            "select name from sqlite_master where name = 'entry_search'"
+        );
+        return statement.step();
+    }
+
+}  // end anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE(test_search_entries, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    Handle<OrdinaryJournal> const journal1 = post_journal
+    (   dbc,
+        date(3000, 1, 5),
+        "Weekly shop",
+        "Butcher",
+        Decimal("12.50")
+    );
+    Handle<OrdinaryJournal> const journal2 = post_journal
+    (   dbc,
+        date(3000, 1, 20),
+        "Butcher's bill",
+        "Sausages",
+        Decimal("30.00")
+    );
+    Handle<OrdinaryJournal> const journal3 = post_journal
+    (   dbc,
+        date(3000, 2, 1),
+        "Weekly shop",
+        "Bakery",
+        Decimal("4.20")
+    );
+    vector<Id> const ids1 = entry_ids(journal1);
+    vector<Id> const ids2 = entry_ids(journal2);
+    vector<Id> const ids3 = entry_ids(journal3);
+
+    EntrySearchQuery query;
+    query.text = wxString("butch");
+    vector<Id> results = search_entries(dbc, query);
+    BOOST_REQUIRE_EQUAL(results.size(), size_t(4));
+    if (index_exists(dbc))
+    {
+        // A match in the Entry's own comment counts for more than one in
+        // the comment of its journal.
+        vector<Id> const best(results.begin(), results.begin() + 2);
+        vector<Id> const rest(results.begin() + 2, results.end());
+        BOOST_CHECK(sorted(best) == ids1);
+        BOOST_CHECK(sorted(rest) == ids2);
+    }
+
+    // Every word must match, ignoring case and punctuation.
+    query.text = wxString("  WEEKLY  sho - ");
+    results = search_entries(dbc, query);
+    BOOST_REQUIRE_EQUAL(results.size(), size_t(4));
+    query.text = wxString("weekly bak");
+    BOOST_CHECK(sorted(search_entries(dbc, query)) == ids3);
+    query.text = wxString("weekly sausages");
+    BOOST_CHECK(search_entries(dbc, query).empty());
+    query.text = wxString(" \"* ");
+    BOOST_CHECK(search_entries(dbc, query).empty());
+
+    // Filters
+    query.text = wxString("weekly");
+    query.min_date = date(3000, 1, 6);
+    BOOST_CHECK(sorted(search_entries(dbc, query)) == ids3);
+    query.min_date = boost::none;
+    query.max_date = date(3000, 1, 31);
+    BOOST_CHECK(sorted(search_entries(dbc, query)) == ids1);
+    query.max_date = boost::none;
+    query.min_amount = Decimal("-5");
+    BOOST_CHECK(sorted(search_entries(dbc, query)) == ids1);
+    query.min_amount = boost::none;
+    query.max_amount = Decimal("4.2");
+    BOOST_CHECK(sorted(search_entries(dbc, query)) == ids3);
+    query.max_amount = boost::none;
+    query.max_results = 3;
+    BOOST_CHECK_EQUAL(search_entries(dbc, query).size(), size_t(3));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_search_entries_after_changes, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    Handle<OrdinaryJournal> const journal = post_journal
+    (   dbc,
+        date(3000, 1, 5),
+        "Weekly shop",
+        "Butcher",
+        Decimal("12.50")
+    );
+    vector<Id> const ids = entry_ids(journal);
+    EntrySearchQuery query;
+    query.text = wxString("groceries");
+    BOOST_CHECK(search_entries(dbc, query).empty());
+
+    journal->set_comment("Groceries");
+    journal->save();
+    BOOST_CHECK(sorted(search_entries(dbc, query)) == ids);
+    query.text = wxString("weekly");
+    BOOST_CHECK(search_entries(dbc, query).empty());
+
+    journal->entries()[0]->set_comment("Weekly meat");
+    journal->save();
+    vector<Id> results = search_entries(dbc, query);
+    BOOST_REQUIRE_EQUAL(results.size(), size_t(1));
+    BOOST_CHECK_EQUAL(results[0], journal->entries()[0]->id());
+
+    journal->remove();
+    query.text = wxString("groceries");
+    BOOST_CHECK(search_entries(dbc, query).empty());
+}
+
+}  // namespace test
+}  // namespace dcm
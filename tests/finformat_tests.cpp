@@ -22,9 +22,13 @@
 #include <wx/app.h>
 #include <wx/intl.h>
 #include <wx/string.h>
+#include <cstddef>
+#include <limits>
 
 using jewel::Decimal;
 using jewel::DecimalFromStringException;
+using std::numeric_limits;
+using std::size_t;
 
 namespace dcm
 {
@@ -197,6 +201,34 @@ BOOST_FIXTURE_TEST_CASE(test_finformat_wx, FinformatTestFixture)
     BOOST_CHECK_EQUAL(finformat_wx_b(d8, loc), "(0.000098)");
 }
 
+BOOST_FIXTURE_TEST_CASE(test_decimal_formatter, FinformatTestFixture)
+{
+    using string_flags::dash_for_zero;
+    using string_flags::hard_align_right;
+
+    DecimalFormatter const formatter(loc);
+    wxString expected = "(896,775,698.98)";
+    localize(expected, loc);
+    BOOST_CHECK_EQUAL(formatter.format(Decimal(-89677569898, 2)), expected);
+    BOOST_CHECK_EQUAL(formatter.format(Decimal(0, 2)), "-   ");
+
+    DecimalFormatter const plain_formatter
+    (   loc,
+        DecimalFormatFlags().clear(dash_for_zero).set(hard_align_right)
+    );
+    expected = "(9,223,372,036,854,775,808)";
+    localize(expected, loc);
+    BOOST_CHECK_EQUAL
+    (   plain_formatter.format
+        (   Decimal(numeric_limits<Decimal::int_type>::min(), 0)
+        ),
+        expected
+    );
+    expected = "0.000000000000000001";
+    localize(expected, loc);
+    BOOST_CHECK_EQUAL(plain_formatter.format(Decimal(1, 18)), expected);
+}
+
 BOOST_FIXTURE_TEST_CASE(test_wx_to_decimal, FinformatTestFixture)
 {
     using string_flags::allow_negative_parens;
@@ -236,6 +268,48 @@ BOOST_FIXTURE_TEST_CASE(test_wx_to_decimal, FinformatTestFixture)
     BOOST_CHECK_EQUAL(wx_to_decimal_b("-5", loc), Decimal(-5, 0));
 }
 
+BOOST_FIXTURE_TEST_CASE(test_decimal_parser, FinformatTestFixture)
+{
+    DecimalParser const parser(loc);
+    Decimal decimal;
+    size_t error_position = 0;
+
+    wxString text = " (1,234.50) ";
+    localize(text, loc);
+    BOOST_CHECK(parser.parse(text, decimal, error_position));
+    BOOST_CHECK_EQUAL(decimal, Decimal(-123450, 2));
+    BOOST_CHECK_EQUAL(decimal.places(), 2);
+    BOOST_CHECK(parser.parse("-", decimal, error_position));
+    BOOST_CHECK_EQUAL(decimal, Decimal(0, 0));
+
+    // Errors are reported by position.
+    text = "12.5x";
+    localize(text, loc);
+    BOOST_CHECK(!parser.parse(text, decimal, error_position));
+    BOOST_CHECK_EQUAL(error_position, size_t(text.Find('x')));
+    BOOST_CHECK(!parser.parse("--5", decimal, error_position));
+    BOOST_CHECK_EQUAL(error_position, size_t(1));
+    BOOST_CHECK(!parser.parse("()", decimal, error_position));
+    BOOST_CHECK_EQUAL(error_position, size_t(1));
+
+    text = "1,000 + 2.5 - 0.25";
+    localize(text, loc);
+    BOOST_CHECK(parser.parse_simple_sum(text, decimal, error_position));
+    BOOST_CHECK_EQUAL(decimal, Decimal(100225, 2));
+    BOOST_CHECK(!parser.parse_simple_sum("3 + (4)", decimal, error_position));
+    BOOST_CHECK_EQUAL(error_position, size_t(4));
+    BOOST_CHECK(!parser.parse_simple_sum("3+", decimal, error_position));
+    BOOST_CHECK_EQUAL(error_position, size_t(2));
+
+    // Parentheses may be disallowed.
+    DecimalParser const strict_parser
+    (   loc,
+        DecimalParsingFlags().clear(string_flags::allow_negative_parens)
+    );
+    BOOST_CHECK(!strict_parser.parse("(3)", decimal, error_position));
+    BOOST_CHECK_EQUAL(error_position, size_t(0));
+}
+
 BOOST_FIXTURE_TEST_CASE(test_wx_to_simple_sum, FinformatTestFixture)
 {
     BOOST_CHECK_EQUAL(wx_to_simple_sum_b("", loc), Decimal(0, 0));
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "handle_cache.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_tests_common.hpp"
+#include "entry.hpp"
+#include "ordinary_journal.hpp"
+#include "persistent_journal.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/test/unit_test.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <cstddef>
+#include <vector>
+
+using jewel::Decimal;
+using sqloxx::Handle;
+using sqloxx::Id;
+using std::size_t;
+using std::vector;
+
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+namespace test
+{
+
+BOOST_FIXTURE_TEST_CASE(test_handle_cache, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    Handle<OrdinaryJournal> const journals[] =
+    {   post_cash_journal
+        (   dbc,
+            gregorian::date(3000, 1, 20),
+            "Butcher",
+            Decimal("-3.00")
+        ),
+        post_cash_journal
+        (   dbc,
+            gregorian::date(3000, 1, 5),
+            "Bakery",
+            Decimal("-10.00")
+        )
+    };
+    dbc.set_caching_level(5);
+
+    vector<Id> entry_ids;
+    for (Handle<OrdinaryJournal> const& journal: journals)
+    {
+        for (Handle<Entry> const& entry: journal->entries())
+        {
+            entry_ids.push_back(entry->id());
+        }
+    }
+    BOOST_REQUIRE_EQUAL(entry_ids.size(), size_t(4));
+
+    // Nothing is retained until there is a capacity...
+    HandleCache<Entry>& cache = dbc.handle_cache<Entry>();
+    BOOST_CHECK_EQUAL(cache.capacity(), size_t(0));
+    BOOST_CHECK_EQUAL(cache.provide(entry_ids[0])->id(), entry_ids[0]);
+    BOOST_CHECK_EQUAL(cache.size(), size_t(0));
+    BOOST_CHECK_EQUAL(cache.statistics().misses, size_t(1));
+
+    // ... and then the most recently used are.
+    cache.set_capacity(2);
+    cache.provide(entry_ids[0]);
+    cache.provide(entry_ids[1]);
+    BOOST_CHECK_EQUAL(cache.statistics().misses, size_t(3));
+    BOOST_CHECK_EQUAL(cache.statistics().hits, size_t(0));
+    Handle<Entry> const entry = cache.provide(entry_ids[0]);
+    BOOST_CHECK_EQUAL(entry->id(), entry_ids[0]);
+    BOOST_CHECK_EQUAL(entry->comment(), wxString("Butcher"));
+    BOOST_CHECK_EQUAL(cache.statistics().hits, size_t(1));
+    BOOST_CHECK_EQUAL(cache.size(), size_t(2));
+
+    // entry_ids[1] is now the least recently used, so goes first.
+    cache.provide(entry_ids[2]);
+    BOOST_CHECK_EQUAL(cache.size(), size_t(2));
+    BOOST_CHECK_EQUAL(cache.statistics().evictions, size_t(1));
+    cache.provide(entry_ids[0]);
+    BOOST_CHECK_EQUAL(cache.statistics().hits, size_t(2));
+    cache.provide(entry_ids[1]);
+    BOOST_CHECK_EQUAL(cache.statistics().misses, size_t(5));
+    BOOST_CHECK_EQUAL(cache.statistics().evictions, size_t(2));
+
+    cache.set_capacity(1);
+    BOOST_CHECK_EQUAL(cache.size(), size_t(1));
+    BOOST_CHECK_EQUAL(cache.statistics().evictions, size_t(3));
+    cache.clear();
+    BOOST_CHECK_EQUAL(cache.size(), size_t(0));
+    BOOST_CHECK_EQUAL(cache.statistics().evictions, size_t(3));
+
+    // Lookups in the journal cache may be for a derived class.
+    HandleCache<PersistentJournal>& journal_cache =
+        dbc.handle_cache<PersistentJournal>();
+    journal_cache.set_capacity(1);
+    Handle<OrdinaryJournal> const journal =
+        journal_cache.provide<OrdinaryJournal>(entry->journal_id());
+    BOOST_CHECK_EQUAL(journal->date(), gregorian::date(3000, 1, 20));
+    BOOST_CHECK_EQUAL
+    (   journal_cache.provide<OrdinaryJournal>(entry->journal_id())->id(),
+        journal->id()
+    );
+    BOOST_CHECK_EQUAL(journal_cache.statistics().hits, size_t(1));
+    BOOST_CHECK_EQUAL(journal_cache.size(), size_t(1));
+
+    // The Entry knows its date without the journal being looked up.
+    BOOST_CHECK_EQUAL(entry->date(), gregorian::date(3000, 1, 20));
+    BOOST_CHECK_EQUAL(journal_cache.statistics().hits, size_t(1));
+    BOOST_CHECK_EQUAL(journal_cache.statistics().misses, size_t(1));
+
+    // Unsaved changes to a retained object outlive the Handle through
+    // which they were made, unless the object is ghostified.
+    cache.set_capacity(1);
+    wxString const original_comment = cache.provide(entry_ids[3])->comment();
+    {
+        Handle<Entry> const edited = cache.provide(entry_ids[3]);
+        edited->set_comment("Abandoned");
+    }
+    BOOST_CHECK_EQUAL
+    (   cache.provide(entry_ids[3])->comment(),
+        wxString("Abandoned")
+    );
+    cache.provide(entry_ids[3])->ghostify();
+    BOOST_CHECK_EQUAL
+    (   cache.provide(entry_ids[3])->comment(),
+        original_comment
+    );
+}
+
+}  // namespace test
+}  // namespace dcm
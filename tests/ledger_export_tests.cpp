@@ -0,0 +1,161 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ledger_export.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include "dcm_tests_common.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/test/unit_test.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/database_transaction.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+using jewel::Decimal;
+using sqloxx::DatabaseTransaction;
+using sqloxx::SQLStatement;
+using std::ostringstream;
+using std::size_t;
+using std::string;
+using std::stringstream;
+
+namespace dcm
+{
+namespace test
+{
+
+namespace
+{
+    size_t num_rows_in(DcmDatabaseConnection& dbc, string const& p_table)
+    {
+        SQLStatement statement(dbc, "select count(*) from " + p_table);
+        statement.step();
+        return statement.extract<int>(0);
+    }
+
+}  // end anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE(test_ledger_export_round_trip, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+
+    // Enough journals for their Entries to span several blocks
+    size_t const num_journals = LedgerExporter::block_size() + 5;
+    DatabaseTransaction transaction(dbc);
+    for (size_t i = 0; i != num_journals; ++i)
+    {
+        ostringstream comment;
+        comment << "Shop, " << (i % 3);
+        post_cash_journal
+        (   dbc,
+            boost::gregorian::date(3000, 1, i % 18 + 10),
+            comment.str(),
+            Decimal(-static_cast<Decimal::int_type>(i % 50 * 100 + 25), 2)
+        );
+    }
+    transaction.commit();
+
+    stringstream stream;
+    LedgerExporter exporter(dbc);
+    size_t const num_rows = exporter.write(stream);
+
+    LedgerExportReader reader(stream);
+    size_t total = 0;
+    for (ExportTableInfo const& table: reader.tables())
+    {
+        total += table.num_rows;
+    }
+    BOOST_CHECK_EQUAL(total, num_rows);
+
+    ExportTableInfo const& entries = reader.table("entries");
+    BOOST_CHECK_EQUAL(entries.num_rows, num_rows_in(dbc, "entries"));
+    size_t const block_size = LedgerExporter::block_size();
+    BOOST_CHECK_EQUAL
+    (   entries.blocks.size(),
+        (entries.num_rows + block_size - 1) / block_size
+    );
+    BOOST_CHECK_EQUAL
+    (   reader.table("ordinary_journals").num_rows,
+        num_rows_in(dbc, "ordinary_journal_detail")
+    );
+    BOOST_CHECK_EQUAL
+    (   reader.table("accounts").num_rows,
+        num_rows_in(dbc, "accounts")
+    );
+
+    // Compare a block against the database, row by row.
+    ExportBlock block;
+    reader.read_block(entries, 1, block);
+    BOOST_CHECK_EQUAL(block.num_rows, block_size);
+    SQLStatement statement
+    (   dbc,
+        "select entry_id, account_id, amount, comment from entries "
+        "order by entry_id limit :limit offset :offset"
+    );
+    statement.bind(":limit", static_cast<int>(block.num_rows));
+    statement.bind(":offset", static_cast<int>(entries.blocks[0].num_rows));
+    for (size_t i = 0; i != block.num_rows; ++i)
+    {
+        BOOST_REQUIRE(statement.step());
+        BOOST_CHECK_EQUAL(block.integers[0][i], statement.extract<int>(0));
+        BOOST_CHECK_EQUAL(block.integers[2][i], statement.extract<int>(1));
+        BOOST_CHECK_EQUAL
+        (   block.integers[3][i],
+            statement.extract<long long>(2)
+        );
+        BOOST_CHECK_EQUAL(block.texts[6][i], statement.extract<string>(3));
+    }
+
+    ostringstream csv;
+    reader.write_csv("ordinary_journals", csv);
+    string const expected_start =
+        "journal_id,date,transaction_type_id,comment\r\n";
+    BOOST_CHECK_EQUAL
+    (   csv.str().substr(0, expected_start.size()),
+        expected_start
+    );
+    BOOST_CHECK(csv.str().find(",3000-01-10,") != string::npos);
+    BOOST_CHECK(csv.str().find(",\"Shop, 1\"\r\n") != string::npos);
+
+    BOOST_CHECK_THROW(reader.table("nonexistent"), LedgerExportException);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_ledger_export_invalid, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    stringstream stream;
+    LedgerExporter exporter(dbc);
+    exporter.write(stream);
+    string const contents = stream.str();
+
+    istringstream truncated(contents.substr(0, contents.size() - 1));
+    BOOST_CHECK_THROW
+    (   LedgerExportReader reader(truncated),
+        LedgerExportException
+    );
+
+    istringstream not_export("Date,Description,Amount\n3000-01-05,A,1.00\n");
+    BOOST_CHECK_THROW
+    (   LedgerExportReader reader(not_export),
+        LedgerExportException
+    );
+}
+
+}  // namespace test
+}  // namespace dcm
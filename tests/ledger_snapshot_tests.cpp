@@ -0,0 +1,305 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ledger_snapshot.hpp"
+#include "account.hpp"
+#include "account_type.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_tests_common.hpp"
+#include "entry.hpp"
+#include "ledger_import.hpp"
+#include "ordinary_journal.hpp"
+#include "read_only_connection.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/optional.hpp>
+#include <boost/test/unit_test.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <cstddef>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+using boost::optional;
+using jewel::Decimal;
+using sqloxx::Handle;
+using sqloxx::Id;
+using sqloxx::SQLStatement;
+using std::istringstream;
+using std::make_shared;
+using std::ostringstream;
+using std::shared_ptr;
+using std::size_t;
+using std::unordered_map;
+using std::vector;
+
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+namespace test
+{
+
+namespace
+{
+    vector<Id> entry_ids_in_database
+    (   DcmDatabaseConnection& dbc,
+        Id p_account_id
+    )
+    {
+        vector<Id> ret;
+        SQLStatement statement
+        (   dbc,
+            "select entry_id from entries join ordinary_journal_detail "
+            "using(journal_id) where account_id = :p order by date, entry_id"
+        );
+        statement.bind(":p", p_account_id);
+        while (statement.step()) ret.push_back(statement.extract<Id>(0));
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE(test_ledger_snapshot, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    LedgerSnapshot& snapshot = dbc.ledger_snapshot();
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    BOOST_CHECK(snapshot.actual_entry_ids().empty());
+
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 20),
+        "Butcher",
+        Decimal("-3.00")
+    );
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 5),
+        "Bakery",
+        Decimal("-10.00")
+    );
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 12),
+        "Refund",
+        Decimal("100.00")
+    );
+
+    LedgerColumns const& columns = snapshot.columns();
+    BOOST_CHECK_EQUAL(columns.size(), size_t(6));
+    for (size_t i = 1; i < columns.size(); ++i)
+    {
+        BOOST_CHECK(columns.dates[i - 1] <= columns.dates[i]);
+    }
+    BOOST_CHECK
+    (   snapshot.actual_entry_ids
+        (   optional<gregorian::date>(),
+            optional<gregorian::date>(),
+            cash->id()
+        ) ==
+        entry_ids_in_database(dbc, cash->id())
+    );
+
+    optional<gregorian::date> const min_date(gregorian::date(3000, 1, 6));
+    optional<gregorian::date> const max_date(gregorian::date(3000, 1, 12));
+    vector<Id> const ids_between =
+        snapshot.actual_entry_ids(min_date, max_date, cash->id());
+    BOOST_REQUIRE_EQUAL(ids_between.size(), size_t(1));
+    Handle<Entry> const refund(dbc, ids_between[0]);
+    BOOST_CHECK_EQUAL(refund->amount(), Decimal("100.00"));
+
+    unordered_map<Id, Decimal::int_type> totals;
+    snapshot.accumulate_totals(totals, true);
+    BOOST_CHECK_EQUAL
+    (   Decimal(totals[cash->id()], 2),
+        cash->technical_balance()
+    );
+    BOOST_CHECK_EQUAL
+    (   Decimal(totals[food->id()], 2),
+        food->technical_balance()
+    );
+
+    // Moving a journal to another date should move its Entries within
+    // the snapshot.
+    Handle<OrdinaryJournal> const journal(dbc, refund->journal_id());
+    journal->set_date(gregorian::date(3000, 1, 25));
+    journal->save();
+    BOOST_CHECK(snapshot.actual_entry_ids(min_date, max_date).empty());
+    vector<Id> const cash_ids = snapshot.actual_entry_ids
+    (   optional<gregorian::date>(),
+        optional<gregorian::date>(),
+        cash->id()
+    );
+    BOOST_CHECK(cash_ids == entry_ids_in_database(dbc, cash->id()));
+    BOOST_CHECK_EQUAL(cash_ids.back(), refund->id());
+
+    // Removing a journal should remove its Entries from the snapshot.
+    journal->remove();
+    BOOST_CHECK_EQUAL(snapshot.columns().size(), size_t(4));
+    BOOST_CHECK
+    (   snapshot.actual_entry_ids
+        (   optional<gregorian::date>(),
+            optional<gregorian::date>(),
+            cash->id()
+        ) ==
+        entry_ids_in_database(dbc, cash->id())
+    );
+    totals.clear();
+    snapshot.accumulate_totals(totals, false);
+    BOOST_CHECK_EQUAL
+    (   Decimal(totals[cash->id()], 2),
+        cash->technical_balance()
+    );
+}
+
+BOOST_FIXTURE_TEST_CASE(test_recent_usage_counts, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    LedgerSnapshot& snapshot = dbc.ledger_snapshot();
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    unordered_map<Id, size_t> counts = snapshot.recent_usage_counts();
+    size_t const cash_count = counts[cash->id()];
+    size_t const food_count = counts[food->id()];
+
+    gregorian::date const date0 = today();
+    gregorian::date const date1 = today() + gregorian::date_duration(1);
+    Handle<OrdinaryJournal> const journal =
+        post_cash_journal(dbc, date0, "Butcher", Decimal("-3.00"));
+    post_cash_journal(dbc, date1, "Bakery", Decimal("-10.00"));
+    counts = snapshot.recent_usage_counts();
+    BOOST_CHECK_EQUAL(counts[cash->id()], cash_count + 2);
+    BOOST_CHECK_EQUAL(counts[food->id()], food_count + 2);
+    BOOST_CHECK_EQUAL
+    (   favourite_accounts(dbc).at(AccountSuperType::pl),
+        food->id()
+    );
+
+    // Moving a journal out of the window takes its Entries out of the
+    // counts...
+    journal->set_date_unrestricted
+    (   today() -
+        gregorian::date_duration(LedgerSnapshot::recent_usage_days() + 1)
+    );
+    journal->save();
+    counts = snapshot.recent_usage_counts();
+    BOOST_CHECK_EQUAL(counts[cash->id()], cash_count + 1);
+
+    // ... and moving it back puts them back in...
+    journal->set_date(date1);
+    journal->save();
+    counts = snapshot.recent_usage_counts();
+    BOOST_CHECK_EQUAL(counts[cash->id()], cash_count + 2);
+    BOOST_CHECK_EQUAL(counts[food->id()], food_count + 2);
+
+    // ... and removing it takes them out again.
+    journal->remove();
+    counts = snapshot.recent_usage_counts();
+    BOOST_CHECK_EQUAL(counts[cash->id()], cash_count + 1);
+    BOOST_CHECK_EQUAL(counts[food->id()], food_count + 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_ledger_snapshot_after_import, TestFixture)
+{
+    // LedgerImporter bypasses Entry and OrdinaryJournal, and marks the
+    // Journals it posts as stale itself. Enough of them are posted here
+    // that they are read back with a single query over their ids, rather
+    // than one by one.
+    DcmDatabaseConnection& dbc = *pdbc;
+    LedgerSnapshot& snapshot = dbc.ledger_snapshot();
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 15),
+        "Butcher",
+        Decimal("-3.00")
+    );
+    BOOST_CHECK_EQUAL(snapshot.columns().size(), size_t(2));
+
+    size_t const num_records = 50;
+    ostringstream oss;
+    for (size_t i = 0; i != num_records; ++i)
+    {
+        oss << "3000-01-" << (10 + i % 10) << ",Shop " << i << ",-1.00\n";
+    }
+    istringstream stream(oss.str());
+    LedgerImporter importer(dbc, cash, food);
+    BOOST_CHECK_EQUAL(importer.import(stream, ImportFormat::csv), num_records);
+
+    LedgerColumns const& columns = snapshot.columns();
+    BOOST_CHECK_EQUAL(columns.size(), (num_records + 1) * 2);
+    BOOST_CHECK
+    (   snapshot.actual_entry_ids
+        (   optional<gregorian::date>(),
+            optional<gregorian::date>(),
+            cash->id()
+        ) ==
+        entry_ids_in_database(dbc, cash->id())
+    );
+    unordered_map<Id, Decimal::int_type> totals;
+    snapshot.accumulate_totals(totals, true);
+    BOOST_CHECK_EQUAL
+    (   Decimal(totals[cash->id()], 2),
+        cash->technical_balance()
+    );
+}
+
+BOOST_FIXTURE_TEST_CASE(test_ledger_snapshot_adopt_columns, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 20),
+        "Butcher",
+        Decimal("-3.00")
+    );
+
+    LedgerSnapshot& ledger = dbc.ledger_snapshot();
+    ReadOnlyConnection reader(db_filepath);
+
+    // Columns loaded elsewhere are adopted if nothing has changed since
+    // the load began...
+    size_t num_changes = ledger.num_changes();
+    shared_ptr<LedgerColumns> columns = make_shared<LedgerColumns>();
+    load_ledger_columns(reader, *columns);
+    BOOST_CHECK(ledger.adopt_columns(columns, num_changes));
+    BOOST_CHECK(ledger.shared_columns() == columns);
+    BOOST_CHECK_EQUAL(ledger.columns().size(), size_t(2));
+
+    // ... but not otherwise.
+    num_changes = ledger.num_changes();
+    columns = make_shared<LedgerColumns>();
+    load_ledger_columns(reader, *columns);
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 21),
+        "Grocer",
+        Decimal("-7.00")
+    );
+    BOOST_CHECK(!ledger.adopt_columns(columns, num_changes));
+    BOOST_CHECK(ledger.shared_columns() != columns);
+    BOOST_CHECK_EQUAL(ledger.columns().size(), size_t(4));
+}
+
+}  // namespace test
+}  // namespace dcm
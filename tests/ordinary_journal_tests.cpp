@@ -29,11 +29,17 @@
 #include <jewel/log.hpp>
 #include <jewel/decimal.hpp>
 #include <sqloxx/handle.hpp>
+#include <sqloxx/id.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <string>
 #include <vector>
 
 using boost::gregorian::date;
 using jewel::Decimal;
 using sqloxx::Handle;
+using sqloxx::Id;
+using sqloxx::SQLStatement;
+using std::string;
 using std::vector;
 
 namespace dcm
@@ -260,5 +266,212 @@ BOOST_FIXTURE_TEST_CASE(test_ordinary_journal_remove_entry, TestFixture)
     BOOST_CHECK_EQUAL(journal1->entries().at(1)->comment(), "d");
 }
 
+BOOST_FIXTURE_TEST_CASE(test_ordinary_journal_entry_date, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<OrdinaryJournal> const journal1(dbc);
+    journal1->set_transaction_type(TransactionType::generic);
+    journal1->set_comment("igloo");
+    Handle<Entry> const entry1a(dbc);
+    entry1a->set_account(cash);
+    entry1a->set_comment("igloo entry a");
+    entry1a->set_whether_reconciled(false);
+    entry1a->set_amount(Decimal("-10.99"));
+    entry1a->set_transaction_side(TransactionSide::source);
+    journal1->push_entry(entry1a);
+    Handle<Entry> const entry1b(dbc);
+    entry1b->set_account(cash);
+    entry1b->set_comment("igloo entry b");
+    entry1b->set_whether_reconciled(false);
+    entry1b->set_amount(Decimal("10.99"));
+    entry1b->set_transaction_side(TransactionSide::destination);
+    journal1->push_entry(entry1b);
+    journal1->set_date(date(3000, 1, 5));
+    journal1->save();
+    BOOST_CHECK_EQUAL(entry1a->date(), date(3000, 1, 5));
+    BOOST_CHECK_EQUAL(entry1b->date(), date(3000, 1, 5));
+
+    // The Entries follow the date of the journal once it is saved.
+    journal1->set_date(date(3000, 2, 7));
+    BOOST_CHECK_EQUAL(entry1a->date(), date(3000, 1, 5));
+    journal1->save();
+    BOOST_CHECK_EQUAL(entry1a->date(), date(3000, 2, 7));
+    BOOST_CHECK_EQUAL(entry1b->date(), date(3000, 2, 7));
+
+    // An Entry reads the date when it is loaded.
+    entry1a->ghostify();
+    BOOST_CHECK_EQUAL(entry1a->date(), date(3000, 2, 7));
+    BOOST_CHECK_EQUAL(entry1a->comment(), wxString("igloo entry a"));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_ordinary_journal_unsaved_changes, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    Handle<OrdinaryJournal> const journal1(dbc);
+    journal1->set_transaction_type(TransactionType::expenditure);
+    journal1->set_comment("igloo");
+    Handle<Entry> const entry1a(dbc);
+    entry1a->set_account(cash);
+    entry1a->set_comment("igloo entry a");
+    entry1a->set_whether_reconciled(false);
+    entry1a->set_amount(Decimal("-10.99"));
+    entry1a->set_transaction_side(TransactionSide::source);
+    journal1->push_entry(entry1a);
+    Handle<Entry> const entry1b(dbc);
+    entry1b->set_account(food);
+    entry1b->set_comment("igloo entry b");
+    entry1b->set_whether_reconciled(false);
+    entry1b->set_amount(Decimal("10.99"));
+    entry1b->set_transaction_side(TransactionSide::destination);
+    journal1->push_entry(entry1b);
+    journal1->set_date(date(3000, 1, 5));
+    BOOST_CHECK(entry1a->has_unsaved_changes());
+    BOOST_CHECK(entry1a->has_unsaved_balance_changes());
+    journal1->save();
+    BOOST_CHECK(!entry1a->has_unsaved_changes());
+    BOOST_CHECK(!entry1b->has_unsaved_changes());
+    BOOST_CHECK(!entry1a->has_unsaved_balance_changes());
+
+    // Setting an attribute to the value it already has is not a change.
+    entry1a->set_comment("igloo entry a");
+    entry1a->set_amount(Decimal("-10.99"));
+    entry1a->set_account(cash);
+    BOOST_CHECK(!entry1a->has_unsaved_changes());
+    entry1a->set_comment("igloo entry a2");
+    BOOST_CHECK(entry1a->has_unsaved_changes());
+    BOOST_CHECK(!entry1a->has_unsaved_balance_changes());
+
+    // Only the Entry that has changed is written when the journal is
+    // saved; here we detect this by changing the other one behind its
+    // back.
+    SQLStatement sneaky_updater
+    (   dbc,
+        "update entries set comment = 'sneaky' where entry_id = :p"
+    );
+    sneaky_updater.bind(":p", entry1b->id());
+    sneaky_updater.step_final();
+    journal1->save();
+    BOOST_CHECK(!entry1a->has_unsaved_changes());
+    SQLStatement comment_reader_a
+    (   dbc,
+        "select comment from entries where entry_id = :p"
+    );
+    comment_reader_a.bind(":p", entry1a->id());
+    BOOST_REQUIRE(comment_reader_a.step());
+    BOOST_CHECK_EQUAL(comment_reader_a.extract<string>(0), "igloo entry a2");
+    SQLStatement comment_reader_b
+    (   dbc,
+        "select comment from entries where entry_id = :p"
+    );
+    comment_reader_b.bind(":p", entry1b->id());
+    BOOST_REQUIRE(comment_reader_b.step());
+    BOOST_CHECK_EQUAL(comment_reader_b.extract<string>(0), "sneaky");
+
+    // Changing the amounts still updates the balances.
+    Decimal const old_cash_balance = cash->technical_balance();
+    Decimal const old_food_balance = food->technical_balance();
+    entry1a->set_amount(Decimal("-5.00"));
+    entry1b->set_amount(Decimal("5.00"));
+    BOOST_CHECK(entry1a->has_unsaved_balance_changes());
+    journal1->save();
+    BOOST_CHECK_EQUAL
+    (   cash->technical_balance(),
+        old_cash_balance + Decimal("5.99")
+    );
+    BOOST_CHECK_EQUAL
+    (   food->technical_balance(),
+        old_food_balance - Decimal("5.99")
+    );
+
+    // Entries removed from the journal are deleted when it is saved, and
+    // the balances follow.
+    Handle<Entry> const entry1c(dbc);
+    entry1c->set_account(cash);
+    entry1c->set_comment("igloo entry c");
+    entry1c->set_whether_reconciled(false);
+    entry1c->set_amount(Decimal("-1.00"));
+    entry1c->set_transaction_side(TransactionSide::source);
+    Handle<Entry> const entry1d(dbc);
+    entry1d->set_account(food);
+    entry1d->set_comment("igloo entry d");
+    entry1d->set_whether_reconciled(false);
+    entry1d->set_amount(Decimal("1.00"));
+    entry1d->set_transaction_side(TransactionSide::destination);
+    journal1->clear_entries();
+    journal1->push_entry(entry1c);
+    journal1->push_entry(entry1d);
+    journal1->save();
+    SQLStatement entry_counter
+    (   dbc,
+        "select count(*) from entries where journal_id = :p"
+    );
+    entry_counter.bind(":p", journal1->id());
+    BOOST_REQUIRE(entry_counter.step());
+    BOOST_CHECK_EQUAL(entry_counter.extract<int>(0), 2);
+    entry_counter.step_final();
+    BOOST_CHECK_EQUAL
+    (   cash->technical_balance(),
+        old_cash_balance + Decimal("9.99")
+    );
+    BOOST_CHECK_EQUAL
+    (   food->technical_balance(),
+        old_food_balance - Decimal("9.99")
+    );
+}
+
+BOOST_FIXTURE_TEST_CASE(test_set_whether_reconciled, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    vector<Handle<Entry> > cash_entries;
+    for (int i = 1; i <= 3; ++i)
+    {
+        Handle<OrdinaryJournal> const journal(dbc);
+        journal->set_transaction_type(TransactionType::expenditure);
+        journal->set_comment("igloo");
+        Handle<Entry> const source(dbc);
+        source->set_account(cash);
+        source->set_comment("igloo source");
+        source->set_whether_reconciled(i == 2);
+        source->set_amount(Decimal("-1.00"));
+        source->set_transaction_side(TransactionSide::source);
+        journal->push_entry(source);
+        Handle<Entry> const destination(dbc);
+        destination->set_account(food);
+        destination->set_comment("igloo destination");
+        destination->set_whether_reconciled(false);
+        destination->set_amount(Decimal("1.00"));
+        destination->set_transaction_side(TransactionSide::destination);
+        journal->push_entry(destination);
+        journal->set_date(date(3000, 1, i));
+        journal->save();
+        cash_entries.push_back(source);
+    }
+
+    // Only those whose status changes are reported.
+    vector<Id> const changed = set_whether_reconciled(dbc, cash_entries, true);
+    BOOST_REQUIRE_EQUAL(changed.size(), static_cast<size_t>(2));
+    BOOST_CHECK_EQUAL(changed[0], cash_entries[0]->id());
+    BOOST_CHECK_EQUAL(changed[1], cash_entries[2]->id());
+    for (Handle<Entry> const& entry: cash_entries)
+    {
+        BOOST_CHECK(entry->is_reconciled());
+        BOOST_CHECK(!entry->has_unsaved_changes());
+        entry->ghostify();
+        BOOST_CHECK(entry->is_reconciled());
+    }
+    BOOST_CHECK(set_whether_reconciled(dbc, cash_entries, true).empty());
+    BOOST_CHECK_EQUAL
+    (   set_whether_reconciled(dbc, cash_entries, false).size(),
+        static_cast<size_t>(3)
+    );
+    cash_entries[1]->ghostify();
+    BOOST_CHECK(!cash_entries[1]->is_reconciled());
+}
+
 }  // namespace test
 }  // namespace dcm
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "period_close.hpp"
+#include "account.hpp"
+#include "date.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include "dcm_tests_common.hpp"
+#include "entry.hpp"
+#include "ordinary_journal.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <cstddef>
+#include <string>
+
+using jewel::Decimal;
+using sqloxx::Handle;
+using sqloxx::SQLStatement;
+using std::size_t;
+using std::string;
+
+namespace filesystem = boost::filesystem;
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+namespace test
+{
+
+namespace
+{
+    int count_rows(DcmDatabaseConnection& dbc, string const& p_query)
+    {
+        SQLStatement statement(dbc, p_query);
+        statement.step();
+        int const ret = statement.extract<int>(0);
+        statement.step_final();
+        return ret;
+    }
+
+}  // end anonymous namespace
+
+BOOST_FIXTURE_TEST_CASE(test_close_period, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    filesystem::path const archive_filepath("Testfile_archive_3829104.db");
+    filesystem::remove(archive_filepath);
+
+    gregorian::date const start = today() - gregorian::date_duration(60);
+    gregorian::date const cutoff = today() - gregorian::date_duration(20);
+    dbc.set_entity_creation_date(start);
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    Handle<OrdinaryJournal> const journal = post_cash_journal
+    (   dbc,
+        start + gregorian::days(10),
+        "Bakery",
+        Decimal("-10.00")
+    );
+    post_cash_journal
+    (   dbc,
+        start + gregorian::days(20),
+        "Refund",
+        Decimal("100.00")
+    );
+    post_cash_journal(dbc, cutoff, "Butcher", Decimal("-3.00"));
+
+    // Reconcile the cash Entry of the first journal.
+    for (Handle<Entry> const& entry: journal->entries())
+    {
+        if (entry->account() == cash)
+        {
+            entry->set_whether_reconciled(true);
+            entry->save();
+        }
+    }
+
+    string const reconciled_query =
+        "select sum(amount) from entries where is_reconciled = 1 and "
+        "account_id = " + std::to_string(cash->id());
+    int const old_reconciled_total = count_rows(dbc, reconciled_query);
+    Decimal const old_cash_balance = cash->technical_balance();
+    Decimal const old_food_balance = food->technical_balance();
+
+    // The opening balances are read, and so cached, before the close.
+    BOOST_CHECK_EQUAL(cash->technical_opening_balance(), Decimal(0, 0));
+    BOOST_CHECK_EQUAL(food->technical_opening_balance(), Decimal(0, 0));
+
+    BOOST_CHECK_THROW
+    (   close_period(dbc, start, archive_filepath),
+        PeriodCloseException
+    );
+    BOOST_CHECK_THROW
+    (   close_period(dbc, today() + gregorian::days(1), archive_filepath),
+        PeriodCloseException
+    );
+    BOOST_CHECK_EQUAL(close_period(dbc, cutoff, archive_filepath), size_t(2));
+
+    BOOST_CHECK_EQUAL(dbc.entity_creation_date(), cutoff);
+    BOOST_CHECK_EQUAL(cash->technical_balance(), old_cash_balance);
+    BOOST_CHECK_EQUAL(food->technical_balance(), old_food_balance);
+    BOOST_CHECK_EQUAL(cash->technical_opening_balance(), Decimal("90.00"));
+    BOOST_CHECK_EQUAL(count_rows(dbc, reconciled_query), old_reconciled_total);
+    BOOST_CHECK_EQUAL
+    (   count_rows
+        (   dbc,
+            "select count(*) from ordinary_journal_detail where date < " +
+            std::to_string(julian_int(dbc.opening_balance_journal_date()))
+        ),
+        0
+    );
+
+    dbc.execute_sql
+    (   "attach database '" + archive_filepath.string() + "' as a"
+    );
+    BOOST_CHECK_EQUAL
+    (   count_rows(dbc, "select count(*) from a.ordinary_journal_detail"),
+        2
+    );
+    BOOST_CHECK_EQUAL(count_rows(dbc, "select count(*) from a.entries"), 4);
+    BOOST_CHECK_EQUAL
+    (   count_rows(dbc, "select count(*) from a.period_closures"),
+        1
+    );
+    dbc.execute_sql("detach database a");
+    filesystem::remove(archive_filepath);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_opening_balances_after_date_change, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    gregorian::date const start = today() - gregorian::date_duration(60);
+    dbc.set_entity_creation_date(start);
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    post_cash_journal
+    (   dbc,
+        start + gregorian::days(10),
+        "Bakery",
+        Decimal("-10.00")
+    );
+    BOOST_CHECK_EQUAL(cash->technical_opening_balance(), Decimal(0, 0));
+
+    // Moving the entity creation date, as close_period(...) does, makes a
+    // different day's journals the opening balance journals.
+    dbc.set_entity_creation_date(start + gregorian::days(11));
+    BOOST_CHECK_EQUAL(cash->technical_opening_balance(), Decimal("-10.00"));
+    dbc.set_entity_creation_date(start);
+    BOOST_CHECK_EQUAL(cash->technical_opening_balance(), Decimal(0, 0));
+}
+
+BOOST_FIXTURE_TEST_CASE(test_close_period_reconciled_balances, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    filesystem::path const archive_filepath("Testfile_archive_7410263.db");
+    filesystem::remove(archive_filepath);
+
+    gregorian::date const start = today() - gregorian::date_duration(60);
+    gregorian::date const cutoff = today() - gregorian::date_duration(20);
+    dbc.set_entity_creation_date(start);
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    Handle<Account> const balancing_account = dbc.balancing_account();
+    Handle<OrdinaryJournal> const journal = post_cash_journal
+    (   dbc,
+        start + gregorian::days(10),
+        "Bakery",
+        Decimal("-10.00")
+    );
+    post_cash_journal
+    (   dbc,
+        start + gregorian::days(20),
+        "Grocer",
+        Decimal("-4.00")
+    );
+    for (Handle<Entry> const& entry: journal->entries())
+    {
+        entry->set_whether_reconciled(true);
+        entry->save();
+    }
+
+    auto const reconciled_total = [&dbc](Handle<Account> const& p_account)
+    {
+        return count_rows
+        (   dbc,
+            "select coalesce(sum(amount), 0) from entries "
+            "where is_reconciled = 1 and account_id = " +
+            std::to_string(p_account->id())
+        );
+    };
+    int const old_cash_total = reconciled_total(cash);
+    int const old_food_total = reconciled_total(food);
+    BOOST_REQUIRE_NE(old_cash_total, 0);
+    BOOST_REQUIRE_NE(old_food_total, 0);
+
+    BOOST_CHECK_EQUAL(close_period(dbc, cutoff, archive_filepath), size_t(2));
+
+    // The reconciled balances of the Accounts carried forward are
+    // unchanged...
+    BOOST_CHECK_EQUAL(reconciled_total(cash), old_cash_total);
+    BOOST_CHECK_EQUAL(reconciled_total(food), old_food_total);
+
+    // ... but the balancing account's side of each carried-forward
+    // journal is unreconciled.
+    BOOST_CHECK_EQUAL
+    (   count_rows
+        (   dbc,
+            "select count(*) from entries where is_reconciled = 1 and "
+            "account_id = " + std::to_string(balancing_account->id())
+        ),
+        0
+    );
+    filesystem::remove(archive_filepath);
+}
+
+BOOST_FIXTURE_TEST_CASE(test_close_period_after_interruption, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    filesystem::path const archive_filepath("Testfile_archive_5920371.db");
+    filesystem::remove(archive_filepath);
+
+    gregorian::date const start = today() - gregorian::date_duration(60);
+    gregorian::date const cutoff = today() - gregorian::date_duration(20);
+    dbc.set_entity_creation_date(start);
+    post_cash_journal
+    (   dbc,
+        start + gregorian::days(10),
+        "Bakery",
+        Decimal("-10.00")
+    );
+    post_cash_journal(dbc, cutoff, "Butcher", Decimal("-3.00"));
+
+    // Leave the archive as it would be had an earlier closure committed
+    // the archive but not the main database: holding copies of journals
+    // (here, all of them) that are still in the main database.
+    dbc.execute_sql
+    (   "attach database '" + archive_filepath.string() + "' as a"
+    );
+    dbc.execute_sql
+    (   "create table a.journals as select * from main.journals; "
+        "create table a.ordinary_journal_detail as "
+        "select * from main.ordinary_journal_detail; "
+        "create table a.entries as select * from main.entries; "
+        "create table a.period_closures(cutoff_date integer not null);"
+    );
+    SQLStatement inserter
+    (   dbc,
+        "insert into a.period_closures(cutoff_date) values(:cutoff)"
+    );
+    inserter.bind(":cutoff", julian_int(cutoff));
+    inserter.step_final();
+    dbc.execute_sql("detach database a");
+
+    BOOST_CHECK_EQUAL(close_period(dbc, cutoff, archive_filepath), size_t(1));
+
+    // Only the journal closed this time is in the archive.
+    dbc.execute_sql
+    (   "attach database '" + archive_filepath.string() + "' as a"
+    );
+    BOOST_CHECK_EQUAL(count_rows(dbc, "select count(*) from a.journals"), 1);
+    BOOST_CHECK_EQUAL
+    (   count_rows(dbc, "select count(*) from a.ordinary_journal_detail"),
+        1
+    );
+    BOOST_CHECK_EQUAL(count_rows(dbc, "select count(*) from a.entries"), 2);
+    BOOST_CHECK_EQUAL
+    (   count_rows(dbc, "select count(*) from a.period_closures"),
+        1
+    );
+    dbc.execute_sql("detach database a");
+    filesystem::remove(archive_filepath);
+}
+
+}  // namespace test
+}  // namespace dcm
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "read_only_connection.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_exceptions.hpp"
+#include "dcm_tests_common.hpp"
+#include "ledger_snapshot.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <sqloxx/sqloxx_exceptions.hpp>
+#include <cstddef>
+
+using jewel::Decimal;
+using sqloxx::SQLiteException;
+using sqloxx::SQLStatement;
+using std::size_t;
+
+namespace filesystem = boost::filesystem;
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+namespace test
+{
+
+BOOST_FIXTURE_TEST_CASE(test_read_only_connection, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 20),
+        "Butcher",
+        Decimal("-3.00")
+    );
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 5),
+        "Bakery",
+        Decimal("-10.00")
+    );
+
+    ReadOnlyConnection reader(db_filepath);
+    {
+        ReadOnlyConnection::Snapshot const snapshot(reader);
+        LedgerColumns columns;
+        load_ledger_columns(reader, columns);
+        BOOST_CHECK_EQUAL(columns.size(), size_t(4));
+        BOOST_CHECK
+        (   columns.entry_ids == dbc.ledger_snapshot().columns().entry_ids
+        );
+
+        // Writes through the main connection are not visible while
+        // the Snapshot is held...
+        post_cash_journal
+        (   dbc,
+            gregorian::date(3000, 1, 21),
+            "Grocer",
+            Decimal("-7.00")
+        );
+        load_ledger_columns(reader, columns);
+        BOOST_CHECK_EQUAL(columns.size(), size_t(4));
+    }
+    // ... but are once it is released.
+    LedgerColumns columns;
+    load_ledger_columns(reader, columns);
+    BOOST_CHECK_EQUAL(columns.size(), size_t(6));
+    BOOST_CHECK
+    (   columns.entry_ids == dbc.ledger_snapshot().columns().entry_ids
+    );
+
+    // Writes through the ReadOnlyConnection are refused.
+    SQLStatement statement(reader, "delete from entries");
+    BOOST_CHECK_THROW(statement.step(), SQLiteException);
+    BOOST_CHECK_EQUAL(dbc.ledger_snapshot().columns().size(), size_t(6));
+
+    // A ReadOnlyConnection does not create a database.
+    filesystem::path const missing("Testfile_no_such_file_204917.db");
+    BOOST_REQUIRE(!filesystem::exists(missing));
+    BOOST_CHECK_THROW
+    (   ReadOnlyConnection bad(missing),
+        ReadOnlyConnectionException
+    );
+    BOOST_CHECK(!filesystem::exists(missing));
+}
+
+}  // namespace test
+}  // namespace dcm
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "task_scheduler.hpp"
+#include "dcm_exceptions.hpp"
+#include <boost/test/unit_test.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::exception_ptr;
+using std::future_status;
+using std::lock_guard;
+using std::mutex;
+using std::promise;
+using std::rethrow_exception;
+using std::runtime_error;
+using std::shared_future;
+using std::size_t;
+using std::vector;
+
+namespace dcm
+{
+namespace test
+{
+
+namespace
+{
+    bool is_cancellation(exception_ptr const& p_error)
+    {
+        try
+        {
+            rethrow_exception(p_error);
+        }
+        catch (TaskCancelledException&)
+        {
+            return true;
+        }
+        catch (...)
+        {
+        }
+        return false;
+    }
+
+    // How long to wait for another thread before concluding that
+    // something has gone wrong.
+    std::chrono::seconds const timeout(10);
+
+}  // end anonymous namespace
+
+BOOST_AUTO_TEST_CASE(test_cancellation_token)
+{
+    CancellationToken const token;
+    CancellationToken copy = token;
+    BOOST_CHECK(!token.is_cancelled());
+    BOOST_CHECK_NO_THROW(token.throw_if_cancelled());
+    copy.cancel();
+    BOOST_CHECK(token.is_cancelled());
+    BOOST_CHECK_THROW(token.throw_if_cancelled(), TaskCancelledException);
+    CancellationToken const other;
+    BOOST_CHECK(!other.is_cancelled());
+}
+
+BOOST_AUTO_TEST_CASE(test_task_scheduler_runs_all_tasks)
+{
+    size_t const num_tasks = 1000;
+    atomic<size_t> sum(0);
+    atomic<size_t> num_completions(0);
+    TaskScheduler scheduler(4);
+    BOOST_CHECK_EQUAL(scheduler.num_threads(), 4);
+    for (size_t i = 1; i <= num_tasks; ++i)
+    {
+        TaskPriority const priority =
+            static_cast<TaskPriority>(i % 3);
+        scheduler.submit
+        (   [&sum, i](CancellationToken const&) { sum += i; },
+            priority,
+            [&num_completions](exception_ptr const& p_error)
+            {
+                if (!p_error) ++num_completions;
+            }
+        );
+    }
+    scheduler.wait_until_idle();
+    BOOST_CHECK_EQUAL(sum, num_tasks * (num_tasks + 1) / 2);
+    BOOST_CHECK_EQUAL(num_completions, num_tasks);
+}
+
+BOOST_AUTO_TEST_CASE(test_task_scheduler_passes_on_exceptions)
+{
+    TaskScheduler scheduler(2);
+    exception_ptr error;
+    scheduler.submit
+    (   [](CancellationToken const&) { throw runtime_error("oops"); },
+        TaskPriority::normal,
+        [&error](exception_ptr const& p_error) { error = p_error; }
+    );
+    scheduler.wait_until_idle();
+    BOOST_REQUIRE(error);
+    BOOST_CHECK_THROW(rethrow_exception(error), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_task_scheduler_survives_throwing_completion)
+{
+    TaskScheduler scheduler(1);
+    bool ran_next = false;
+    scheduler.submit
+    (   [](CancellationToken const&) {},
+        TaskPriority::normal,
+        [](exception_ptr const&) { throw runtime_error("oops"); }
+    );
+    scheduler.submit
+    (   [&ran_next](CancellationToken const&) { ran_next = true; }
+    );
+    scheduler.wait_until_idle();
+    BOOST_CHECK(ran_next);
+}
+
+BOOST_AUTO_TEST_CASE(test_task_scheduler_priorities_and_cancellation)
+{
+    // With a single thread kept busy by a blocking task, we can control
+    // the order in which the remaining tasks are found in the queue.
+    TaskScheduler scheduler(1);
+    mutex order_mutex;
+    vector<int> order;
+    auto const record = [&order, &order_mutex](int p_value)
+    {
+        lock_guard<mutex> const lock(order_mutex);
+        order.push_back(p_value);
+    };
+    vector<exception_ptr> errors(4);
+    promise<void> blocked;
+    promise<void> gate;
+    shared_future<void> const gate_opened = gate.get_future().share();
+    scheduler.submit
+    (   [&blocked, gate_opened](CancellationToken const&)
+        {
+            blocked.set_value();
+            gate_opened.wait_for(timeout);
+        }
+    );
+    BOOST_REQUIRE
+    (   blocked.get_future().wait_for(timeout) == future_status::ready
+    );
+    scheduler.submit
+    (   [&record](CancellationToken const&) { record(0); },
+        TaskPriority::low,
+        [&errors](exception_ptr const& e) { errors[0] = e; }
+    );
+    scheduler.submit
+    (   [&record](CancellationToken const&) { record(1); },
+        TaskPriority::normal,
+        [&errors](exception_ptr const& e) { errors[1] = e; }
+    );
+    scheduler.submit
+    (   [&record](CancellationToken const&) { record(2); },
+        TaskPriority::high,
+        [&errors](exception_ptr const& e) { errors[2] = e; }
+    );
+    CancellationToken doomed = scheduler.submit
+    (   [&record](CancellationToken const&) { record(3); },
+        TaskPriority::high,
+        [&errors](exception_ptr const& e) { errors[3] = e; }
+    );
+    doomed.cancel();
+    gate.set_value();
+    scheduler.wait_until_idle();
+    BOOST_REQUIRE_EQUAL(order.size(), 3);
+    BOOST_CHECK_EQUAL(order[0], 2);
+    BOOST_CHECK_EQUAL(order[1], 1);
+    BOOST_CHECK_EQUAL(order[2], 0);
+    BOOST_CHECK(!errors[0]);
+    BOOST_CHECK(!errors[1]);
+    BOOST_CHECK(!errors[2]);
+    BOOST_CHECK(is_cancellation(errors[3]));
+}
+
+BOOST_AUTO_TEST_CASE(test_task_scheduler_destruction_cancels_tasks)
+{
+    atomic<size_t> num_cancelled(0);
+    promise<void> started;
+    {
+        TaskScheduler scheduler(1);
+        scheduler.submit
+        (   [&started](CancellationToken const& p_token)
+            {
+                // A long task, polling its token as it goes.
+                started.set_value();
+                while (true)
+                {
+                    p_token.throw_if_cancelled();
+                    std::this_thread::sleep_for
+                    (   std::chrono::milliseconds(1)
+                    );
+                }
+            },
+            TaskPriority::normal,
+            [&num_cancelled](exception_ptr const& e)
+            {
+                if (is_cancellation(e)) ++num_cancelled;
+            }
+        );
+        for (int i = 0; i != 10; ++i)
+        {
+            scheduler.submit
+            (   [](CancellationToken const&) {},
+                TaskPriority::normal,
+                [&num_cancelled](exception_ptr const& e)
+                {
+                    if (is_cancellation(e)) ++num_cancelled;
+                }
+            );
+        }
+        BOOST_REQUIRE
+        (   started.get_future().wait_for(timeout) == future_status::ready
+        );
+    }
+    BOOST_CHECK_EQUAL(num_cancelled, 11);
+}
+
+}  // namespace test
+}  // namespace dcm
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2013 Matthew Harvey
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "warm_start_cache.hpp"
+#include "account.hpp"
+#include "account_type.hpp"
+#include "dcm_database_connection.hpp"
+#include "dcm_tests_common.hpp"
+#include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include <jewel/decimal.hpp>
+#include <sqloxx/handle.hpp>
+#include <sqloxx/sql_statement.hpp>
+#include <fstream>
+
+using jewel::Decimal;
+using sqloxx::Handle;
+using sqloxx::SQLStatement;
+using std::ofstream;
+
+namespace filesystem = boost::filesystem;
+namespace gregorian = boost::gregorian;
+
+namespace dcm
+{
+namespace test
+{
+
+BOOST_FIXTURE_TEST_CASE(test_warm_start_cache, TestFixture)
+{
+    DcmDatabaseConnection& dbc = *pdbc;
+    Handle<Account> const cash(dbc, Account::id_for_name(dbc, "cash"));
+    Handle<Account> const food(dbc, Account::id_for_name(dbc, "food"));
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 20),
+        "Butcher",
+        Decimal("-3.50")
+    );
+
+    filesystem::path const cache_filepath =
+        WarmStartCache::filepath_for(db_filepath);
+    BOOST_REQUIRE(!filesystem::exists(cache_filepath));
+
+    EntryListFilter filter;
+    filter.account_id = food->id();
+    filter.max_date = gregorian::date(3000, 1, 31);
+
+    // With no file, nothing is loaded; but a file can be saved.
+    {
+        WarmStartCache cache(dbc, db_filepath);
+        BOOST_CHECK(!cache.is_loaded());
+        BOOST_CHECK(cache.account_figures().empty());
+        BOOST_CHECK(!cache.entry_list_filter());
+        cache.set_entry_list_filter(filter);
+        cache.save();
+        BOOST_CHECK(filesystem::exists(cache_filepath));
+    }
+
+    // The saved file is loaded, with the figures as they were...
+    {
+        WarmStartCache cache(dbc, db_filepath);
+        BOOST_REQUIRE(cache.is_loaded());
+        BOOST_CHECK(!filesystem::exists(cache_filepath));
+        BOOST_CHECK_EQUAL
+        (   cache.favourite_accounts().at(AccountSuperType::balance_sheet),
+            cash->id()
+        );
+        BOOST_CHECK_EQUAL
+        (   cache.favourite_accounts().at(AccountSuperType::pl),
+            food->id()
+        );
+        BOOST_CHECK_EQUAL
+        (   cache.account_figures().at(cash->id()).balance,
+            cash->friendly_balance()
+        );
+        BOOST_CHECK_EQUAL
+        (   cache.account_figures().at(food->id()).balance,
+            food->friendly_balance()
+        );
+        BOOST_CHECK_EQUAL
+        (   cache.account_figures().at(food->id()).budget,
+            food->budget()
+        );
+        BOOST_REQUIRE(cache.entry_list_filter());
+        BOOST_CHECK(cache.entry_list_filter()->account_id == food->id());
+        BOOST_CHECK(!cache.entry_list_filter()->min_date);
+        BOOST_CHECK(cache.entry_list_filter()->max_date == filter.max_date);
+    }
+
+    // ... but only once, unless it is saved again.
+    {
+        WarmStartCache cache(dbc, db_filepath);
+        BOOST_CHECK(!cache.is_loaded());
+        cache.save();
+    }
+    {
+        WarmStartCache cache(dbc, db_filepath);
+        BOOST_CHECK(cache.is_loaded());
+        cache.save();
+    }
+
+    // A file saved before the database was last written to is ignored.
+    post_cash_journal
+    (   dbc,
+        gregorian::date(3000, 1, 21),
+        "Baker",
+        Decimal("-2.00")
+    );
+    {
+        WarmStartCache cache(dbc, db_filepath);
+        BOOST_CHECK(!cache.is_loaded());
+        cache.save();
+    }
+
+    // A file whose stamp does not match the database file is ignored.
+    {
+        ofstream file(cache_filepath.string().c_str());
+        file << "dcm-warm-start-cache 1\nstamp 4000000000\n"
+             << "favourites " << cash->id() << ' ' << food->id() << '\n'
+             << "end\n";
+    }
+    {
+        WarmStartCache cache(dbc, db_filepath);
+        BOOST_CHECK(!cache.is_loaded());
+        BOOST_CHECK(cache.favourite_accounts().empty());
+    }
+
+    // A malformed file is ignored.
+    {
+        ofstream file(cache_filepath.string().c_str());
+        file << "dcm-warm-start-cache 1\nstamp x\n";
+    }
+    {
+        WarmStartCache cache(dbc, db_filepath);
+        BOOST_CHECK(!cache.is_loaded());
+        BOOST_CHECK(cache.favourite_accounts().empty());
+    }
+
+    // The database itself is not written to.
+    SQLStatement statement(dbc, "pragma user_version");
+    BOOST_REQUIRE(statement.step());
+    BOOST_CHECK_EQUAL(statement.extract<int>(0), 0);
+    statement.step_final();
+
+    filesystem::remove(cache_filepath);
+}
+
+}  // namespace test
+}  // namespace dcm